@@ -0,0 +1,430 @@
+//
+// Copyright (c) 2008-2020 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include <Urho3D/Container/FlatHashMap.h>
+#include <Urho3D/Container/FrameAllocator.h>
+#include <Urho3D/Container/HashMap.h>
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/ProcessUtils.h>
+#include <Urho3D/Core/StringUtils.h>
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/Graphics/Batch.h>
+#include <Urho3D/Math/Random.h>
+
+#ifdef WIN32
+#include <windows.h>
+#endif
+
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+using namespace Urho3D;
+
+/// Number of allocations through the array new operator, which String uses for its heap buffers.
+static unsigned numArrayAllocations = 0;
+
+// Replace the array new and delete operators to count the allocations. Defined before including DebugNew.h, which redefines
+// new in MSVC debug builds
+void* operator new[](size_t size)
+{
+    ++numArrayAllocations;
+    void* ptr = malloc(size ? size : 1);
+    if (!ptr)
+        throw std::bad_alloc();
+    return ptr;
+}
+
+void operator delete[](void* ptr) noexcept
+{
+    free(ptr);
+}
+
+#include <Urho3D/DebugNew.h>
+
+/// Shortest and longest time of the repeated runs of one benchmark.
+struct BenchmarkTime
+{
+    /// Add the time of one run in microseconds.
+    void Add(long long usec)
+    {
+        min_ = Min(min_, usec);
+        max_ = Max(max_, usec);
+    }
+
+    /// Return as text in milliseconds.
+    String ToString() const
+    {
+        char buffer[64];
+        sprintf(buffer, "%8.3f ms (max %8.3f ms)", min_ / 1000.0, max_ / 1000.0);
+        return String(buffer);
+    }
+
+    /// Shortest time.
+    long long min_{M_MAX_INT};
+    /// Longest time.
+    long long max_{};
+};
+
+/// Results are added here so that the compiler does not optimize the benchmarked work away.
+static volatile unsigned sink = 0;
+
+unsigned RandomUInt();
+void BenchmarkHashMaps(unsigned count, unsigned repeats);
+template <class T> void BenchmarkHashMap(const char* name, const PODVector<unsigned>& keys, const PODVector<unsigned>& missingKeys,
+    unsigned repeats);
+void BenchmarkStrings(unsigned count, unsigned repeats);
+void BenchmarkString(const char* name, unsigned count, unsigned length, unsigned repeats);
+void BenchmarkStringAllocations(const char* name, const char** values, unsigned numValues, unsigned count);
+void BenchmarkBatchSort(unsigned count, unsigned repeats);
+
+int main(int argc, char** argv)
+{
+    #ifdef WIN32
+    const Vector<String>& arguments = ParseArguments(GetCommandLineW());
+    #else
+    const Vector<String>& arguments = ParseArguments(argc, argv);
+    #endif
+
+    unsigned count = 100000;
+    unsigned repeats = 10;
+    Vector<String> benchmarks;
+
+    for (unsigned i = 0; i < arguments.Size(); ++i)
+    {
+        if (arguments[i].Length() > 1 && arguments[i][0] == '-')
+        {
+            String argument = arguments[i].Substring(1).ToLower();
+            String value = i + 1 < arguments.Size() ? arguments[i + 1] : String::EMPTY;
+
+            if (argument == "n" && !value.Empty())
+            {
+                count = Max(ToUInt(value), 1U);
+                ++i;
+            }
+            else if (argument == "r" && !value.Empty())
+            {
+                repeats = Max(ToUInt(value), 1U);
+                ++i;
+            }
+            else
+                ErrorExit("Unknown option " + arguments[i]);
+        }
+        else if (arguments[i] == "hashmap" || arguments[i] == "string" || arguments[i] == "batchsort")
+            benchmarks.Push(arguments[i]);
+        else
+        {
+            ErrorExit(
+                "Usage: Benchmark [hashmap] [string] [batchsort] [options]\n\n"
+                "Times container and rendering operations on the CPU. Runs all benchmarks if none are given. Each "
+                "benchmark is repeated, and the shortest and longest run are reported.\n\n"
+                "hashmap     HashMap compared to FlatHashMap with random unsigned keys\n"
+                "string      String operations on strings that fit the inline buffer, and on longer strings, and heap\n"
+                "            allocations of strings with typical names and paths\n"
+                "batchsort   Batch queue sorting with the comparison sort compared to the radix sort\n\n"
+                "Options:\n"
+                "-n <count>  Number of elements, default 100000\n"
+                "-r <count>  Number of repeats, default 10"
+            );
+        }
+    }
+
+    if (benchmarks.Empty())
+    {
+        benchmarks.Push("hashmap");
+        benchmarks.Push("string");
+        benchmarks.Push("batchsort");
+    }
+
+    // The Time subsystem initializes the high-resolution timer
+    SharedPtr<Context> context(new Context());
+    context->RegisterSubsystem(new Time(context));
+    SetRandomSeed(1);
+
+    PrintLine("Elements " + String(count) + ", repeats " + String(repeats));
+
+    if (benchmarks.Contains("hashmap"))
+        BenchmarkHashMaps(count, repeats);
+    if (benchmarks.Contains("string"))
+        BenchmarkStrings(count, repeats);
+    if (benchmarks.Contains("batchsort"))
+        BenchmarkBatchSort(count, repeats);
+
+    return 0;
+}
+
+unsigned RandomUInt()
+{
+    // Rand() returns 15 bits
+    return ((unsigned)Rand() << 30u) ^ ((unsigned)Rand() << 15u) ^ (unsigned)Rand();
+}
+
+void BenchmarkHashMaps(unsigned count, unsigned repeats)
+{
+    PrintLine("\nHash maps");
+
+    PODVector<unsigned> keys(count);
+    PODVector<unsigned> missingKeys(count);
+    for (unsigned i = 0; i < count; ++i)
+    {
+        keys[i] = RandomUInt();
+        missingKeys[i] = RandomUInt();
+    }
+
+    BenchmarkHashMap<HashMap<unsigned, unsigned> >("HashMap", keys, missingKeys, repeats);
+    BenchmarkHashMap<FlatHashMap<unsigned, unsigned> >("FlatHashMap", keys, missingKeys, repeats);
+}
+
+template <class T> void BenchmarkHashMap(const char* name, const PODVector<unsigned>& keys, const PODVector<unsigned>& missingKeys,
+    unsigned repeats)
+{
+    BenchmarkTime insertTime;
+    BenchmarkTime findTime;
+    BenchmarkTime missTime;
+    BenchmarkTime iterateTime;
+    BenchmarkTime eraseTime;
+    HiresTimer timer;
+    unsigned count = keys.Size();
+
+    for (unsigned r = 0; r < repeats; ++r)
+    {
+        T map;
+        unsigned result = 0;
+
+        timer.Reset();
+        for (unsigned i = 0; i < count; ++i)
+            map[keys[i]] = i;
+        insertTime.Add(timer.GetUSec(false));
+
+        timer.Reset();
+        for (unsigned i = 0; i < count; ++i)
+            result += map.Find(keys[i])->second_;
+        findTime.Add(timer.GetUSec(false));
+
+        timer.Reset();
+        for (unsigned i = 0; i < count; ++i)
+            result += map.Contains(missingKeys[i]) ? 1 : 0;
+        missTime.Add(timer.GetUSec(false));
+
+        timer.Reset();
+        for (typename T::ConstIterator i = map.Begin(); i != map.End(); ++i)
+            result += i->second_;
+        iterateTime.Add(timer.GetUSec(false));
+
+        timer.Reset();
+        for (unsigned i = 0; i < count; ++i)
+            map.Erase(keys[i]);
+        eraseTime.Add(timer.GetUSec(false));
+
+        sink += result;
+    }
+
+    PrintLine(String(name) + ":");
+    PrintLine("  Insert   " + insertTime.ToString());
+    PrintLine("  Find     " + findTime.ToString());
+    PrintLine("  Miss     " + missTime.ToString());
+    PrintLine("  Iterate  " + iterateTime.ToString());
+    PrintLine("  Erase    " + eraseTime.ToString());
+}
+
+void BenchmarkStrings(unsigned count, unsigned repeats)
+{
+    PrintLine("\nStrings");
+
+    // 8 characters fit the inline buffer even after appending, 40 always need a heap buffer
+    BenchmarkString("8 characters", count, 8, repeats);
+    BenchmarkString("40 characters", count, 40, repeats);
+
+    static const char* names[] = {"Position", "Rotation", "Scale", "Name", "Tags", "Is Enabled", "Cast Shadows", "Model",
+        "Material", "StaticModel", "AnimatedModel", "RigidBody", "CollisionShape", "Light", "Camera", "Health", "Speed",
+        "MatDiffColor", "Diffuse", "Walk"};
+    static const char* paths[] = {"Models/Box.mdl", "Models/Mushroom.mdl", "Models/Jack.mdl", "Materials/Stone.xml",
+        "Materials/Jack.xml", "Textures/StoneDiffuse.dds", "Textures/Ramp.png", "Techniques/DiffNormal.xml",
+        "Shaders/GLSL/LitSolid.glsl", "Scenes/Level1.xml", "Sounds/Click.wav", "UI/DefaultStyle.xml"};
+
+    // Without the inline buffer every non-empty string allocated its buffer from the heap, so that count is the baseline
+    PrintLine("\nString heap allocations, compared to one per string without the inline buffer");
+#if defined(_WIN32) && !defined(URHO3D_STATIC_DEFINE)
+    PrintLine("Not available, as allocations inside the Urho3D DLL are not counted");
+#else
+    BenchmarkStringAllocations("Names", names, sizeof(names) / sizeof(names[0]), count);
+    BenchmarkStringAllocations("Paths", paths, sizeof(paths) / sizeof(paths[0]), count);
+#endif
+}
+
+void BenchmarkString(const char* name, unsigned count, unsigned length, unsigned repeats)
+{
+    PODVector<char> characters(count * (length + 1));
+    for (unsigned i = 0; i < count; ++i)
+    {
+        char* str = &characters[i * (length + 1)];
+        for (unsigned j = 0; j < length; ++j)
+            str[j] = (char)('a' + Rand() % 26);
+        str[length] = 0;
+    }
+
+    BenchmarkTime constructTime;
+    BenchmarkTime copyTime;
+    BenchmarkTime appendTime;
+    BenchmarkTime compareTime;
+    BenchmarkTime destructTime;
+    HiresTimer timer;
+
+    for (unsigned r = 0; r < repeats; ++r)
+    {
+        unsigned result = 0;
+        auto* strings = new Vector<String>();
+        strings->Reserve(count);
+
+        timer.Reset();
+        for (unsigned i = 0; i < count; ++i)
+            strings->Push(String(&characters[i * (length + 1)]));
+        constructTime.Add(timer.GetUSec(false));
+
+        timer.Reset();
+        auto* copies = new Vector<String>(*strings);
+        copyTime.Add(timer.GetUSec(false));
+
+        timer.Reset();
+        for (unsigned i = 0; i < count; ++i)
+            (*copies)[i] += "_x";
+        appendTime.Add(timer.GetUSec(false));
+
+        timer.Reset();
+        for (unsigned i = 1; i < count; ++i)
+            result += (*strings)[i] == (*strings)[i - 1] ? 1 : 0;
+        compareTime.Add(timer.GetUSec(false));
+
+        timer.Reset();
+        delete copies;
+        delete strings;
+        destructTime.Add(timer.GetUSec(false));
+
+        sink += result;
+    }
+
+    PrintLine(String(name) + ":");
+    PrintLine("  Construct  " + constructTime.ToString());
+    PrintLine("  Copy       " + copyTime.ToString());
+    PrintLine("  Append     " + appendTime.ToString());
+    PrintLine("  Compare    " + compareTime.ToString());
+    PrintLine("  Destruct   " + destructTime.ToString());
+}
+
+void BenchmarkStringAllocations(const char* name, const char** values, unsigned numValues, unsigned count)
+{
+    unsigned totalLength = 0;
+    for (unsigned i = 0; i < numValues; ++i)
+        totalLength += String::CStringLength(values[i]);
+
+    // Reserve the vectors first, so that only the string buffers are counted
+    Vector<String> strings;
+    Vector<String> copies;
+    strings.Reserve(count);
+    copies.Reserve(count);
+
+    unsigned startAllocations = numArrayAllocations;
+    for (unsigned i = 0; i < count; ++i)
+        strings.Push(String(values[i % numValues]));
+    unsigned constructAllocations = numArrayAllocations - startAllocations;
+
+    startAllocations = numArrayAllocations;
+    for (unsigned i = 0; i < count; ++i)
+        copies.Push(strings[i]);
+    unsigned copyAllocations = numArrayAllocations - startAllocations;
+
+    sink += strings.Back().Length() + copies.Back().Length();
+
+    char averageLength[32];
+    sprintf(averageLength, "%.1f", (float)totalLength / numValues);
+    PrintLine(String(name) + ", " + String(numValues) + " distinct, average " + String(averageLength) + " characters:");
+    PrintLine("  Construct  " + String(constructAllocations) + " / " + String(count));
+    PrintLine("  Copy       " + String(copyAllocations) + " / " + String(count));
+}
+
+void BenchmarkBatchSort(unsigned count, unsigned repeats)
+{
+    PrintLine("\nBatch sort");
+
+    // Fill the sort keys directly, with a spread of shaders, light queues, materials and geometries typical of a scene pass
+    PODVector<Batch> batches(count);
+    for (unsigned i = 0; i < count; ++i)
+    {
+        Batch& batch = batches[i];
+        batch.renderOrder_ = (unsigned char)(Rand() % 16 ? DEFAULT_RENDER_ORDER : DEFAULT_RENDER_ORDER + 1);
+        batch.isBase_ = Rand() % 4 != 0;
+        batch.distance_ = Random(1000.0f);
+        batch.shaderSortKey_ = ((unsigned)(Rand() % 32) << 16u) | (unsigned)(Rand() % 32);
+        batch.sortKey_ = ((unsigned long long)(Rand() % 8) << 32u) | ((unsigned long long)(Rand() % 256) << 16u) |
+            (unsigned long long)(Rand() % 1024);
+    }
+
+    BatchQueue queue;
+    FrameAllocator allocator;
+    PODVector<Batch*> sorted(count);
+    PODVector<Batch*> comparisonSorted(count);
+    const char* modeNames[] = {"State", "Front to back", "Back to front"};
+    HiresTimer timer;
+
+    for (unsigned mode = BSM_STATE; mode <= BSM_BACKTOFRONT; ++mode)
+    {
+        BenchmarkTime comparisonTime;
+        BenchmarkTime radixTime;
+
+        for (unsigned r = 0; r < repeats; ++r)
+        {
+            for (unsigned i = 0; i < count; ++i)
+                sorted[i] = &batches[i];
+            timer.Reset();
+            queue.SortBatches(sorted, (BatchSortMode)mode);
+            comparisonTime.Add(timer.GetUSec(false));
+            comparisonSorted = sorted;
+
+            for (unsigned i = 0; i < count; ++i)
+                sorted[i] = &batches[i];
+            allocator.Reset();
+            timer.Reset();
+            queue.SortBatches(sorted, (BatchSortMode)mode, &allocator);
+            radixTime.Add(timer.GetUSec(false));
+        }
+
+        // Batches that compare equal may be in a different order, but their keys have to match
+        unsigned mismatches = 0;
+        for (unsigned i = 0; i < count; ++i)
+        {
+            const Batch* lhs = sorted[i];
+            const Batch* rhs = comparisonSorted[i];
+            if (lhs->renderOrder_ != rhs->renderOrder_ || lhs->isBase_ != rhs->isBase_ || lhs->distance_ != rhs->distance_ ||
+                lhs->shaderSortKey_ != rhs->shaderSortKey_ || lhs->sortKey_ != rhs->sortKey_)
+                ++mismatches;
+        }
+
+        PrintLine(String(modeNames[mode]) + ":");
+        PrintLine("  Comparison sort  " + comparisonTime.ToString());
+        PrintLine("  Radix sort       " + radixTime.ToString());
+        if (mismatches)
+            PrintLine("  Radix sort order differs from the comparison sort at " + String(mismatches) + " batches", true);
+    }
+
+    if (count < 1024)
+        PrintLine("Queues under 1024 batches use the comparison sort also when given a frame allocator");
+}
@@ -0,0 +1,227 @@
+//
+// Copyright (c) 2008-2020 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include <Urho3D/Container/HashSet.h>
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/ProcessUtils.h>
+#include <Urho3D/Engine/Engine.h>
+#include <Urho3D/Engine/EngineDefs.h>
+#include <Urho3D/Graphics/Material.h>
+#include <Urho3D/Graphics/Renderer.h>
+#include <Urho3D/Graphics/ShaderPrecache.h>
+#include <Urho3D/Graphics/Technique.h>
+#include <Urho3D/IO/FileSystem.h>
+#include <Urho3D/IO/Log.h>
+#include <Urho3D/Resource/ResourceCache.h>
+#include <Urho3D/Resource/XMLFile.h>
+
+#ifdef WIN32
+#include <windows.h>
+#endif
+
+#include <Urho3D/DebugNew.h>
+
+using namespace Urho3D;
+
+void CollectResourceNames(Context* context, const String& pattern, Vector<String>& names);
+unsigned PrecompileResource(Context* context, const String& name, ShaderPrecache* precache);
+
+int main(int argc, char** argv)
+{
+    #ifdef WIN32
+    const Vector<String>& arguments = ParseArguments(GetCommandLineW());
+    #else
+    const Vector<String>& arguments = ParseArguments(argc, argv);
+    #endif
+
+    Vector<String> patterns;
+    VariantMap engineParameters;
+    String precacheFileName;
+
+    for (unsigned i = 0; i < arguments.Size(); ++i)
+    {
+        if (arguments[i].Length() > 1 && arguments[i][0] == '-')
+        {
+            String argument = arguments[i].Substring(1).ToLower();
+            String value = i + 1 < arguments.Size() ? arguments[i + 1] : String::EMPTY;
+
+            if (argument == "p" && !value.Empty())
+            {
+                engineParameters[EP_RESOURCE_PATHS] = value;
+                ++i;
+            }
+            else if (argument == "pp" && !value.Empty())
+            {
+                engineParameters[EP_RESOURCE_PREFIX_PATHS] = value;
+                ++i;
+            }
+            else if (argument == "cache" && !value.Empty())
+            {
+                engineParameters[EP_SHADER_CACHE_DIR] = value;
+                ++i;
+            }
+            else if (argument == "precache" && !value.Empty())
+            {
+                precacheFileName = value;
+                ++i;
+            }
+            else if (argument == "lqshadows")
+                engineParameters[EP_LOW_QUALITY_SHADOWS] = true;
+            else
+                ErrorExit("Unknown option " + arguments[i]);
+        }
+        else
+            patterns.Push(arguments[i]);
+    }
+
+    if (patterns.Empty())
+    {
+        ErrorExit(
+            "Usage: ShaderCompiler <material or technique> [material or technique ...] [options]\n\n"
+            "Compiles the shader variations that the passes of the given techniques, or the techniques of the given "
+            "materials, can use with the default rendering settings. Where the rendering API supports it, the compiled "
+            "bytecode is written to the shader cache, so that it can be shipped and loaded instead of compiled on "
+            "first use. Resources are given by resource name, and the file name part may contain a wildcard, for "
+            "example Techniques/*.xml\n\n"
+            "Options:\n"
+            "-p <paths>      Resource paths separated with ';'\n"
+            "-pp <paths>     Resource prefix paths separated with ';'\n"
+            "-cache <dir>    Shader cache directory, relative to the shader resource directory if not absolute\n"
+            "-precache <file> Write the compiled shader combinations to a precache file, which can be loaded at\n"
+            "                 startup with the ShaderPrecache engine parameter\n"
+            "-lqshadows      Compile low quality shadow variations"
+        );
+    }
+
+    engineParameters[EP_WINDOW_TITLE] = "ShaderCompiler";
+    engineParameters[EP_WINDOW_WIDTH] = 320;
+    engineParameters[EP_WINDOW_HEIGHT] = 240;
+    engineParameters[EP_FULL_SCREEN] = false;
+    engineParameters[EP_SOUND] = false;
+    engineParameters[EP_WORKER_THREADS] = false;
+    engineParameters[EP_LOG_NAME] = String::EMPTY;
+
+    SharedPtr<Context> context(new Context());
+    SharedPtr<Engine> engine(new Engine(context));
+    // A rendering device is needed for compiling the shaders, so the engine can not be headless
+    if (!engine->Initialize(engineParameters))
+        ErrorExit("Failed to initialize the engine");
+
+    context->GetSubsystem<Log>()->SetLevel(LOG_WARNING);
+
+    Vector<String> names;
+    for (unsigned i = 0; i < patterns.Size(); ++i)
+        CollectResourceNames(context, patterns[i], names);
+
+    // The precache file is written when the ShaderPrecache object is destroyed
+    SharedPtr<ShaderPrecache> precache;
+    if (!precacheFileName.Empty())
+        precache = new ShaderPrecache(context, GetInternalPath(precacheFileName));
+
+    unsigned numCompiled = 0;
+    for (unsigned i = 0; i < names.Size(); ++i)
+        numCompiled += PrecompileResource(context, names[i], precache);
+
+    PrintLine("Compiled " + String(numCompiled) + " shader variations from " + String(names.Size()) + " resources");
+    return EXIT_SUCCESS;
+}
+
+void CollectResourceNames(Context* context, const String& pattern, Vector<String>& names)
+{
+    String path, file, extension;
+    SplitPath(pattern, path, file, extension);
+
+    if (!file.Contains('*'))
+    {
+        if (!names.Contains(pattern))
+            names.Push(pattern);
+        return;
+    }
+
+    // Expand the wildcard in all resource directories
+    auto* cache = context->GetSubsystem<ResourceCache>();
+    auto* fileSystem = context->GetSubsystem<FileSystem>();
+    const Vector<String>& resourceDirs = cache->GetResourceDirs();
+    HashSet<String> found;
+
+    for (unsigned i = 0; i < resourceDirs.Size(); ++i)
+    {
+        Vector<String> files;
+        fileSystem->ScanDir(files, resourceDirs[i] + path, file + extension, SCAN_FILES, false);
+        for (unsigned j = 0; j < files.Size(); ++j)
+            found.Insert(path + files[j]);
+    }
+
+    if (found.Empty())
+        PrintLine("No resources found matching " + pattern, true);
+
+    for (HashSet<String>::ConstIterator i = found.Begin(); i != found.End(); ++i)
+    {
+        if (!names.Contains(*i))
+            names.Push(*i);
+    }
+}
+
+unsigned PrecompileResource(Context* context, const String& name, ShaderPrecache* precache)
+{
+    auto* cache = context->GetSubsystem<ResourceCache>();
+    auto* renderer = context->GetSubsystem<Renderer>();
+
+    // Techniques are XML files with a technique root element, anything else is treated as a material
+    bool isTechnique = false;
+    if (GetExtension(name) == ".xml")
+    {
+        auto* xmlFile = cache->GetResource<XMLFile>(name);
+        if (xmlFile && xmlFile->GetRoot().GetName() == "technique")
+            isTechnique = true;
+    }
+
+    unsigned numCompiled = 0;
+
+    if (isTechnique)
+    {
+        auto* technique = cache->GetResource<Technique>(name);
+        if (!technique)
+        {
+            PrintLine("Failed to load technique " + name, true);
+            return 0;
+        }
+
+        numCompiled = renderer->PrecompileShaders(technique, precache);
+    }
+    else
+    {
+        auto* material = cache->GetResource<Material>(name);
+        if (!material)
+        {
+            PrintLine("Failed to load material " + name, true);
+            return 0;
+        }
+
+        // Use the techniques as modified by the material's shader defines
+        for (unsigned i = 0; i < material->GetNumTechniques(); ++i)
+            numCompiled += renderer->PrecompileShaders(material->GetTechnique(i), precache);
+    }
+
+    PrintLine(name + ": " + String(numCompiled) + " shader variations");
+    return numCompiled;
+}
@@ -356,6 +356,9 @@ template <class T> void RegisterMembers_Batch(asIScriptEngine* engine, const cha
     // unsigned long long Batch::sortKey_
     engine->RegisterObjectProperty(className, "uint64 sortKey", offsetof(T, sortKey_));
 
+    // unsigned Batch::shaderSortKey_
+    engine->RegisterObjectProperty(className, "uint shaderSortKey", offsetof(T, shaderSortKey_));
+
     // float Batch::distance_
     engine->RegisterObjectProperty(className, "float distance", offsetof(T, distance_));
 
@@ -415,7 +418,11 @@ template <class T> void RegisterMembers_BatchQueue(asIScriptEngine* engine, cons
 {
     // void BatchQueue::SetInstancingData(void* lockedData, unsigned stride, unsigned& freeIndex)
     // Error: type "void*" can not automatically bind
-    // void BatchQueue::SortFrontToBack2Pass(PODVector<Batch*>& batches)
+    // void BatchQueue::SortBackToFront(FrameAllocator* allocator)
+    // Error: type "FrameAllocator*" can not automatically bind
+    // void BatchQueue::SortFrontToBack(FrameAllocator* allocator)
+    // Error: type "FrameAllocator*" can not automatically bind
+    // void BatchQueue::SortFrontToBack2Pass(PODVector<Batch*>& batches, FrameAllocator* allocator = nullptr)
     // Error: type "PODVector<Batch*>&" can not automatically bind
 
     // void BatchQueue::Clear(int maxSortedInstances)
@@ -438,8 +445,8 @@ template <class T> void RegisterMembers_BatchQueue(asIScriptEngine* engine, cons
 
     // HashMap<BatchGroupKey, BatchGroup> BatchQueue::batchGroups_
     // Error: type "HashMap<BatchGroupKey, BatchGroup>" can not automatically bind
-    // HashMap<unsigned, unsigned> BatchQueue::shaderRemapping_
-    // Error: type "HashMap<unsigned, unsigned>" can not automatically bind
+    // HashMap<unsigned long long, unsigned> BatchQueue::shaderRemapping_
+    // Error: type "HashMap<unsigned long long, unsigned>" can not automatically bind
     // HashMap<unsigned short, unsigned short> BatchQueue::materialRemapping_
     // Error: type "HashMap<unsigned short, unsigned short>" can not automatically bind
     // HashMap<unsigned short, unsigned short> BatchQueue::geometryRemapping_
@@ -11392,11 +11399,8 @@ template <class T> void RegisterMembers_Renderer(asIScriptEngine* engine, const
     // void Renderer::Render()
     engine->RegisterObjectMethod(className, "void Render()", AS_METHODPR(T, Render, (), void), AS_CALL_THISCALL);
 
-    // bool Renderer::ResizeInstancingBuffer(unsigned numInstances)
-    engine->RegisterObjectMethod(className, "bool ResizeInstancingBuffer(uint)", AS_METHODPR(T, ResizeInstancingBuffer, (unsigned), bool), AS_CALL_THISCALL);
-
-    // void Renderer::SetBatchShaders(Batch& batch, Technique* tech, bool allowShadows, const BatchQueue& queue)
-    engine->RegisterObjectMethod(className, "void SetBatchShaders(Batch&, Technique@+, bool, const BatchQueue&in)", AS_METHODPR(T, SetBatchShaders, (Batch&, Technique*, bool, const BatchQueue&), void), AS_CALL_THISCALL);
+    // bool Renderer::SetBatchShaders(Batch& batch, Technique* tech, bool allowShadows, const BatchQueue& queue)
+    engine->RegisterObjectMethod(className, "bool SetBatchShaders(Batch&, Technique@+, bool, const BatchQueue&in)", AS_METHODPR(T, SetBatchShaders, (Batch&, Technique*, bool, const BatchQueue&), bool), AS_CALL_THISCALL);
 
     // void Renderer::SetCullMode(CullMode mode, Camera* camera)
     engine->RegisterObjectMethod(className, "void SetCullMode(CullMode, Camera@+)", AS_METHODPR(T, SetCullMode, (CullMode, Camera*), void), AS_CALL_THISCALL);
@@ -17577,6 +17581,8 @@ template <class T> void RegisterMembers_Drawable(asIScriptEngine* engine, const
     // Error: type "const Vector<SourceBatch>&" can not automatically bind
     // Octant* Drawable::GetOctant() const
     // Error: type "Octant" can not automatically bind bacause have @nobind mark
+    // virtual const Vector<SourceBatch>& Drawable::GetShadowBatches() const
+    // Error: type "const Vector<SourceBatch>&" can not automatically bind
     // virtual void Drawable::ProcessRayQuery(const RayOctreeQuery& query, PODVector<RayQueryResult>& results)
     // Error: type "RayOctreeQuery" can not automatically bind bacause have @nobind mark
     // virtual void Drawable::Update(const FrameInfo& frame)
@@ -22,6 +22,8 @@
 
 #include "../Precompiled.h"
 
+#include "../Container/PoolAllocator.h"
+
 #include "../DebugNew.h"
 
 namespace Urho3D
@@ -38,6 +40,7 @@ AllocatorBlock* AllocatorReserveBlock(AllocatorBlock* allocator, unsigned nodeSi
     newBlock->capacity_ = capacity;
     newBlock->free_ = nullptr;
     newBlock->next_ = nullptr;
+    newBlock->threadSafe_ = false;
 
     if (!allocator)
         allocator = newBlock;
@@ -74,6 +77,17 @@ AllocatorBlock* AllocatorInitialize(unsigned nodeSize, unsigned initialCapacity)
     return block;
 }
 
+AllocatorBlock* AllocatorInitializeThreadSafe(unsigned nodeSize)
+{
+    auto* block = reinterpret_cast<AllocatorBlock*>(new unsigned char[sizeof(AllocatorBlock)]);
+    block->nodeSize_ = nodeSize;
+    block->capacity_ = 0;
+    block->free_ = nullptr;
+    block->next_ = nullptr;
+    block->threadSafe_ = true;
+    return block;
+}
+
 void AllocatorUninitialize(AllocatorBlock* allocator)
 {
     while (allocator)
@@ -89,6 +103,9 @@ void* AllocatorReserve(AllocatorBlock* allocator)
     if (!allocator)
         return nullptr;
 
+    if (allocator->threadSafe_)
+        return PoolAllocatorReserve(allocator->nodeSize_);
+
     if (!allocator->free_)
     {
         // Free nodes have been exhausted. Allocate a new larger block
@@ -111,6 +128,12 @@ void AllocatorFree(AllocatorBlock* allocator, void* ptr)
     if (!allocator || !ptr)
         return;
 
+    if (allocator->threadSafe_)
+    {
+        PoolAllocatorFree(ptr, allocator->nodeSize_);
+        return;
+    }
+
     auto* dataPtr = static_cast<unsigned char*>(ptr);
     auto* node = reinterpret_cast<AllocatorNode*>(dataPtr - sizeof(AllocatorNode));
 
@@ -47,6 +47,8 @@ struct AllocatorBlock
     AllocatorNode* free_;
     /// Next allocator block.
     AllocatorBlock* next_;
+    /// Whether nodes are allocated from the thread-safe pool allocator instead of the blocks.
+    bool threadSafe_;
     /// Nodes follow.
 };
 
@@ -60,6 +62,8 @@ struct AllocatorNode
 
 /// Initialize a fixed-size allocator with the node size and initial capacity.
 URHO3D_API AllocatorBlock* AllocatorInitialize(unsigned nodeSize, unsigned initialCapacity = 1);
+/// Initialize a fixed-size allocator which allocates nodes from the thread-safe pool allocator. Nodes can then be allocated and freed in any thread.
+URHO3D_API AllocatorBlock* AllocatorInitializeThreadSafe(unsigned nodeSize);
 /// Uninitialize a fixed-size allocator. Frees all blocks in the chain.
 URHO3D_API void AllocatorUninitialize(AllocatorBlock* allocator);
 /// Reserve a node. Creates a new block if necessary.
@@ -0,0 +1,92 @@
+//
+// Copyright (c) 2008-2020 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Precompiled.h"
+
+#include "../Container/FlatHashBase.h"
+
+#include <cstring>
+#include <new>
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+unsigned FlatHashBase::CapacityForSize(unsigned size)
+{
+    unsigned capacity = MIN_CAPACITY;
+    while (MaxSize(capacity) < size)
+        capacity = capacity * 2 + 1;
+    return capacity;
+}
+
+void FlatHashBase::EraseControl(unsigned index)
+{
+    // If the groups before and after the slot together contain an empty slot within one group width, no probe
+    // sequence can have continued past this slot when it was full, and it can be made empty again
+    unsigned indexBefore = (index - GROUP_WIDTH) & capacity_;
+    unsigned emptyAfter = MatchGroup(ctrl_ + index, CTRL_EMPTY);
+    unsigned emptyBefore = MatchGroup(ctrl_ + indexBefore, CTRL_EMPTY);
+
+    bool wasNeverFull = false;
+    if (emptyAfter && emptyBefore)
+    {
+        unsigned leadingFull = 0;
+        while (!(emptyBefore & (1u << (GROUP_WIDTH - 1 - leadingFull))))
+            ++leadingFull;
+        wasNeverFull = LowestBit(emptyAfter) + leadingFull < GROUP_WIDTH;
+    }
+
+    if (wasNeverFull)
+    {
+        SetControl(index, CTRL_EMPTY);
+        ++growthLeft_;
+    }
+    else
+        SetControl(index, CTRL_DELETED);
+
+    --size_;
+}
+
+void FlatHashBase::AllocateTable(unsigned capacity, unsigned slotSize)
+{
+    ctrl_ = new signed char[capacity + GROUP_WIDTH];
+    slots_ = ::operator new((size_t)capacity * slotSize);
+    capacity_ = capacity;
+    ResetControl();
+}
+
+void FlatHashBase::ResetControl()
+{
+    memset(ctrl_, CTRL_EMPTY, capacity_ + GROUP_WIDTH);
+    ctrl_[capacity_] = CTRL_SENTINEL;
+    growthLeft_ = MaxSize(capacity_) - size_;
+}
+
+void FlatHashBase::FreeTable(signed char* ctrl, void* slots)
+{
+    delete[] ctrl;
+    ::operator delete(slots);
+}
+
+}
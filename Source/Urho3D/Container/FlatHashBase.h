@@ -0,0 +1,264 @@
+//
+// Copyright (c) 2008-2020 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#ifdef URHO3D_IS_BUILDING
+#include "Urho3D.h"
+#else
+#include <Urho3D/Urho3D.h>
+#endif
+
+#include "../Container/Hash.h"
+#include "../Container/Swap.h"
+
+#ifdef URHO3D_SSE
+#include <emmintrin.h>
+#endif
+
+namespace Urho3D
+{
+
+/// Flat hash set/map iterator base class.
+struct FlatHashIteratorBase
+{
+    /// Construct.
+    FlatHashIteratorBase() :
+        ctrl_(nullptr)
+    {
+    }
+
+    /// Construct with a control byte pointer.
+    explicit FlatHashIteratorBase(const signed char* ctrl) :
+        ctrl_(ctrl)
+    {
+    }
+
+    /// Test for equality with another iterator.
+    bool operator ==(const FlatHashIteratorBase& rhs) const { return ctrl_ == rhs.ctrl_; }
+
+    /// Test for inequality with another iterator.
+    bool operator !=(const FlatHashIteratorBase& rhs) const { return ctrl_ != rhs.ctrl_; }
+
+    /// Control byte of the current slot.
+    const signed char* ctrl_;
+};
+
+/// Flat hash set/map base class. Stores the elements in a single open-addressed slot array with a parallel array of control bytes, which are probed a group at a time.
+/** Each control byte is either empty, deleted (a tombstone), the end sentinel, or the low 7 bits of the hash of a stored element. A lookup compares a whole group of control bytes against the hash bits at once, and only compares keys where they match.
+    Note that to prevent extra memory use due to vtable pointer, %FlatHashBase intentionally does not declare a virtual destructor
+    and therefore %FlatHashBase pointers should never be used.
+  */
+class URHO3D_API FlatHashBase
+{
+public:
+    /// Number of control bytes probed at once.
+    static const unsigned GROUP_WIDTH = 16;
+    /// Minimum capacity. The capacity is always a power of two minus one.
+    static const unsigned MIN_CAPACITY = GROUP_WIDTH - 1;
+    /// Control byte of an empty slot.
+    static const signed char CTRL_EMPTY = -128;
+    /// Control byte of an erased slot.
+    static const signed char CTRL_DELETED = -2;
+    /// Control byte at the end of the slots, which stops iteration.
+    static const signed char CTRL_SENTINEL = -1;
+    /// Slot index returned when no slot is available.
+    static const unsigned NO_SLOT = 0xffffffff;
+
+    /// Construct.
+    FlatHashBase() :
+        ctrl_(nullptr),
+        slots_(nullptr),
+        capacity_(0),
+        size_(0),
+        growthLeft_(0)
+    {
+    }
+
+    /// Swap with another flat hash set or map.
+    void Swap(FlatHashBase& rhs)
+    {
+        Urho3D::Swap(ctrl_, rhs.ctrl_);
+        Urho3D::Swap(slots_, rhs.slots_);
+        Urho3D::Swap(capacity_, rhs.capacity_);
+        Urho3D::Swap(size_, rhs.size_);
+        Urho3D::Swap(growthLeft_, rhs.growthLeft_);
+    }
+
+    /// Return number of elements.
+    unsigned Size() const { return size_; }
+
+    /// Return number of slots.
+    unsigned Capacity() const { return capacity_; }
+
+    /// Return whether has no elements.
+    bool Empty() const { return size_ == 0; }
+
+protected:
+    /// Return maximum number of elements for a capacity, so that at least one slot always remains empty.
+    static unsigned MaxSize(unsigned capacity) { return capacity - capacity / 8; }
+
+    /// Return the smallest capacity which can hold the number of elements.
+    static unsigned CapacityForSize(unsigned size);
+
+    /// Scramble a hash value so that both the probe start position and the control byte bits are well distributed.
+    static unsigned MixHash(unsigned hash)
+    {
+        hash ^= hash >> 16;
+        hash *= 0x85ebca6bu;
+        hash ^= hash >> 13;
+        hash *= 0xc2b2ae35u;
+        hash ^= hash >> 16;
+        return hash;
+    }
+
+    /// Return the control byte for a mixed hash.
+    static signed char HashControl(unsigned hash) { return (signed char)(hash & 0x7fu); }
+
+    /// Return the probe start position for a mixed hash.
+    unsigned HashPosition(unsigned hash) const { return (hash >> 7u) & capacity_; }
+
+    /// Return bit mask of the control bytes in a group which equal the value.
+    static unsigned MatchGroup(const signed char* group, signed char value)
+    {
+#ifdef URHO3D_SSE
+        __m128i ctrl = _mm_loadu_si128(reinterpret_cast<const __m128i*>(group));
+        return (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(value), ctrl));
+#else
+        unsigned mask = 0;
+        for (unsigned i = 0; i < GROUP_WIDTH; ++i)
+        {
+            if (group[i] == value)
+                mask |= 1u << i;
+        }
+        return mask;
+#endif
+    }
+
+    /// Return bit mask of the empty or deleted control bytes in a group.
+    static unsigned MatchGroupFree(const signed char* group)
+    {
+#ifdef URHO3D_SSE
+        __m128i ctrl = _mm_loadu_si128(reinterpret_cast<const __m128i*>(group));
+        return (unsigned)_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_set1_epi8(CTRL_SENTINEL), ctrl));
+#else
+        unsigned mask = 0;
+        for (unsigned i = 0; i < GROUP_WIDTH; ++i)
+        {
+            if (group[i] < CTRL_SENTINEL)
+                mask |= 1u << i;
+        }
+        return mask;
+#endif
+    }
+
+    /// Return index of the lowest set bit. The mask must not be zero.
+    static unsigned LowestBit(unsigned mask)
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        return (unsigned)__builtin_ctz(mask);
+#else
+        unsigned index = 0;
+        while (!(mask & 1u))
+        {
+            mask >>= 1;
+            ++index;
+        }
+        return index;
+#endif
+    }
+
+    /// Return the first slot along the probe sequence of a hash which is empty or deleted. The table must have been allocated.
+    unsigned FindFreeSlot(unsigned hash) const
+    {
+        unsigned position = HashPosition(hash);
+        unsigned step = 0;
+        for (;;)
+        {
+            unsigned mask = MatchGroupFree(ctrl_ + position);
+            if (mask)
+                return (position + LowestBit(mask)) & capacity_;
+            step += GROUP_WIDTH;
+            position = (position + step) & capacity_;
+        }
+    }
+
+    /// Set a control byte, and its clone after the sentinel if the slot is within the first group.
+    void SetControl(unsigned index, signed char value)
+    {
+        ctrl_[index] = value;
+        ctrl_[((index - (GROUP_WIDTH - 1)) & capacity_) + (GROUP_WIDTH - 1)] = value;
+    }
+
+    /// Claim a free slot for a new element with the hash and set its control byte. Return the slot index, or NO_SLOT if the table must be grown first.
+    unsigned PrepareInsert(unsigned hash)
+    {
+        if (!capacity_)
+            return NO_SLOT;
+
+        unsigned index = FindFreeSlot(hash);
+        if (!growthLeft_ && ctrl_[index] != CTRL_DELETED)
+            return NO_SLOT;
+
+        if (ctrl_[index] == CTRL_EMPTY)
+            --growthLeft_;
+        ++size_;
+        SetControl(index, HashControl(hash));
+        return index;
+    }
+
+    /// Mark a slot erased. Sets it empty instead of deleted if no probe sequence can have passed over it, so that tombstones do not accumulate.
+    void EraseControl(unsigned index);
+
+    /// Return the capacity to use when the table is full: double if mostly full of elements, same if mostly full of tombstones.
+    unsigned GrowCapacity() const { return size_ > MaxSize(capacity_) / 2 ? capacity_ * 2 + 1 : (capacity_ > MIN_CAPACITY ? capacity_ : MIN_CAPACITY); }
+
+    /// Allocate control bytes and slots for a capacity and reset the control bytes to empty, without freeing the previous ones. The caller must move the elements and free the previous table.
+    void AllocateTable(unsigned capacity, unsigned slotSize);
+
+    /// Reset all control bytes to empty.
+    void ResetControl();
+
+    /// Free control bytes and slots.
+    static void FreeTable(signed char* ctrl, void* slots);
+
+    /// Skip to the next used slot or the sentinel, starting from a control byte.
+    static const signed char* SkipFree(const signed char* ctrl)
+    {
+        while (*ctrl < CTRL_SENTINEL)
+            ++ctrl;
+        return ctrl;
+    }
+
+    /// Control bytes. There is one for each slot, followed by the sentinel and clones of the first group for unaligned group loads.
+    signed char* ctrl_;
+    /// Slots.
+    void* slots_;
+    /// Number of slots. Also the mask for wrapping probe positions.
+    unsigned capacity_;
+    /// Number of elements.
+    unsigned size_;
+    /// Number of empty slots which can still be used before the table must grow.
+    unsigned growthLeft_;
+};
+
+}
@@ -0,0 +1,564 @@
+//
+// Copyright (c) 2008-2020 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../Container/FlatHashBase.h"
+#include "../Container/Pair.h"
+#include "../Container/Vector.h"
+
+#include <initializer_list>
+#include <new>
+
+namespace Urho3D
+{
+
+/// Open-addressing hash map template class. Stores the pairs in a flat array, so lookups do not chase node pointers. Has the same interface as HashMap, except that iteration order is unspecified and iterators are forward only. Inserting may invalidate iterators and pair pointers, erasing invalidates only those of the erased pair.
+template <class T, class U> class FlatHashMap : public FlatHashBase
+{
+public:
+    using KeyType = T;
+    using ValueType = U;
+
+    /// Flat hash map key-value pair with const key.
+    class KeyValue
+    {
+    public:
+        /// Construct with default key.
+        KeyValue() :
+            first_(T())
+        {
+        }
+
+        /// Construct with key and value.
+        KeyValue(const T& first, const U& second) :
+            first_(first),
+            second_(second)
+        {
+        }
+
+        /// Copy-construct.
+        KeyValue(const KeyValue& value) :
+            first_(value.first_),
+            second_(value.second_)
+        {
+        }
+
+        /// Prevent assignment.
+        KeyValue& operator =(const KeyValue& rhs) = delete;
+
+        /// Test for equality with another pair.
+        bool operator ==(const KeyValue& rhs) const { return first_ == rhs.first_ && second_ == rhs.second_; }
+        /// Test for inequality with another pair.
+        bool operator !=(const KeyValue& rhs) const { return first_ != rhs.first_ || second_ != rhs.second_; }
+
+        /// Key.
+        const T first_;
+        /// Value.
+        U second_;
+    };
+
+    /// Flat hash map iterator.
+    struct Iterator : public FlatHashIteratorBase
+    {
+        /// Construct.
+        Iterator() :
+            ptr_(nullptr)
+        {
+        }
+
+        /// Construct with a control byte and slot pointer.
+        Iterator(const signed char* ctrl, KeyValue* ptr) :
+            FlatHashIteratorBase(ctrl),
+            ptr_(ptr)
+        {
+        }
+
+        /// Preincrement the pointer.
+        Iterator& operator ++()
+        {
+            GotoNext();
+            return *this;
+        }
+
+        /// Postincrement the pointer.
+        Iterator operator ++(int)
+        {
+            Iterator it = *this;
+            GotoNext();
+            return it;
+        }
+
+        /// Point to the pair.
+        KeyValue* operator ->() const { return ptr_; }
+
+        /// Dereference the pair.
+        KeyValue& operator *() const { return *ptr_; }
+
+        /// Go to the next used slot.
+        void GotoNext()
+        {
+            const signed char* next = SkipFree(ctrl_ + 1);
+            ptr_ += next - ctrl_;
+            ctrl_ = next;
+        }
+
+        /// Slot pointer.
+        KeyValue* ptr_;
+    };
+
+    /// Flat hash map const iterator.
+    struct ConstIterator : public FlatHashIteratorBase
+    {
+        /// Construct.
+        ConstIterator() :
+            ptr_(nullptr)
+        {
+        }
+
+        /// Construct with a control byte and slot pointer.
+        ConstIterator(const signed char* ctrl, const KeyValue* ptr) :
+            FlatHashIteratorBase(ctrl),
+            ptr_(ptr)
+        {
+        }
+
+        /// Construct from a non-const iterator.
+        ConstIterator(const Iterator& rhs) :        // NOLINT(google-explicit-constructor)
+            FlatHashIteratorBase(rhs.ctrl_),
+            ptr_(rhs.ptr_)
+        {
+        }
+
+        /// Assign from a non-const iterator.
+        ConstIterator& operator =(const Iterator& rhs)
+        {
+            ctrl_ = rhs.ctrl_;
+            ptr_ = rhs.ptr_;
+            return *this;
+        }
+
+        /// Preincrement the pointer.
+        ConstIterator& operator ++()
+        {
+            GotoNext();
+            return *this;
+        }
+
+        /// Postincrement the pointer.
+        ConstIterator operator ++(int)
+        {
+            ConstIterator it = *this;
+            GotoNext();
+            return it;
+        }
+
+        /// Point to the pair.
+        const KeyValue* operator ->() const { return ptr_; }
+
+        /// Dereference the pair.
+        const KeyValue& operator *() const { return *ptr_; }
+
+        /// Go to the next used slot.
+        void GotoNext()
+        {
+            const signed char* next = SkipFree(ctrl_ + 1);
+            ptr_ += next - ctrl_;
+            ctrl_ = next;
+        }
+
+        /// Slot pointer.
+        const KeyValue* ptr_;
+    };
+
+    /// Construct empty.
+    FlatHashMap() = default;
+
+    /// Construct from another flat hash map.
+    FlatHashMap(const FlatHashMap<T, U>& map)
+    {
+        Reserve(map.Size());
+        Insert(map);
+    }
+
+    /// Move-construct from another flat hash map.
+    FlatHashMap(FlatHashMap<T, U> && map) noexcept
+    {
+        Swap(map);
+    }
+
+    /// Aggregate initialization constructor.
+    FlatHashMap(const std::initializer_list<Pair<T, U>>& list)
+    {
+        Reserve((unsigned)list.size());
+        for (auto it = list.begin(); it != list.end(); it++)
+        {
+            Insert(*it);
+        }
+    }
+
+    /// Destruct.
+    ~FlatHashMap()
+    {
+        if (ctrl_)
+        {
+            DestructPairs();
+            FreeTable(ctrl_, slots_);
+        }
+    }
+
+    /// Assign a flat hash map.
+    FlatHashMap& operator =(const FlatHashMap<T, U>& rhs)
+    {
+        // In case of self-assignment do nothing
+        if (&rhs != this)
+        {
+            Clear();
+            Insert(rhs);
+        }
+        return *this;
+    }
+
+    /// Move-assign a flat hash map.
+    FlatHashMap& operator =(FlatHashMap<T, U> && rhs) noexcept
+    {
+        Swap(rhs);
+        return *this;
+    }
+
+    /// Add-assign a pair.
+    FlatHashMap& operator +=(const Pair<T, U>& rhs)
+    {
+        Insert(rhs);
+        return *this;
+    }
+
+    /// Add-assign a flat hash map.
+    FlatHashMap& operator +=(const FlatHashMap<T, U>& rhs)
+    {
+        Insert(rhs);
+        return *this;
+    }
+
+    /// Test for equality with another flat hash map.
+    bool operator ==(const FlatHashMap<T, U>& rhs) const
+    {
+        if (rhs.Size() != Size())
+            return false;
+
+        for (ConstIterator i = Begin(); i != End(); ++i)
+        {
+            ConstIterator j = rhs.Find(i->first_);
+            if (j == rhs.End() || j->second_ != i->second_)
+                return false;
+        }
+
+        return true;
+    }
+
+    /// Test for inequality with another flat hash map.
+    bool operator !=(const FlatHashMap<T, U>& rhs) const { return !(*this == rhs); }
+
+    /// Index the map. Create a new pair if key not found.
+    U& operator [](const T& key)
+    {
+        unsigned hash = MixHash(MakeHash(key));
+        unsigned index = FindSlot(key, hash);
+        if (index == NO_SLOT)
+        {
+            index = InsertSlot(hash);
+            new(Slots() + index) KeyValue(key, U());
+        }
+        return Slots()[index].second_;
+    }
+
+    /// Index the map. Return null if key is not found, does not create a new pair.
+    U* operator [](const T& key) const
+    {
+        unsigned index = FindSlot(key, MixHash(MakeHash(key)));
+        return index != NO_SLOT ? &Slots()[index].second_ : nullptr;
+    }
+
+    /// Populate the map using variadic template. This handles the base case.
+    FlatHashMap& Populate(const T& key, const U& value)
+    {
+        this->operator [](key) = value;
+        return *this;
+    }
+
+    /// Populate the map using variadic template.
+    template <typename... Args> FlatHashMap& Populate(const T& key, const U& value, const Args&... args)
+    {
+        this->operator [](key) = value;
+        return Populate(args...);
+    }
+
+    /// Insert a pair. Return an iterator to it.
+    Iterator Insert(const Pair<T, U>& pair)
+    {
+        bool exists;
+        return Insert(pair, exists);
+    }
+
+    /// Insert a pair. Return iterator and set exists flag according to whether the key already existed.
+    Iterator Insert(const Pair<T, U>& pair, bool& exists)
+    {
+        unsigned hash = MixHash(MakeHash(pair.first_));
+        unsigned index = FindSlot(pair.first_, hash);
+        exists = index != NO_SLOT;
+        if (exists)
+            Slots()[index].second_ = pair.second_;
+        else
+        {
+            index = InsertSlot(hash);
+            new(Slots() + index) KeyValue(pair.first_, pair.second_);
+        }
+        return Iterator(ctrl_ + index, Slots() + index);
+    }
+
+    /// Insert a map.
+    void Insert(const FlatHashMap<T, U>& map)
+    {
+        for (ConstIterator it = map.Begin(); it != map.End(); ++it)
+            Insert(MakePair(it->first_, it->second_));
+    }
+
+    /// Insert a pair by iterator. Return iterator to the value.
+    Iterator Insert(const ConstIterator& it) { return Insert(MakePair(it->first_, it->second_)); }
+
+    /// Insert a range by iterators.
+    void Insert(const ConstIterator& start, const ConstIterator& end)
+    {
+        for (ConstIterator it = start; it != end; ++it)
+            Insert(MakePair(it->first_, it->second_));
+    }
+
+    /// Erase a pair by key. Return true if was found.
+    bool Erase(const T& key)
+    {
+        unsigned index = FindSlot(key, MixHash(MakeHash(key)));
+        if (index == NO_SLOT)
+            return false;
+
+        EraseSlot(index);
+        return true;
+    }
+
+    /// Erase a pair by iterator. Return iterator to the next pair.
+    Iterator Erase(const Iterator& it)
+    {
+        if (!it.ctrl_ || it == End())
+            return End();
+
+        Iterator next = it;
+        ++next;
+        EraseSlot((unsigned)(it.ctrl_ - ctrl_));
+        return next;
+    }
+
+    /// Clear the map. Keeps the allocated slots.
+    void Clear()
+    {
+        if (!size_)
+            return;
+
+        DestructPairs();
+        size_ = 0;
+        ResetControl();
+    }
+
+    /// Reserve slots for at least the number of pairs, so that inserting up to it does not reallocate.
+    void Reserve(unsigned numPairs)
+    {
+        if (numPairs > MaxSize(capacity_))
+            Resize(CapacityForSize(numPairs));
+    }
+
+    /// Return iterator to the pair with key, or end iterator if not found.
+    Iterator Find(const T& key)
+    {
+        unsigned index = FindSlot(key, MixHash(MakeHash(key)));
+        return index != NO_SLOT ? Iterator(ctrl_ + index, Slots() + index) : End();
+    }
+
+    /// Return const iterator to the pair with key, or end iterator if not found.
+    ConstIterator Find(const T& key) const
+    {
+        unsigned index = FindSlot(key, MixHash(MakeHash(key)));
+        return index != NO_SLOT ? ConstIterator(ctrl_ + index, Slots() + index) : End();
+    }
+
+    /// Return whether contains a pair with key.
+    bool Contains(const T& key) const { return FindSlot(key, MixHash(MakeHash(key))) != NO_SLOT; }
+
+    /// Try to copy value to output. Return true if was found.
+    bool TryGetValue(const T& key, U& out) const
+    {
+        unsigned index = FindSlot(key, MixHash(MakeHash(key)));
+        if (index == NO_SLOT)
+            return false;
+
+        out = Slots()[index].second_;
+        return true;
+    }
+
+    /// Return all the keys.
+    Vector<T> Keys() const
+    {
+        Vector<T> result;
+        result.Reserve(Size());
+        for (ConstIterator i = Begin(); i != End(); ++i)
+            result.Push(i->first_);
+        return result;
+    }
+
+    /// Return all the values.
+    Vector<U> Values() const
+    {
+        Vector<U> result;
+        result.Reserve(Size());
+        for (ConstIterator i = Begin(); i != End(); ++i)
+            result.Push(i->second_);
+        return result;
+    }
+
+    /// Return iterator to the beginning.
+    Iterator Begin()
+    {
+        if (!ctrl_)
+            return Iterator();
+        const signed char* first = SkipFree(ctrl_);
+        return Iterator(first, Slots() + (first - ctrl_));
+    }
+
+    /// Return iterator to the beginning.
+    ConstIterator Begin() const
+    {
+        if (!ctrl_)
+            return ConstIterator();
+        const signed char* first = SkipFree(ctrl_);
+        return ConstIterator(first, Slots() + (first - ctrl_));
+    }
+
+    /// Return iterator to the end.
+    Iterator End() { return ctrl_ ? Iterator(ctrl_ + capacity_, Slots() + capacity_) : Iterator(); }
+
+    /// Return iterator to the end.
+    ConstIterator End() const { return ctrl_ ? ConstIterator(ctrl_ + capacity_, Slots() + capacity_) : ConstIterator(); }
+
+    /// Return first pair in iteration order.
+    const KeyValue& Front() const { return *Begin(); }
+
+private:
+    /// Return the slots.
+    KeyValue* Slots() const { return static_cast<KeyValue*>(slots_); }
+
+    /// Find the slot of a key with mixed hash. Return NO_SLOT if not found.
+    unsigned FindSlot(const T& key, unsigned hash) const
+    {
+        if (!ctrl_)
+            return NO_SLOT;
+
+        signed char control = HashControl(hash);
+        unsigned position = HashPosition(hash);
+        unsigned step = 0;
+        for (;;)
+        {
+            const signed char* group = ctrl_ + position;
+            for (unsigned mask = MatchGroup(group, control); mask; mask &= mask - 1)
+            {
+                unsigned index = (position + LowestBit(mask)) & capacity_;
+                if (Slots()[index].first_ == key)
+                    return index;
+            }
+            // An empty slot ends the probe sequence, as the key would have been inserted there
+            if (MatchGroup(group, CTRL_EMPTY))
+                return NO_SLOT;
+            step += GROUP_WIDTH;
+            position = (position + step) & capacity_;
+        }
+    }
+
+    /// Claim a slot for a new key with mixed hash, growing the table if necessary. The pair must be constructed in the slot.
+    unsigned InsertSlot(unsigned hash)
+    {
+        unsigned index = PrepareInsert(hash);
+        if (index == NO_SLOT)
+        {
+            Resize(GrowCapacity());
+            index = PrepareInsert(hash);
+        }
+        return index;
+    }
+
+    /// Destruct and erase the pair in a slot.
+    void EraseSlot(unsigned index)
+    {
+        (Slots() + index)->~KeyValue();
+        EraseControl(index);
+    }
+
+    /// Reallocate to a new capacity and move the pairs.
+    void Resize(unsigned capacity)
+    {
+        signed char* oldCtrl = ctrl_;
+        KeyValue* oldSlots = Slots();
+        unsigned oldCapacity = capacity_;
+
+        AllocateTable(capacity, (unsigned)sizeof(KeyValue));
+
+        for (unsigned i = 0; i < oldCapacity; ++i)
+        {
+            if (oldCtrl[i] >= 0)
+            {
+                unsigned hash = MixHash(MakeHash(oldSlots[i].first_));
+                unsigned index = FindFreeSlot(hash);
+                SetControl(index, HashControl(hash));
+                new(Slots() + index) KeyValue(oldSlots[i]);
+                (oldSlots + i)->~KeyValue();
+            }
+        }
+
+        if (oldCtrl)
+            FreeTable(oldCtrl, oldSlots);
+    }
+
+    /// Destruct all pairs without resetting the control bytes.
+    void DestructPairs()
+    {
+        for (unsigned i = 0; i < capacity_ && size_; ++i)
+        {
+            if (ctrl_[i] >= 0)
+                (Slots() + i)->~KeyValue();
+        }
+    }
+};
+
+template <class T, class U> typename Urho3D::FlatHashMap<T, U>::ConstIterator begin(const Urho3D::FlatHashMap<T, U>& v) { return v.Begin(); }
+
+template <class T, class U> typename Urho3D::FlatHashMap<T, U>::ConstIterator end(const Urho3D::FlatHashMap<T, U>& v) { return v.End(); }
+
+template <class T, class U> typename Urho3D::FlatHashMap<T, U>::Iterator begin(Urho3D::FlatHashMap<T, U>& v) { return v.Begin(); }
+
+template <class T, class U> typename Urho3D::FlatHashMap<T, U>::Iterator end(Urho3D::FlatHashMap<T, U>& v) { return v.End(); }
+
+}
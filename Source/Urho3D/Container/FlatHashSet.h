@@ -0,0 +1,373 @@
+//
+// Copyright (c) 2008-2020 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../Container/FlatHashBase.h"
+#include "../Container/Vector.h"
+
+#include <initializer_list>
+#include <new>
+
+namespace Urho3D
+{
+
+/// Open-addressing hash set template class. Stores the keys in a flat array, so lookups do not chase node pointers. Has the same interface as HashSet, except that iteration order is unspecified and iterators are forward only. Inserting may invalidate iterators, erasing invalidates only those of the erased key.
+template <class T> class FlatHashSet : public FlatHashBase
+{
+public:
+    /// Flat hash set iterator.
+    struct Iterator : public FlatHashIteratorBase
+    {
+        /// Construct.
+        Iterator() :
+            ptr_(nullptr)
+        {
+        }
+
+        /// Construct with a control byte and slot pointer.
+        Iterator(const signed char* ctrl, const T* ptr) :
+            FlatHashIteratorBase(ctrl),
+            ptr_(ptr)
+        {
+        }
+
+        /// Preincrement the pointer.
+        Iterator& operator ++()
+        {
+            GotoNext();
+            return *this;
+        }
+
+        /// Postincrement the pointer.
+        Iterator operator ++(int)
+        {
+            Iterator it = *this;
+            GotoNext();
+            return it;
+        }
+
+        /// Point to the key.
+        const T* operator ->() const { return ptr_; }
+
+        /// Dereference the key.
+        const T& operator *() const { return *ptr_; }
+
+        /// Go to the next used slot.
+        void GotoNext()
+        {
+            const signed char* next = SkipFree(ctrl_ + 1);
+            ptr_ += next - ctrl_;
+            ctrl_ = next;
+        }
+
+        /// Slot pointer.
+        const T* ptr_;
+    };
+
+    /// Flat hash set const iterator. Keys can not be modified, so this is the same as the non-const iterator.
+    using ConstIterator = Iterator;
+
+    /// Construct empty.
+    FlatHashSet() = default;
+
+    /// Construct from another flat hash set.
+    FlatHashSet(const FlatHashSet<T>& set)
+    {
+        Reserve(set.Size());
+        Insert(set);
+    }
+
+    /// Move-construct from another flat hash set.
+    FlatHashSet(FlatHashSet<T> && set) noexcept
+    {
+        Swap(set);
+    }
+
+    /// Aggregate initialization constructor.
+    FlatHashSet(const std::initializer_list<T>& list)
+    {
+        Reserve((unsigned)list.size());
+        for (auto it = list.begin(); it != list.end(); it++)
+        {
+            Insert(*it);
+        }
+    }
+
+    /// Destruct.
+    ~FlatHashSet()
+    {
+        if (ctrl_)
+        {
+            DestructKeys();
+            FreeTable(ctrl_, slots_);
+        }
+    }
+
+    /// Assign a flat hash set.
+    FlatHashSet& operator =(const FlatHashSet<T>& rhs)
+    {
+        // In case of self-assignment do nothing
+        if (&rhs != this)
+        {
+            Clear();
+            Insert(rhs);
+        }
+        return *this;
+    }
+
+    /// Move-assign a flat hash set.
+    FlatHashSet& operator =(FlatHashSet<T> && rhs) noexcept
+    {
+        Swap(rhs);
+        return *this;
+    }
+
+    /// Add-assign a value.
+    FlatHashSet& operator +=(const T& rhs)
+    {
+        Insert(rhs);
+        return *this;
+    }
+
+    /// Add-assign a flat hash set.
+    FlatHashSet& operator +=(const FlatHashSet<T>& rhs)
+    {
+        Insert(rhs);
+        return *this;
+    }
+
+    /// Test for equality with another flat hash set.
+    bool operator ==(const FlatHashSet<T>& rhs) const
+    {
+        if (rhs.Size() != Size())
+            return false;
+
+        for (ConstIterator i = Begin(); i != End(); ++i)
+        {
+            if (!rhs.Contains(*i))
+                return false;
+        }
+
+        return true;
+    }
+
+    /// Test for inequality with another flat hash set.
+    bool operator !=(const FlatHashSet<T>& rhs) const { return !(*this == rhs); }
+
+    /// Insert a key. Return an iterator to it.
+    Iterator Insert(const T& key)
+    {
+        bool exists;
+        return Insert(key, exists);
+    }
+
+    /// Insert a key. Return an iterator and set exists flag according to whether the key already existed.
+    Iterator Insert(const T& key, bool& exists)
+    {
+        unsigned hash = MixHash(MakeHash(key));
+        unsigned index = FindSlot(key, hash);
+        exists = index != NO_SLOT;
+        if (!exists)
+        {
+            index = InsertSlot(hash);
+            new(Slots() + index) T(key);
+        }
+        return Iterator(ctrl_ + index, Slots() + index);
+    }
+
+    /// Insert a set.
+    void Insert(const FlatHashSet<T>& set)
+    {
+        for (ConstIterator it = set.Begin(); it != set.End(); ++it)
+            Insert(*it);
+    }
+
+    /// Insert a key by iterator. Return iterator to the value.
+    Iterator Insert(const ConstIterator& it) { return Insert(*it); }
+
+    /// Erase a key. Return true if was found.
+    bool Erase(const T& key)
+    {
+        unsigned index = FindSlot(key, MixHash(MakeHash(key)));
+        if (index == NO_SLOT)
+            return false;
+
+        EraseSlot(index);
+        return true;
+    }
+
+    /// Erase a key by iterator. Return iterator to the next key.
+    Iterator Erase(const Iterator& it)
+    {
+        if (!it.ctrl_ || it == End())
+            return End();
+
+        Iterator next = it;
+        ++next;
+        EraseSlot((unsigned)(it.ctrl_ - ctrl_));
+        return next;
+    }
+
+    /// Clear the set. Keeps the allocated slots.
+    void Clear()
+    {
+        if (!size_)
+            return;
+
+        DestructKeys();
+        size_ = 0;
+        ResetControl();
+    }
+
+    /// Reserve slots for at least the number of keys, so that inserting up to it does not reallocate.
+    void Reserve(unsigned numKeys)
+    {
+        if (numKeys > MaxSize(capacity_))
+            Resize(CapacityForSize(numKeys));
+    }
+
+    /// Return iterator to the key, or end iterator if not found.
+    Iterator Find(const T& key) const
+    {
+        unsigned index = FindSlot(key, MixHash(MakeHash(key)));
+        return index != NO_SLOT ? Iterator(ctrl_ + index, Slots() + index) : End();
+    }
+
+    /// Return whether contains a key.
+    bool Contains(const T& key) const { return FindSlot(key, MixHash(MakeHash(key))) != NO_SLOT; }
+
+    /// Return all the keys.
+    Vector<T> Keys() const
+    {
+        Vector<T> result;
+        result.Reserve(Size());
+        for (ConstIterator i = Begin(); i != End(); ++i)
+            result.Push(*i);
+        return result;
+    }
+
+    /// Return iterator to the beginning.
+    Iterator Begin() const
+    {
+        if (!ctrl_)
+            return Iterator();
+        const signed char* first = SkipFree(ctrl_);
+        return Iterator(first, Slots() + (first - ctrl_));
+    }
+
+    /// Return iterator to the end.
+    Iterator End() const { return ctrl_ ? Iterator(ctrl_ + capacity_, Slots() + capacity_) : Iterator(); }
+
+    /// Return first key in iteration order.
+    const T& Front() const { return *Begin(); }
+
+private:
+    /// Return the slots.
+    T* Slots() const { return static_cast<T*>(slots_); }
+
+    /// Find the slot of a key with mixed hash. Return NO_SLOT if not found.
+    unsigned FindSlot(const T& key, unsigned hash) const
+    {
+        if (!ctrl_)
+            return NO_SLOT;
+
+        signed char control = HashControl(hash);
+        unsigned position = HashPosition(hash);
+        unsigned step = 0;
+        for (;;)
+        {
+            const signed char* group = ctrl_ + position;
+            for (unsigned mask = MatchGroup(group, control); mask; mask &= mask - 1)
+            {
+                unsigned index = (position + LowestBit(mask)) & capacity_;
+                if (Slots()[index] == key)
+                    return index;
+            }
+            // An empty slot ends the probe sequence, as the key would have been inserted there
+            if (MatchGroup(group, CTRL_EMPTY))
+                return NO_SLOT;
+            step += GROUP_WIDTH;
+            position = (position + step) & capacity_;
+        }
+    }
+
+    /// Claim a slot for a new key with mixed hash, growing the table if necessary. The key must be constructed in the slot.
+    unsigned InsertSlot(unsigned hash)
+    {
+        unsigned index = PrepareInsert(hash);
+        if (index == NO_SLOT)
+        {
+            Resize(GrowCapacity());
+            index = PrepareInsert(hash);
+        }
+        return index;
+    }
+
+    /// Destruct and erase the key in a slot.
+    void EraseSlot(unsigned index)
+    {
+        (Slots() + index)->~T();
+        EraseControl(index);
+    }
+
+    /// Reallocate to a new capacity and move the keys.
+    void Resize(unsigned capacity)
+    {
+        signed char* oldCtrl = ctrl_;
+        T* oldSlots = Slots();
+        unsigned oldCapacity = capacity_;
+
+        AllocateTable(capacity, (unsigned)sizeof(T));
+
+        for (unsigned i = 0; i < oldCapacity; ++i)
+        {
+            if (oldCtrl[i] >= 0)
+            {
+                unsigned hash = MixHash(MakeHash(oldSlots[i]));
+                unsigned index = FindFreeSlot(hash);
+                SetControl(index, HashControl(hash));
+                new(Slots() + index) T(oldSlots[i]);
+                (oldSlots + i)->~T();
+            }
+        }
+
+        if (oldCtrl)
+            FreeTable(oldCtrl, oldSlots);
+    }
+
+    /// Destruct all keys without resetting the control bytes.
+    void DestructKeys()
+    {
+        for (unsigned i = 0; i < capacity_ && size_; ++i)
+        {
+            if (ctrl_[i] >= 0)
+                (Slots() + i)->~T();
+        }
+    }
+};
+
+template <class T> typename Urho3D::FlatHashSet<T>::ConstIterator begin(const Urho3D::FlatHashSet<T>& v) { return v.Begin(); }
+
+template <class T> typename Urho3D::FlatHashSet<T>::ConstIterator end(const Urho3D::FlatHashSet<T>& v) { return v.End(); }
+
+}
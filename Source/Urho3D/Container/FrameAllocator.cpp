@@ -0,0 +1,115 @@
+//
+// Copyright (c) 2008-2020 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Precompiled.h"
+
+#include "../Container/FrameAllocator.h"
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+FrameAllocator::FrameAllocator(unsigned initialCapacity) :
+    block_(nullptr),
+    current_(nullptr),
+    end_(nullptr),
+    previousUsedBytes_(0),
+    capacity_(0)
+{
+    if (initialCapacity)
+        CreateBlock(initialCapacity);
+}
+
+FrameAllocator::~FrameAllocator()
+{
+    while (block_)
+    {
+        Block* previous = block_->previous_;
+        delete[] reinterpret_cast<unsigned char*>(block_);
+        block_ = previous;
+    }
+}
+
+void FrameAllocator::Reset()
+{
+    if (block_ && block_->previous_)
+    {
+        // Several blocks were needed during the frame: replace them with one block that fits all
+        unsigned totalCapacity = capacity_;
+        while (block_)
+        {
+            Block* previous = block_->previous_;
+            delete[] reinterpret_cast<unsigned char*>(block_);
+            block_ = previous;
+        }
+        capacity_ = 0;
+        CreateBlock(totalCapacity);
+    }
+    else if (block_)
+        current_ = reinterpret_cast<unsigned char*>(block_ + 1);
+
+    previousUsedBytes_ = 0;
+}
+
+unsigned FrameAllocator::GetUsedBytes() const
+{
+    if (!block_)
+        return 0;
+
+    return previousUsedBytes_ + (unsigned)(current_ - reinterpret_cast<unsigned char*>(block_ + 1));
+}
+
+unsigned FrameAllocator::GetNumBlocks() const
+{
+    unsigned numBlocks = 0;
+    for (Block* block = block_; block; block = block->previous_)
+        ++numBlocks;
+    return numBlocks;
+}
+
+void* FrameAllocator::AllocateBlock(unsigned size, unsigned alignment)
+{
+    if (block_)
+        previousUsedBytes_ += (unsigned)(current_ - reinterpret_cast<unsigned char*>(block_ + 1));
+
+    // Grow geometrically so that a frame needs only few blocks. Reserve room for aligning the first allocation
+    unsigned blockSize = capacity_ > size + alignment ? capacity_ : size + alignment;
+    CreateBlock(blockSize);
+
+    auto* ptr = reinterpret_cast<unsigned char*>((reinterpret_cast<size_t>(current_) + alignment - 1) & ~(size_t)(alignment - 1));
+    current_ = ptr + size;
+    return ptr;
+}
+
+void FrameAllocator::CreateBlock(unsigned size)
+{
+    auto* block = reinterpret_cast<Block*>(new unsigned char[sizeof(Block) + size]);
+    block->previous_ = block_;
+    block->size_ = size;
+    block_ = block;
+    current_ = reinterpret_cast<unsigned char*>(block + 1);
+    end_ = current_ + size;
+    capacity_ += size;
+}
+
+}
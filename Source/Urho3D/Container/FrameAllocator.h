@@ -0,0 +1,290 @@
+//
+// Copyright (c) 2008-2020 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#ifdef URHO3D_IS_BUILDING
+#include "Urho3D.h"
+#else
+#include <Urho3D/Urho3D.h>
+#endif
+
+#include "../Base/Iter.h"
+
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+
+namespace Urho3D
+{
+
+/// Default initial capacity of a frame allocator in bytes.
+static const unsigned DEFAULT_FRAME_ALLOCATOR_SIZE = 256 * 1024;
+
+/// Linear allocator for scratch memory that only needs to live until the end of the frame. Allocating bumps a pointer, and all memory is reclaimed at once on reset. Not thread-safe; each thread should use its own allocator.
+class URHO3D_API FrameAllocator
+{
+public:
+    /// Construct with initial capacity in bytes.
+    explicit FrameAllocator(unsigned initialCapacity = DEFAULT_FRAME_ALLOCATOR_SIZE);
+    /// Destruct. Free all memory blocks.
+    ~FrameAllocator();
+
+    /// Prevent copy construction.
+    FrameAllocator(const FrameAllocator& rhs) = delete;
+    /// Prevent assignment.
+    FrameAllocator& operator =(const FrameAllocator& rhs) = delete;
+
+    /// Allocate memory with alignment, which must be a power of two. Allocates a new block if the current one is exhausted.
+    void* Allocate(unsigned size, unsigned alignment = sizeof(void*))
+    {
+        // With no block there is no pointer to align. Compare as integers so that an exhausted block does not form a pointer
+        // past its end
+        if (!current_)
+            return AllocateBlock(size, alignment);
+
+        size_t aligned = (reinterpret_cast<size_t>(current_) + alignment - 1) & ~(size_t)(alignment - 1);
+        if (aligned + size > reinterpret_cast<size_t>(end_))
+            return AllocateBlock(size, alignment);
+
+        current_ = reinterpret_cast<unsigned char*>(aligned + size);
+        return reinterpret_cast<void*>(aligned);
+    }
+
+    /// Allocate uninitialized memory for an array of objects.
+    template <class T> T* Allocate(unsigned count) { return static_cast<T*>(Allocate((unsigned)(count * sizeof(T)), alignof(T))); }
+
+    /// Reclaim all allocated memory. If more than one block was needed, replace them with a single block large enough to hold everything.
+    void Reset();
+
+    /// Return number of bytes allocated since the last reset.
+    unsigned GetUsedBytes() const;
+    /// Return total capacity of the memory blocks in bytes.
+    unsigned GetCapacity() const { return capacity_; }
+    /// Return number of memory blocks.
+    unsigned GetNumBlocks() const;
+
+private:
+    /// Memory block header. Data follows.
+    struct Block
+    {
+        /// Previous block.
+        Block* previous_;
+        /// Data size in bytes.
+        unsigned size_;
+    };
+
+    /// Allocate a new block and allocate from it.
+    void* AllocateBlock(unsigned size, unsigned alignment);
+    /// Create a new block with the data size and make it current.
+    void CreateBlock(unsigned size);
+
+    /// Current block.
+    Block* block_;
+    /// Next free byte in the current block.
+    unsigned char* current_;
+    /// End of the current block.
+    unsigned char* end_;
+    /// Bytes allocated from previous blocks since the last reset.
+    unsigned previousUsedBytes_;
+    /// Total capacity of all blocks in bytes.
+    unsigned capacity_;
+};
+
+/// STL-compatible allocator that allocates from a frame allocator. Deallocation is a no-op.
+template <class T> class FrameStlAllocator
+{
+public:
+    using value_type = T;
+
+    /// Construct with frame allocator.
+    explicit FrameStlAllocator(FrameAllocator& allocator) noexcept :
+        allocator_(&allocator)
+    {
+    }
+
+    /// Construct from an allocator of another type.
+    template <class U> FrameStlAllocator(const FrameStlAllocator<U>& rhs) noexcept :    // NOLINT(google-explicit-constructor)
+        allocator_(rhs.GetAllocator())
+    {
+    }
+
+    /// Allocate memory for objects.
+    T* allocate(std::size_t n) { return allocator_->Allocate<T>((unsigned)n); }
+
+    /// Deallocate memory. Does nothing, as the memory is reclaimed when the frame allocator is reset.
+    void deallocate(T* /*p*/, std::size_t /*n*/) noexcept { }
+
+    /// Return the frame allocator.
+    FrameAllocator* GetAllocator() const { return allocator_; }
+
+    /// Test for equality with another allocator.
+    template <class U> bool operator ==(const FrameStlAllocator<U>& rhs) const { return allocator_ == rhs.GetAllocator(); }
+
+    /// Test for inequality with another allocator.
+    template <class U> bool operator !=(const FrameStlAllocator<U>& rhs) const { return allocator_ != rhs.GetAllocator(); }
+
+private:
+    /// Frame allocator.
+    FrameAllocator* allocator_;
+};
+
+/// %Vector template class for POD types, which stores its elements in frame allocator memory. Supports the common operations of PODVector. When the capacity is exceeded, the elements are copied to a new allocation and the old memory is reclaimed only on the allocator reset. The vector must be cleared or rebound to an allocator after the allocator has been reset.
+template <class T> class FramePODVector
+{
+public:
+    using ValueType = T;
+    using Iterator = RandomAccessIterator<T>;
+    using ConstIterator = RandomAccessConstIterator<T>;
+
+    /// Construct empty without allocator.
+    FramePODVector() noexcept = default;
+
+    /// Construct empty with frame allocator.
+    explicit FramePODVector(FrameAllocator* allocator) noexcept :
+        allocator_(allocator)
+    {
+    }
+
+    /// Set the frame allocator and clear the vector without freeing memory. Should be called each frame before use, as the previous memory is no longer valid.
+    void SetAllocator(FrameAllocator* allocator)
+    {
+        allocator_ = allocator;
+        buffer_ = nullptr;
+        size_ = 0;
+        capacity_ = 0;
+    }
+
+    /// Add an element at the end.
+    void Push(const T& value)
+    {
+        if (size_ < capacity_)
+            buffer_[size_++] = value;
+        else
+        {
+            // Copy the value first, in case it is located in the old buffer
+            T valueCopy = value;
+            Resize(size_ + 1);
+            Back() = valueCopy;
+        }
+    }
+
+    /// Remove the last element.
+    void Pop()
+    {
+        if (size_)
+            --size_;
+    }
+
+    /// Resize the vector. New elements are left uninitialized.
+    void Resize(unsigned newSize)
+    {
+        if (newSize > capacity_)
+        {
+            unsigned newCapacity = capacity_ + (capacity_ + 1) / 2;
+            Reserve(newSize > newCapacity ? newSize : newCapacity);
+        }
+        size_ = newSize;
+    }
+
+    /// Set new capacity. Only grows the capacity.
+    void Reserve(unsigned newCapacity)
+    {
+        if (newCapacity <= capacity_)
+            return;
+
+        assert(allocator_);
+        T* newBuffer = allocator_->Allocate<T>(newCapacity);
+        if (size_)
+            memcpy(newBuffer, buffer_, size_ * sizeof(T));
+        buffer_ = newBuffer;
+        capacity_ = newCapacity;
+    }
+
+    /// Clear the vector, keeping the capacity.
+    void Clear() { size_ = 0; }
+
+    /// Return element at index.
+    T& operator [](unsigned index)
+    {
+        assert(index < size_);
+        return buffer_[index];
+    }
+
+    /// Return const element at index.
+    const T& operator [](unsigned index) const
+    {
+        assert(index < size_);
+        return buffer_[index];
+    }
+
+    /// Return element at index.
+    T& At(unsigned index) { return (*this)[index]; }
+    /// Return const element at index.
+    const T& At(unsigned index) const { return (*this)[index]; }
+    /// Return iterator to the beginning.
+    Iterator Begin() { return Iterator(buffer_); }
+    /// Return const iterator to the beginning.
+    ConstIterator Begin() const { return ConstIterator(buffer_); }
+    /// Return iterator to the end.
+    Iterator End() { return Iterator(buffer_ + size_); }
+    /// Return const iterator to the end.
+    ConstIterator End() const { return ConstIterator(buffer_ + size_); }
+    /// Return first element.
+    T& Front() { return (*this)[0]; }
+    /// Return const first element.
+    const T& Front() const { return (*this)[0]; }
+    /// Return last element.
+    T& Back() { return (*this)[size_ - 1]; }
+    /// Return const last element.
+    const T& Back() const { return (*this)[size_ - 1]; }
+    /// Return the buffer with right type.
+    T* Buffer() const { return buffer_; }
+    /// Return size of vector.
+    unsigned Size() const { return size_; }
+    /// Return capacity of vector.
+    unsigned Capacity() const { return capacity_; }
+    /// Return whether vector is empty.
+    bool Empty() const { return size_ == 0; }
+    /// Return the frame allocator.
+    FrameAllocator* GetAllocator() const { return allocator_; }
+
+private:
+    /// Frame allocator.
+    FrameAllocator* allocator_{};
+    /// Buffer.
+    T* buffer_{};
+    /// Size of vector.
+    unsigned size_{};
+    /// Buffer capacity.
+    unsigned capacity_{};
+};
+
+template <class T> typename Urho3D::FramePODVector<T>::ConstIterator begin(const Urho3D::FramePODVector<T>& v) { return v.Begin(); }
+
+template <class T> typename Urho3D::FramePODVector<T>::ConstIterator end(const Urho3D::FramePODVector<T>& v) { return v.End(); }
+
+template <class T> typename Urho3D::FramePODVector<T>::Iterator begin(Urho3D::FramePODVector<T>& v) { return v.Begin(); }
+
+template <class T> typename Urho3D::FramePODVector<T>::Iterator end(Urho3D::FramePODVector<T>& v) { return v.End(); }
+
+}
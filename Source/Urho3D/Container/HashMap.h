@@ -455,6 +455,18 @@ public:
         return Iterator(next);
     }
 
+    /// Allocate nodes from the thread-safe pool allocator instead of a free list owned by the map, so that nodes can be allocated and freed in any thread and free memory is shared between containers. Accessing the map from several threads still requires external synchronization. Has no effect unless the map is empty.
+    void SetThreadSafeAllocator()
+    {
+        if (!allocator_ || allocator_->threadSafe_ || Size())
+            return;
+
+        FreeNode(Tail());
+        AllocatorUninitialize(allocator_);
+        allocator_ = AllocatorInitializeThreadSafe((unsigned)sizeof(Node));
+        head_ = tail_ = ReserveNode();
+    }
+
     /// Clear the map.
     void Clear()
     {
@@ -342,6 +342,18 @@ public:
         return it;
     }
 
+    /// Allocate nodes from the thread-safe pool allocator instead of a free list owned by the list, so that nodes can be allocated and freed in any thread and free memory is shared between containers. Accessing the list from several threads still requires external synchronization. Has no effect unless the list is empty.
+    void SetThreadSafeAllocator()
+    {
+        if (!allocator_ || allocator_->threadSafe_ || Size())
+            return;
+
+        FreeNode(Tail());
+        AllocatorUninitialize(allocator_);
+        allocator_ = AllocatorInitializeThreadSafe((unsigned)sizeof(Node));
+        head_ = tail_ = ReserveNode();
+    }
+
     /// Clear the list.
     void Clear()
     {
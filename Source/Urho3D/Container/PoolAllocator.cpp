@@ -0,0 +1,428 @@
+//
+// Copyright (c) 2008-2020 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Precompiled.h"
+
+#include "../Container/PoolAllocator.h"
+
+#include <atomic>
+#include <mutex>
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+/// Number of memory pointers held by a magazine.
+static const unsigned MAGAZINE_SIZE = 64;
+/// Size of a memory slab which size class objects are carved from.
+static const unsigned SLAB_SIZE = 64 * 1024;
+
+/// Stack of free memory pointers of one size class.
+struct Magazine
+{
+    /// Next magazine in a depot list.
+    Magazine* next_;
+    /// Number of pointers.
+    unsigned count_;
+    /// Pointers.
+    void* rounds_[MAGAZINE_SIZE];
+};
+
+/// Global store of magazines and slab memory for one size class.
+struct DepotClass
+{
+    /// Lock.
+    std::mutex mutex_;
+    /// Magazines which contain free memory.
+    Magazine* full_{};
+    /// Empty magazines.
+    Magazine* empty_{};
+    /// Next unused byte of the current slab.
+    unsigned char* slabCurrent_{};
+    /// End of the current slab.
+    unsigned char* slabEnd_{};
+};
+
+class ThreadCache;
+
+/// Global depot of the pool allocator.
+struct Depot
+{
+    /// Size classes.
+    DepotClass classes_[POOL_ALLOCATOR_NUM_CLASSES];
+    /// Lock for the thread cache registry and the statistics of released caches.
+    std::mutex registryMutex_;
+    /// Lock for the orphan cache.
+    std::mutex orphanMutex_;
+    /// Registered thread caches.
+    ThreadCache* caches_{};
+    /// Cache used by threads whose own cache has already been released when exiting.
+    ThreadCache* orphanCache_{};
+    /// Statistics of released thread caches.
+    PoolAllocatorStats releasedStats_{};
+    /// Bytes reserved from the system.
+    std::atomic<long long> reservedBytes_{};
+};
+
+/// Return the depot. Never destroyed, so that memory can be freed during static destruction.
+static Depot& GetDepot()
+{
+    static auto* depot = new Depot();
+    return *depot;
+}
+
+/// Per-thread cache of magazines for each size class.
+class ThreadCache
+{
+public:
+    /// Construct and register to the depot.
+    ThreadCache()
+    {
+        Depot& depot = GetDepot();
+        std::lock_guard<std::mutex> lock(depot.registryMutex_);
+        next_ = depot.caches_;
+        depot.caches_ = this;
+    }
+
+    /// Return magazines to the depot and unregister.
+    ~ThreadCache()
+    {
+        Depot& depot = GetDepot();
+
+        for (unsigned i = 0; i < POOL_ALLOCATOR_NUM_CLASSES; ++i)
+        {
+            DepotClass& depotClass = depot.classes_[i];
+            std::lock_guard<std::mutex> lock(depotClass.mutex_);
+            ReturnMagazine(depotClass, loaded_[i]);
+            ReturnMagazine(depotClass, previous_[i]);
+        }
+
+        std::lock_guard<std::mutex> lock(depot.registryMutex_);
+        depot.releasedStats_.allocations_ += allocations_;
+        depot.releasedStats_.requestedBytes_ += requestedBytes_;
+        depot.releasedStats_.usedBytes_ += usedBytes_;
+        for (ThreadCache** cache = &depot.caches_; *cache; cache = &(*cache)->next_)
+        {
+            if (*cache == this)
+            {
+                *cache = next_;
+                break;
+            }
+        }
+    }
+
+    /// Reserve memory of a size class.
+    void* Reserve(unsigned sizeClass, unsigned size)
+    {
+        Magazine* magazine = loaded_[sizeClass];
+        if (!magazine || !magazine->count_)
+            magazine = Reload(sizeClass);
+
+        AddStats(1, size, (sizeClass + 1) * POOL_ALLOCATOR_GRANULARITY);
+        return magazine->rounds_[--magazine->count_];
+    }
+
+    /// Free memory of a size class.
+    void Free(void* ptr, unsigned sizeClass, unsigned size)
+    {
+        Magazine* magazine = loaded_[sizeClass];
+        if (!magazine || magazine->count_ == MAGAZINE_SIZE)
+            magazine = Unload(sizeClass);
+
+        AddStats(-1, -(long long)size, -(long long)((sizeClass + 1) * POOL_ALLOCATOR_GRANULARITY));
+        magazine->rounds_[magazine->count_++] = ptr;
+    }
+
+    /// Add to the statistics. Only the owning thread writes them, so no atomic read-modify-write is needed.
+    void AddStats(long long allocations, long long requestedBytes, long long usedBytes)
+    {
+        allocations_.store(allocations_.load(std::memory_order_relaxed) + allocations, std::memory_order_relaxed);
+        requestedBytes_.store(requestedBytes_.load(std::memory_order_relaxed) + requestedBytes, std::memory_order_relaxed);
+        usedBytes_.store(usedBytes_.load(std::memory_order_relaxed) + usedBytes, std::memory_order_relaxed);
+    }
+
+    /// Next registered cache.
+    ThreadCache* next_{};
+    /// Number of allocations made minus allocations freed in this thread.
+    std::atomic<long long> allocations_{};
+    /// Requested bytes allocated minus freed in this thread.
+    std::atomic<long long> requestedBytes_{};
+    /// Size class bytes allocated minus freed in this thread.
+    std::atomic<long long> usedBytes_{};
+
+private:
+    /// Make a magazine with free memory loaded when the loaded magazine is empty, and return it.
+    Magazine* Reload(unsigned sizeClass)
+    {
+        Magazine*& loaded = loaded_[sizeClass];
+        Magazine*& previous = previous_[sizeClass];
+
+        // If the previous magazine has memory, just exchange
+        if (previous && previous->count_)
+        {
+            Swap(loaded, previous);
+            return loaded;
+        }
+
+        // Otherwise return the previous magazine to the depot and get one with memory
+        DepotClass& depotClass = GetDepot().classes_[sizeClass];
+        std::lock_guard<std::mutex> lock(depotClass.mutex_);
+
+        ReturnMagazine(depotClass, previous);
+        previous = loaded;
+
+        Magazine* magazine = depotClass.full_;
+        if (magazine)
+            depotClass.full_ = magazine->next_;
+        else
+        {
+            magazine = TakeEmptyMagazine(depotClass);
+            FillFromSlab(depotClass, magazine, (sizeClass + 1) * POOL_ALLOCATOR_GRANULARITY);
+        }
+
+        loaded = magazine;
+        return loaded;
+    }
+
+    /// Make a magazine with room loaded when the loaded magazine is full, and return it.
+    Magazine* Unload(unsigned sizeClass)
+    {
+        Magazine*& loaded = loaded_[sizeClass];
+        Magazine*& previous = previous_[sizeClass];
+
+        // If the previous magazine has room, just exchange
+        if (previous && previous->count_ < MAGAZINE_SIZE)
+        {
+            Swap(loaded, previous);
+            return loaded;
+        }
+
+        // Otherwise return the previous magazine to the depot and get an empty one
+        DepotClass& depotClass = GetDepot().classes_[sizeClass];
+        std::lock_guard<std::mutex> lock(depotClass.mutex_);
+
+        ReturnMagazine(depotClass, previous);
+        previous = loaded;
+        loaded = TakeEmptyMagazine(depotClass);
+        return loaded;
+    }
+
+    /// Return a magazine to the depot list according to whether it has memory. The depot class must be locked.
+    static void ReturnMagazine(DepotClass& depotClass, Magazine* magazine)
+    {
+        if (!magazine)
+            return;
+
+        Magazine*& list = magazine->count_ ? depotClass.full_ : depotClass.empty_;
+        magazine->next_ = list;
+        list = magazine;
+    }
+
+    /// Take an empty magazine from the depot, or allocate a new one. The depot class must be locked.
+    static Magazine* TakeEmptyMagazine(DepotClass& depotClass)
+    {
+        Magazine* magazine = depotClass.empty_;
+        if (magazine)
+            depotClass.empty_ = magazine->next_;
+        else
+        {
+            magazine = new Magazine();
+            GetDepot().reservedBytes_ += sizeof(Magazine);
+        }
+
+        magazine->next_ = nullptr;
+        magazine->count_ = 0;
+        return magazine;
+    }
+
+    /// Fill an empty magazine with memory carved from the current slab, or a new slab if exhausted. The depot class must be locked.
+    static void FillFromSlab(DepotClass& depotClass, Magazine* magazine, unsigned objectSize)
+    {
+        if (depotClass.slabCurrent_ + objectSize > depotClass.slabEnd_)
+        {
+            // Slabs are never freed, like the blocks of the single-threaded allocator while it is in use
+            depotClass.slabCurrent_ = new unsigned char[SLAB_SIZE];
+            depotClass.slabEnd_ = depotClass.slabCurrent_ + SLAB_SIZE;
+            GetDepot().reservedBytes_ += SLAB_SIZE;
+        }
+
+        while (magazine->count_ < MAGAZINE_SIZE && depotClass.slabCurrent_ + objectSize <= depotClass.slabEnd_)
+        {
+            magazine->rounds_[magazine->count_++] = depotClass.slabCurrent_;
+            depotClass.slabCurrent_ += objectSize;
+        }
+    }
+
+    /// Swap two magazine pointers.
+    static void Swap(Magazine*& first, Magazine*& second)
+    {
+        Magazine* temp = first;
+        first = second;
+        second = temp;
+    }
+
+    /// Magazines in use for each size class.
+    Magazine* loaded_[POOL_ALLOCATOR_NUM_CLASSES]{};
+    /// Previously used magazines for each size class. Allows switching between allocation and freeing without going to the depot.
+    Magazine* previous_[POOL_ALLOCATOR_NUM_CLASSES]{};
+};
+
+/// Holder which releases the thread cache when the thread exits.
+struct ThreadCacheHolder
+{
+    /// Destruct. Release the cache.
+    ~ThreadCacheHolder();
+
+    /// Thread cache.
+    ThreadCache* cache_{};
+};
+
+/// Thread cache of the calling thread. Trivially destructible, so it remains accessible after the holder has been destroyed.
+static thread_local ThreadCache* currentCache = nullptr;
+/// Whether the thread cache of the calling thread has been released.
+static thread_local bool cacheReleased = false;
+/// Holder of the thread cache of the calling thread.
+static thread_local ThreadCacheHolder cacheHolder;
+
+ThreadCacheHolder::~ThreadCacheHolder()
+{
+    delete cache_;
+    currentCache = nullptr;
+    cacheReleased = true;
+}
+
+/// Return the cache of the calling thread, or null if it has been released when the thread is exiting.
+static ThreadCache* GetThreadCache()
+{
+    if (!currentCache && !cacheReleased)
+    {
+        currentCache = new ThreadCache();
+        cacheHolder.cache_ = currentCache;
+    }
+
+    return currentCache;
+}
+
+/// Reserve memory too large for the size classes from the system.
+static void* ReserveLarge(ThreadCache& cache, unsigned size)
+{
+    cache.AddStats(1, size, size);
+    GetDepot().reservedBytes_ += size;
+    return new unsigned char[size];
+}
+
+/// Free memory too large for the size classes to the system.
+static void FreeLarge(ThreadCache& cache, void* ptr, unsigned size)
+{
+    cache.AddStats(-1, -(long long)size, -(long long)size);
+    GetDepot().reservedBytes_ -= size;
+    delete[] static_cast<unsigned char*>(ptr);
+}
+
+/// Return the shared cache for exiting threads. The orphan lock must be held.
+static ThreadCache& GetOrphanCache()
+{
+    Depot& depot = GetDepot();
+    if (!depot.orphanCache_)
+        depot.orphanCache_ = new ThreadCache();
+    return *depot.orphanCache_;
+}
+
+/// Reserve memory using the shared cache, when the thread's own cache has been released.
+static void* ReserveOrphan(unsigned size)
+{
+    std::lock_guard<std::mutex> lock(GetDepot().orphanMutex_);
+    ThreadCache& cache = GetOrphanCache();
+
+    unsigned sizeClass = (size - 1) / POOL_ALLOCATOR_GRANULARITY;
+    return sizeClass < POOL_ALLOCATOR_NUM_CLASSES ? cache.Reserve(sizeClass, size) : ReserveLarge(cache, size);
+}
+
+/// Free memory using the shared cache, when the thread's own cache has been released.
+static void FreeOrphan(void* ptr, unsigned size)
+{
+    std::lock_guard<std::mutex> lock(GetDepot().orphanMutex_);
+    ThreadCache& cache = GetOrphanCache();
+
+    unsigned sizeClass = (size - 1) / POOL_ALLOCATOR_GRANULARITY;
+    if (sizeClass < POOL_ALLOCATOR_NUM_CLASSES)
+        cache.Free(ptr, sizeClass, size);
+    else
+        FreeLarge(cache, ptr, size);
+}
+
+void* PoolAllocatorReserve(unsigned size)
+{
+    if (!size)
+        size = 1;
+
+    ThreadCache* cache = GetThreadCache();
+    if (!cache)
+        return ReserveOrphan(size);
+
+    unsigned sizeClass = (size - 1) / POOL_ALLOCATOR_GRANULARITY;
+    if (sizeClass < POOL_ALLOCATOR_NUM_CLASSES)
+        return cache->Reserve(sizeClass, size);
+    else
+        return ReserveLarge(*cache, size);
+}
+
+void PoolAllocatorFree(void* ptr, unsigned size)
+{
+    if (!ptr)
+        return;
+    if (!size)
+        size = 1;
+
+    ThreadCache* cache = GetThreadCache();
+    if (!cache)
+    {
+        FreeOrphan(ptr, size);
+        return;
+    }
+
+    unsigned sizeClass = (size - 1) / POOL_ALLOCATOR_GRANULARITY;
+    if (sizeClass < POOL_ALLOCATOR_NUM_CLASSES)
+        cache->Free(ptr, sizeClass, size);
+    else
+        FreeLarge(*cache, ptr, size);
+}
+
+PoolAllocatorStats GetPoolAllocatorStats()
+{
+    Depot& depot = GetDepot();
+    std::lock_guard<std::mutex> lock(depot.registryMutex_);
+
+    PoolAllocatorStats stats = depot.releasedStats_;
+    for (ThreadCache* cache = depot.caches_; cache; cache = cache->next_)
+    {
+        stats.allocations_ += cache->allocations_.load(std::memory_order_relaxed);
+        stats.requestedBytes_ += cache->requestedBytes_.load(std::memory_order_relaxed);
+        stats.usedBytes_ += cache->usedBytes_.load(std::memory_order_relaxed);
+    }
+    stats.reservedBytes_ = depot.reservedBytes_.load(std::memory_order_relaxed);
+
+    return stats;
+}
+
+}
@@ -0,0 +1,94 @@
+//
+// Copyright (c) 2008-2020 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#ifdef URHO3D_IS_BUILDING
+#include "Urho3D.h"
+#else
+#include <Urho3D/Urho3D.h>
+#endif
+
+#include <new>
+
+namespace Urho3D
+{
+
+/// Size granularity of the pool allocator size classes in bytes. Also the alignment of the allocated memory.
+static const unsigned POOL_ALLOCATOR_GRANULARITY = 16;
+/// Number of pool allocator size classes. Larger allocations are passed to the system allocator.
+static const unsigned POOL_ALLOCATOR_NUM_CLASSES = 32;
+
+/// %Pool allocator statistics.
+struct PoolAllocatorStats
+{
+    /// Return fraction of the reserved memory which does not hold requested data, due to size class rounding and cached free memory.
+    float GetFragmentation() const { return reservedBytes_ ? 1.0f - (float)requestedBytes_ / (float)reservedBytes_ : 0.0f; }
+
+    /// Number of allocations in use.
+    long long allocations_;
+    /// Bytes requested by the allocations in use.
+    long long requestedBytes_;
+    /// Bytes in use, rounded up to the size classes.
+    long long usedBytes_;
+    /// Bytes reserved from the system.
+    long long reservedBytes_;
+};
+
+/// Reserve memory from the thread-safe, size-classed pool allocator. Each thread caches free memory of each size class in magazines, which are exchanged with a global depot when exhausted or full, so that the common case needs no locking.
+URHO3D_API void* PoolAllocatorReserve(unsigned size);
+/// Free memory reserved from the pool allocator with the same size. May be called from any thread.
+URHO3D_API void PoolAllocatorFree(void* ptr, unsigned size);
+/// Return pool allocator statistics of all threads.
+URHO3D_API PoolAllocatorStats GetPoolAllocatorStats();
+
+/// %Pool allocator template class. Allocates objects of a specific class from the thread-safe pool allocator, so they can be allocated and freed in any thread.
+template <class T> class PoolAllocator
+{
+public:
+    /// Reserve and default-construct an object.
+    T* Reserve()
+    {
+        auto* newObject = static_cast<T*>(PoolAllocatorReserve((unsigned)sizeof(T)));
+        new(newObject) T();
+
+        return newObject;
+    }
+
+    /// Reserve and copy-construct an object.
+    T* Reserve(const T& object)
+    {
+        auto* newObject = static_cast<T*>(PoolAllocatorReserve((unsigned)sizeof(T)));
+        new(newObject) T(object);
+
+        return newObject;
+    }
+
+    /// Destruct and free an object.
+    void Free(T* object)
+    {
+        (object)->~T();
+        PoolAllocatorFree(object, (unsigned)sizeof(T));
+    }
+};
+
+}
@@ -25,11 +25,24 @@
 #include "../Container/Swap.h"
 #include "../Container/VectorBase.h"
 
+#include <cstring>
+
 namespace Urho3D
 {
 
 static const int QUICKSORT_THRESHOLD = 16;
 
+/// Value with a 128-bit sort key for radix sorting.
+template <class T> struct RadixSortItem
+{
+    /// Most significant half of the key.
+    unsigned long long highKey_;
+    /// Least significant half of the key.
+    unsigned long long lowKey_;
+    /// Value.
+    T value_;
+};
+
 // Based on Comparison of several sorting algorithms by Juha Nieminen
 // http://warp.povusers.org/SortComparison/
 
@@ -141,4 +154,61 @@ template <class T, class U> void Sort(RandomAccessIterator<T> begin, RandomAcces
     InsertionSort(begin, end, compare);
 }
 
+/// Perform a stable least significant digit radix sort by key, one byte per pass, using a scratch array of the same size. Bytes that are equal in all keys are skipped. The values must be trivially copyable.
+template <class T> void RadixSort(RadixSortItem<T>* items, RadixSortItem<T>* scratch, unsigned count)
+{
+    static const unsigned NUM_KEY_BYTES = 16;
+
+    if (count < 2)
+        return;
+
+    // Build the histograms of all key bytes in one pass
+    unsigned counts[NUM_KEY_BYTES][256];
+    memset(counts, 0, sizeof counts);
+    for (unsigned i = 0; i < count; ++i)
+    {
+        unsigned long long lowKey = items[i].lowKey_;
+        unsigned long long highKey = items[i].highKey_;
+        for (unsigned j = 0; j < 8; ++j)
+        {
+            ++counts[j][(lowKey >> (j * 8)) & 0xffu];
+            ++counts[j + 8][(highKey >> (j * 8)) & 0xffu];
+        }
+    }
+
+    RadixSortItem<T>* src = items;
+    RadixSortItem<T>* dest = scratch;
+
+    for (unsigned j = 0; j < NUM_KEY_BYTES; ++j)
+    {
+        unsigned* byteCounts = counts[j];
+        const unsigned long long& firstKey = j < 8 ? src[0].lowKey_ : src[0].highKey_;
+        const unsigned shift = (j & 7u) * 8;
+
+        // All keys share this byte, so the pass would not change the order
+        if (byteCounts[(firstKey >> shift) & 0xffu] == count)
+            continue;
+
+        // Convert the counts to starting offsets
+        unsigned offset = 0;
+        for (unsigned k = 0; k < 256; ++k)
+        {
+            unsigned bucketCount = byteCounts[k];
+            byteCounts[k] = offset;
+            offset += bucketCount;
+        }
+
+        for (unsigned i = 0; i < count; ++i)
+        {
+            unsigned long long key = j < 8 ? src[i].lowKey_ : src[i].highKey_;
+            dest[byteCounts[(key >> shift) & 0xffu]++] = src[i];
+        }
+
+        Swap(src, dest);
+    }
+
+    if (src != items)
+        memcpy(items, src, count * sizeof(RadixSortItem<T>));
+}
+
 }
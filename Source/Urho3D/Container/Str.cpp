@@ -40,17 +40,15 @@ char String::endZero = 0;
 const String String::EMPTY;
 
 String::String(const WString& str) :
-    length_(0),
-    capacity_(0),
-    buffer_(&endZero)
+    buffer_(&endZero),
+    length_(0)
 {
     SetUTF8FromWChar(str.CString());
 }
 
 String::String(int value) :
-    length_(0),
-    capacity_(0),
-    buffer_(&endZero)
+    buffer_(&endZero),
+    length_(0)
 {
     char tempBuffer[CONVERSION_BUFFER_LENGTH];
     sprintf(tempBuffer, "%d", value);
@@ -58,9 +56,8 @@ String::String(int value) :
 }
 
 String::String(short value) :
-    length_(0),
-    capacity_(0),
-    buffer_(&endZero)
+    buffer_(&endZero),
+    length_(0)
 {
     char tempBuffer[CONVERSION_BUFFER_LENGTH];
     sprintf(tempBuffer, "%d", value);
@@ -68,9 +65,8 @@ String::String(short value) :
 }
 
 String::String(long value) :
-    length_(0),
-    capacity_(0),
-    buffer_(&endZero)
+    buffer_(&endZero),
+    length_(0)
 {
     char tempBuffer[CONVERSION_BUFFER_LENGTH];
     sprintf(tempBuffer, "%ld", value);
@@ -78,9 +74,8 @@ String::String(long value) :
 }
 
 String::String(long long value) :
-    length_(0),
-    capacity_(0),
-    buffer_(&endZero)
+    buffer_(&endZero),
+    length_(0)
 {
     char tempBuffer[CONVERSION_BUFFER_LENGTH];
     sprintf(tempBuffer, "%lld", value);
@@ -88,9 +83,8 @@ String::String(long long value) :
 }
 
 String::String(unsigned value) :
-    length_(0),
-    capacity_(0),
-    buffer_(&endZero)
+    buffer_(&endZero),
+    length_(0)
 {
     char tempBuffer[CONVERSION_BUFFER_LENGTH];
     sprintf(tempBuffer, "%u", value);
@@ -98,9 +92,8 @@ String::String(unsigned value) :
 }
 
 String::String(unsigned short value) :
-    length_(0),
-    capacity_(0),
-    buffer_(&endZero)
+    buffer_(&endZero),
+    length_(0)
 {
     char tempBuffer[CONVERSION_BUFFER_LENGTH];
     sprintf(tempBuffer, "%u", value);
@@ -108,9 +101,8 @@ String::String(unsigned short value) :
 }
 
 String::String(unsigned long value) :
-    length_(0),
-    capacity_(0),
-    buffer_(&endZero)
+    buffer_(&endZero),
+    length_(0)
 {
     char tempBuffer[CONVERSION_BUFFER_LENGTH];
     sprintf(tempBuffer, "%lu", value);
@@ -118,9 +110,8 @@ String::String(unsigned long value) :
 }
 
 String::String(unsigned long long value) :
-    length_(0),
-    capacity_(0),
-    buffer_(&endZero)
+    buffer_(&endZero),
+    length_(0)
 {
     char tempBuffer[CONVERSION_BUFFER_LENGTH];
     sprintf(tempBuffer, "%llu", value);
@@ -128,9 +119,8 @@ String::String(unsigned long long value) :
 }
 
 String::String(float value) :
-    length_(0),
-    capacity_(0),
-    buffer_(&endZero)
+    buffer_(&endZero),
+    length_(0)
 {
     char tempBuffer[CONVERSION_BUFFER_LENGTH];
     sprintf(tempBuffer, "%g", value);
@@ -138,9 +128,8 @@ String::String(float value) :
 }
 
 String::String(double value) :
-    length_(0),
-    capacity_(0),
-    buffer_(&endZero)
+    buffer_(&endZero),
+    length_(0)
 {
     char tempBuffer[CONVERSION_BUFFER_LENGTH];
     sprintf(tempBuffer, "%.15g", value);
@@ -148,9 +137,8 @@ String::String(double value) :
 }
 
 String::String(bool value) :
-    length_(0),
-    capacity_(0),
-    buffer_(&endZero)
+    buffer_(&endZero),
+    length_(0)
 {
     if (value)
         *this = "true";
@@ -159,18 +147,16 @@ String::String(bool value) :
 }
 
 String::String(char value) :
-    length_(0),
-    capacity_(0),
-    buffer_(&endZero)
+    buffer_(&endZero),
+    length_(0)
 {
     Resize(1);
     buffer_[0] = value;
 }
 
 String::String(char value, unsigned length) :
-    length_(0),
-    capacity_(0),
-    buffer_(&endZero)
+    buffer_(&endZero),
+    length_(0)
 {
     Resize(length);
     for (unsigned i = 0; i < length; ++i)
@@ -417,34 +403,45 @@ String::Iterator String::Erase(const String::Iterator& start, const String::Iter
 
 void String::Resize(unsigned newLength)
 {
-    if (!capacity_)
+    // The shared empty buffer has no capacity and must never be written to
+    if (buffer_ == &endZero)
     {
-        // If zero length requested, do not allocate buffer yet
+        // If zero length requested, do not set up a buffer yet
         if (!newLength)
             return;
 
-        // Calculate initial capacity
-        capacity_ = newLength + 1;
-        if (capacity_ < MIN_CAPACITY)
-            capacity_ = MIN_CAPACITY;
+        if (newLength < INLINE_CAPACITY)
+            buffer_ = inlineBuffer_;
+        else
+        {
+            // Calculate initial capacity
+            unsigned capacity = newLength + 1;
+            if (capacity < MIN_CAPACITY)
+                capacity = MIN_CAPACITY;
 
-        buffer_ = new char[capacity_];
+            buffer_ = new char[capacity];
+            capacity_ = capacity;
+        }
     }
     else
     {
-        if (newLength && capacity_ < newLength + 1)
+        unsigned capacity = Capacity();
+        if (newLength && capacity < newLength + 1)
         {
             // Increase the capacity with half each time it is exceeded
-            while (capacity_ < newLength + 1)
-                capacity_ += (capacity_ + 1) >> 1u;
+            while (capacity < newLength + 1)
+                capacity += (capacity + 1) >> 1u;
 
-            auto* newBuffer = new char[capacity_];
+            auto* newBuffer = new char[capacity];
             // Move the existing data to the new buffer, then delete the old buffer
             if (length_)
                 CopyChars(newBuffer, buffer_, length_);
-            delete[] buffer_;
+            if (IsHeapBuffer())
+                delete[] buffer_;
 
+            // The capacity shares storage with the inline buffer, so set it only after the data has been moved
             buffer_ = newBuffer;
+            capacity_ = capacity;
         }
     }
 
@@ -456,22 +453,27 @@ void String::Reserve(unsigned newCapacity)
 {
     if (newCapacity < length_ + 1)
         newCapacity = length_ + 1;
-    if (newCapacity == capacity_)
+    if (newCapacity == Capacity())
+        return;
+
+    // Use the inline buffer if the string fits
+    char* newBuffer = newCapacity <= INLINE_CAPACITY ? inlineBuffer_ : new char[newCapacity];
+    if (newBuffer == buffer_)
         return;
 
-    auto* newBuffer = new char[newCapacity];
     // Move the existing data to the new buffer, then delete the old buffer
     CopyChars(newBuffer, buffer_, length_ + 1);
-    if (capacity_)
+    if (IsHeapBuffer())
         delete[] buffer_;
 
-    capacity_ = newCapacity;
     buffer_ = newBuffer;
+    if (IsHeapBuffer())
+        capacity_ = newCapacity;
 }
 
 void String::Compact()
 {
-    if (capacity_)
+    if (IsHeapBuffer())
         Reserve(length_ + 1);
 }
 
@@ -482,9 +484,21 @@ void String::Clear()
 
 void String::Swap(String& str)
 {
-    Urho3D::Swap(length_, str.length_);
-    Urho3D::Swap(capacity_, str.capacity_);
+    bool inlineThis = buffer_ == inlineBuffer_;
+    bool inlineOther = str.buffer_ == str.inlineBuffer_;
+
     Urho3D::Swap(buffer_, str.buffer_);
+    Urho3D::Swap(length_, str.length_);
+
+    // Swap the inline buffers, which also swaps the capacities of heap buffers, then point inline strings to their new owner
+    char temp[INLINE_CAPACITY];
+    memcpy(temp, inlineBuffer_, INLINE_CAPACITY);
+    memcpy(inlineBuffer_, str.inlineBuffer_, INLINE_CAPACITY);
+    memcpy(str.inlineBuffer_, temp, INLINE_CAPACITY);
+    if (inlineOther)
+        buffer_ = inlineBuffer_;
+    if (inlineThis)
+        str.buffer_ = str.inlineBuffer_;
 }
 
 String String::Substring(unsigned pos) const
@@ -51,53 +51,47 @@ public:
 
     /// Construct empty.
     String() noexcept :
-        length_(0),
-        capacity_(0),
-        buffer_(&endZero)
+        buffer_(&endZero),
+        length_(0)
     {
     }
 
     /// Construct from another string.
     String(const String& str) :
-        length_(0),
-        capacity_(0),
-        buffer_(&endZero)
+        buffer_(&endZero),
+        length_(0)
     {
         *this = str;
     }
 
     /// Move-construct from another string.
     String(String && str) noexcept :
-        length_(0),
-        capacity_(0),
-        buffer_(&endZero)
+        buffer_(&endZero),
+        length_(0)
     {
         Swap(str);
     }
 
     /// Construct from a C string.
     String(const char* str) :   // NOLINT(google-explicit-constructor)
-        length_(0),
-        capacity_(0),
-        buffer_(&endZero)
+        buffer_(&endZero),
+        length_(0)
     {
         *this = str;
     }
 
     /// Construct from a C string.
     String(char* str) :         // NOLINT(google-explicit-constructor)
-        length_(0),
-        capacity_(0),
-        buffer_(&endZero)
+        buffer_(&endZero),
+        length_(0)
     {
         *this = (const char*)str;
     }
 
     /// Construct from a char array and length.
     String(const char* str, unsigned length) :
-        length_(0),
-        capacity_(0),
-        buffer_(&endZero)
+        buffer_(&endZero),
+        length_(0)
     {
         Resize(length);
         CopyChars(buffer_, str, length);
@@ -105,18 +99,16 @@ public:
 
     /// Construct from a null-terminated wide character array.
     explicit String(const wchar_t* str) :
-        length_(0),
-        capacity_(0),
-        buffer_(&endZero)
+        buffer_(&endZero),
+        length_(0)
     {
         SetUTF8FromWChar(str);
     }
 
     /// Construct from a null-terminated wide character array.
     explicit String(wchar_t* str) :
-        length_(0),
-        capacity_(0),
-        buffer_(&endZero)
+        buffer_(&endZero),
+        length_(0)
     {
         SetUTF8FromWChar(str);
     }
@@ -155,9 +147,8 @@ public:
 
     /// Construct from a convertible value.
     template <class T> explicit String(const T& value) :
-        length_(0),
-        capacity_(0),
-        buffer_(&endZero)
+        buffer_(&endZero),
+        length_(0)
     {
         *this = value.ToString();
     }
@@ -165,7 +156,7 @@ public:
     /// Destruct.
     ~String()
     {
-        if (capacity_)
+        if (IsHeapBuffer())
             delete[] buffer_;
     }
 
@@ -432,7 +423,7 @@ public:
     unsigned Length() const { return length_; }
 
     /// Return buffer capacity.
-    unsigned Capacity() const { return capacity_; }
+    unsigned Capacity() const { return IsHeapBuffer() ? capacity_ : (buffer_ == inlineBuffer_ ? INLINE_CAPACITY : 0); }
 
     /// Return whether the string is empty.
     /// @property
@@ -516,6 +507,8 @@ public:
     static const unsigned NPOS = 0xffffffff;
     /// Initial dynamic allocation size.
     static const unsigned MIN_CAPACITY = 8;
+    /// Size of the inline buffer including the terminating zero. Keeps the string small enough to fit in a Variant as part of ResourceRef.
+    static const unsigned INLINE_CAPACITY = sizeof(void*) > 4 ? 12 : 4;
     /// Empty string.
     static const String EMPTY;
 
@@ -547,12 +540,20 @@ private:
     /// Replace a substring with another substring.
     void Replace(unsigned pos, unsigned length, const char* srcStart, unsigned srcLength);
 
+    /// Return whether the buffer is allocated from the heap.
+    bool IsHeapBuffer() const { return buffer_ != inlineBuffer_ && buffer_ != &endZero; }
+
+    /// String buffer, point to &endZero if buffer is not set up, or to the inline buffer for short strings.
+    char* buffer_;
     /// String length.
     unsigned length_;
-    /// Capacity, zero if buffer not allocated.
-    unsigned capacity_;
-    /// String buffer, point to &endZero if buffer is not allocated.
-    char* buffer_;
+    union
+    {
+        /// Capacity of a heap-allocated buffer.
+        unsigned capacity_;
+        /// Inline buffer for short strings, so that they need no heap allocation.
+        char inlineBuffer_[INLINE_CAPACITY];
+    };
 
     /// End zero for empty strings.
     static char endZero;
@@ -104,7 +104,7 @@ public:
     ~Vector()
     {
         DestructElements(Buffer(), size_);
-        delete[] buffer_;
+        FreeBuffer();
     }
 
     /// Assign from another vector.
@@ -126,6 +126,22 @@ public:
         return *this;
     }
 
+    /// Swap with another vector. Elements are moved one by one if either vector uses inline storage.
+    void Swap(Vector<T>& vector)
+    {
+        if (!IsInlineBuffer() && !vector.IsInlineBuffer())
+            VectorBase::Swap(vector);
+        else if (&vector != this)
+        {
+            Vector<T> temp;
+            temp.DoInsertElements(0, Begin(), End(), MoveTag{});
+            Clear();
+            DoInsertElements(0, vector.Begin(), vector.End(), MoveTag{});
+            vector.Clear();
+            vector.DoInsertElements(0, temp.Begin(), temp.End(), MoveTag{});
+        }
+    }
+
     /// Add-assign an element.
     Vector<T>& operator +=(const T& rhs)
     {
@@ -221,7 +237,7 @@ public:
     /// Create an element at the end.
     template <class... Args> T& EmplaceBack(Args&&... args)
     {
-        if (size_ < capacity_)
+        if (size_ < Capacity())
         {
             // Optimize common case
             ++size_;
@@ -239,7 +255,7 @@ public:
 #ifndef COVERITY_SCAN_MODEL
     void Push(const T& value)
     {
-        if (size_ < capacity_)
+        if (size_ < Capacity())
         {
             // Optimize common case
             ++size_;
@@ -252,7 +268,7 @@ public:
     /// Move-add an element at the end.
     void Push(T && value)
     {
-        if (size_ < capacity_)
+        if (size_ < Capacity())
         {
             // Optimize common case
             ++size_;
@@ -437,23 +453,26 @@ public:
     {
         if (newCapacity < size_)
             newCapacity = size_;
+        // Inline storage is never shrunk
+        if (IsInlineBuffer() && newCapacity <= Capacity())
+            return;
 
         if (newCapacity != capacity_)
         {
             T* newBuffer = nullptr;
-            capacity_ = newCapacity;
 
-            if (capacity_)
+            if (newCapacity)
             {
-                newBuffer = reinterpret_cast<T*>(AllocateBuffer((unsigned)(capacity_ * sizeof(T))));
+                newBuffer = reinterpret_cast<T*>(AllocateBuffer((unsigned)(newCapacity * sizeof(T))));
                 // Move the data into the new buffer
                 ConstructElements(newBuffer, Begin(), End(), MoveTag{});
             }
 
             // Delete the old buffer
             DestructElements(Buffer(), size_);
-            delete[] buffer_;
+            FreeBuffer();
             buffer_ = reinterpret_cast<unsigned char*>(newBuffer);
+            capacity_ = newCapacity;
         }
     }
 
@@ -531,7 +550,7 @@ public:
     unsigned Size() const { return size_; }
 
     /// Return capacity of vector.
-    unsigned Capacity() const { return capacity_; }
+    unsigned Capacity() const { return capacity_ & ~INLINE_BUFFER; }
 
     /// Return whether vector is empty.
     bool Empty() const { return size_ == 0; }
@@ -587,20 +606,20 @@ private:
         else
         {
             // Allocate new buffer if necessary and copy the current elements
-            if (newSize > capacity_)
+            if (newSize > Capacity())
             {
                 T* src = Buffer();
 
                 // Reallocate vector
                 Vector<T> newVector;
-                newVector.Reserve(CalculateCapacity(newSize, capacity_));
+                newVector.Reserve(CalculateCapacity(newSize, Capacity()));
                 newVector.size_ = size_;
                 T* dest = newVector.Buffer();
 
                 // Move old elements
                 ConstructElements(dest, src, src + size_, MoveTag{});
 
-                Swap(newVector);
+                VectorBase::Swap(newVector);
             }
 
             // Initialize the new elements
@@ -618,13 +637,13 @@ private:
             pos = size_;
 
         const auto numElements = (unsigned)(end - start);
-        if (size_ + numElements > capacity_)
+        if (size_ + numElements > Capacity())
         {
             T* src = Buffer();
 
             // Reallocate vector
             Vector<T> newVector;
-            newVector.Reserve(CalculateCapacity(size_ + numElements, capacity_));
+            newVector.Reserve(CalculateCapacity(size_ + numElements, Capacity()));
             newVector.size_ = size_ + numElements;
             T* dest = newVector.Buffer();
 
@@ -637,7 +656,7 @@ private:
             if (pos < size_)
                 ConstructElements(dest + pos + numElements, src + pos, src + size_, MoveTag{});
 
-            Swap(newVector);
+            VectorBase::Swap(newVector);
         }
         else if (numElements > 0)
         {
@@ -729,7 +748,7 @@ public:
     /// Destruct.
     ~PODVector()
     {
-        delete[] buffer_;
+        FreeBuffer();
     }
 
     /// Assign from another vector.
@@ -744,6 +763,19 @@ public:
         return *this;
     }
 
+    /// Swap with another vector. Elements are copied if either vector uses inline storage.
+    void Swap(PODVector<T>& vector)
+    {
+        if (!IsInlineBuffer() && !vector.IsInlineBuffer())
+            VectorBase::Swap(vector);
+        else if (&vector != this)
+        {
+            PODVector<T> temp(vector);
+            vector = *this;
+            *this = temp;
+        }
+    }
+
     /// Add-assign an element.
     PODVector<T>& operator +=(const T& rhs)
     {
@@ -839,7 +871,7 @@ public:
     /// Add an element at the end.
     void Push(const T& value)
     {
-        if (size_ < capacity_)
+        if (size_ < Capacity())
             ++size_;
         else
             Resize(size_ + 1);
@@ -1029,24 +1061,26 @@ public:
     /// Resize the vector.
     void Resize(unsigned newSize)
     {
-        if (newSize > capacity_)
+        if (newSize > Capacity())
         {
-            if (!capacity_)
-                capacity_ = newSize;
+            unsigned newCapacity = Capacity();
+            if (!newCapacity)
+                newCapacity = newSize;
             else
             {
-                while (capacity_ < newSize)
-                    capacity_ += (capacity_ + 1) >> 1;
+                while (newCapacity < newSize)
+                    newCapacity += (newCapacity + 1) >> 1;
             }
 
-            unsigned char* newBuffer = AllocateBuffer((unsigned)(capacity_ * sizeof(T)));
+            unsigned char* newBuffer = AllocateBuffer((unsigned)(newCapacity * sizeof(T)));
             // Move the data into the new buffer and delete the old
             if (buffer_)
             {
                 CopyElements(reinterpret_cast<T*>(newBuffer), Buffer(), size_);
-                delete[] buffer_;
+                FreeBuffer();
             }
             buffer_ = newBuffer;
+            capacity_ = newCapacity;
         }
 
         size_ = newSize;
@@ -1066,22 +1100,25 @@ public:
     {
         if (newCapacity < size_)
             newCapacity = size_;
+        // Inline storage is never shrunk
+        if (IsInlineBuffer() && newCapacity <= Capacity())
+            return;
 
         if (newCapacity != capacity_)
         {
             unsigned char* newBuffer = nullptr;
-            capacity_ = newCapacity;
 
-            if (capacity_)
+            if (newCapacity)
             {
-                newBuffer = AllocateBuffer((unsigned)(capacity_ * sizeof(T)));
+                newBuffer = AllocateBuffer((unsigned)(newCapacity * sizeof(T)));
                 // Move the data into the new buffer
                 CopyElements(reinterpret_cast<T*>(newBuffer), Buffer(), size_);
             }
 
             // Delete the old buffer
-            delete[] buffer_;
+            FreeBuffer();
             buffer_ = newBuffer;
+            capacity_ = newCapacity;
         }
     }
 
@@ -1151,7 +1188,7 @@ public:
     unsigned Size() const { return size_; }
 
     /// Return capacity of vector.
-    unsigned Capacity() const { return capacity_; }
+    unsigned Capacity() const { return capacity_ & ~INLINE_BUFFER; }
 
     /// Return whether vector is empty.
     bool Empty() const { return size_ == 0; }
@@ -60,6 +60,19 @@ public:
 protected:
     static unsigned char* AllocateBuffer(unsigned size);
 
+    /// Return whether the buffer is inline storage owned by a derived small vector.
+    bool IsInlineBuffer() const { return (capacity_ & INLINE_BUFFER) != 0; }
+
+    /// Free the buffer unless it is inline storage.
+    void FreeBuffer()
+    {
+        if (!IsInlineBuffer())
+            delete[] buffer_;
+    }
+
+    /// Capacity flag set while the buffer is inline storage.
+    static const unsigned INLINE_BUFFER = 0x80000000u;
+
     /// Size of vector.
     unsigned size_;
     /// Buffer capacity.
@@ -435,6 +435,21 @@ void Context::RemoveEventSender(Object* sender)
         }
         specificEventReceivers_.Erase(i);
     }
+
+    specificEventChannels_.Erase(sender);
+}
+
+void Context::RemoveEventChannelReceiver(Object* receiver)
+{
+    for (HashMap<StringHash, SharedPtr<EventChannelBase> >::Iterator i = eventChannels_.Begin(); i != eventChannels_.End(); ++i)
+        i->second_->Unsubscribe(receiver);
+
+    for (HashMap<Object*, HashMap<StringHash, SharedPtr<EventChannelBase> > >::Iterator i = specificEventChannels_.Begin();
+         i != specificEventChannels_.End(); ++i)
+    {
+        for (HashMap<StringHash, SharedPtr<EventChannelBase> >::Iterator j = i->second_.Begin(); j != i->second_.End(); ++j)
+            j->second_->Unsubscribe(receiver);
+    }
 }
 
 void Context::RemoveEventReceiver(Object* receiver, StringHash eventType)
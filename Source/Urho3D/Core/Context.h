@@ -24,6 +24,7 @@
 
 #include "../Container/HashSet.h"
 #include "../Core/Attribute.h"
+#include "../Core/EventChannel.h"
 #include "../Core/Object.h"
 
 namespace Urho3D
@@ -203,6 +204,11 @@ public:
         return i != eventReceivers_.End() ? i->second_ : nullptr;
     }
 
+    /// Return the typed event channel for an event struct, creating it if necessary. The channel exists for the lifetime of the context, so the pointer can be stored.
+    template <class E> EventChannel<E>* GetEventChannel();
+    /// Return the typed event channel for an event struct sent by a specific sender, creating it if necessary. The channel exists until the sender is destroyed.
+    template <class E> EventChannel<E>* GetEventChannel(Object* sender);
+
 private:
     /// Add event receiver.
     void AddEventReceiver(Object* receiver, StringHash eventType);
@@ -214,6 +220,8 @@ private:
     void RemoveEventReceiver(Object* receiver, Object* sender, StringHash eventType);
     /// Remove event receiver from non-specific events.
     void RemoveEventReceiver(Object* receiver, StringHash eventType);
+    /// Remove event receiver from all typed event channels. Called on its destruction.
+    void RemoveEventChannelReceiver(Object* receiver);
     /// Begin event send.
     void BeginSendEvent(Object* sender, StringHash eventType);
     /// End event send. Clean up event receivers removed in the meanwhile.
@@ -234,6 +242,10 @@ private:
     HashMap<StringHash, SharedPtr<EventReceiverGroup> > eventReceivers_;
     /// Event receivers for specific senders' events.
     HashMap<Object*, HashMap<StringHash, SharedPtr<EventReceiverGroup> > > specificEventReceivers_;
+    /// Typed event channels.
+    HashMap<StringHash, SharedPtr<EventChannelBase> > eventChannels_;
+    /// Typed event channels of specific senders.
+    HashMap<Object*, HashMap<StringHash, SharedPtr<EventChannelBase> > > specificEventChannels_;
     /// Event sender stack.
     PODVector<Object*> eventSenders_;
     /// Event data stack.
@@ -274,6 +286,22 @@ template <class T> T* Context::GetSubsystem() const { return static_cast<T*>(Get
 
 template <class T> AttributeInfo* Context::GetAttribute(const char* name) { return GetAttribute(T::GetTypeStatic(), name); }
 
+template <class E> EventChannel<E>* Context::GetEventChannel()
+{
+    SharedPtr<EventChannelBase>& channel = eventChannels_[E::GetEventTypeStatic()];
+    if (!channel)
+        channel = new EventChannel<E>();
+    return static_cast<EventChannel<E>*>(channel.Get());
+}
+
+template <class E> EventChannel<E>* Context::GetEventChannel(Object* sender)
+{
+    SharedPtr<EventChannelBase>& channel = specificEventChannels_[sender][E::GetEventTypeStatic()];
+    if (!channel)
+        channel = new EventChannel<E>();
+    return static_cast<EventChannel<E>*>(channel.Get());
+}
+
 template <class T> void Context::UpdateAttributeDefaultValue(const char* name, const Variant& defaultValue)
 {
     UpdateAttributeDefaultValue(T::GetTypeStatic(), name, defaultValue);
@@ -40,24 +40,56 @@ URHO3D_EVENT(E_UPDATE, Update)
     URHO3D_PARAM(P_TIMESTEP, TimeStep);            // float
 }
 
+/// Typed counterpart of E_UPDATE, sent through EventChannel<LogicUpdateEvent> right after it.
+struct LogicUpdateEvent
+{
+    URHO3D_TYPED_EVENT(LogicUpdateEvent)
+    /// Frame time step.
+    float timeStep_;
+};
+
 /// Application-wide logic post-update event.
 URHO3D_EVENT(E_POSTUPDATE, PostUpdate)
 {
     URHO3D_PARAM(P_TIMESTEP, TimeStep);            // float
 }
 
+/// Typed counterpart of E_POSTUPDATE, sent through EventChannel<PostUpdateEvent> right after it.
+struct PostUpdateEvent
+{
+    URHO3D_TYPED_EVENT(PostUpdateEvent)
+    /// Frame time step.
+    float timeStep_;
+};
+
 /// Render update event.
 URHO3D_EVENT(E_RENDERUPDATE, RenderUpdate)
 {
     URHO3D_PARAM(P_TIMESTEP, TimeStep);            // float
 }
 
+/// Typed counterpart of E_RENDERUPDATE, sent through EventChannel<RenderUpdateEvent> right after it.
+struct RenderUpdateEvent
+{
+    URHO3D_TYPED_EVENT(RenderUpdateEvent)
+    /// Frame time step.
+    float timeStep_;
+};
+
 /// Post-render update event.
 URHO3D_EVENT(E_POSTRENDERUPDATE, PostRenderUpdate)
 {
     URHO3D_PARAM(P_TIMESTEP, TimeStep);            // float
 }
 
+/// Typed counterpart of E_POSTRENDERUPDATE, sent through EventChannel<PostRenderUpdateEvent> right after it.
+struct PostRenderUpdateEvent
+{
+    URHO3D_TYPED_EVENT(PostRenderUpdateEvent)
+    /// Frame time step.
+    float timeStep_;
+};
+
 /// Frame end event.
 URHO3D_EVENT(E_ENDFRAME, EndFrame)
 {
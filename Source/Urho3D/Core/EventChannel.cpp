@@ -0,0 +1,86 @@
+//
+// Copyright (c) 2008-2020 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Precompiled.h"
+
+#include "../Core/EventChannel.h"
+#include "../Core/Thread.h"
+#include "../IO/Log.h"
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+void EventChannelBase::Unsubscribe(Object* receiver)
+{
+    unsigned index = receivers_.IndexOf(receiver);
+    if (index < receivers_.Size())
+    {
+        if (inSend_)
+        {
+            receivers_[index] = nullptr;
+            dirty_ = true;
+        }
+        else
+        {
+            receivers_.Erase(index);
+            EraseHandler(index);
+        }
+    }
+
+    // A receiver subscribed during the send can be unsubscribed before it is added
+    index = pendingReceivers_.IndexOf(receiver);
+    if (index < pendingReceivers_.Size())
+        pendingReceivers_[index] = nullptr;
+}
+
+bool EventChannelBase::HasSubscribed(Object* receiver) const
+{
+    return receivers_.Contains(receiver) || pendingReceivers_.Contains(receiver);
+}
+
+bool EventChannelBase::BeginSend()
+{
+    if (!Thread::IsMainThread())
+    {
+        URHO3D_LOGERROR("Sending events is only supported from the main thread");
+        return false;
+    }
+
+    ++inSend_;
+    return true;
+}
+
+void EventChannelBase::EndSend()
+{
+    assert(inSend_ > 0);
+    --inSend_;
+
+    if (inSend_ == 0 && dirty_)
+    {
+        CleanUp();
+        dirty_ = false;
+    }
+}
+
+}
@@ -0,0 +1,170 @@
+//
+// Copyright (c) 2008-2020 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../Core/Object.h"
+
+namespace Urho3D
+{
+
+/// Base class for typed event channels. Tracks the receiving objects so that they can be unsubscribed on destruction.
+/// @nobind
+class URHO3D_API EventChannelBase : public RefCounted
+{
+public:
+    /// Construct.
+    EventChannelBase() :
+        inSend_(0),
+        dirty_(false)
+    {
+    }
+
+    /// Unsubscribe a receiver. Leaves a hole if called during send, which is cleaned up afterward.
+    void Unsubscribe(Object* receiver);
+    /// Return whether a receiver is subscribed.
+    bool HasSubscribed(Object* receiver) const;
+    /// Return whether there are any receivers.
+    bool HasReceivers() const { return !receivers_.Empty() || !pendingReceivers_.Empty(); }
+
+protected:
+    /// Begin send. Return false if sending is not allowed from the calling thread.
+    bool BeginSend();
+    /// End send. Clean up holes and add receivers subscribed in the meanwhile.
+    void EndSend();
+    /// Mark a receiver as having channel subscriptions, so that it unsubscribes itself on destruction.
+    static void MarkReceiver(Object* receiver) { receiver->hasEventChannels_ = true; }
+    /// Erase the handler at index.
+    virtual void EraseHandler(unsigned index) = 0;
+    /// Remove holes and move the pending subscriptions to the receiver list.
+    virtual void CleanUp() = 0;
+
+    /// Receivers, parallel to the handlers of the derived class. May contain holes during sending.
+    PODVector<Object*> receivers_;
+    /// Receivers subscribed during sending, added when the outermost send ends.
+    PODVector<Object*> pendingReceivers_;
+    /// "In send" recursion counter.
+    unsigned inSend_;
+    /// Cleanup required flag.
+    bool dirty_;
+};
+
+/// Typed event channel. Receivers are stored in a flat array and invoked with a reference to an event struct, so sending does not build a VariantMap or look up receivers by event type. Senders are expected to look the channel up once from the Context and keep the pointer. Exists in parallel with the string hash events; the event struct must declare its identity with URHO3D_TYPED_EVENT.
+/// @nobind
+template <class E> class EventChannel : public EventChannelBase
+{
+public:
+    /// Handler member function, stored converted to a member of Object so that no allocation is needed per receiver.
+    using HandlerFunction = void (Object::*)(const E&);
+
+    /// Subscribe a receiver's member function. Replaces an existing subscription of the same receiver.
+    template <class T> void Subscribe(T* receiver, void (T::*function)(const E&))
+    {
+        Subscribe(static_cast<Object*>(receiver), static_cast<HandlerFunction>(function));
+    }
+
+    /// Subscribe a receiver's member function converted to a member of Object. Replaces an existing subscription of the same receiver.
+    void Subscribe(Object* receiver, HandlerFunction function)
+    {
+        if (!receiver || !function)
+            return;
+
+        MarkReceiver(receiver);
+
+        if (inSend_)
+        {
+            // The existing handler may be executing, so only leave a hole and add the new one after the send
+            Unsubscribe(receiver);
+            pendingReceivers_.Push(receiver);
+            pendingHandlers_.Push(function);
+            dirty_ = true;
+        }
+        else
+        {
+            unsigned index = receivers_.IndexOf(receiver);
+            if (index < receivers_.Size())
+                handlers_[index] = function;
+            else
+            {
+                receivers_.Push(receiver);
+                handlers_.Push(function);
+            }
+        }
+    }
+
+    /// Send the event to all receivers that do not block events.
+    void Send(const E& event)
+    {
+        if (receivers_.Empty() || !BeginSend())
+            return;
+
+        // Receivers subscribed during the send are added afterward, so the handler array does not move
+        const unsigned numReceivers = receivers_.Size();
+        for (unsigned i = 0; i < numReceivers; ++i)
+        {
+            Object* receiver = receivers_[i];
+            if (receiver && !receiver->GetBlockEvents())
+                (receiver->*handlers_[i])(event);
+        }
+
+        EndSend();
+    }
+
+    /// Return number of receivers, including holes during sending.
+    unsigned GetNumReceivers() const { return receivers_.Size(); }
+
+private:
+    /// Erase the handler at index.
+    void EraseHandler(unsigned index) override { handlers_.Erase(index); }
+
+    /// Remove holes and move the pending subscriptions to the receiver list.
+    void CleanUp() override
+    {
+        for (unsigned i = receivers_.Size() - 1; i < receivers_.Size(); --i)
+        {
+            if (!receivers_[i])
+            {
+                receivers_.Erase(i);
+                handlers_.Erase(i);
+            }
+        }
+
+        for (unsigned i = 0; i < pendingReceivers_.Size(); ++i)
+        {
+            if (pendingReceivers_[i])
+            {
+                receivers_.Push(pendingReceivers_[i]);
+                handlers_.Push(pendingHandlers_[i]);
+            }
+        }
+
+        pendingReceivers_.Clear();
+        pendingHandlers_.Clear();
+    }
+
+    /// Handlers, parallel to the receivers.
+    PODVector<HandlerFunction> handlers_;
+    /// Handlers subscribed during sending.
+    PODVector<HandlerFunction> pendingHandlers_;
+};
+
+}
@@ -76,7 +76,8 @@ bool TypeInfo::IsTypeOf(const TypeInfo* typeInfo) const
 
 Object::Object(Context* context) :
     context_(context),
-    blockEvents_(false)
+    blockEvents_(false),
+    hasEventChannels_(false)
 {
     assert(context_);
 }
@@ -85,6 +86,8 @@ Object::~Object()
 {
     UnsubscribeFromAllEvents();
     context_->RemoveEventSender(this);
+    if (hasEventChannels_)
+        context_->RemoveEventChannelReceiver(this);
 }
 
 void Object::OnEvent(Object* sender, StringHash eventType, VariantMap& eventData)
@@ -83,6 +83,7 @@ private:
 class URHO3D_API Object : public RefCounted
 {
     friend class Context;
+    friend class EventChannelBase;
 
 public:
     /// Construct.
@@ -199,6 +200,8 @@ private:
 
     /// Block object from sending and receiving any events.
     bool blockEvents_;
+    /// Has subscribed to typed event channels.
+    bool hasEventChannels_;
 };
 
 template <class T> T* Object::GetSubsystem() const { return static_cast<T*>(GetSubsystem(T::GetTypeStatic())); }
@@ -371,6 +374,8 @@ URHO3D_API StringHashRegister& GetEventNameRegister();
 #define URHO3D_EVENT(eventID, eventName) static const Urho3D::StringHash eventID(Urho3D::GetEventNameRegister().RegisterString(#eventName)); namespace eventName
 /// Describe an event's parameter hash ID. Should be used inside an event namespace.
 #define URHO3D_PARAM(paramID, paramName) static const Urho3D::StringHash paramID(#paramName)
+/// Describe a typed event struct's hash ID, which identifies its EventChannel in the Context. Should be used inside the struct definition.
+#define URHO3D_TYPED_EVENT(typeName) static Urho3D::StringHash GetEventTypeStatic() { static const Urho3D::StringHash eventType(#typeName); return eventType; }
 /// Convenience macro to construct an EventHandler that points to a receiver object and its member function.
 #define URHO3D_HANDLER(className, function) (new Urho3D::EventHandlerImpl<className>(this, &className::function))
 /// Convenience macro to construct an EventHandler that points to a receiver object and its member function, and also defines a userdata pointer.
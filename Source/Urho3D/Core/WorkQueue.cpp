@@ -31,6 +31,196 @@
 namespace Urho3D
 {
 
+/// Work item is not queued, or has already been taken for execution.
+static const unsigned WORKITEM_IDLE = 0;
+/// Work item is queued in a worker thread deque and waiting for execution.
+static const unsigned WORKITEM_QUEUED = 1;
+/// Work item was removed while still referenced by a worker thread deque.
+static const unsigned WORKITEM_REMOVED = 2;
+
+/// Work-stealing lane for items with the maximum priority, such as rendering work that is completed within the frame.
+static const unsigned LANE_HIGH_PRIORITY = 0;
+/// Work-stealing lane for all other items.
+static const unsigned LANE_NORMAL = 1;
+/// Number of work-stealing lanes per worker thread.
+static const unsigned NUM_LANES = 2;
+
+/// Initial capacity of a work item deque. Must be a power of two.
+static const unsigned INITIAL_DEQUE_SIZE = 256;
+
+/// Divisor of the remaining elements per thread when sizing a parallel for chunk. Higher values give smaller chunks for better balancing.
+static const unsigned PARALLEL_FOR_CHUNK_DIVISOR = 2;
+
+/// Shared state of a parallel for loop.
+struct ParallelForState
+{
+    /// Work function to call for each chunk.
+    void (*workFunction_)(const WorkItem*, unsigned);
+    /// Start of the element range.
+    unsigned char* start_;
+    /// Number of elements.
+    unsigned count_;
+    /// Size of an element in bytes.
+    unsigned elementSize_;
+    /// Minimum number of elements in a chunk.
+    unsigned minChunkSize_;
+    /// Number of work items processing the range.
+    unsigned numItems_;
+    /// Per-thread statistics.
+    ParallelForStats* stats_;
+    /// Index of the next element to be claimed.
+    std::atomic<unsigned> next_;
+};
+
+void ParallelForWork(const WorkItem* item, unsigned threadIndex)
+{
+    auto* state = reinterpret_cast<ParallelForState*>(item->start_);
+    // The item is executed only by this thread, so it can be reused to describe each chunk to the work function
+    auto* chunkItem = const_cast<WorkItem*>(item);
+    ParallelForStats& stats = state->stats_[threadIndex];
+    HiresTimer timer;
+
+    for (;;)
+    {
+        unsigned begin = state->next_.load(std::memory_order_relaxed);
+        unsigned chunkSize;
+
+        do
+        {
+            if (begin >= state->count_)
+            {
+                stats.time_ += timer.GetUSec(false);
+                return;
+            }
+
+            unsigned remaining = state->count_ - begin;
+            chunkSize = Min(Max(remaining / (state->numItems_ * PARALLEL_FOR_CHUNK_DIVISOR), state->minChunkSize_), remaining);
+        } while (!state->next_.compare_exchange_weak(begin, begin + chunkSize, std::memory_order_relaxed));
+
+        chunkItem->start_ = state->start_ + (size_t)begin * state->elementSize_;
+        chunkItem->end_ = state->start_ + (size_t)(begin + chunkSize) * state->elementSize_;
+        state->workFunction_(chunkItem, threadIndex);
+
+        stats.elements_ += chunkSize;
+        ++stats.chunks_;
+    }
+}
+
+/// Reset parallel for statistics.
+static void ResetParallelForStats(PODVector<ParallelForStats>& stats)
+{
+    for (PODVector<ParallelForStats>::Iterator i = stats.Begin(); i != stats.End(); ++i)
+        *i = ParallelForStats();
+}
+
+/// Advance a xorshift random seed and return the new value.
+static inline unsigned NextSeed(unsigned& seed)
+{
+    seed ^= seed << 13u;
+    seed ^= seed >> 17u;
+    seed ^= seed << 5u;
+    return seed;
+}
+
+/// Lock-free work item deque with a single producer (the main thread) and multiple consumers (the owning worker thread and thieves). Items are taken from the front in the order they were pushed.
+class WorkItemDeque
+{
+public:
+    /// Construct.
+    WorkItemDeque() :
+        head_(0),
+        tail_(0)
+    {
+        buffers_.Push(new Buffer(INITIAL_DEQUE_SIZE));
+        buffer_ = buffers_.Back();
+    }
+
+    /// Destruct.
+    ~WorkItemDeque()
+    {
+        for (unsigned i = 0; i < buffers_.Size(); ++i)
+            delete buffers_[i];
+    }
+
+    /// Prevent copy construction.
+    WorkItemDeque(const WorkItemDeque& rhs) = delete;
+    /// Prevent assignment.
+    WorkItemDeque& operator =(const WorkItemDeque& rhs) = delete;
+
+    /// Push a work item to the back. Must only be called from the main thread.
+    void Push(WorkItem* item)
+    {
+        unsigned tail = tail_.load(std::memory_order_relaxed);
+        unsigned head = head_.load(std::memory_order_acquire);
+        Buffer* buffer = buffer_.load(std::memory_order_relaxed);
+
+        if (tail - head > buffer->mask_)
+        {
+            // Grow to double size. The old buffer is retained, as consumers may still be reading from it
+            auto* newBuffer = new Buffer((buffer->mask_ + 1) * 2);
+            for (unsigned i = head; i != tail; ++i)
+                newBuffer->slots_[i & newBuffer->mask_].store(buffer->slots_[i & buffer->mask_].load(std::memory_order_relaxed),
+                    std::memory_order_relaxed);
+            buffers_.Push(newBuffer);
+            buffer_.store(newBuffer, std::memory_order_release);
+            buffer = newBuffer;
+        }
+
+        buffer->slots_[tail & buffer->mask_].store(item, std::memory_order_relaxed);
+        tail_.store(tail + 1, std::memory_order_release);
+    }
+
+    /// Take a work item from the front. Return null if empty. Safe to call from any thread.
+    WorkItem* Take()
+    {
+        unsigned head = head_.load(std::memory_order_acquire);
+
+        for (;;)
+        {
+            unsigned tail = tail_.load(std::memory_order_acquire);
+            if ((int)(tail - head) <= 0)
+                return nullptr;
+
+            Buffer* buffer = buffer_.load(std::memory_order_acquire);
+            WorkItem* item = buffer->slots_[head & buffer->mask_].load(std::memory_order_relaxed);
+            if (head_.compare_exchange_weak(head, head + 1, std::memory_order_acq_rel, std::memory_order_acquire))
+                return item;
+        }
+    }
+
+    /// Return whether is empty.
+    bool Empty() const { return (int)(tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire)) <= 0; }
+
+private:
+    /// Ring buffer of work item slots.
+    struct Buffer
+    {
+        /// Construct with size, which must be a power of two.
+        explicit Buffer(unsigned size) :
+            slots_(new std::atomic<WorkItem*>[size]),
+            mask_(size - 1)
+        {
+        }
+
+        /// Destruct.
+        ~Buffer() { delete[] slots_; }
+
+        /// Work item slots.
+        std::atomic<WorkItem*>* slots_;
+        /// Index mask.
+        unsigned mask_;
+    };
+
+    /// Index of the front item. Advanced by consumers.
+    std::atomic<unsigned> head_;
+    /// Index past the back item. Advanced by the producer.
+    std::atomic<unsigned> tail_;
+    /// Current ring buffer.
+    std::atomic<Buffer*> buffer_;
+    /// All ring buffers allocated so far, including retired ones. Accessed only by the producer.
+    PODVector<Buffer*> buffers_;
+};
+
 /// Worker thread managed by the work queue.
 class WorkerThread : public Thread, public RefCounted
 {
@@ -58,6 +248,11 @@ public:
     /// Return thread index.
     unsigned GetIndex() const { return index_; }
 
+    /// Work item deques per priority lane, filled by the main thread. Used in work-stealing mode.
+    WorkItemDeque deques_[NUM_LANES];
+    /// Work item deque for continuations queued by this thread. Used in work-stealing mode.
+    WorkItemDeque continuationDeque_;
+
 private:
     /// Work queue.
     WorkQueue* owner_;
@@ -70,11 +265,18 @@ WorkQueue::WorkQueue(Context* context) :
     shutDown_(false),
     pausing_(false),
     paused_(false),
+    workStealing_(false),
+    nextThread_(0),
+    stealSeed_(0x9e3779b9),
     completing_(false),
     tolerance_(10),
-    lastSize_(0),
+    numPooledItems_(0),
+    maxPooledItemsInUse_(0),
     maxNonThreadedWorkMs_(5)
 {
+    // Frame allocators start empty and grow to what their thread needs, as most threads never use them
+    frameAllocators_.Push(new FrameAllocator(0));
+
     SubscribeToEvent(E_BEGINFRAME, URHO3D_HANDLER(WorkQueue, HandleBeginFrame));
 }
 
@@ -86,6 +288,19 @@ WorkQueue::~WorkQueue()
 
     for (unsigned i = 0; i < threads_.Size(); ++i)
         threads_[i]->Stop();
+
+    // Release the references held by the queue
+    for (PODVector<WorkItem*>::Iterator i = workItems_.Begin(); i != workItems_.End(); ++i)
+        ReturnToPool(*i);
+    for (PODVector<WorkItem*>::Iterator i = removedItems_.Begin(); i != removedItems_.End(); ++i)
+        ReturnToPool(*i);
+    for (PODVector<WorkItem*>::Iterator i = poolItems_.Begin(); i != poolItems_.End(); ++i)
+        (*i)->ReleaseRef();
+    for (PODVector<WorkItem*>::Iterator i = heldItems_.Begin(); i != heldItems_.End(); ++i)
+        (*i)->ReleaseRef();
+
+    for (PODVector<FrameAllocator*>::Iterator i = frameAllocators_.Begin(); i != frameAllocators_.End(); ++i)
+        delete *i;
 }
 
 void WorkQueue::CreateThreads(unsigned numThreads)
@@ -99,12 +314,26 @@ void WorkQueue::CreateThreads(unsigned numThreads)
     // Start threads in paused mode
     Pause();
 
+    // Create all threads before running any, as in work-stealing mode they access each other's deques
     for (unsigned i = 0; i < numThreads; ++i)
     {
-        SharedPtr<WorkerThread> thread(new WorkerThread(this, i + 1));
-        thread->Run();
-        threads_.Push(thread);
+        threads_.Push(SharedPtr<WorkerThread>(new WorkerThread(this, i + 1)));
+        frameAllocators_.Push(new FrameAllocator(0));
     }
+
+    // Move any work queued before the threads existed to the deques
+    if (IsWorkStealingActive())
+    {
+        for (List<WorkItem*>::Iterator i = queue_.Begin(); i != queue_.End(); ++i)
+        {
+            (*i)->queueState_ = WORKITEM_QUEUED;
+            PushWorkItem(*i);
+        }
+        queue_.Clear();
+    }
+
+    for (unsigned i = 0; i < threads_.Size(); ++i)
+        threads_[i]->Run();
 #else
     URHO3D_LOGERROR("Can not create worker threads as threading is disabled");
 #endif
@@ -112,22 +341,44 @@ void WorkQueue::CreateThreads(unsigned numThreads)
 
 SharedPtr<WorkItem> WorkQueue::GetFreeItem()
 {
+    return SharedPtr<WorkItem>(AllocateItem());
+}
+
+WorkItem* WorkQueue::AllocateItem()
+{
+    assert(Thread::IsMainThread());
+
+    WorkItem* item;
+
     if (poolItems_.Size() > 0)
     {
-        SharedPtr<WorkItem> item = poolItems_.Front();
-        poolItems_.PopFront();
-        return item;
+        // Reuse the most recently returned item, as it is likely to be in cache
+        item = poolItems_.Back();
+        poolItems_.Pop();
     }
     else
     {
-        // No usable items found, create a new one set it as pooled and return it.
-        SharedPtr<WorkItem> item(new WorkItem());
+        // No usable items found, create a new one set it as pooled and return it. The pool keeps a reference to it
+        item = new WorkItem();
         item->pooled_ = true;
-        return item;
+        item->AddRef();
+        ++numPooledItems_;
     }
+
+    unsigned numInUse = numPooledItems_ - poolItems_.Size();
+    if (numInUse > maxPooledItemsInUse_)
+        maxPooledItemsInUse_ = numInUse;
+
+    return item;
+}
+
+void WorkQueue::AddWorkItem(WorkItem* item)
+{
+    static const PODVector<WorkItem*> noDependencies;
+    AddWorkItem(item, noDependencies);
 }
 
-void WorkQueue::AddWorkItem(const SharedPtr<WorkItem>& item)
+void WorkQueue::AddWorkItem(WorkItem* item, const PODVector<WorkItem*>& dependencies)
 {
     if (!item)
     {
@@ -138,55 +389,71 @@ void WorkQueue::AddWorkItem(const SharedPtr<WorkItem>& item)
     // Check for duplicate items.
     assert(!workItems_.Contains(item));
 
-    // Push to the main thread list to keep item alive
-    // Clear completed flag in case item is reused
+    // Push to the main thread list. Keep the item alive, unless the pool already does
+    // Clear completed flag and continuations in case item is reused
     workItems_.Push(item);
+    if (!item->pooled_)
+        item->AddRef();
     item->completed_ = false;
+    item->continuationsReleased_ = false;
+    item->continuations_.Clear();
 
-    // Make sure worker threads' list is safe to modify
-    if (threads_.Size() && !paused_)
-        queueMutex_.Acquire();
-
-    // Find position for new item
-    if (queue_.Empty())
-        queue_.Push(item);
-    else
+    // Hold an extra count while attaching to the dependencies, so that the item can not become ready prematurely
+    item->pendingDependencies_ = 1;
+    for (PODVector<WorkItem*>::ConstIterator i = dependencies.Begin(); i != dependencies.End(); ++i)
     {
-        bool inserted = false;
+        WorkItem* dependency = *i;
+        if (!dependency || dependency == item)
+            continue;
 
-        for (List<WorkItem*>::Iterator i = queue_.Begin(); i != queue_.End(); ++i)
+        // If the dependency has already released its continuations, it has been executed and need not be waited for
+        while (dependency->continuationLock_.exchange(true, std::memory_order_acquire))
         {
-            if ((*i)->priority_ <= item->priority_)
-            {
-                queue_.Insert(i, item);
-                inserted = true;
-                break;
-            }
         }
-
-        if (!inserted)
-            queue_.Push(item);
+        if (!dependency->continuationsReleased_)
+        {
+            dependency->continuations_.Push(item);
+            ++item->pendingDependencies_;
+        }
+        dependency->continuationLock_.store(false, std::memory_order_release);
     }
 
-    if (threads_.Size())
-    {
-        queueMutex_.Release();
-        paused_ = false;
-    }
+    if (--item->pendingDependencies_ == 0)
+        QueueWorkItem(item, 0);
+
+    Resume();
 }
 
 bool WorkQueue::RemoveWorkItem(SharedPtr<WorkItem> item)
 {
-    if (!item)
+    // Items which other items depend on can not be removed, as the dependent items would never execute
+    if (!item || !item->continuations_.Empty())
         return false;
 
+    if (IsWorkStealingActive())
+    {
+        PODVector<WorkItem*>::Iterator j = workItems_.Find(item);
+        if (j == workItems_.End())
+            return false;
+
+        // Can only remove successfully if the item was not yet claimed by threads for execution. The deque still
+        // references the item, so keep it alive until a thread discards it
+        unsigned expected = WORKITEM_QUEUED;
+        if (!item->queueState_.compare_exchange_strong(expected, WORKITEM_REMOVED))
+            return false;
+
+        removedItems_.Push(item);
+        workItems_.Erase(j);
+        return true;
+    }
+
     MutexLock lock(queueMutex_);
 
     // Can only remove successfully if the item was not yet taken by threads for execution
     List<WorkItem*>::Iterator i = queue_.Find(item.Get());
     if (i != queue_.End())
     {
-        List<SharedPtr<WorkItem> >::Iterator j = workItems_.Find(item);
+        PODVector<WorkItem*>::Iterator j = workItems_.Find(item);
         if (j != workItems_.End())
         {
             queue_.Erase(i);
@@ -199,17 +466,73 @@ bool WorkQueue::RemoveWorkItem(SharedPtr<WorkItem> item)
     return false;
 }
 
+void WorkQueue::ParallelFor(void (*workFunction)(const WorkItem*, unsigned), void* start, unsigned count, unsigned elementSize,
+    void* aux, unsigned minChunkSize)
+{
+    if (!count)
+        return;
+
+    unsigned numThreads = GetNumThreads() + 1; // Worker threads + main thread
+    if (parallelForStats_.Size() != numThreads)
+    {
+        parallelForStats_.Resize(numThreads);
+        ResetParallelForStats(parallelForStats_);
+    }
+
+    minChunkSize = Max(minChunkSize, 1U);
+
+    ParallelForState state;
+    state.workFunction_ = workFunction;
+    state.start_ = static_cast<unsigned char*>(start);
+    state.count_ = count;
+    state.elementSize_ = elementSize;
+    state.minChunkSize_ = minChunkSize;
+    state.numItems_ = Min(numThreads, (count + minChunkSize - 1) / minChunkSize);
+    state.stats_ = &parallelForStats_[0];
+    state.next_ = 0;
+
+    // Keep the items local to the call, as a work function may start a nested parallel for loop
+    PODVector<WorkItem*> items;
+    items.Reserve(state.numItems_);
+    for (unsigned i = 0; i < state.numItems_; ++i)
+    {
+        WorkItem* item = AllocateItem();
+        item->priority_ = M_MAX_UNSIGNED;
+        item->workFunction_ = ParallelForWork;
+        item->start_ = &state;
+        item->aux_ = aux;
+        AddWorkItem(item);
+        items.Push(item);
+    }
+
+    Complete(items);
+}
+
 unsigned WorkQueue::RemoveWorkItems(const Vector<SharedPtr<WorkItem> >& items)
 {
+    if (IsWorkStealingActive())
+    {
+        unsigned removed = 0;
+        for (Vector<SharedPtr<WorkItem> >::ConstIterator i = items.Begin(); i != items.End(); ++i)
+        {
+            if (RemoveWorkItem(*i))
+                ++removed;
+        }
+        return removed;
+    }
+
     MutexLock lock(queueMutex_);
     unsigned removed = 0;
 
     for (Vector<SharedPtr<WorkItem> >::ConstIterator i = items.Begin(); i != items.End(); ++i)
     {
+        if (!(*i)->continuations_.Empty())
+            continue;
+
         List<WorkItem*>::Iterator j = queue_.Find(i->Get());
         if (j != queue_.End())
         {
-            List<SharedPtr<WorkItem> >::Iterator k = workItems_.Find(*i);
+            PODVector<WorkItem*>::Iterator k = workItems_.Find(*i);
             if (k != workItems_.End())
             {
                 queue_.Erase(j);
@@ -245,12 +568,44 @@ void WorkQueue::Resume()
     }
 }
 
+void WorkQueue::SetWorkStealing(bool enable)
+{
+    if (enable == workStealing_)
+        return;
+
+    if (!workItems_.Empty() || !removedItems_.Empty())
+    {
+        URHO3D_LOGERROR("Can not change work-stealing mode while work is queued");
+        return;
+    }
+
+    workStealing_ = enable;
+}
 
 void WorkQueue::Complete(unsigned priority)
 {
     completing_ = true;
 
-    if (threads_.Size())
+    if (IsWorkStealingActive())
+    {
+        Resume();
+
+        // Take work items also in the main thread. Items below the priority are put back after the deques are exhausted
+        PODVector<WorkItem*> deferred;
+        while (WorkItem* item = TakeWorkItem(0, stealSeed_, priority, &deferred))
+            ExecuteWorkItem(item, 0);
+        PushDeferredItems(deferred);
+
+        // Wait for threaded work to complete
+        while (!IsCompleted(priority))
+        {
+        }
+
+        // If no work at all remaining, pause worker threads by leaving the mutex locked
+        if (IsQueueEmpty())
+            Pause();
+    }
+    else if (threads_.Size())
     {
         Resume();
 
@@ -263,8 +618,7 @@ void WorkQueue::Complete(unsigned priority)
                 WorkItem* item = queue_.Front();
                 queue_.PopFront();
                 queueMutex_.Release();
-                item->workFunction_(item, 0);
-                item->completed_ = true;
+                ExecuteWorkItem(item, 0);
             }
             else
             {
@@ -289,18 +643,68 @@ void WorkQueue::Complete(unsigned priority)
         {
             WorkItem* item = queue_.Front();
             queue_.PopFront();
-            item->workFunction_(item, 0);
-            item->completed_ = true;
+            ExecuteWorkItem(item, 0);
+        }
+    }
+
+    PurgeCompleted(priority);
+    completing_ = false;
+}
+
+void WorkQueue::Complete(const PODVector<WorkItem*>& items)
+{
+    // Hold a reference to the items while waiting, so that a purge in between, for example by a nested parallel for,
+    // does not return them to the pool and reset their completed flags
+    unsigned priority = M_MAX_UNSIGNED;
+    for (PODVector<WorkItem*>::ConstIterator i = items.Begin(); i != items.End(); ++i)
+    {
+        (*i)->AddRef();
+        priority = Min(priority, (*i)->priority_);
+    }
+
+    completing_ = true;
+
+    if (threads_.Size())
+    {
+        Resume();
+
+        // Take work items also in the main thread until the items are completed. If nothing can be taken, put back the
+        // skipped items so that worker threads can execute them in case the items depend on them
+        PODVector<WorkItem*> deferred;
+        while (!IsCompleted(items))
+        {
+            if (WorkItem* item = TakeMainThreadItem(priority, deferred))
+                ExecuteWorkItem(item, 0);
+            else
+                PushDeferredItems(deferred);
+        }
+        PushDeferredItems(deferred);
+
+        // If no work at all remaining, pause worker threads by leaving the mutex locked
+        if (IsQueueEmpty())
+            Pause();
+    }
+    else
+    {
+        // No worker threads: execute queued work in the main thread until the items are completed
+        while (!IsCompleted(items) && !queue_.Empty() && queue_.Front()->priority_ >= priority)
+        {
+            WorkItem* item = queue_.Front();
+            queue_.PopFront();
+            ExecuteWorkItem(item, 0);
         }
     }
 
+    for (PODVector<WorkItem*>::ConstIterator i = items.Begin(); i != items.End(); ++i)
+        (*i)->ReleaseRef();
+
     PurgeCompleted(priority);
     completing_ = false;
 }
 
 bool WorkQueue::IsCompleted(unsigned priority) const
 {
-    for (List<SharedPtr<WorkItem> >::ConstIterator i = workItems_.Begin(); i != workItems_.End(); ++i)
+    for (PODVector<WorkItem*>::ConstIterator i = workItems_.Begin(); i != workItems_.End(); ++i)
     {
         if ((*i)->priority_ >= priority && !(*i)->completed_)
             return false;
@@ -309,16 +713,50 @@ bool WorkQueue::IsCompleted(unsigned priority) const
     return true;
 }
 
+bool WorkQueue::IsCompleted(const PODVector<WorkItem*>& items) const
+{
+    for (PODVector<WorkItem*>::ConstIterator i = items.Begin(); i != items.End(); ++i)
+    {
+        if (!(*i)->completed_)
+            return false;
+    }
+
+    return true;
+}
+
 void WorkQueue::ProcessItems(unsigned threadIndex)
 {
     bool wasActive = false;
+    unsigned seed = 0x9e3779b9u * threadIndex + 1;
 
     for (;;)
     {
         if (shutDown_)
             return;
 
-        if (pausing_ && !wasActive)
+        if (workStealing_)
+        {
+            WorkItem* item = TakeWorkItem(threadIndex, seed, 0, nullptr);
+            if (item)
+            {
+                wasActive = true;
+
+                ExecuteWorkItem(item, threadIndex);
+            }
+            else
+            {
+                wasActive = false;
+
+                // Block on the queue mutex while paused, but do not contend for it while the main thread is pausing
+                if (!pausing_)
+                {
+                    queueMutex_.Acquire();
+                    queueMutex_.Release();
+                }
+                Time::Sleep(0);
+            }
+        }
+        else if (pausing_ && !wasActive)
             Time::Sleep(0);
         else
         {
@@ -330,8 +768,7 @@ void WorkQueue::ProcessItems(unsigned threadIndex)
                 WorkItem* item = queue_.Front();
                 queue_.PopFront();
                 queueMutex_.Release();
-                item->workFunction_(item, threadIndex);
-                item->completed_ = true;
+                ExecuteWorkItem(item, threadIndex);
             }
             else
             {
@@ -344,49 +781,282 @@ void WorkQueue::ProcessItems(unsigned threadIndex)
     }
 }
 
+void WorkQueue::QueueWorkItem(WorkItem* item, unsigned threadIndex)
+{
+    if (IsWorkStealingActive())
+    {
+        if (threadIndex)
+        {
+            // Worker threads queue continuations to their own deque, of which they are the only producer
+            item->queueState_ = WORKITEM_QUEUED;
+            threads_[threadIndex - 1]->continuationDeque_.Push(item);
+        }
+        else
+        {
+            // If the item was removed but is still referenced by a deque, revive it in place instead of queuing it twice
+            unsigned expected = WORKITEM_REMOVED;
+            if (item->queueState_.compare_exchange_strong(expected, WORKITEM_QUEUED))
+            {
+                // The reference held for the removed item is no longer needed, as the collection holds one again
+                removedItems_.Remove(item);
+                if (!item->pooled_)
+                    item->ReleaseRef();
+            }
+            else
+            {
+                item->queueState_ = WORKITEM_QUEUED;
+                PushWorkItem(item);
+            }
+        }
+    }
+    else if (threads_.Size())
+    {
+        // Make sure worker threads' list is safe to modify. When paused, the main thread is already holding the mutex
+        bool lock = threadIndex || !paused_;
+        if (lock)
+            queueMutex_.Acquire();
+        InsertWorkItem(item);
+        if (lock)
+            queueMutex_.Release();
+    }
+    else
+        InsertWorkItem(item);
+}
+
+void WorkQueue::InsertWorkItem(WorkItem* item)
+{
+    // Find position for new item
+    if (queue_.Empty())
+        queue_.Push(item);
+    else
+    {
+        bool inserted = false;
+
+        for (List<WorkItem*>::Iterator i = queue_.Begin(); i != queue_.End(); ++i)
+        {
+            if ((*i)->priority_ <= item->priority_)
+            {
+                queue_.Insert(i, item);
+                inserted = true;
+                break;
+            }
+        }
+
+        if (!inserted)
+            queue_.Push(item);
+    }
+}
+
+void WorkQueue::ExecuteWorkItem(WorkItem* item, unsigned threadIndex)
+{
+    item->workFunction_(item, threadIndex);
+
+    // Release the continuations before marking the item completed, so that it is not purged while they are accessed
+    while (item->continuationLock_.exchange(true, std::memory_order_acquire))
+    {
+    }
+    item->continuationsReleased_ = true;
+    item->continuationLock_.store(false, std::memory_order_release);
+
+    for (PODVector<WorkItem*>::ConstIterator i = item->continuations_.Begin(); i != item->continuations_.End(); ++i)
+    {
+        if (--(*i)->pendingDependencies_ == 0)
+            QueueWorkItem(*i, threadIndex);
+    }
+
+    item->completed_ = true;
+}
+
+WorkItem* WorkQueue::TakeMainThreadItem(unsigned priority, PODVector<WorkItem*>& deferred)
+{
+    if (IsWorkStealingActive())
+        return TakeWorkItem(0, stealSeed_, priority, &deferred);
+
+    MutexLock lock(queueMutex_);
+
+    if (!queue_.Empty() && queue_.Front()->priority_ >= priority)
+    {
+        WorkItem* item = queue_.Front();
+        queue_.PopFront();
+        return item;
+    }
+
+    return nullptr;
+}
+
+void WorkQueue::PushDeferredItems(PODVector<WorkItem*>& deferred)
+{
+    for (PODVector<WorkItem*>::ConstIterator i = deferred.Begin(); i != deferred.End(); ++i)
+        PushWorkItem(*i);
+    deferred.Clear();
+}
+
+void WorkQueue::PushWorkItem(WorkItem* item)
+{
+    unsigned lane = item->priority_ == M_MAX_UNSIGNED ? LANE_HIGH_PRIORITY : LANE_NORMAL;
+    threads_[nextThread_]->deques_[lane].Push(item);
+    if (++nextThread_ >= threads_.Size())
+        nextThread_ = 0;
+}
+
+WorkItem* WorkQueue::TakeWorkItem(unsigned threadIndex, unsigned& seed, unsigned priority, PODVector<WorkItem*>* deferred)
+{
+    unsigned numThreads = threads_.Size();
+    // Only the high priority lane can contain items of maximum priority
+    unsigned numLanes = priority == M_MAX_UNSIGNED ? 1 : NUM_LANES;
+
+    // Prefer continuations queued by the own thread, as their data is likely to be in cache
+    if (threadIndex)
+    {
+        if (WorkItem* item = TakeFromDeque(threads_[threadIndex - 1]->continuationDeque_, priority, deferred))
+            return item;
+    }
+
+    for (unsigned lane = 0; lane < numLanes; ++lane)
+    {
+        // Try the own deque first, then steal starting from a random victim
+        if (threadIndex)
+        {
+            if (WorkItem* item = TakeFromDeque(threads_[threadIndex - 1]->deques_[lane], priority, deferred))
+                return item;
+        }
+
+        unsigned victim = NextSeed(seed) % numThreads;
+        for (unsigned i = 0; i < numThreads; ++i)
+        {
+            if (WorkItem* item = TakeFromDeque(threads_[victim]->deques_[lane], priority, deferred))
+                return item;
+            if (++victim >= numThreads)
+                victim = 0;
+        }
+    }
+
+    // Finally steal continuations queued by other threads
+    unsigned victim = NextSeed(seed) % numThreads;
+    for (unsigned i = 0; i < numThreads; ++i)
+    {
+        if (WorkItem* item = TakeFromDeque(threads_[victim]->continuationDeque_, priority, deferred))
+            return item;
+        if (++victim >= numThreads)
+            victim = 0;
+    }
+
+    return nullptr;
+}
+
+WorkItem* WorkQueue::TakeFromDeque(WorkItemDeque& deque, unsigned priority, PODVector<WorkItem*>* deferred)
+{
+    while (WorkItem* item = deque.Take())
+    {
+        if (deferred && item->priority_ < priority)
+            deferred->Push(item);
+        // Claiming fails if the item was removed; it can then be dropped
+        else if (item->queueState_.exchange(WORKITEM_IDLE) == WORKITEM_QUEUED)
+            return item;
+    }
+
+    return nullptr;
+}
+
+bool WorkQueue::IsDequesEmpty() const
+{
+    for (unsigned i = 0; i < threads_.Size(); ++i)
+    {
+        if (!threads_[i]->continuationDeque_.Empty())
+            return false;
+
+        for (unsigned j = 0; j < NUM_LANES; ++j)
+        {
+            if (!threads_[i]->deques_[j].Empty())
+                return false;
+        }
+    }
+
+    return true;
+}
+
 void WorkQueue::PurgeCompleted(unsigned priority)
 {
     // Purge completed work items and send completion events. Do not signal items lower than priority threshold,
     // as those may be user submitted and lead to eg. scene manipulation that could happen in the middle of the
-    // render update, which is not allowed
-    for (List<SharedPtr<WorkItem> >::Iterator i = workItems_.Begin(); i != workItems_.End();)
+    // render update, which is not allowed. Compact the collection in place, preserving the order
+    unsigned dest = 0;
+    for (unsigned i = 0; i < workItems_.Size(); ++i)
     {
-        if ((*i)->completed_ && (*i)->priority_ >= priority)
+        WorkItem* item = workItems_[i];
+
+        if (item->completed_ && item->priority_ >= priority)
         {
-            if ((*i)->sendEvent_)
+            if (item->sendEvent_)
             {
                 using namespace WorkItemCompleted;
 
                 VariantMap& eventData = GetEventDataMap();
-                eventData[P_ITEM] = i->Get();
+                eventData[P_ITEM] = item;
                 SendEvent(E_WORKITEMCOMPLETED, eventData);
             }
 
-            ReturnToPool(*i);
-            i = workItems_.Erase(i);
+            ReturnToPool(item);
         }
         else
-            ++i;
+            workItems_[dest++] = item;
+    }
+    workItems_.Resize(dest);
+
+    // Return removed items to the pool once no deque references them anymore
+    dest = 0;
+    for (unsigned i = 0; i < removedItems_.Size(); ++i)
+    {
+        WorkItem* item = removedItems_[i];
+
+        if (item->queueState_ == WORKITEM_IDLE)
+            ReturnToPool(item);
+        else
+            removedItems_[dest++] = item;
+    }
+    removedItems_.Resize(dest);
+
+    // Return completed items to the pool once they are no longer referenced outside the queue
+    dest = 0;
+    for (unsigned i = 0; i < heldItems_.Size(); ++i)
+    {
+        WorkItem* item = heldItems_[i];
+
+        if (item->Refs() == 1)
+            ReturnToPool(item);
+        else
+            heldItems_[dest++] = item;
     }
+    heldItems_.Resize(dest);
 }
 
 void WorkQueue::PurgePool()
 {
-    unsigned currentSize = poolItems_.Size();
-    int difference = lastSize_ - currentSize;
-
-    // Difference tolerance, should be fairly significant to reduce the pool size.
-    for (unsigned i = 0; poolItems_.Size() > 0 && difference > tolerance_ && i < (unsigned)difference; i++)
-        poolItems_.PopFront();
+    // Delete free items exceeding the highest usage since the last purge plus the tolerance. In steady state, nothing is deleted
+    unsigned numNeeded = maxPooledItemsInUse_ + (unsigned)Max(tolerance_, 0);
+    while (numPooledItems_ > numNeeded && poolItems_.Size())
+    {
+        poolItems_.Back()->ReleaseRef();
+        poolItems_.Pop();
+        --numPooledItems_;
+    }
 
-    lastSize_ = currentSize;
+    maxPooledItemsInUse_ = numPooledItems_ - poolItems_.Size();
 }
 
-void WorkQueue::ReturnToPool(SharedPtr<WorkItem>& item)
+void WorkQueue::ReturnToPool(WorkItem* item)
 {
     // Check if this was a pooled item and set it to usable
     if (item->pooled_)
     {
+        // If the item is still referenced, for example by a SharedPtr from GetFreeItem() or while being waited on, keep it
+        // completed and out of the pool until released
+        if (item->Refs() > 1)
+        {
+            heldItems_.Push(item);
+            return;
+        }
+
         // Reset the values to their defaults. This should
         // be safe to do here as the completed event has
         // already been handled and this is part of the
@@ -398,9 +1068,13 @@ void WorkQueue::ReturnToPool(SharedPtr<WorkItem>& item)
         item->priority_ = M_MAX_UNSIGNED;
         item->sendEvent_ = false;
         item->completed_ = false;
+        item->continuationsReleased_ = false;
+        item->continuations_.Clear();
 
         poolItems_.Push(item);
     }
+    else
+        item->ReleaseRef();
 }
 
 void WorkQueue::HandleBeginFrame(StringHash eventType, VariantMap& eventData)
@@ -416,14 +1090,21 @@ void WorkQueue::HandleBeginFrame(StringHash eventType, VariantMap& eventData)
         {
             WorkItem* item = queue_.Front();
             queue_.PopFront();
-            item->workFunction_(item, 0);
-            item->completed_ = true;
+            ExecuteWorkItem(item, 0);
         }
     }
 
     // Complete and signal items down to the lowest priority
     PurgeCompleted(0);
     PurgePool();
+
+    // Keep the parallel for statistics of the last frame available
+    lastParallelForStats_ = parallelForStats_;
+    ResetParallelForStats(parallelForStats_);
+
+    // Reclaim the per-frame scratch memory
+    for (PODVector<FrameAllocator*>::Iterator i = frameAllocators_.Begin(); i != frameAllocators_.End(); ++i)
+        (*i)->Reset();
 }
 
 }
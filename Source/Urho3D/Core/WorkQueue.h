@@ -22,11 +22,15 @@
 
 #pragma once
 
+#include "../Container/FrameAllocator.h"
 #include "../Container/List.h"
+#include "../Container/Vector.h"
 #include "../Core/Mutex.h"
 #include "../Core/Object.h"
+#include "../Core/Thread.h"
 
 #include <atomic>
+#include <cassert>
 
 namespace Urho3D
 {
@@ -38,6 +42,18 @@ URHO3D_EVENT(E_WORKITEMCOMPLETED, WorkItemCompleted)
 }
 
 class WorkerThread;
+class WorkItemDeque;
+
+/// Per-thread statistics of parallel for loops.
+struct ParallelForStats
+{
+    /// Number of elements processed.
+    unsigned elements_{};
+    /// Number of chunks processed.
+    unsigned chunks_{};
+    /// Time spent processing in microseconds.
+    long long time_{};
+};
 
 /// Work queue item.
 /// @nobind
@@ -63,6 +79,16 @@ public:
 
 private:
     bool pooled_{};
+    /// Queue state used by the work-stealing scheduler.
+    std::atomic<unsigned> queueState_{};
+    /// Number of dependencies which have not completed yet.
+    std::atomic<unsigned> pendingDependencies_{};
+    /// Lock for modifying the continuations.
+    std::atomic<bool> continuationLock_{};
+    /// Whether the continuations have been released, after which no new ones can be added.
+    bool continuationsReleased_{};
+    /// Work items that depend on this item.
+    PODVector<WorkItem*> continuations_;
 };
 
 /// Work queue subsystem for multithreading.
@@ -80,10 +106,43 @@ public:
 
     /// Create worker threads. Can only be called once.
     void CreateThreads(unsigned numThreads);
-    /// Get pointer to an usable WorkItem from the item pool. Allocate one if no more free items.
+    /// Get pointer to an usable WorkItem from the item pool. Allocate one if no more free items. The item does not return to the pool while the pointer is held, so its completed flag can be polled. Must be called from the main thread.
     SharedPtr<WorkItem> GetFreeItem();
+    /// Get an usable WorkItem from the item pool as a plain pointer, without reference counting. The item is kept alive by the pool, and returns to it once completed. Allocate one if no more free items. Must be called from the main thread, as the pool is not locked.
+    WorkItem* AllocateItem();
     /// Add a work item and resume worker threads.
-    void AddWorkItem(const SharedPtr<WorkItem>& item);
+    void AddWorkItem(WorkItem* item);
+    /// Add a work item that will not start executing until the dependency work items have completed, and resume worker threads. The dependencies must have been added to the queue and not yet purged, and should have at least the priority of the item.
+    void AddWorkItem(WorkItem* item, const PODVector<WorkItem*>& dependencies);
+    /// Add work items to process a range of elements in parallel, split into chunks automatically according to the number of threads. Optionally return the created items, for example to use them as dependencies or to complete them, and make the items depend on other work items. Must be called from the main thread, as the items come from the unlocked item pool.
+    template <class T> void AddParallelWorkItems(void (*workFunction)(const WorkItem*, unsigned), T* start, T* end, void* aux,
+        unsigned priority = M_MAX_UNSIGNED, PODVector<WorkItem*>* items = nullptr, const PODVector<WorkItem*>& dependencies = PODVector<WorkItem*>())
+    {
+        assert(Thread::IsMainThread());
+
+        unsigned count = (unsigned)(end - start);
+        unsigned numChunks = Min(GetNumThreads() + 1, count); // Worker threads + main thread
+        for (unsigned i = 0; i < numChunks; ++i)
+        {
+            WorkItem* item = AllocateItem();
+            item->priority_ = priority;
+            item->workFunction_ = workFunction;
+            item->aux_ = aux;
+            // Distribute the remainder to the first chunks
+            item->start_ = start + (unsigned long long)count * i / numChunks;
+            item->end_ = start + (unsigned long long)count * (i + 1) / numChunks;
+            AddWorkItem(item, dependencies);
+            if (items)
+                items->Push(item);
+        }
+    }
+    /// Process a range of elements in parallel and wait for completion. Each thread repeatedly claims a chunk sized in proportion to the remaining elements (guided scheduling), so that threads which get expensive elements do not leave others idle. The work function is called with the start and end of each chunk, and the auxiliary data pointer. Must be called from the main thread.
+    template <class T> void ParallelFor(void (*workFunction)(const WorkItem*, unsigned), T* start, T* end, void* aux, unsigned minChunkSize = 1)
+    {
+        ParallelFor(workFunction, start, (unsigned)(end - start), (unsigned)sizeof(T), aux, minChunkSize);
+    }
+    /// Process a range of elements of the specified size in parallel and wait for completion. Must be called from the main thread.
+    void ParallelFor(void (*workFunction)(const WorkItem*, unsigned), void* start, unsigned count, unsigned elementSize, void* aux, unsigned minChunkSize = 1);
     /// Remove a work item before it has started executing. Return true if successfully removed.
     bool RemoveWorkItem(SharedPtr<WorkItem> item);
     /// Remove a number of work items before they have started executing. Return the number of items successfully removed.
@@ -94,8 +153,13 @@ public:
     void Resume();
     /// Finish all queued work which has at least the specified priority. Main thread will also execute priority work. Pause worker threads if no more work remains.
     void Complete(unsigned priority);
+    /// Finish the specified work items without waiting for other queued work. Main thread will also execute work which has at least the lowest priority of the items. Pause worker threads if no more work remains.
+    void Complete(const PODVector<WorkItem*>& items);
 
-    /// Set the pool telerance before it starts deleting pool items.
+    /// Enable or disable the work-stealing scheduler, which gives each worker thread its own work item deques and lets idle threads steal from others instead of sharing one mutex-protected queue. Can only be changed while no work is queued.
+    void SetWorkStealing(bool enable);
+
+    /// Set how many free pool items to keep in addition to the highest number of items used during the last frame, before deleting pool items.
     void SetTolerance(int tolerance) { tolerance_ = tolerance; }
 
     /// Set how many milliseconds maximum per frame to spend on low-priority work, when there are no worker threads.
@@ -104,11 +168,21 @@ public:
     /// Return number of worker threads.
     unsigned GetNumThreads() const { return threads_.Size(); }
 
+    /// Return whether the work-stealing scheduler is enabled.
+    bool GetWorkStealing() const { return workStealing_; }
+
     /// Return whether all work with at least the specified priority is finished.
     bool IsCompleted(unsigned priority) const;
+    /// Return whether the specified work items are finished.
+    bool IsCompleted(const PODVector<WorkItem*>& items) const;
     /// Return whether the queue is currently completing work in the main thread.
     bool IsCompleting() const { return completing_; }
 
+    /// Return per-thread statistics of parallel for loops during the last frame. Index 0 is the main thread.
+    const PODVector<ParallelForStats>& GetParallelForStats() const { return lastParallelForStats_; }
+    /// Return the frame allocator of a thread (0 = main thread) for scratch memory. Reset at the beginning of each frame, so must not be used by work that can span frames.
+    FrameAllocator& GetFrameAllocator(unsigned threadIndex) { return *frameAllocators_[threadIndex]; }
+
     /// Return the pool tolerance.
     int GetTolerance() const { return tolerance_; }
 
@@ -118,23 +192,55 @@ public:
 private:
     /// Process work items until shut down. Called by the worker threads.
     void ProcessItems(unsigned threadIndex);
+    /// Queue a work item whose dependencies have completed, from the specified thread.
+    void QueueWorkItem(WorkItem* item, unsigned threadIndex);
+    /// Insert a work item to the prioritized queue. Used when not in work-stealing mode.
+    void InsertWorkItem(WorkItem* item);
+    /// Execute a work item in the specified thread, then release its continuations and mark it completed.
+    void ExecuteWorkItem(WorkItem* item, unsigned threadIndex);
+    /// Take a work item with at least the specified priority for execution in the main thread, or null if none available. Items skipped in work-stealing mode are collected to the deferred list.
+    WorkItem* TakeMainThreadItem(unsigned priority, PODVector<WorkItem*>& deferred);
+    /// Put back work items skipped by the main thread in work-stealing mode.
+    void PushDeferredItems(PODVector<WorkItem*>& deferred);
+    /// Distribute a work item to a worker thread deque. Used in work-stealing mode.
+    void PushWorkItem(WorkItem* item);
+    /// Take and claim a work item from the worker thread deques, starting from the calling thread's own deque. Items below the specified priority are collected to the deferred list instead, if one is given. Used in work-stealing mode.
+    WorkItem* TakeWorkItem(unsigned threadIndex, unsigned& seed, unsigned priority, PODVector<WorkItem*>* deferred);
+    /// Take and claim a work item from a single deque. Items below the specified priority are collected to the deferred list instead, if one is given.
+    static WorkItem* TakeFromDeque(WorkItemDeque& deque, unsigned priority, PODVector<WorkItem*>* deferred);
+    /// Return whether the worker thread deques are empty. Used in work-stealing mode.
+    bool IsDequesEmpty() const;
+    /// Return whether no work items are waiting to be taken for execution.
+    bool IsQueueEmpty() const { return IsWorkStealingActive() ? IsDequesEmpty() : queue_.Empty(); }
+    /// Return whether work-stealing mode is in effect, which requires worker threads.
+    bool IsWorkStealingActive() const { return workStealing_ && !threads_.Empty(); }
     /// Purge completed work items which have at least the specified priority, and send completion events as necessary.
     void PurgeCompleted(unsigned priority);
     /// Purge the pool to reduce allocation where its unneeded.
     void PurgePool();
-    /// Return a work item to the pool.
-    void ReturnToPool(SharedPtr<WorkItem>& item);
+    /// Return a pooled work item to the pool, or release the reference held by the queue for other items.
+    void ReturnToPool(WorkItem* item);
     /// Handle frame start event. Purge completed work from the main thread queue, and perform work if no threads at all.
     void HandleBeginFrame(StringHash eventType, VariantMap& eventData);
 
     /// Worker threads.
     Vector<SharedPtr<WorkerThread> > threads_;
-    /// Work item pool for reuse to cut down on allocation. The bool is a flag for item pooling and whether it is available or not.
-    List<SharedPtr<WorkItem> > poolItems_;
-    /// Work item collection. Accessed only by the main thread.
-    List<SharedPtr<WorkItem> > workItems_;
+    /// Free work items for reuse to cut down on allocation. The queue holds a reference to every pooled item, whether free or in use.
+    PODVector<WorkItem*> poolItems_;
+    /// Work item collection. The queue holds a reference to each item while in the collection. Accessed only by the main thread.
+    PODVector<WorkItem*> workItems_;
     /// Work item prioritized queue for worker threads. Pointers are guaranteed to be valid (point to workItems).
     List<WorkItem*> queue_;
+    /// Completed pooled items still referenced outside the queue. Returned to the pool once only the queue references them.
+    PODVector<WorkItem*> heldItems_;
+    /// Items removed while still referenced by a worker thread deque. Returned to the pool once a worker has discarded them. Used in work-stealing mode.
+    PODVector<WorkItem*> removedItems_;
+    /// Per-thread statistics of parallel for loops during the current frame.
+    PODVector<ParallelForStats> parallelForStats_;
+    /// Per-thread statistics of parallel for loops during the last frame.
+    PODVector<ParallelForStats> lastParallelForStats_;
+    /// Per-thread frame allocators. Index 0 is the main thread.
+    PODVector<FrameAllocator*> frameAllocators_;
     /// Worker queue mutex.
     Mutex queueMutex_;
     /// Shutting down flag.
@@ -143,12 +249,20 @@ private:
     std::atomic<bool> pausing_;
     /// Paused flag. Indicates the queue mutex being locked to prevent worker threads using up CPU time.
     bool paused_;
+    /// Work-stealing mode flag.
+    std::atomic<bool> workStealing_;
+    /// Next worker thread deque to distribute work items to. Used in work-stealing mode.
+    unsigned nextThread_;
+    /// Random seed for choosing the victim deque when the main thread takes work.
+    unsigned stealSeed_;
     /// Completing work in the main thread flag.
     bool completing_;
     /// Tolerance for the shared pool before it begins to deallocate.
     int tolerance_;
-    /// Last size of the shared pool.
-    unsigned lastSize_;
+    /// Number of pooled items allocated.
+    unsigned numPooledItems_;
+    /// Highest number of pooled items in use since the pool was last purged.
+    unsigned maxPooledItemsInUse_;
     /// Maximum milliseconds per frame to spend on low-priority work, when there are no worker threads.
     int maxNonThreadedWorkMs_;
 };
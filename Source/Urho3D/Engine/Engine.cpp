@@ -118,6 +118,12 @@ Engine::Engine(Context* context) :
     // Register self as a subsystem
     context_->RegisterSubsystem(this);
 
+    // Bind the typed frame update channels once, so that sending them needs no lookup
+    updateChannel_ = context_->GetEventChannel<LogicUpdateEvent>();
+    postUpdateChannel_ = context_->GetEventChannel<PostUpdateEvent>();
+    renderUpdateChannel_ = context_->GetEventChannel<RenderUpdateEvent>();
+    postRenderUpdateChannel_ = context_->GetEventChannel<PostRenderUpdateEvent>();
+
     // Create subsystems which do not depend on engine initialization or startup parameters
     context_->RegisterSubsystem(new Time(context_));
     context_->RegisterSubsystem(new WorkQueue(context_));
@@ -210,7 +216,9 @@ bool Engine::Initialize(const VariantMap& parameters)
     unsigned numThreads = GetParameter(parameters, EP_WORKER_THREADS, true).GetBool() ? GetNumPhysicalCPUs() - 1 : 0;
     if (numThreads)
     {
-        GetSubsystem<WorkQueue>()->CreateThreads(numThreads);
+        auto* workQueue = GetSubsystem<WorkQueue>();
+        workQueue->SetWorkStealing(GetParameter(parameters, EP_WORK_STEALING, false).GetBool());
+        workQueue->CreateThreads(numThreads);
 
         URHO3D_LOGINFOF("Created %u worker thread%s", numThreads, numThreads > 1 ? "s" : "");
     }
@@ -264,6 +272,12 @@ bool Engine::Initialize(const VariantMap& parameters)
 
         if (HasParameter(parameters, EP_DUMP_SHADERS))
             graphics->BeginDumpShaders(GetParameter(parameters, EP_DUMP_SHADERS, String::EMPTY).GetString());
+        if (HasParameter(parameters, EP_SHADER_PRECACHE))
+        {
+            SharedPtr<File> precacheFile = cache->GetFile(GetParameter(parameters, EP_SHADER_PRECACHE).GetString());
+            if (precacheFile)
+                graphics->PrecacheShaders(*precacheFile);
+        }
         if (HasParameter(parameters, EP_RENDER_PATH))
             renderer->SetDefaultRenderPath(cache->GetResource<XMLFile>(GetParameter(parameters, EP_RENDER_PATH).GetString()));
 
@@ -694,15 +708,19 @@ void Engine::Update()
     VariantMap& eventData = GetEventDataMap();
     eventData[P_TIMESTEP] = timeStep_;
     SendEvent(E_UPDATE, eventData);
+    updateChannel_->Send(LogicUpdateEvent{timeStep_});
 
     // Logic post-update event
     SendEvent(E_POSTUPDATE, eventData);
+    postUpdateChannel_->Send(PostUpdateEvent{timeStep_});
 
     // Rendering update event
     SendEvent(E_RENDERUPDATE, eventData);
+    renderUpdateChannel_->Send(RenderUpdateEvent{timeStep_});
 
     // Post-render update event
     SendEvent(E_POSTRENDERUPDATE, eventData);
+    postRenderUpdateChannel_->Send(PostRenderUpdateEvent{timeStep_});
 }
 
 void Engine::Render()
@@ -30,6 +30,11 @@ namespace Urho3D
 
 class Console;
 class DebugHud;
+template <class E> class EventChannel;
+struct LogicUpdateEvent;
+struct PostRenderUpdateEvent;
+struct PostUpdateEvent;
+struct RenderUpdateEvent;
 
 /// Urho3D engine. Creates the other subsystems.
 class URHO3D_API Engine : public Object
@@ -145,6 +150,14 @@ private:
     HiresTimer frameTimer_;
     /// Previous timesteps for smoothing.
     PODVector<float> lastTimeSteps_;
+    /// Typed logic update event channel.
+    EventChannel<LogicUpdateEvent>* updateChannel_;
+    /// Typed logic post-update event channel.
+    EventChannel<PostUpdateEvent>* postUpdateChannel_;
+    /// Typed render update event channel.
+    EventChannel<RenderUpdateEvent>* renderUpdateChannel_;
+    /// Typed post-render update event channel.
+    EventChannel<PostRenderUpdateEvent>* postRenderUpdateChannel_;
     /// Next frame timestep in seconds.
     float timeStep_;
     /// How many frames to average for the smoothed timestep.
@@ -52,6 +52,7 @@ static const String EP_RESOURCE_PACKAGES = "ResourcePackages";
 static const String EP_RESOURCE_PATHS = "ResourcePaths";
 static const String EP_RESOURCE_PREFIX_PATHS = "ResourcePrefixPaths";
 static const String EP_SHADER_CACHE_DIR = "ShaderCacheDir";
+static const String EP_SHADER_PRECACHE = "ShaderPrecache";
 static const String EP_SHADOWS = "Shadows";
 static const String EP_SOUND = "Sound";
 static const String EP_SOUND_BUFFER = "SoundBuffer";
@@ -73,5 +74,6 @@ static const String EP_WINDOW_RESIZABLE = "WindowResizable";
 static const String EP_WINDOW_TITLE = "WindowTitle";
 static const String EP_WINDOW_WIDTH = "WindowWidth";
 static const String EP_WORKER_THREADS = "WorkerThreads";
+static const String EP_WORK_STEALING = "WorkStealing";
 
 }
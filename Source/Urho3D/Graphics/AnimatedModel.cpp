@@ -928,7 +928,7 @@ void AnimatedModel::UpdateBoneBoundingBox()
     }
 
     boneBoundingBoxDirty_ = false;
-    worldBoundingBoxDirty_ = true;
+    MarkWorldBoundingBoxDirty();
 }
 
 void AnimatedModel::OnNodeSet(Node* node)
@@ -22,6 +22,7 @@
 
 #include "../Precompiled.h"
 
+#include "../Container/FrameAllocator.h"
 #include "../Graphics/Camera.h"
 #include "../Graphics/Geometry.h"
 #include "../Graphics/Graphics.h"
@@ -40,12 +41,34 @@
 namespace Urho3D
 {
 
+/// Minimum number of batches for using a radix sort instead of a comparison sort.
+static const unsigned RADIX_SORT_THRESHOLD = 1024;
+/// Number of frames a retained batch group can stay unused before it is removed.
+static const unsigned MAX_RETAINED_UNUSED_FRAMES = 16;
+
+/// Return whether the batches have the same state sorting keys.
+inline bool IsSameBatchState(Batch* lhs, Batch* rhs)
+{
+    return lhs->isBase_ == rhs->isBase_ && lhs->shaderSortKey_ == rhs->shaderSortKey_ && lhs->sortKey_ == rhs->sortKey_;
+}
+
+/// Compare the state sorting keys of the batches. Base batches go first.
+inline bool CompareBatchState(Batch* lhs, Batch* rhs)
+{
+    if (lhs->isBase_ != rhs->isBase_)
+        return lhs->isBase_;
+    else if (lhs->shaderSortKey_ != rhs->shaderSortKey_)
+        return lhs->shaderSortKey_ < rhs->shaderSortKey_;
+    else
+        return lhs->sortKey_ < rhs->sortKey_;
+}
+
 inline bool CompareBatchesState(Batch* lhs, Batch* rhs)
 {
     if (lhs->renderOrder_ != rhs->renderOrder_)
         return lhs->renderOrder_ < rhs->renderOrder_;
-    else if (lhs->sortKey_ != rhs->sortKey_)
-        return lhs->sortKey_ < rhs->sortKey_;
+    else if (!IsSameBatchState(lhs, rhs))
+        return CompareBatchState(lhs, rhs);
     else
         return lhs->distance_ < rhs->distance_;
 }
@@ -57,7 +80,7 @@ inline bool CompareBatchesFrontToBack(Batch* lhs, Batch* rhs)
     else if (lhs->distance_ != rhs->distance_)
         return lhs->distance_ < rhs->distance_;
     else
-        return lhs->sortKey_ < rhs->sortKey_;
+        return CompareBatchState(lhs, rhs);
 }
 
 inline bool CompareBatchesBackToFront(Batch* lhs, Batch* rhs)
@@ -67,7 +90,15 @@ inline bool CompareBatchesBackToFront(Batch* lhs, Batch* rhs)
     else if (lhs->distance_ != rhs->distance_)
         return lhs->distance_ > rhs->distance_;
     else
-        return lhs->sortKey_ < rhs->sortKey_;
+        return CompareBatchState(lhs, rhs);
+}
+
+/// Map a float to an unsigned integer with the same ordering.
+inline unsigned FloatToOrderedUInt(float value)
+{
+    unsigned bits;
+    memcpy(&bits, &value, sizeof bits);
+    return (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u);
 }
 
 inline bool CompareInstancesFrontToBack(const InstanceData& lhs, const InstanceData& rhs)
@@ -161,18 +192,17 @@ void CalculateSpotMatrix(Matrix4& dest, Light* light)
 
 void Batch::CalculateSortKey()
 {
-    auto shaderID = (unsigned)(
-        ((*((unsigned*)&vertexShader_) / sizeof(ShaderVariation)) + (*((unsigned*)&pixelShader_) / sizeof(ShaderVariation))) &
-        0x7fffu);
-    if (!isBase_)
-        shaderID |= 0x8000;
-
-    auto lightQueueID = (unsigned)((*((unsigned*)&lightQueue_) / sizeof(LightBatchQueue)) & 0xffffu);
-    auto materialID = (unsigned)((*((unsigned*)&material_) / sizeof(Material)) & 0xffffu);
-    auto geometryID = (unsigned)((*((unsigned*)&geometry_) / sizeof(Geometry)) & 0xffffu);
-
-    sortKey_ = (((unsigned long long)shaderID) << 48u) | (((unsigned long long)lightQueueID) << 32u) |
-               (((unsigned long long)materialID) << 16u) | geometryID;
+    // Use the small stable IDs of the objects, so that the key does not depend on memory addresses
+    // The base pass flag is not part of the keys, as it is compared directly
+    unsigned vsID = vertexShader_ ? vertexShader_->GetSortID() & 0xffffu : 0;
+    unsigned psID = pixelShader_ ? pixelShader_->GetSortID() & 0xffffu : 0;
+    shaderSortKey_ = (psID << 16u) | vsID;
+
+    unsigned lightQueueID = lightQueue_ ? lightQueue_->sortID_ & 0xffffu : 0;
+    unsigned materialID = material_ ? material_->GetSortID() & 0xffffu : 0;
+    unsigned geometryID = geometry_ ? geometry_->GetSortID() & 0xffffu : 0;
+
+    sortKey_ = (((unsigned long long)lightQueueID) << 32u) | (((unsigned long long)materialID) << 16u) | geometryID;
 }
 
 void Batch::Prepare(View* view, Camera* camera, bool setModelTransform, bool allowDepthWrite) const
@@ -593,15 +623,38 @@ void Batch::Prepare(View* view, Camera* camera, bool setModelTransform, bool all
         graphics->SetTexture(TU_ENVIRONMENT, zone_->GetZoneTexture());
 #endif
 
+    // Set the cluster grid light lists if using clustered lighting. Otherwise the light buffer unit is bound by the renderpath
+    if (graphics->HasTextureUnit(TU_LIGHTBUFFER))
+    {
+        Texture2D* clusterTexture = view->GetClusterTexture();
+        if (clusterTexture)
+            graphics->SetTexture(TU_LIGHTBUFFER, clusterTexture);
+    }
+
     // Set material-specific shader parameters and textures
     if (material_)
     {
+        const HashMap<StringHash, MaterialShaderParameter>& parameters = material_->GetShaderParameters();
         if (graphics->NeedParameterUpdate(SP_MATERIAL, reinterpret_cast<const void*>(material_->GetShaderParameterHash())))
         {
-            const HashMap<StringHash, MaterialShaderParameter>& parameters = material_->GetShaderParameters();
-            for (HashMap<StringHash, MaterialShaderParameter>::ConstIterator i = parameters.Begin(); i != parameters.End(); ++i)
-                graphics->SetShaderParameter(i->first_, i->second_.value_);
+            // Copy whole constant buffers precomputed by the material if possible, else set the parameters one by one
+            const ShaderParameterBlock* block = material_->GetShaderParameterBlock(graphics);
+            if (block)
+            {
+                if (graphics->SetShaderParameterBlock(*block, material_))
+                    renderer->AddShaderParameterStats(parameters.Size(), 0);
+                else
+                    renderer->AddShaderParameterStats(0, parameters.Size());
+            }
+            else
+            {
+                for (HashMap<StringHash, MaterialShaderParameter>::ConstIterator i = parameters.Begin(); i != parameters.End(); ++i)
+                    graphics->SetShaderParameter(i->first_, i->second_.value_);
+                renderer->AddShaderParameterStats(parameters.Size(), 0);
+            }
         }
+        else
+            renderer->AddShaderParameterStats(0, parameters.Size());
 
         const HashMap<TextureUnit, SharedPtr<Texture> >& textures = material_->GetTextures();
         for (HashMap<TextureUnit, SharedPtr<Texture> >::ConstIterator i = textures.Begin(); i != textures.End(); ++i)
@@ -642,14 +695,14 @@ void Batch::Draw(View* view, Camera* camera, bool allowDepthWrite) const
     }
 }
 
-void BatchGroup::SetInstancingData(void* lockedData, unsigned stride, unsigned& freeIndex)
+void BatchGroup::SetInstancingData(void* lockedData, unsigned lockStart, unsigned stride, unsigned& freeIndex)
 {
     // Do not use up buffer space if not going to draw as instanced
     if (geometryType_ != GEOM_INSTANCED)
         return;
 
     startIndex_ = freeIndex;
-    unsigned char* buffer = static_cast<unsigned char*>(lockedData) + startIndex_ * stride;
+    unsigned char* buffer = static_cast<unsigned char*>(lockedData) + (startIndex_ - lockStart) * stride;
 
     for (unsigned i = 0; i < instances_.Size(); ++i)
     {
@@ -721,36 +774,67 @@ void BatchQueue::Clear(int maxSortedInstances)
 {
     batches_.Clear();
     sortedBatches_.Clear();
-    batchGroups_.Clear();
+    sortedBatchGroups_.Clear();
+
+    if (retainBatchGroups_)
+    {
+        // Keep the groups along with their instance storage and shaders, but remove the ones unused for a while
+        for (HashMap<BatchGroupKey, BatchGroup>::Iterator i = batchGroups_.Begin(); i != batchGroups_.End();)
+        {
+            BatchGroup& group = i->second_;
+            if (group.instances_.Empty())
+            {
+                if (++group.numUnusedFrames_ > MAX_RETAINED_UNUSED_FRAMES)
+                {
+                    i = batchGroups_.Erase(i);
+                    continue;
+                }
+            }
+            else
+            {
+                group.instances_.Clear();
+                group.numUnusedFrames_ = 0;
+            }
+            ++i;
+        }
+    }
+    else
+        batchGroups_.Clear();
+
+    numUsedBatchGroups_ = 0;
     maxSortedInstances_ = (unsigned)maxSortedInstances;
 }
 
-void BatchQueue::SortBackToFront()
+void BatchQueue::SortBackToFront(FrameAllocator* allocator)
 {
     sortedBatches_.Resize(batches_.Size());
 
     for (unsigned i = 0; i < batches_.Size(); ++i)
         sortedBatches_[i] = &batches_[i];
 
-    Sort(sortedBatches_.Begin(), sortedBatches_.End(), CompareBatchesBackToFront);
+    SortBatches(sortedBatches_, BSM_BACKTOFRONT, allocator);
 
-    sortedBatchGroups_.Resize(batchGroups_.Size());
+    sortedBatchGroups_.Resize(numUsedBatchGroups_);
 
+    // Skip retained groups that received no instances this frame
     unsigned index = 0;
     for (HashMap<BatchGroupKey, BatchGroup>::Iterator i = batchGroups_.Begin(); i != batchGroups_.End(); ++i)
-        sortedBatchGroups_[index++] = &i->second_;
+    {
+        if (!i->second_.instances_.Empty())
+            sortedBatchGroups_[index++] = &i->second_;
+    }
 
     Sort(sortedBatchGroups_.Begin(), sortedBatchGroups_.End(), CompareBatchGroupOrder);
 }
 
-void BatchQueue::SortFrontToBack()
+void BatchQueue::SortFrontToBack(FrameAllocator* allocator)
 {
     sortedBatches_.Clear();
 
     for (unsigned i = 0; i < batches_.Size(); ++i)
         sortedBatches_.Push(&batches_[i]);
 
-    SortFrontToBack2Pass(sortedBatches_);
+    SortFrontToBack2Pass(sortedBatches_, allocator);
 
     // Sort each group front to back
     for (HashMap<BatchGroupKey, BatchGroup>::Iterator i = batchGroups_.Begin(); i != batchGroups_.End(); ++i)
@@ -770,24 +854,28 @@ void BatchQueue::SortFrontToBack()
         }
     }
 
-    sortedBatchGroups_.Resize(batchGroups_.Size());
+    sortedBatchGroups_.Resize(numUsedBatchGroups_);
 
+    // Skip retained groups that received no instances this frame
     unsigned index = 0;
     for (HashMap<BatchGroupKey, BatchGroup>::Iterator i = batchGroups_.Begin(); i != batchGroups_.End(); ++i)
-        sortedBatchGroups_[index++] = &i->second_;
+    {
+        if (!i->second_.instances_.Empty())
+            sortedBatchGroups_[index++] = &i->second_;
+    }
 
-    SortFrontToBack2Pass(reinterpret_cast<PODVector<Batch*>& >(sortedBatchGroups_));
+    SortFrontToBack2Pass(reinterpret_cast<PODVector<Batch*>& >(sortedBatchGroups_), allocator);
 }
 
-void BatchQueue::SortFrontToBack2Pass(PODVector<Batch*>& batches)
+void BatchQueue::SortFrontToBack2Pass(PODVector<Batch*>& batches, FrameAllocator* allocator)
 {
     // Mobile devices likely use a tiled deferred approach, with which front-to-back sorting is irrelevant. The 2-pass
     // method is also time consuming, so just sort with state having priority
 #ifdef GL_ES_VERSION_2_0
-    Sort(batches.Begin(), batches.End(), CompareBatchesState);
+    SortBatches(batches, BSM_STATE, allocator);
 #else
     // For desktop, first sort by distance and remap shader/material/geometry IDs in the sort key
-    Sort(batches.Begin(), batches.End(), CompareBatchesFrontToBack);
+    SortBatches(batches, BSM_FRONTTOBACK, allocator);
 
     unsigned freeShaderID = 0;
     unsigned short freeMaterialID = 0;
@@ -797,13 +885,15 @@ void BatchQueue::SortFrontToBack2Pass(PODVector<Batch*>& batches)
     {
         Batch* batch = *i;
 
-        auto shaderID = (unsigned)(batch->sortKey_ >> 32u);
-        HashMap<unsigned, unsigned>::ConstIterator j = shaderRemapping_.Find(shaderID);
+        // Remap the shaders and light queue together. The base pass flag is compared separately
+        unsigned long long shaderKey = (((unsigned long long)batch->shaderSortKey_) << 16u) | (batch->sortKey_ >> 32u);
+        unsigned shaderID;
+        HashMap<unsigned long long, unsigned>::ConstIterator j = shaderRemapping_.Find(shaderKey);
         if (j != shaderRemapping_.End())
             shaderID = j->second_;
         else
         {
-            shaderID = shaderRemapping_[shaderID] = freeShaderID | (shaderID & 0x80000000);
+            shaderID = shaderRemapping_[shaderKey] = freeShaderID;
             ++freeShaderID;
         }
 
@@ -827,7 +917,8 @@ void BatchQueue::SortFrontToBack2Pass(PODVector<Batch*>& batches)
             ++freeGeometryID;
         }
 
-        batch->sortKey_ = (((unsigned long long)shaderID) << 32u) | (((unsigned long long)materialID) << 16u) | geometryID;
+        batch->shaderSortKey_ = shaderID;
+        batch->sortKey_ = (((unsigned long long)materialID) << 16u) | geometryID;
     }
 
     shaderRemapping_.Clear();
@@ -835,14 +926,81 @@ void BatchQueue::SortFrontToBack2Pass(PODVector<Batch*>& batches)
     geometryRemapping_.Clear();
 
     // Finally sort again with the rewritten ID's
-    Sort(batches.Begin(), batches.End(), CompareBatchesState);
+    SortBatches(batches, BSM_STATE, allocator);
 #endif
 }
 
-void BatchQueue::SetInstancingData(void* lockedData, unsigned stride, unsigned& freeIndex)
+void BatchQueue::SortBatches(PODVector<Batch*>& batches, BatchSortMode mode, FrameAllocator* allocator)
+{
+    unsigned numBatches = batches.Size();
+
+    if (numBatches < RADIX_SORT_THRESHOLD || !allocator)
+    {
+        switch (mode)
+        {
+        case BSM_STATE:
+            Sort(batches.Begin(), batches.End(), CompareBatchesState);
+            break;
+
+        case BSM_FRONTTOBACK:
+            Sort(batches.Begin(), batches.End(), CompareBatchesFrontToBack);
+            break;
+
+        case BSM_BACKTOFRONT:
+            Sort(batches.Begin(), batches.End(), CompareBatchesBackToFront);
+            break;
+        }
+        return;
+    }
+
+    // Render order (8 bits), distance (32 bits), base pass flag (1 bit), shader sort key (32 bits) and the rest of the sort key
+    // (48 bits) fit in a 128-bit key without loss, so the result matches the comparison sort
+    // The keys and scratch buffer are only needed during the sort, so take them from the sorting thread's frame allocator
+    // instead of keeping them in every queue
+    auto* items = allocator->Allocate<RadixSortItem<Batch*> >(numBatches);
+    auto* scratch = allocator->Allocate<RadixSortItem<Batch*> >(numBatches);
+
+    for (unsigned i = 0; i < numBatches; ++i)
+    {
+        Batch* batch = batches[i];
+        RadixSortItem<Batch*>& item = items[i];
+        auto renderOrder = (unsigned long long)batch->renderOrder_;
+        auto distance = (unsigned long long)FloatToOrderedUInt(batch->distance_);
+        auto notBase = (unsigned long long)!batch->isBase_;
+        auto shaderKey = (unsigned long long)batch->shaderSortKey_;
+        unsigned long long sortKey = batch->sortKey_ & 0xffffffffffffULL;
+
+        switch (mode)
+        {
+        case BSM_STATE:
+            item.highKey_ = (renderOrder << 56u) | (notBase << 55u) | (shaderKey << 23u) | (sortKey >> 25u);
+            item.lowKey_ = (sortKey << 39u) | (distance << 7u);
+            break;
+
+        case BSM_FRONTTOBACK:
+            item.highKey_ = (renderOrder << 56u) | (distance << 24u) | (notBase << 23u) | (shaderKey >> 9u);
+            item.lowKey_ = (shaderKey << 55u) | (sortKey << 7u);
+            break;
+
+        case BSM_BACKTOFRONT:
+            item.highKey_ = (renderOrder << 56u) | ((~distance & 0xffffffffu) << 24u) | (notBase << 23u) | (shaderKey >> 9u);
+            item.lowKey_ = (shaderKey << 55u) | (sortKey << 7u);
+            break;
+        }
+
+        item.value_ = batch;
+    }
+
+    RadixSort(items, scratch, numBatches);
+
+    for (unsigned i = 0; i < numBatches; ++i)
+        batches[i] = items[i].value_;
+}
+
+void BatchQueue::SetInstancingData(void* lockedData, unsigned lockStart, unsigned stride, unsigned& freeIndex)
 {
     for (HashMap<BatchGroupKey, BatchGroup>::Iterator i = batchGroups_.Begin(); i != batchGroups_.End(); ++i)
-        i->second_.SetInstancingData(lockedData, stride, freeIndex);
+        i->second_.SetInstancingData(lockedData, lockStart, stride, freeIndex);
 }
 
 void BatchQueue::Draw(View* view, Camera* camera, bool markToStencil, bool usingLightOptimization, bool allowDepthWrite) const
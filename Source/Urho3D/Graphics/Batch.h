@@ -23,6 +23,7 @@
 #pragma once
 
 #include "../Container/Ptr.h"
+#include "../Container/Sort.h"
 #include "../Graphics/Drawable.h"
 #include "../Graphics/Material.h"
 #include "../Math/MathDefs.h"
@@ -34,6 +35,7 @@ namespace Urho3D
 
 class Camera;
 class Drawable;
+class FrameAllocator;
 class Geometry;
 class Light;
 class Material;
@@ -46,6 +48,14 @@ class View;
 class Zone;
 struct LightBatchQueue;
 
+/// Batch sorting criterion after render order.
+enum BatchSortMode
+{
+    BSM_STATE = 0,
+    BSM_FRONTTOBACK,
+    BSM_BACKTOFRONT
+};
+
 /// Queued 3D geometry draw call.
 struct Batch
 {
@@ -67,15 +77,17 @@ struct Batch
     {
     }
 
-    /// Calculate state sorting key, which consists of base pass flag, light, pass and geometry.
+    /// Calculate state sorting keys. The shaders go to their own key, and the light queue, material and geometry to the other.
     void CalculateSortKey();
     /// Prepare for rendering.
     void Prepare(View* view, Camera* camera, bool setModelTransform, bool allowDepthWrite) const;
     /// Prepare and draw.
     void Draw(View* view, Camera* camera, bool allowDepthWrite) const;
 
-    /// State sorting key.
+    /// State sorting key of the light queue, material and geometry. Compared after the base pass flag and the shader sorting key.
     unsigned long long sortKey_{};
+    /// State sorting key of the pixel and vertex shaders.
+    unsigned shaderSortKey_{};
     /// Distance from camera.
     float distance_{};
     /// 8-bit render order modifier from material.
@@ -163,8 +175,8 @@ struct BatchGroup : public Batch
         }
     }
 
-    /// Pre-set the instance data. Buffer must be big enough to hold all data.
-    void SetInstancingData(void* lockedData, unsigned stride, unsigned& freeIndex);
+    /// Pre-set the instance data. Buffer must be big enough to hold all data. The locked data begins at instance index lockStart.
+    void SetInstancingData(void* lockedData, unsigned lockStart, unsigned stride, unsigned& freeIndex);
     /// Prepare and draw.
     void Draw(View* view, Camera* camera, bool allowDepthWrite) const;
 
@@ -172,6 +184,16 @@ struct BatchGroup : public Batch
     PODVector<InstanceData> instances_;
     /// Instance stream start index, or M_MAX_UNSIGNED if transforms not pre-set.
     unsigned startIndex_;
+    /// Retained vertex shaders for static and instanced rendering.
+    ShaderVariation* retainedVertexShaders_[2]{};
+    /// Retained pixel shaders for static and instanced rendering.
+    ShaderVariation* retainedPixelShaders_[2]{};
+    /// Pass shaders version of the retained shaders.
+    unsigned retainedShadersVersion_{};
+    /// Zone height fog flag of the retained shaders.
+    bool retainedHeightFog_{};
+    /// Number of consecutive frames without instances in a retained batch queue.
+    unsigned numUnusedFrames_{};
 };
 
 /// Instanced draw call grouping key.
@@ -228,26 +250,32 @@ struct BatchQueue
 public:
     /// Clear for new frame by clearing all groups and batches.
     void Clear(int maxSortedInstances);
-    /// Sort non-instanced draw calls back to front.
-    void SortBackToFront();
-    /// Sort instanced and non-instanced draw calls front to back.
-    void SortFrontToBack();
+    /// Sort non-instanced draw calls back to front. Uses a comparison sort.
+    void SortBackToFront() { SortBackToFront(nullptr); }
+    /// Sort non-instanced draw calls back to front. Large queues are radix sorted with scratch memory from the frame allocator, if given.
+    void SortBackToFront(FrameAllocator* allocator);
+    /// Sort instanced and non-instanced draw calls front to back. Uses a comparison sort.
+    void SortFrontToBack() { SortFrontToBack(nullptr); }
+    /// Sort instanced and non-instanced draw calls front to back. Large queues are radix sorted with scratch memory from the frame allocator, if given.
+    void SortFrontToBack(FrameAllocator* allocator);
     /// Sort batches front to back while also maintaining state sorting.
-    void SortFrontToBack2Pass(PODVector<Batch*>& batches);
-    /// Pre-set instance data of all groups. The vertex buffer must be big enough to hold all data.
-    void SetInstancingData(void* lockedData, unsigned stride, unsigned& freeIndex);
+    void SortFrontToBack2Pass(PODVector<Batch*>& batches, FrameAllocator* allocator = nullptr);
+    /// Sort batches by render order, then by state or distance. Uses a radix sort for large queues if a frame allocator is given for the scratch memory.
+    void SortBatches(PODVector<Batch*>& batches, BatchSortMode mode, FrameAllocator* allocator = nullptr);
+    /// Pre-set instance data of all groups. The vertex buffer must be big enough to hold all data. The locked data begins at instance index lockStart.
+    void SetInstancingData(void* lockedData, unsigned lockStart, unsigned stride, unsigned& freeIndex);
     /// Draw.
     void Draw(View* view, Camera* camera, bool markToStencil, bool usingLightOptimization, bool allowDepthWrite) const;
     /// Return the combined amount of instances.
     unsigned GetNumInstances() const;
 
     /// Return whether the batch group is empty.
-    bool IsEmpty() const { return batches_.Empty() && batchGroups_.Empty(); }
+    bool IsEmpty() const { return batches_.Empty() && !numUsedBatchGroups_; }
 
     /// Instanced draw calls.
     HashMap<BatchGroupKey, BatchGroup> batchGroups_;
     /// Shader remapping table for 2-pass state and distance sort.
-    HashMap<unsigned, unsigned> shaderRemapping_;
+    HashMap<unsigned long long, unsigned> shaderRemapping_;
     /// Material remapping table for 2-pass state and distance sort.
     HashMap<unsigned short, unsigned short> materialRemapping_;
     /// Geometry remapping table for 2-pass state and distance sort.
@@ -259,6 +287,10 @@ public:
     PODVector<Batch*> sortedBatches_;
     /// Sorted instanced draw calls.
     PODVector<BatchGroup*> sortedBatchGroups_;
+    /// Number of instanced draw calls with instances this frame. Retained groups may be empty.
+    unsigned numUsedBatchGroups_{};
+    /// Whether to keep the instanced draw calls and their shaders on clear.
+    bool retainBatchGroups_{};
     /// Maximum sorted instances.
     unsigned maxSortedInstances_;
     /// Whether the pass command contains extra shader defines.
@@ -291,6 +323,8 @@ struct ShadowBatchQueue
 /// Queue for light related draw calls.
 struct LightBatchQueue
 {
+    /// Small ID used in the batch sort keys. Unique among the light queues of a view.
+    unsigned sortID_;
     /// Per-pixel light.
     Light* light_;
     /// Light negative flag.
@@ -48,6 +48,7 @@ void ConstantBuffer::SetParameter(unsigned offset, unsigned size, const void* da
         return; // Would overflow the buffer
 
     memcpy(&shadowData_[offset], data, size);
+    dataSource_ = nullptr;
     dirty_ = true;
 }
 
@@ -67,6 +68,18 @@ void ConstantBuffer::SetVector3ArrayParameter(unsigned offset, unsigned rows, co
         ++dest; // Skip over the w coordinate
     }
 
+    dataSource_ = nullptr;
+    dirty_ = true;
+}
+
+void ConstantBuffer::SetData(const void* data, const void* source, unsigned version)
+{
+    if (!size_)
+        return;
+
+    memcpy(shadowData_.Get(), data, size_);
+    dataSource_ = source;
+    dataVersion_ = version;
     dirty_ = true;
 }
 
@@ -52,6 +52,8 @@ public:
     void SetParameter(unsigned offset, unsigned size, const void* data);
     /// Set a Vector3 array parameter and mark buffer dirty.
     void SetVector3ArrayParameter(unsigned offset, unsigned rows, const void* data);
+    /// Set the whole buffer contents from precomputed data and mark buffer dirty. The source and version identify the data for skipping redundant copies.
+    void SetData(const void* data, const void* source, unsigned version);
     /// Apply to GPU.
     void Apply();
 
@@ -61,11 +63,18 @@ public:
     /// Return whether has unapplied data.
     bool IsDirty() const { return dirty_; }
 
+    /// Return whether the contents were last set from the given precomputed data source and version.
+    bool HasData(const void* source, unsigned version) const { return source && source == dataSource_ && version == dataVersion_; }
+
 private:
     /// Shadow data.
     SharedArrayPtr<unsigned char> shadowData_;
     /// Buffer byte size.
     unsigned size_{};
+    /// Source of the precomputed data the contents were last set from, or null if modified by individual parameters.
+    const void* dataSource_{};
+    /// Version of the precomputed data the contents were last set from.
+    unsigned dataVersion_{};
     /// Dirty flag.
     bool dirty_{};
 };
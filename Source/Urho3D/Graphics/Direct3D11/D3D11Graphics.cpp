@@ -892,6 +892,12 @@ void Graphics::SetShaders(ShaderVariation* vs, ShaderVariation* ps)
     if (vs == vertexShader_ && ps == pixelShader_)
         return;
 
+    // Wait for asynchronous compiles to finish, as the shaders are needed now
+    if (vs && vs->IsCompiling())
+        vs->Create();
+    if (ps && ps->IsCompiling())
+        ps->Create();
+
     if (vs != vertexShader_)
     {
         // Create the shader now if not yet created. If already attempted, do not retry
@@ -1142,6 +1148,27 @@ bool Graphics::HasShaderParameter(StringHash param)
     return impl_->shaderProgram_ && impl_->shaderProgram_->parameters_.Find(param) != impl_->shaderProgram_->parameters_.End();
 }
 
+bool Graphics::SetShaderParameterBlock(const ShaderParameterBlock& block, const void* source)
+{
+    bool copied = false;
+    const unsigned char* data = block.data_.Buffer();
+
+    for (PODVector<ConstantBuffer*>::ConstIterator i = block.buffers_.Begin(); i != block.buffers_.End(); ++i)
+    {
+        ConstantBuffer* buffer = *i;
+        if (!buffer->HasData(source, block.version_))
+        {
+            if (!buffer->IsDirty())
+                impl_->dirtyConstantBuffers_.Push(buffer);
+            buffer->SetData(data, source, block.version_);
+            copied = true;
+        }
+        data += buffer->GetSize();
+    }
+
+    return copied;
+}
+
 bool Graphics::HasTextureUnit(TextureUnit unit)
 {
     return (vertexShader_ && vertexShader_->HasTextureUnit(unit)) || (pixelShader_ && pixelShader_->HasTextureUnit(unit));
@@ -1661,6 +1688,15 @@ ShaderProgram* Graphics::GetShaderProgram() const
     return impl_->shaderProgram_;
 }
 
+const ShaderParameter* Graphics::GetShaderParameterInfo(StringHash param) const
+{
+    if (!impl_->shaderProgram_)
+        return nullptr;
+
+    HashMap<StringHash, ShaderParameter>::ConstIterator i = impl_->shaderProgram_->parameters_.Find(param);
+    return i != impl_->shaderProgram_->parameters_.End() ? &i->second_ : nullptr;
+}
+
 TextureUnit Graphics::GetTextureUnit(const String& name)
 {
     HashMap<String, TextureUnit>::Iterator i = textureUnits_.Find(name);
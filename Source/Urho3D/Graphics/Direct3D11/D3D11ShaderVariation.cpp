@@ -22,6 +22,8 @@
 
 #include "../../Precompiled.h"
 
+#include "../../Core/Profiler.h"
+#include "../../Core/WorkQueue.h"
 #include "../../Graphics/Graphics.h"
 #include "../../Graphics/GraphicsImpl.h"
 #include "../../Graphics/Shader.h"
@@ -58,6 +60,12 @@ void ShaderVariation::OnDeviceLost()
 
 bool ShaderVariation::Create()
 {
+    if (compiling_)
+    {
+        WaitForCompile();
+        return object_.ptr_ != nullptr;
+    }
+
     Release();
 
     if (!graphics_)
@@ -70,16 +78,12 @@ bool ShaderVariation::Create()
     }
 
     // Check for up-to-date bytecode on disk
-    String path, name, extension;
-    SplitPath(owner_->GetName(), path, name, extension);
-    extension = type_ == VS ? ".vs4" : ".ps4";
-
-    String binaryShaderName = graphics_->GetShaderCacheDir() + name + "_" + StringHash(defines_).ToString() + extension;
+    String binaryShaderName = GetByteCodeFileName(type_ == VS ? ".vs4" : ".ps4");
 
     if (!LoadByteCode(binaryShaderName))
     {
         // Compile shader if don't have valid bytecode
-        if (!Compile())
+        if (!Compile(owner_->GetSourceCode(type_), owner_->GetName()))
             return false;
         // Save the bytecode after successful compile, but not if the source is from a package
         if (owner_->GetTimeStamp())
@@ -87,6 +91,88 @@ bool ShaderVariation::Create()
     }
 
     // Then create shader from the bytecode
+    return CreateFromByteCode();
+}
+
+bool ShaderVariation::CreateAsync()
+{
+    if (compiling_)
+        return true;
+
+    // Loading cached bytecode is fast, so compile in a worker thread only when there is no cache entry. D3DCompile and the
+    // device's shader creation are thread-safe
+    auto* queue = graphics_ ? graphics_->GetSubsystem<WorkQueue>() : nullptr;
+    if (!queue || !queue->GetNumThreads() || !owner_ ||
+        owner_->GetSubsystem<ResourceCache>()->Exists(GetByteCodeFileName(type_ == VS ? ".vs4" : ".ps4")))
+        return Create();
+
+    Release();
+
+    // Copy the source, as a shader reload could modify it while compiling
+    compileSourceCode_ = owner_->GetSourceCode(type_);
+    compileSourceName_ = owner_->GetName();
+
+    compileItem_ = queue->GetFreeItem();
+    compileItem_->workFunction_ = CompileWork;
+    compileItem_->start_ = this;
+    // Lowest priority, so that rendering work does not wait for compiles
+    compileItem_->priority_ = 0;
+    compiling_ = true;
+    queue->AddWorkItem(compileItem_);
+
+    return true;
+}
+
+bool ShaderVariation::PollCompile()
+{
+    if (!compiling_)
+        return false;
+
+    if (!compileItem_->completed_)
+        return true;
+
+    FinishCompile();
+    return false;
+}
+
+void ShaderVariation::CompileWork(const WorkItem* item, unsigned threadIndex)
+{
+    auto* variation = reinterpret_cast<ShaderVariation*>(item->start_);
+
+    if (variation->Compile(variation->compileSourceCode_, variation->compileSourceName_))
+        variation->CreateFromByteCode();
+}
+
+void ShaderVariation::WaitForCompile()
+{
+    // If the work queue has already been destroyed, the item has either completed or will never run
+    auto* queue = graphics_ ? graphics_->GetSubsystem<WorkQueue>() : nullptr;
+    if (queue && !compileItem_->completed_)
+    {
+        URHO3D_PROFILE(WaitForShaderCompile);
+
+        PODVector<WorkItem*> items;
+        items.Push(compileItem_);
+        queue->Complete(items);
+    }
+
+    FinishCompile();
+}
+
+void ShaderVariation::FinishCompile()
+{
+    compiling_ = false;
+    compileItem_.Reset();
+    compileSourceCode_.Clear();
+    compileSourceName_.Clear();
+
+    // Save the bytecode after successful compile, but not if the source is from a package
+    if (object_.ptr_ && owner_ && owner_->GetTimeStamp())
+        SaveByteCode(GetByteCodeFileName(type_ == VS ? ".vs4" : ".ps4"));
+}
+
+bool ShaderVariation::CreateFromByteCode()
+{
     ID3D11Device* device = graphics_->GetImpl()->GetDevice();
     if (type_ == VS)
     {
@@ -122,6 +208,10 @@ bool ShaderVariation::Create()
 
 void ShaderVariation::Release()
 {
+    // The compile writes the bytecode and shader object, so it must finish first
+    if (compiling_)
+        WaitForCompile();
+
     if (object_.ptr_)
     {
         if (!graphics_)
@@ -170,13 +260,8 @@ bool ShaderVariation::LoadByteCode(const String& binaryShaderName)
     if (!cache->Exists(binaryShaderName))
         return false;
 
-    FileSystem* fileSystem = owner_->GetSubsystem<FileSystem>();
-    unsigned sourceTimeStamp = owner_->GetTimeStamp();
-    // If source code is loaded from a package, its timestamp will be zero. Else check that binary is not older
-    // than source
-    if (sourceTimeStamp && fileSystem->GetLastModifiedTime(cache->GetResourceFileName(binaryShaderName)) < sourceTimeStamp)
-        return false;
-
+    // The file name is keyed by the source code and defines, so the bytecode is up to date if it exists. This also allows
+    // precompiled bytecode to be shipped regardless of file timestamps
     SharedPtr<File> file = cache->GetFile(binaryShaderName);
     if (!file || file->ReadFileID() != "USHD")
     {
@@ -232,9 +317,8 @@ bool ShaderVariation::LoadByteCode(const String& binaryShaderName)
     }
 }
 
-bool ShaderVariation::Compile()
+bool ShaderVariation::Compile(const String& sourceCode, const String& sourceName)
 {
-    const String& sourceCode = owner_->GetSourceCode(type_);
     Vector<String> defines = defines_.Split(' ');
 
     // Set the entrypoint, profile and flags according to the shader being compiled
@@ -298,7 +382,7 @@ bool ShaderVariation::Compile()
     ID3DBlob* shaderCode = nullptr;
     ID3DBlob* errorMsgs = nullptr;
 
-    HRESULT hr = D3DCompile(sourceCode.CString(), sourceCode.Length(), owner_->GetName().CString(), &macros.Front(), nullptr,
+    HRESULT hr = D3DCompile(sourceCode.CString(), sourceCode.Length(), sourceName.CString(), &macros.Front(), nullptr,
         entryPoint, profile, flags, 0, &shaderCode, &errorMsgs);
     if (FAILED(hr))
     {
@@ -375,7 +459,9 @@ void ShaderVariation::ParseParameters(unsigned char* bufData, unsigned bufSize)
         String resourceName(resourceDesc.Name);
         if (resourceDesc.Type == D3D_SIT_CBUFFER)
             cbRegisterMap[resourceName] = resourceDesc.BindPoint;
-        else if (resourceDesc.Type == D3D_SIT_SAMPLER && resourceDesc.BindPoint < MAX_TEXTURE_UNITS)
+        // Textures read without a sampler (Load) also need their unit bound
+        else if ((resourceDesc.Type == D3D_SIT_SAMPLER || resourceDesc.Type == D3D_SIT_TEXTURE) &&
+            resourceDesc.BindPoint < MAX_TEXTURE_UNITS)
             useTextureUnits_[resourceDesc.BindPoint] = true;
     }
 
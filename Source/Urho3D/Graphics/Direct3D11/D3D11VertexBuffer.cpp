@@ -208,6 +208,17 @@ void* VertexBuffer::Lock(unsigned start, unsigned count, bool discard)
         return nullptr;
 }
 
+void* VertexBuffer::LockNoOverwrite(unsigned start, unsigned count)
+{
+    // Can only map the hardware buffer without overwrite if it is dynamic and not shadowed
+    if (lockState_ != LOCK_NONE || !object_.ptr_ || shadowData_ || !dynamic_ || !count || start + count > vertexCount_)
+        return Lock(start, count, false);
+
+    lockStart_ = start;
+    lockCount_ = count;
+    return MapBuffer(start, count, false, true);
+}
+
 void VertexBuffer::Unlock()
 {
     switch (lockState_)
@@ -269,7 +280,7 @@ bool VertexBuffer::UpdateToGPU()
         return false;
 }
 
-void* VertexBuffer::MapBuffer(unsigned start, unsigned count, bool discard)
+void* VertexBuffer::MapBuffer(unsigned start, unsigned count, bool discard, bool noOverwrite)
 {
     void* hwData = nullptr;
 
@@ -278,13 +289,14 @@ void* VertexBuffer::MapBuffer(unsigned start, unsigned count, bool discard)
         D3D11_MAPPED_SUBRESOURCE mappedData;
         mappedData.pData = nullptr;
 
-        HRESULT hr = graphics_->GetImpl()->GetDeviceContext()->Map((ID3D11Buffer*)object_.ptr_, 0, discard ? D3D11_MAP_WRITE_DISCARD :
-            D3D11_MAP_WRITE, 0, &mappedData);
+        D3D11_MAP mapType = discard ? D3D11_MAP_WRITE_DISCARD : (noOverwrite ? D3D11_MAP_WRITE_NO_OVERWRITE : D3D11_MAP_WRITE);
+        HRESULT hr = graphics_->GetImpl()->GetDeviceContext()->Map((ID3D11Buffer*)object_.ptr_, 0, mapType, 0, &mappedData);
         if (FAILED(hr) || !mappedData.pData)
             URHO3D_LOGD3DERROR("Failed to map vertex buffer", hr);
         else
         {
-            hwData = mappedData.pData;
+            // The whole buffer is mapped, so offset to the start of the range
+            hwData = static_cast<unsigned char*>(mappedData.pData) + start * vertexSize_;
             lockState_ = LOCK_HARDWARE;
         }
     }
@@ -1315,6 +1315,12 @@ bool Graphics::HasShaderParameter(StringHash param)
     return impl_->shaderProgram_ && impl_->shaderProgram_->parameters_.Find(param) != impl_->shaderProgram_->parameters_.End();
 }
 
+bool Graphics::SetShaderParameterBlock(const ShaderParameterBlock& block, const void* source)
+{
+    // Direct3D9 shader parameters are not kept in constant buffers, so blocks are never valid
+    return false;
+}
+
 bool Graphics::HasTextureUnit(TextureUnit unit)
 {
     return pixelShader_ && pixelShader_->HasTextureUnit(unit);
@@ -1943,6 +1949,20 @@ VertexBuffer* Graphics::GetVertexBuffer(unsigned index) const
     return index < MAX_VERTEX_STREAMS ? vertexBuffers_[index] : nullptr;
 }
 
+ShaderProgram* Graphics::GetShaderProgram() const
+{
+    return impl_->shaderProgram_;
+}
+
+const ShaderParameter* Graphics::GetShaderParameterInfo(StringHash param) const
+{
+    if (!impl_->shaderProgram_)
+        return nullptr;
+
+    HashMap<StringHash, ShaderParameter>::ConstIterator i = impl_->shaderProgram_->parameters_.Find(param);
+    return i != impl_->shaderProgram_->parameters_.End() ? &i->second_ : nullptr;
+}
+
 TextureUnit Graphics::GetTextureUnit(const String& name)
 {
     HashMap<String, TextureUnit>::Iterator i = textureUnits_.Find(name);
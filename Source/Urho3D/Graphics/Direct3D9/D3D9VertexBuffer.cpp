@@ -204,6 +204,18 @@ void* VertexBuffer::Lock(unsigned start, unsigned count, bool discard)
         return nullptr;
 }
 
+void* VertexBuffer::LockNoOverwrite(unsigned start, unsigned count)
+{
+    // Can only lock the hardware buffer without overwrite if it is dynamic and not shadowed
+    if (lockState_ != LOCK_NONE || !object_.ptr_ || shadowData_ || !dynamic_ || graphics_->IsDeviceLost() || !count ||
+        start + count > vertexCount_)
+        return Lock(start, count, false);
+
+    lockStart_ = start;
+    lockCount_ = count;
+    return MapBuffer(start, count, false, true);
+}
+
 void VertexBuffer::Unlock()
 {
     switch (lockState_)
@@ -274,7 +286,7 @@ bool VertexBuffer::UpdateToGPU()
         return false;
 }
 
-void* VertexBuffer::MapBuffer(unsigned start, unsigned count, bool discard)
+void* VertexBuffer::MapBuffer(unsigned start, unsigned count, bool discard, bool noOverwrite)
 {
     void* hwData = nullptr;
 
@@ -284,6 +296,8 @@ void* VertexBuffer::MapBuffer(unsigned start, unsigned count, bool discard)
 
         if (discard && dynamic_)
             flags = D3DLOCK_DISCARD;
+        else if (noOverwrite && dynamic_)
+            flags = D3DLOCK_NOOVERWRITE;
 
         HRESULT hr = ((IDirect3DVertexBuffer9*)object_.ptr_)->Lock(start * vertexSize_, count * vertexSize_, &hwData, flags);
         if (FAILED(hr))
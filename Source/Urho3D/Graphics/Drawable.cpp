@@ -382,6 +382,14 @@ void Drawable::OnMarkedDirty(Node* node)
         zoneDirty_ = true;
 }
 
+void Drawable::MarkWorldBoundingBoxDirty()
+{
+    worldBoundingBoxDirty_ = true;
+    // The drawable stays in its octant, so the octree is not updated, but queries must not test the cached box
+    if (octant_)
+        octant_->MarkDrawableBoundsDirty();
+}
+
 void Drawable::AddToOctree()
 {
     // Do not add to octree when disabled
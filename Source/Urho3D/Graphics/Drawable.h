@@ -24,6 +24,7 @@
 
 #pragma once
 
+#include "../Container/SmallVector.h"
 #include "../Graphics/GraphicsDefs.h"
 #include "../Math/BoundingBox.h"
 #include "../Scene/Component.h"
@@ -75,6 +76,8 @@ struct FrameInfo
     IntVector2 viewSize_;
     /// Camera being used.
     Camera* camera_;
+    /// Occlusion buffer of the view, or null if occlusion is not used.
+    OcclusionBuffer* occlusionBuffer_{};
 };
 
 /// Source data for a 3D geometry draw call.
@@ -248,6 +251,8 @@ public:
 
     /// Return draw call source data.
     const Vector<SourceBatch>& GetBatches() const { return batches_; }
+    /// Return draw call source data for shadow map rendering. Same as GetBatches(), unless the drawable culls parts of itself against the view.
+    virtual const Vector<SourceBatch>& GetShadowBatches() const { return batches_; }
 
     /// Set new zone. Zone assignment may optionally be temporary, meaning it needs to be re-evaluated on the next frame.
     void SetZone(Zone* zone, bool temporary = false);
@@ -344,6 +349,8 @@ protected:
     /// Handle removal from octree.
     virtual void OnRemoveFromOctree() { }
 
+    /// Mark the world-space bounding box dirty without a node transform change, along with the octant's cached bounds of its drawables. Is thread-safe.
+    void MarkWorldBoundingBoxDirty();
     /// Add to octree.
     void AddToOctree();
     /// Remove from octree.
@@ -357,7 +364,7 @@ protected:
     /// Local-space bounding box.
     BoundingBox boundingBox_;
     /// Draw call source data.
-    Vector<SourceBatch> batches_;
+    SmallVector<SourceBatch, 1> batches_;
     /// Drawable flags.
     unsigned char drawableFlags_;
     /// Bounding box dirty flag.
@@ -411,7 +418,7 @@ protected:
     /// First per-pixel light added this frame.
     Light* firstLight_;
     /// Per-pixel lights affecting this drawable.
-    PODVector<Light*> lights_;
+    SmallPODVector<Light*, 4> lights_;
     /// Per-vertex lights affecting this drawable.
     PODVector<Light*> vertexLights_;
 };
@@ -22,6 +22,7 @@
 
 #include "../Precompiled.h"
 
+#include "../Core/IDPool.h"
 #include "../Graphics/Geometry.h"
 #include "../Graphics/Graphics.h"
 #include "../Graphics/IndexBuffer.h"
@@ -34,6 +35,13 @@
 namespace Urho3D
 {
 
+/// Return the pool of geometry sort IDs. Intentionally never destroyed, as geometries may outlive static destruction.
+static IDPool& GetSortIDPool()
+{
+    static auto* pool = new IDPool();
+    return *pool;
+}
+
 Geometry::Geometry(Context* context) :
     Object(context),
     primitiveType_(TRIANGLE_LIST),
@@ -43,12 +51,16 @@ Geometry::Geometry(Context* context) :
     vertexCount_(0),
     rawVertexSize_(0),
     rawIndexSize_(0),
-    lodDistance_(0.0f)
+    lodDistance_(0.0f),
+    sortID_(GetSortIDPool().Allocate())
 {
     SetNumVertexBuffers(1);
 }
 
-Geometry::~Geometry() = default;
+Geometry::~Geometry()
+{
+    GetSortIDPool().Free(sortID_);
+}
 
 bool Geometry::SetNumVertexBuffers(unsigned num)
 {
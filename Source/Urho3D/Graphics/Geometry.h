@@ -111,6 +111,8 @@ public:
 
     /// Return buffers' combined hash value for state sorting.
     unsigned short GetBufferHash() const;
+    /// Return small integer ID for batch state sorting. Unique among existing geometries.
+    unsigned GetSortID() const { return sortID_; }
     /// Return raw vertex and index data for CPU operations, or null pointers if not available. Will return data of the first vertex buffer if override data not set.
     void GetRawData(const unsigned char*& vertexData, unsigned& vertexSize, const unsigned char*& indexData, unsigned& indexSize, const PODVector<VertexElement>*& elements) const;
     /// Return raw vertex and index data for CPU operations, or null pointers if not available. Will return data of the first vertex buffer if override data not set.
@@ -152,6 +154,8 @@ private:
     unsigned rawVertexSize_;
     /// Raw index data override size.
     unsigned rawIndexSize_;
+    /// Batch state sorting ID.
+    unsigned sortID_;
 };
 
 }
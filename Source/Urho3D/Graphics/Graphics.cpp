@@ -40,6 +40,7 @@
 #include "../Graphics/RibbonTrail.h"
 #include "../Graphics/Shader.h"
 #include "../Graphics/ShaderPrecache.h"
+#include "../Graphics/ShaderProgram.h"
 #include "../Graphics/Skybox.h"
 #include "../Graphics/StaticModelGroup.h"
 #include "../Graphics/Technique.h"
@@ -231,6 +232,138 @@ void Graphics::SetShaderParameter(StringHash param, const Variant& value)
     }
 }
 
+void Graphics::BeginShaderParameterBlock(ShaderParameterBlock& block, unsigned version)
+{
+    block.program_ = GetShaderProgram();
+    block.version_ = version;
+    block.valid_ = block.program_ != nullptr;
+    block.buffers_.Clear();
+    block.data_.Clear();
+}
+
+bool Graphics::WriteShaderParameterBlock(ShaderParameterBlock& block, StringHash param, const Variant& value)
+{
+    const ShaderParameter* info = GetShaderParameterInfo(param);
+    if (!info)
+        return true;
+    if (!info->bufferPtr_)
+    {
+        block.valid_ = false;
+        return false;
+    }
+
+    // Find the constant buffer's contents in the block, or append zero-initialized contents for it
+    ConstantBuffer* buffer = info->bufferPtr_;
+    unsigned bufferSize = buffer->GetSize();
+    unsigned start = 0;
+    unsigned index = 0;
+    for (; index < block.buffers_.Size() && block.buffers_[index] != buffer; ++index)
+        start += block.buffers_[index]->GetSize();
+    if (index == block.buffers_.Size())
+    {
+        block.buffers_.Push(buffer);
+        block.data_.Resize(start + bufferSize);
+        memset(&block.data_[start], 0, bufferSize);
+    }
+
+    // Lay out the value the same way as ConstantBuffer::SetParameter() and SetVector3ArrayParameter() would
+    unsigned char* dest = &block.data_[start] + info->offset_;
+    const void* data = nullptr;
+    unsigned size = 0;
+    bool boolValue;
+    float floatValue;
+    int intValue;
+
+    switch (value.GetType())
+    {
+    case VAR_BOOL:
+        boolValue = value.GetBool();
+        data = &boolValue;
+        size = sizeof(bool);
+        break;
+
+    case VAR_INT:
+        intValue = value.GetInt();
+        data = &intValue;
+        size = sizeof(int);
+        break;
+
+    case VAR_FLOAT:
+    case VAR_DOUBLE:
+        floatValue = value.GetFloat();
+        data = &floatValue;
+        size = sizeof(float);
+        break;
+
+    case VAR_VECTOR2:
+        data = &value.GetVector2();
+        size = sizeof(Vector2);
+        break;
+
+    case VAR_VECTOR3:
+        data = &value.GetVector3();
+        size = sizeof(Vector3);
+        break;
+
+    case VAR_VECTOR4:
+        data = &value.GetVector4();
+        size = sizeof(Vector4);
+        break;
+
+    case VAR_COLOR:
+        data = &value.GetColor();
+        size = sizeof(Color);
+        break;
+
+    case VAR_MATRIX3X4:
+        data = &value.GetMatrix3x4();
+        size = sizeof(Matrix3x4);
+        break;
+
+    case VAR_MATRIX4:
+        data = &value.GetMatrix4();
+        size = sizeof(Matrix4);
+        break;
+
+    case VAR_MATRIX3:
+        {
+            if (info->offset_ + 3 * 4 * sizeof(float) > bufferSize)
+                return true; // Would overflow the buffer
+
+            const float* src = value.GetMatrix3().Data();
+            auto* destFloats = reinterpret_cast<float*>(dest);
+            for (unsigned row = 0; row < 3; ++row)
+            {
+                *destFloats++ = *src++;
+                *destFloats++ = *src++;
+                *destFloats++ = *src++;
+                ++destFloats; // Skip over the w coordinate
+            }
+        }
+        return true;
+
+    case VAR_BUFFER:
+        {
+            const PODVector<unsigned char>& buffer = value.GetBuffer();
+            if (buffer.Size() >= sizeof(float))
+            {
+                data = &buffer[0];
+                size = buffer.Size() / sizeof(float) * sizeof(float);
+            }
+        }
+        break;
+
+    default:
+        // Unsupported parameter type, leave zero
+        break;
+    }
+
+    if (data && size && info->offset_ + size <= bufferSize)
+        memcpy(dest, data, size);
+
+    return true;
+}
+
 IntVector2 Graphics::GetWindowPosition() const
 {
     if (window_)
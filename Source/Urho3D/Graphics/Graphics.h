@@ -258,6 +258,15 @@ public:
     bool NeedParameterUpdate(ShaderParameterGroup group, const void* source);
     /// Check whether a shader parameter exists on the currently set shaders.
     bool HasShaderParameter(StringHash param);
+    /// Start building a shader parameter block for the currently set shaders.
+    /// @nobind
+    void BeginShaderParameterBlock(ShaderParameterBlock& block, unsigned version);
+    /// Write a shader parameter into a block. Supported variant types are the same as when setting individually. Return false if the parameter exists on the currently set shaders outside constant buffers.
+    /// @nobind
+    bool WriteShaderParameterBlock(ShaderParameterBlock& block, StringHash param, const Variant& value);
+    /// Copy a shader parameter block to its constant buffers, skipping buffers that already hold the same source and version. Return true if any buffer was copied.
+    /// @nobind
+    bool SetShaderParameterBlock(const ShaderParameterBlock& block, const void* source);
     /// Check whether the current vertex or pixel shader uses a texture unit.
     bool HasTextureUnit(TextureUnit unit);
     /// Clear remembered shader parameter source group.
@@ -520,6 +529,9 @@ public:
     /// Return shader program. This is an API-specific class and should not be used by applications.
     /// @nobind
     ShaderProgram* GetShaderProgram() const;
+    /// Return shader parameter definition on the currently set shaders, or null if not found.
+    /// @nobind
+    const ShaderParameter* GetShaderParameterInfo(StringHash param) const;
 
     /// Return texture unit index by name.
     TextureUnit GetTextureUnit(const String& name);
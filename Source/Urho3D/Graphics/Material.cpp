@@ -24,10 +24,12 @@
 
 #include "../Core/Context.h"
 #include "../Core/CoreEvents.h"
+#include "../Core/IDPool.h"
 #include "../Core/Profiler.h"
 #include "../Graphics/Graphics.h"
 #include "../Graphics/Material.h"
 #include "../Graphics/Renderer.h"
+#include "../Graphics/ShaderProgram.h"
 #include "../Graphics/Technique.h"
 #include "../Graphics/Texture2D.h"
 #include "../Graphics/Texture2DArray.h"
@@ -43,6 +45,8 @@
 #include "../Scene/SceneEvents.h"
 #include "../Scene/ValueAnimation.h"
 
+#include <atomic>
+
 #include "../DebugNew.h"
 
 namespace Urho3D
@@ -195,13 +199,27 @@ void ShaderParameterAnimationInfo::ApplyValue(const Variant& newValue)
     static_cast<Material*>(target_.Get())->SetShaderParameter(name_, newValue);
 }
 
+/// Next shader parameter version. Shared by all materials so that a (material, version) pair is never reused, even if a destroyed material's address is. Materials may be loaded in background threads.
+static std::atomic<unsigned> nextShaderParameterVersion(1);
+
+/// Return the pool of material sort IDs. Intentionally never destroyed, as materials may outlive static destruction.
+static IDPool& GetSortIDPool()
+{
+    static auto* pool = new IDPool();
+    return *pool;
+}
+
 Material::Material(Context* context) :
-    Resource(context)
+    Resource(context),
+    sortID_(GetSortIDPool().Allocate())
 {
     ResetToDefaults();
 }
 
-Material::~Material() = default;
+Material::~Material()
+{
+    GetSortIDPool().Free(sortID_);
+}
 
 void Material::RegisterObject(Context* context)
 {
@@ -1297,6 +1315,45 @@ void Material::RefreshShaderParameterHash()
     unsigned dataSize = temp.GetSize();
     for (unsigned i = 0; i < dataSize; ++i)
         shaderParameterHash_ = SDBMHash(shaderParameterHash_, data[i]);
+
+    // Precomputed constant buffer contents are rebuilt lazily on next use
+    shaderParameterVersion_ = nextShaderParameterVersion++;
+}
+
+const ShaderParameterBlock* Material::GetShaderParameterBlock(Graphics* graphics)
+{
+    ShaderProgram* program = graphics->GetShaderProgram();
+    if (!program)
+        return nullptr;
+
+    HashMap<ShaderProgram*, ShaderParameterBlock>::Iterator i = shaderParameterBlocks_.Find(program);
+    if (i == shaderParameterBlocks_.End())
+    {
+        // Forget blocks of shader programs that have since been destroyed before adding a new one
+        for (HashMap<ShaderProgram*, ShaderParameterBlock>::Iterator j = shaderParameterBlocks_.Begin();
+             j != shaderParameterBlocks_.End();)
+        {
+            if (j->second_.program_.Expired())
+                j = shaderParameterBlocks_.Erase(j);
+            else
+                ++j;
+        }
+        i = shaderParameterBlocks_.Insert(MakePair(program, ShaderParameterBlock()));
+    }
+
+    ShaderParameterBlock& block = i->second_;
+    if (block.program_.Get() != program || block.version_ != shaderParameterVersion_)
+    {
+        graphics->BeginShaderParameterBlock(block, shaderParameterVersion_);
+        for (HashMap<StringHash, MaterialShaderParameter>::ConstIterator j = shaderParameters_.Begin();
+             j != shaderParameters_.End(); ++j)
+        {
+            if (!graphics->WriteShaderParameterBlock(block, j->first_, j->second_.value_))
+                break;
+        }
+    }
+
+    return block.valid_ ? &block : nullptr;
 }
 
 void Material::RefreshMemoryUse()
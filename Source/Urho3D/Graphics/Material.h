@@ -24,6 +24,7 @@
 
 #include "../Graphics/GraphicsDefs.h"
 #include "../Graphics/Light.h"
+#include "../Graphics/ShaderVariation.h"
 #include "../Math/Vector4.h"
 #include "../Resource/Resource.h"
 #include "../Scene/ValueAnimationInfo.h"
@@ -31,6 +32,7 @@
 namespace Urho3D
 {
 
+class Graphics;
 class Material;
 class Pass;
 class Scene;
@@ -286,6 +288,12 @@ public:
 
     /// Return shader parameter hash value. Used as an optimization to avoid setting shader parameters unnecessarily.
     unsigned GetShaderParameterHash() const { return shaderParameterHash_; }
+    /// Return shader parameters precomputed into constant buffer contents for the currently set shaders, rebuilding them if the parameters have changed. Return null if the shaders do not keep the parameters in constant buffers.
+    /// @nobind
+    const ShaderParameterBlock* GetShaderParameterBlock(Graphics* graphics);
+
+    /// Return small integer ID for batch state sorting. Unique among existing materials.
+    unsigned GetSortID() const { return sortID_; }
 
     /// Return name for texture unit.
     static String GetTextureUnitName(TextureUnit unit);
@@ -339,6 +347,12 @@ private:
     unsigned auxViewFrameNumber_{};
     /// Shader parameter hash value.
     unsigned shaderParameterHash_{};
+    /// Shader parameter version, taken from a global counter whenever the parameters change.
+    unsigned shaderParameterVersion_{};
+    /// Precomputed constant buffer contents of the shader parameters per shader program.
+    HashMap<ShaderProgram*, ShaderParameterBlock> shaderParameterBlocks_;
+    /// Batch state sorting ID.
+    unsigned sortID_;
     /// Alpha-to-coverage flag.
     bool alphaToCoverage_{};
     /// Line antialiasing flag.
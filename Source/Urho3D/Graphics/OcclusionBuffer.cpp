@@ -25,8 +25,14 @@
 #include "../Core/WorkQueue.h"
 #include "../Core/Profiler.h"
 #include "../Graphics/Camera.h"
+#include "../Graphics/Drawable.h"
 #include "../Graphics/OcclusionBuffer.h"
 #include "../IO/Log.h"
+#include "../Scene/Node.h"
+
+#ifdef URHO3D_SSE
+#include <emmintrin.h>
+#endif
 
 #include "../DebugNew.h"
 
@@ -44,11 +50,94 @@ enum ClipMask : unsigned
 };
 URHO3D_FLAGSET(ClipMask, ClipMaskFlags);
 
+#ifdef URHO3D_SSE
+/// Return per-component minimum of four integers. SSE2 has no integer min / max instructions, so use compare & select.
+static inline __m128i MinInt4(__m128i a, __m128i b)
+{
+    __m128i less = _mm_cmplt_epi32(a, b);
+    return _mm_or_si128(_mm_and_si128(less, a), _mm_andnot_si128(less, b));
+}
+
+/// Return per-component maximum of four integers.
+static inline __m128i MaxInt4(__m128i a, __m128i b)
+{
+    __m128i greater = _mm_cmpgt_epi32(a, b);
+    return _mm_or_si128(_mm_and_si128(greater, a), _mm_andnot_si128(greater, b));
+}
+
+/// Shuffle integers from two vectors, taking two components from each.
+#define SHUFFLE_INT4(a, b, mask) _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(a), _mm_castsi128_ps(b), mask))
+
+/// Build four depth hierarchy values from eight minimum and eight maximum values of the row(s) above.
+static inline void StoreDepthValues(DepthValue* dest, __m128i minLow, __m128i minHigh, __m128i maxLow, __m128i maxHigh)
+{
+    __m128i minValues = MinInt4(SHUFFLE_INT4(minLow, minHigh, _MM_SHUFFLE(2, 0, 2, 0)),
+        SHUFFLE_INT4(minLow, minHigh, _MM_SHUFFLE(3, 1, 3, 1)));
+    __m128i maxValues = MaxInt4(SHUFFLE_INT4(maxLow, maxHigh, _MM_SHUFFLE(2, 0, 2, 0)),
+        SHUFFLE_INT4(maxLow, maxHigh, _MM_SHUFFLE(3, 1, 3, 1)));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dest), _mm_unpacklo_epi32(minValues, maxValues));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + 2), _mm_unpackhi_epi32(minValues, maxValues));
+}
+
+/// Return horizontal minimum of four floats.
+static inline float HorizontalMin(__m128 v)
+{
+    v = _mm_min_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2)));
+    v = _mm_min_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtss_f32(v);
+}
+
+/// Return horizontal maximum of four floats.
+static inline float HorizontalMax(__m128 v)
+{
+    v = _mm_max_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2)));
+    v = _mm_max_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtss_f32(v);
+}
+#endif
+
+/// Rasterize one horizontal span of a triangle, keeping the closer depth value for each pixel.
+static inline void DrawSpan(int* dest, int* end, int invZ, int dInvZdX)
+{
+#ifdef URHO3D_SSE
+    if (end - dest >= 4)
+    {
+        // Interpolate four pixels at a time. Use unsigned math so that wraparound matches the scalar loop
+        auto start = (unsigned)invZ;
+        auto step = (unsigned)dInvZdX;
+        __m128i values = _mm_set_epi32((int)(start + 3 * step), (int)(start + 2 * step), (int)(start + step), (int)start);
+        __m128i valueStep = _mm_set1_epi32((int)(4 * step));
+
+        do
+        {
+            __m128i old = _mm_loadu_si128(reinterpret_cast<__m128i*>(dest));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dest), MinInt4(values, old));
+            values = _mm_add_epi32(values, valueStep);
+            dest += 4;
+        }
+        while (end - dest >= 4);
+
+        invZ = _mm_cvtsi128_si32(values);
+    }
+#endif
+
+    while (dest < end)
+    {
+        if (invZ < *dest)
+            *dest = invZ;
+        invZ += dInvZdX;
+        ++dest;
+    }
+}
+
 void DrawOcclusionBatchWork(const WorkItem* item, unsigned threadIndex)
 {
     auto* buffer = reinterpret_cast<OcclusionBuffer*>(item->aux_);
-    OcclusionBatch& batch = *reinterpret_cast<OcclusionBatch*>(item->start_);
-    buffer->DrawBatch(batch, threadIndex);
+    auto* start = reinterpret_cast<OcclusionBatch*>(item->start_);
+    auto* end = reinterpret_cast<OcclusionBatch*>(item->end_);
+
+    while (start != end)
+        buffer->DrawBatch(*start++, threadIndex);
 }
 
 OcclusionBuffer::OcclusionBuffer(Context* context) :
@@ -78,6 +167,7 @@ bool OcclusionBuffer::SetSize(int width, int height, bool threaded)
 
     width_ = width;
     height_ = height;
+    contentsValid_ = false;
 
     // Build work buffers for threading
     unsigned numThreadBuffers = threaded ? GetSubsystem<WorkQueue>()->GetNumThreads() + 1 : 1;
@@ -117,6 +207,12 @@ void OcclusionBuffer::SetView(Camera* camera)
     if (!camera)
         return;
 
+    if (camera != camera_)
+    {
+        camera_ = camera;
+        contentsValid_ = false;
+    }
+
     view_ = camera->GetView();
     projection_ = camera->GetProjection();
     viewProj_ = projection_ * view_;
@@ -159,6 +255,64 @@ void OcclusionBuffer::Clear()
         buffers_[i].used_ = false;
 
     depthHierarchyDirty_ = true;
+    drawnOccluders_.Clear();
+    contentsViewProj_ = viewProj_;
+    numReprojections_ = 0;
+    contentsValid_ = false;
+}
+
+bool OcclusionBuffer::Reuse()
+{
+    Reset();
+
+    bool reuse = contentsValid_ && !buffers_.Empty();
+    bool viewChanged = !viewProj_.Equals(contentsViewProj_);
+    if (viewChanged && numReprojections_ >= OCCLUSION_MAX_REPROJECTED_FRAMES)
+        reuse = false;
+
+    // The drawn occluders can not be removed from the buffer, so check that they still exist and have not moved
+    for (HashMap<Drawable*, DrawnOccluder>::ConstIterator i = drawnOccluders_.Begin(); reuse && i != drawnOccluders_.End(); ++i)
+    {
+        Drawable* drawable = i->second_.drawable_;
+        Node* node = drawable ? drawable->GetNode() : nullptr;
+        if (!node || !drawable->IsEnabledEffective() || !drawable->IsOccluder() ||
+            node->GetWorldTransform() != i->second_.worldTransform_ ||
+            drawable->GetWorldBoundingBox() != i->second_.worldBoundingBox_)
+            reuse = false;
+    }
+
+    if (!reuse)
+    {
+        Clear();
+        contentsValid_ = true;
+        return false;
+    }
+
+    // Thread buffers still hold the previous frame's triangles, so they must be cleared before use
+    for (unsigned i = 1; i < buffers_.Size(); ++i)
+        buffers_[i].used_ = false;
+
+    if (viewChanged)
+    {
+        ReprojectBuffer();
+        contentsViewProj_ = viewProj_;
+        ++numReprojections_;
+        depthHierarchyDirty_ = true;
+    }
+
+    return true;
+}
+
+void OcclusionBuffer::AddDrawnOccluder(Drawable* drawable)
+{
+    Node* node = drawable ? drawable->GetNode() : nullptr;
+    if (!node)
+        return;
+
+    DrawnOccluder& occluder = drawnOccluders_[drawable];
+    occluder.drawable_ = drawable;
+    occluder.worldTransform_ = node->GetWorldTransform();
+    occluder.worldBoundingBox_ = drawable->GetWorldBoundingBox();
 }
 
 bool OcclusionBuffer::AddTriangles(const Matrix3x4& model, const void* vertexData, unsigned vertexSize, unsigned vertexStart,
@@ -212,17 +366,7 @@ void OcclusionBuffer::DrawTriangles()
         // Threaded
         auto* queue = GetSubsystem<WorkQueue>();
 
-        for (Vector<OcclusionBatch>::Iterator i = batches_.Begin(); i != batches_.End(); ++i)
-        {
-            SharedPtr<WorkItem> item = queue->GetFreeItem();
-            item->priority_ = M_MAX_UNSIGNED;
-            item->workFunction_ = DrawOcclusionBatchWork;
-            item->aux_ = this;
-            item->start_ = &(*i);
-            queue->AddWorkItem(item);
-        }
-
-        queue->Complete(M_MAX_UNSIGNED);
+        queue->ParallelFor(DrawOcclusionBatchWork, batches_.Buffer(), batches_.Buffer() + batches_.Size(), this);
 
         MergeBuffers();
         depthHierarchyDirty_ = true;
@@ -252,6 +396,22 @@ void OcclusionBuffer::BuildDepthHierarchy()
             if (y * 2 + 1 < height_)
             {
                 int* src2 = src + width_;
+#ifdef URHO3D_SSE
+                // Build four values at a time from two rows of eight pixels
+                while (end - dest >= 4)
+                {
+                    __m128i upperLow = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+                    __m128i upperHigh = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 4));
+                    __m128i lowerLow = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src2));
+                    __m128i lowerHigh = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src2 + 4));
+                    StoreDepthValues(dest, MinInt4(upperLow, lowerLow), MinInt4(upperHigh, lowerHigh),
+                        MaxInt4(upperLow, lowerLow), MaxInt4(upperHigh, lowerHigh));
+
+                    src += 8;
+                    src2 += 8;
+                    dest += 4;
+                }
+#endif
                 while (dest < end)
                 {
                     int minUpper = Min(src[0], src[1]);
@@ -268,6 +428,17 @@ void OcclusionBuffer::BuildDepthHierarchy()
             }
             else
             {
+#ifdef URHO3D_SSE
+                while (end - dest >= 4)
+                {
+                    __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+                    __m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 4));
+                    StoreDepthValues(dest, low, high, low, high);
+
+                    src += 8;
+                    dest += 4;
+                }
+#endif
                 while (dest < end)
                 {
                     dest->min_ = Min(src[0], src[1]);
@@ -297,6 +468,30 @@ void OcclusionBuffer::BuildDepthHierarchy()
             if (y * 2 + 1 < prevHeight)
             {
                 DepthValue* src2 = src + prevWidth;
+#ifdef URHO3D_SSE
+                // Build four values at a time from two rows of eight values. Even components hold the minimums and odd
+                // components the maximums, so shuffle them apart first
+                while (end - dest >= 4)
+                {
+                    __m128i upper[4], lower[4], minValues[4], maxValues[4];
+                    for (unsigned j = 0; j < 4; ++j)
+                    {
+                        upper[j] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + j * 2));
+                        lower[j] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src2 + j * 2));
+                        minValues[j] = MinInt4(upper[j], lower[j]);
+                        maxValues[j] = MaxInt4(upper[j], lower[j]);
+                    }
+                    StoreDepthValues(dest,
+                        SHUFFLE_INT4(minValues[0], minValues[1], _MM_SHUFFLE(2, 0, 2, 0)),
+                        SHUFFLE_INT4(minValues[2], minValues[3], _MM_SHUFFLE(2, 0, 2, 0)),
+                        SHUFFLE_INT4(maxValues[0], maxValues[1], _MM_SHUFFLE(3, 1, 3, 1)),
+                        SHUFFLE_INT4(maxValues[2], maxValues[3], _MM_SHUFFLE(3, 1, 3, 1)));
+
+                    src += 8;
+                    src2 += 8;
+                    dest += 4;
+                }
+#endif
                 while (dest < end)
                 {
                     int minUpper = Min(src[0].min_, src[1].min_);
@@ -313,6 +508,22 @@ void OcclusionBuffer::BuildDepthHierarchy()
             }
             else
             {
+#ifdef URHO3D_SSE
+                while (end - dest >= 4)
+                {
+                    __m128i values[4];
+                    for (unsigned j = 0; j < 4; ++j)
+                        values[j] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + j * 2));
+                    StoreDepthValues(dest,
+                        SHUFFLE_INT4(values[0], values[1], _MM_SHUFFLE(2, 0, 2, 0)),
+                        SHUFFLE_INT4(values[2], values[3], _MM_SHUFFLE(2, 0, 2, 0)),
+                        SHUFFLE_INT4(values[0], values[1], _MM_SHUFFLE(3, 1, 3, 1)),
+                        SHUFFLE_INT4(values[2], values[3], _MM_SHUFFLE(3, 1, 3, 1)));
+
+                    src += 8;
+                    dest += 4;
+                }
+#endif
                 while (dest < end)
                 {
                     dest->min_ = Min(src[0].min_, src[1].min_);
@@ -338,6 +549,55 @@ bool OcclusionBuffer::IsVisible(const BoundingBox& worldSpaceBox) const
     if (buffers_.Empty())
         return true;
 
+    float minX, maxX, minY, maxY, minZ;
+
+#ifdef URHO3D_SSE
+    {
+        // Transform and project four corners at a time. The operations are done in the same order as in ModelTransform()
+        // and ViewportTransform() so the result matches the non-SIMD path
+        const Vector3& boxMin = worldSpaceBox.min_;
+        const Vector3& boxMax = worldSpaceBox.max_;
+        const Matrix4& m = viewProj_;
+        __m128 cornerX = _mm_set_ps(boxMax.x_, boxMin.x_, boxMax.x_, boxMin.x_);
+        __m128 cornerY = _mm_set_ps(boxMax.y_, boxMax.y_, boxMin.y_, boxMin.y_);
+        __m128 cornerZ[2] = {_mm_set1_ps(boxMin.z_), _mm_set1_ps(boxMax.z_)};
+        __m128 projMin[3], projMax[2];
+
+        for (unsigned i = 0; i < 2; ++i)
+        {
+            __m128 x = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(m.m00_), cornerX),
+                _mm_mul_ps(_mm_set1_ps(m.m01_), cornerY)), _mm_mul_ps(_mm_set1_ps(m.m02_), cornerZ[i])), _mm_set1_ps(m.m03_));
+            __m128 y = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(m.m10_), cornerX),
+                _mm_mul_ps(_mm_set1_ps(m.m11_), cornerY)), _mm_mul_ps(_mm_set1_ps(m.m12_), cornerZ[i])), _mm_set1_ps(m.m13_));
+            __m128 z = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(m.m20_), cornerX),
+                _mm_mul_ps(_mm_set1_ps(m.m21_), cornerY)), _mm_mul_ps(_mm_set1_ps(m.m22_), cornerZ[i])), _mm_set1_ps(m.m23_));
+            __m128 w = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(m.m30_), cornerX),
+                _mm_mul_ps(_mm_set1_ps(m.m31_), cornerY)), _mm_mul_ps(_mm_set1_ps(m.m32_), cornerZ[i])), _mm_set1_ps(m.m33_));
+
+            // Apply a far clip relative bias. If any of the corners cross the near plane, assume visible
+            z = _mm_sub_ps(z, _mm_set1_ps(OCCLUSION_RELATIVE_BIAS));
+            if (_mm_movemask_ps(_mm_cmple_ps(z, _mm_setzero_ps())))
+                return true;
+
+            __m128 invW = _mm_div_ps(_mm_set1_ps(1.0f), w);
+            x = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(invW, x), _mm_set1_ps(scaleX_)), _mm_set1_ps(offsetX_));
+            y = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(invW, y), _mm_set1_ps(scaleY_)), _mm_set1_ps(offsetY_));
+            z = _mm_mul_ps(_mm_mul_ps(invW, z), _mm_set1_ps(OCCLUSION_Z_SCALE));
+
+            projMin[0] = i ? _mm_min_ps(projMin[0], x) : x;
+            projMax[0] = i ? _mm_max_ps(projMax[0], x) : x;
+            projMin[1] = i ? _mm_min_ps(projMin[1], y) : y;
+            projMax[1] = i ? _mm_max_ps(projMax[1], y) : y;
+            projMin[2] = i ? _mm_min_ps(projMin[2], z) : z;
+        }
+
+        minX = HorizontalMin(projMin[0]);
+        maxX = HorizontalMax(projMax[0]);
+        minY = HorizontalMin(projMin[1]);
+        maxY = HorizontalMax(projMax[1]);
+        minZ = HorizontalMin(projMin[2]);
+    }
+#else
     // Transform corners to projection space
     Vector4 vertices[8];
     vertices[0] = ModelTransform(viewProj_, worldSpaceBox.min_);
@@ -354,8 +614,6 @@ bool OcclusionBuffer::IsVisible(const BoundingBox& worldSpaceBox) const
         vertice.z_ -= OCCLUSION_RELATIVE_BIAS;
 
     // Transform to screen space. If any of the corners cross the near plane, assume visible
-    float minX, maxX, minY, maxY, minZ;
-
     if (vertices[0].z_ <= 0.0f)
         return true;
 
@@ -378,6 +636,7 @@ bool OcclusionBuffer::IsVisible(const BoundingBox& worldSpaceBox) const
         if (projected.y_ > maxY) maxY = projected.y_;
         if (projected.z_ < minZ) minZ = projected.z_;
     }
+#endif
 
     // Expand the bounding box 1 pixel in each direction to be conservative and correct rasterization offset
     IntRect rect((int)(minX - 1.5f), (int)(minY - 1.5f), RoundToInt(maxX), RoundToInt(maxY));
@@ -901,16 +1160,7 @@ void OcclusionBuffer::DrawTriangle2D(const Vector3* vertices, bool clockwise, un
             int* endRow = bufferData + middleY * width_;
             while (row < endRow)
             {
-                int invZ = topToBottom.invZ_;
-                int* dest = row + (topToBottom.x_ >> 16u);
-                int* end = row + (topToMiddle.x_ >> 16u);
-                while (dest < end)
-                {
-                    if (invZ < *dest)
-                        *dest = invZ;
-                    invZ += gradients.dInvZdXInt_;
-                    ++dest;
-                }
+                DrawSpan(row + (topToBottom.x_ >> 16u), row + (topToMiddle.x_ >> 16u), topToBottom.invZ_, gradients.dInvZdXInt_);
 
                 topToBottom.x_ += topToBottom.xStep_;
                 topToBottom.invZ_ += topToBottom.invZStep_;
@@ -927,16 +1177,7 @@ void OcclusionBuffer::DrawTriangle2D(const Vector3* vertices, bool clockwise, un
             int* endRow = bufferData + bottomY * width_;
             while (row < endRow)
             {
-                int invZ = topToBottom.invZ_;
-                int* dest = row + (topToBottom.x_ >> 16u);
-                int* end = row + (middleToBottom.x_ >> 16u);
-                while (dest < end)
-                {
-                    if (invZ < *dest)
-                        *dest = invZ;
-                    invZ += gradients.dInvZdXInt_;
-                    ++dest;
-                }
+                DrawSpan(row + (topToBottom.x_ >> 16u), row + (middleToBottom.x_ >> 16u), topToBottom.invZ_, gradients.dInvZdXInt_);
 
                 topToBottom.x_ += topToBottom.xStep_;
                 topToBottom.invZ_ += topToBottom.invZStep_;
@@ -955,16 +1196,7 @@ void OcclusionBuffer::DrawTriangle2D(const Vector3* vertices, bool clockwise, un
             int* endRow = bufferData + middleY * width_;
             while (row < endRow)
             {
-                int invZ = topToMiddle.invZ_;
-                int* dest = row + (topToMiddle.x_ >> 16u);
-                int* end = row + (topToBottom.x_ >> 16u);
-                while (dest < end)
-                {
-                    if (invZ < *dest)
-                        *dest = invZ;
-                    invZ += gradients.dInvZdXInt_;
-                    ++dest;
-                }
+                DrawSpan(row + (topToMiddle.x_ >> 16u), row + (topToBottom.x_ >> 16u), topToMiddle.invZ_, gradients.dInvZdXInt_);
 
                 topToMiddle.x_ += topToMiddle.xStep_;
                 topToMiddle.invZ_ += topToMiddle.invZStep_;
@@ -981,16 +1213,7 @@ void OcclusionBuffer::DrawTriangle2D(const Vector3* vertices, bool clockwise, un
             int* endRow = bufferData + bottomY * width_;
             while (row < endRow)
             {
-                int invZ = middleToBottom.invZ_;
-                int* dest = row + (middleToBottom.x_ >> 16u);
-                int* end = row + (topToBottom.x_ >> 16u);
-                while (dest < end)
-                {
-                    if (invZ < *dest)
-                        *dest = invZ;
-                    invZ += gradients.dInvZdXInt_;
-                    ++dest;
-                }
+                DrawSpan(row + (middleToBottom.x_ >> 16u), row + (topToBottom.x_ >> 16u), middleToBottom.invZ_, gradients.dInvZdXInt_);
 
                 middleToBottom.x_ += middleToBottom.xStep_;
                 middleToBottom.invZ_ += middleToBottom.invZStep_;
@@ -1014,6 +1237,17 @@ void OcclusionBuffer::MergeBuffers()
         int* dest = buffers_[0].data_;
         int count = width_ * height_;
 
+#ifdef URHO3D_SSE
+        for (; count >= 4; count -= 4)
+        {
+            __m128i srcValues = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+            __m128i destValues = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dest));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dest), MinInt4(srcValues, destValues));
+            src += 4;
+            dest += 4;
+        }
+#endif
+
         while (count--)
         {
             // If thread buffer's depth value is closer, overwrite the original
@@ -1025,6 +1259,91 @@ void OcclusionBuffer::MergeBuffers()
     }
 }
 
+void OcclusionBuffer::ReprojectBuffer()
+{
+    URHO3D_PROFILE(ReprojectOcclusion);
+
+    // Transform from the previous view's screen space (normalized to -1 to 1) to the current view's clip space
+    Matrix4 transform = viewProj_ * contentsViewProj_.Inverse();
+    int* data = buffers_[0].data_;
+    auto fillValue = (int)OCCLUSION_Z_SCALE;
+
+    // Take the farthest depth of each pixel's neighbourhood, so that silhouettes do not move outward due to rounding
+    reprojectionBuffer_.Resize((unsigned)(width_ * height_ * 2));
+    int* farthest = reprojectionBuffer_.Buffer();
+    int* scattered = farthest + width_ * height_;
+
+    for (int y = 0; y < height_; ++y)
+    {
+        const int* src = data + y * width_;
+        const int* above = y > 0 ? src - width_ : src;
+        const int* below = y < height_ - 1 ? src + width_ : src;
+        int* dest = farthest + y * width_;
+
+        for (int x = 0; x < width_; ++x)
+        {
+            int left = x > 0 ? x - 1 : x;
+            int right = x < width_ - 1 ? x + 1 : x;
+            dest[x] = Max(Max(Max(above[left], above[x]), Max(above[right], src[left])),
+                Max(Max(src[x], src[right]), Max(Max(below[left], below[x]), below[right])));
+        }
+    }
+
+    // Scatter each covered pixel to its new position. Unwritten pixels are marked with -1. When several pixels land
+    // on the same position, keep the farthest to stay conservative
+    for (int i = 0; i < width_ * height_; ++i)
+        scattered[i] = -1;
+
+    for (int y = 0; y < height_; ++y)
+    {
+        const int* src = farthest + y * width_;
+        float screenY = ((float)y + 0.5f - offsetY_) / scaleY_;
+
+        for (int x = 0; x < width_; ++x)
+        {
+            if (src[x] >= fillValue)
+                continue;
+
+            Vector4 vertex = transform * Vector4(((float)x + 0.5f - offsetX_) / scaleX_, screenY, (float)src[x] / OCCLUSION_Z_SCALE,
+                1.0f);
+            if (vertex.z_ <= 0.0f || vertex.w_ <= 0.0f)
+                continue;
+
+            Vector3 projected = ViewportTransform(vertex);
+            int destX = RoundToInt(projected.x_ - 0.5f);
+            int destY = RoundToInt(projected.y_ - 0.5f);
+            if (destX < 0 || destY < 0 || destX >= width_ || destY >= height_)
+                continue;
+
+            int depth = Min(CeilToInt(projected.z_), fillValue);
+            int& dest = scattered[destY * width_ + destX];
+            if (depth > dest)
+                dest = depth;
+        }
+    }
+
+    // Fill single pixel holes left by magnification from the farther neighbour, and leave the rest empty
+    const int* src = scattered;
+    for (int y = 0; y < height_; ++y)
+    {
+        for (int x = 0; x < width_; ++x)
+        {
+            int index = y * width_ + x;
+            int value = src[index];
+            if (value < 0)
+            {
+                if (x > 0 && x < width_ - 1 && src[index - 1] >= 0 && src[index + 1] >= 0)
+                    value = Max(src[index - 1], src[index + 1]);
+                else if (y > 0 && y < height_ - 1 && src[index - width_] >= 0 && src[index + width_] >= 0)
+                    value = Max(src[index - width_], src[index + width_]);
+                else
+                    value = fillValue;
+            }
+            data[index] = value;
+        }
+    }
+}
+
 void OcclusionBuffer::ClearBuffer(unsigned threadIndex)
 {
     if (threadIndex >= buffers_.Size())
@@ -1034,6 +1353,15 @@ void OcclusionBuffer::ClearBuffer(unsigned threadIndex)
     int count = width_ * height_;
     auto fillValue = (int)OCCLUSION_Z_SCALE;
 
+#ifdef URHO3D_SSE
+    __m128i fillValues = _mm_set1_epi32(fillValue);
+    for (; count >= 4; count -= 4)
+    {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dest), fillValues);
+        dest += 4;
+    }
+#endif
+
     while (count--)
         *dest++ = fillValue;
 }
@@ -27,6 +27,7 @@
 #include "../Core/Object.h"
 #include "../Core/Timer.h"
 #include "../Container/ArrayPtr.h"
+#include "../Container/HashMap.h"
 #include "../Graphics/GraphicsDefs.h"
 #include "../Math/Frustum.h"
 
@@ -35,6 +36,7 @@ namespace Urho3D
 
 class BoundingBox;
 class Camera;
+class Drawable;
 class IndexBuffer;
 class IntRect;
 class VertexBuffer;
@@ -80,12 +82,24 @@ struct OcclusionBatch
     unsigned drawCount_;
 };
 
+/// Occluder drawn to a temporally reused occlusion buffer.
+struct DrawnOccluder
+{
+    /// Drawable.
+    WeakPtr<Drawable> drawable_;
+    /// World transform when drawn.
+    Matrix3x4 worldTransform_;
+    /// World bounding box when drawn.
+    BoundingBox worldBoundingBox_;
+};
+
 static const int OCCLUSION_MIN_SIZE = 8;
 static const int OCCLUSION_DEFAULT_MAX_TRIANGLES = 5000;
 static const float OCCLUSION_RELATIVE_BIAS = 0.00001f;
 static const int OCCLUSION_FIXED_BIAS = 16;
 static const float OCCLUSION_X_SCALE = 65536.0f;
 static const float OCCLUSION_Z_SCALE = 16777216.0f;
+static const unsigned OCCLUSION_MAX_REPROJECTED_FRAMES = 4;
 
 /// Software renderer for occlusion.
 class URHO3D_API OcclusionBuffer : public Object
@@ -110,6 +124,10 @@ public:
     void Reset();
     /// Clear the buffer.
     void Clear();
+    /// Keep the contents from the previous frame, reprojecting them if the view has changed. If the size or camera has changed, the drawn occluders have moved, or the contents have been reprojected too many times, clear the buffer instead. Return true if the contents were kept.
+    bool Reuse();
+    /// Record an occluder as drawn so that it does not need to be drawn again while the contents are reused.
+    void AddDrawnOccluder(Drawable* drawable);
     /// Submit a triangle mesh to the buffer using non-indexed geometry. Return true if did not overflow the allowed triangle count.
     bool AddTriangles(const Matrix3x4& model, const void* vertexData, unsigned vertexSize, unsigned vertexStart, unsigned vertexCount);
     /// Submit a triangle mesh to the buffer using indexed geometry. Return true if did not overflow the allowed triangle count.
@@ -125,6 +143,9 @@ public:
     /// Return highest level depth values.
     int* GetBuffer() const { return buffers_.Size() ? buffers_[0].data_ : nullptr; }
 
+    /// Return camera set in SetView().
+    Camera* GetCamera() const { return camera_; }
+
     /// Return view transform matrix.
     const Matrix3x4& GetView() const { return view_; }
 
@@ -149,6 +170,9 @@ public:
     /// Return whether is using threads to speed up rendering.
     bool IsThreaded() const { return buffers_.Size() > 1; }
 
+    /// Return whether an occluder is already included in contents kept by Reuse().
+    bool HasDrawnOccluder(Drawable* drawable) const { return drawnOccluders_.Contains(drawable); }
+
     /// Test a bounding box for visibility. For best performance, build depth hierarchy first.
     bool IsVisible(const BoundingBox& worldSpaceBox) const;
     /// Return time since last use in milliseconds.
@@ -178,6 +202,8 @@ private:
     void ClearBuffer(unsigned threadIndex);
     /// Merge thread work buffers into the first buffer.
     void MergeBuffers();
+    /// Reproject the main buffer from the view it was drawn with to the current view.
+    void ReprojectBuffer();
 
     /// Highest-level buffer data per thread.
     Vector<OcclusionBufferData> buffers_;
@@ -185,6 +211,12 @@ private:
     Vector<SharedArrayPtr<DepthValue> > mipBuffers_;
     /// Submitted render jobs.
     PODVector<OcclusionBatch> batches_;
+    /// Occluders drawn since the buffer was last cleared, when reusing the contents.
+    HashMap<Drawable*, DrawnOccluder> drawnOccluders_;
+    /// Work buffer for reprojection.
+    PODVector<int> reprojectionBuffer_;
+    /// Camera to render from.
+    WeakPtr<Camera> camera_;
     /// Buffer width.
     int width_{};
     /// Buffer height.
@@ -199,12 +231,18 @@ private:
     bool depthHierarchyDirty_{true};
     /// Culling reverse flag.
     bool reverseCulling_{};
+    /// Contents can be reused flag.
+    bool contentsValid_{};
+    /// Number of times the contents have been reprojected since the buffer was cleared.
+    unsigned numReprojections_{};
     /// View transform matrix.
     Matrix3x4 view_;
     /// Projection matrix.
     Matrix4 projection_;
     /// Combined view and projection matrix.
     Matrix4 viewProj_;
+    /// Combined view and projection matrix the contents correspond to.
+    Matrix4 contentsViewProj_;
     /// Last used timer.
     Timer useTimer_;
     /// Near clip distance.
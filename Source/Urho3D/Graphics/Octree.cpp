@@ -88,6 +88,7 @@ Octant::~Octant()
             root_->drawables_.Push(*i);
             root_->QueueUpdate(*i);
         }
+        root_->drawableBoundsDirty_ = true;
         drawables_.Clear();
         numDrawables_ = 0;
     }
@@ -244,7 +245,11 @@ void Octant::GetDrawablesInternal(OctreeQuery& query, bool inside) const
     {
         auto** start = const_cast<Drawable**>(&drawables_[0]);
         Drawable** end = start + drawables_.Size();
-        query.TestDrawables(start, end, inside);
+        // Fully inside octants need no bounding box tests, so the blocks are only useful when intersecting
+        if (!inside && !drawableBoundsDirty_)
+            query.TestDrawableBounds(start, end, &drawableBounds_[0], inside);
+        else
+            query.TestDrawables(start, end, inside);
     }
 
     for (auto child : children_)
@@ -308,6 +313,42 @@ void Octant::GetDrawablesOnlyInternal(RayOctreeQuery& query, PODVector<Drawable*
     }
 }
 
+void Octant::UpdateDrawableBounds()
+{
+    if (drawableBoundsDirty_)
+    {
+        unsigned numDrawables = drawables_.Size();
+        drawableBounds_.Resize((numDrawables + 3) >> 2u);
+        // Clear the unused lanes of the last block
+        if (numDrawables & 3u)
+            memset(&drawableBounds_.Back(), 0, sizeof(DrawableBoundsBlock));
+
+        for (unsigned i = 0; i < numDrawables; ++i)
+        {
+            const BoundingBox& box = drawables_[i]->GetWorldBoundingBox();
+            Vector3 center = box.Center();
+            Vector3 halfSize = center - box.min_;
+            DrawableBoundsBlock& block = drawableBounds_[i >> 2u];
+            unsigned lane = i & 3u;
+
+            block.centerX_[lane] = center.x_;
+            block.centerY_[lane] = center.y_;
+            block.centerZ_[lane] = center.z_;
+            block.halfSizeX_[lane] = halfSize.x_;
+            block.halfSizeY_[lane] = halfSize.y_;
+            block.halfSizeZ_[lane] = halfSize.z_;
+        }
+
+        drawableBoundsDirty_ = false;
+    }
+
+    for (auto child : children_)
+    {
+        if (child)
+            child->UpdateDrawableBounds();
+    }
+}
+
 Octree::Octree(Context* context) :
     Component(context),
     Octant(BoundingBox(-DEFAULT_OCTREE_SIZE, DEFAULT_OCTREE_SIZE), 0, nullptr, this),
@@ -369,6 +410,11 @@ void Octree::Update(const FrameInfo& frame)
         return;
     }
 
+    // If the scene batches world transform updates, resolve them now so that drawables find their transforms clean
+    Scene* scene = GetScene();
+    if (scene)
+        scene->UpdateTransforms();
+
     // Let drawables update themselves before reinsertion. This can be used for animation
     if (!drawableUpdates_.Empty())
     {
@@ -376,34 +422,11 @@ void Octree::Update(const FrameInfo& frame)
 
         // Perform updates in worker threads. Notify the scene that a threaded update is going on and components
         // (for example physics objects) should not perform non-threadsafe work when marked dirty
-        Scene* scene = GetScene();
         auto* queue = GetSubsystem<WorkQueue>();
         scene->BeginThreadedUpdate();
 
-        int numWorkItems = queue->GetNumThreads() + 1; // Worker threads + main thread
-        int drawablesPerItem = Max((int)(drawableUpdates_.Size() / numWorkItems), 1);
-
-        PODVector<Drawable*>::Iterator start = drawableUpdates_.Begin();
-        // Create a work item for each thread
-        for (int i = 0; i < numWorkItems; ++i)
-        {
-            SharedPtr<WorkItem> item = queue->GetFreeItem();
-            item->priority_ = M_MAX_UNSIGNED;
-            item->workFunction_ = UpdateDrawablesWork;
-            item->aux_ = const_cast<FrameInfo*>(&frame);
-
-            PODVector<Drawable*>::Iterator end = drawableUpdates_.End();
-            if (i < numWorkItems - 1 && end - start > drawablesPerItem)
-                end = start + drawablesPerItem;
-
-            item->start_ = &(*start);
-            item->end_ = &(*end);
-            queue->AddWorkItem(item);
-
-            start = end;
-        }
-
-        queue->Complete(M_MAX_UNSIGNED);
+        queue->ParallelFor(UpdateDrawablesWork, drawableUpdates_.Buffer(), drawableUpdates_.Buffer() + drawableUpdates_.Size(),
+            const_cast<FrameInfo*>(&frame));
         scene->EndThreadedUpdate();
     }
 
@@ -426,7 +449,6 @@ void Octree::Update(const FrameInfo& frame)
     }
 
     // Notify drawable update being finished. Custom animation (eg. IK) can be done at this point
-    Scene* scene = GetScene();
     if (scene)
     {
         using namespace SceneDrawableUpdateFinished;
@@ -472,6 +494,12 @@ void Octree::Update(const FrameInfo& frame)
     }
 
     drawableUpdates_.Clear();
+
+    // Rebuild the bounding box blocks of the octants whose drawables were added, removed, moved or resized
+    {
+        URHO3D_PROFILE(UpdateOctreeBounds);
+        UpdateDrawableBounds();
+    }
 }
 
 void Octree::AddManualDrawable(Drawable* drawable)
@@ -554,9 +582,15 @@ void Octree::QueueUpdate(Drawable* drawable)
     {
         MutexLock lock(octreeMutex_);
         threadedDrawableUpdates_.Push(drawable);
+        if (drawable->GetOctant())
+            drawable->GetOctant()->MarkDrawableBoundsDirty();
     }
     else
+    {
         drawableUpdates_.Push(drawable);
+        if (drawable->GetOctant())
+            drawable->GetOctant()->MarkDrawableBoundsDirty();
+    }
 
     drawable->updateQueued_ = true;
 }
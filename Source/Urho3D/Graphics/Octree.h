@@ -27,6 +27,8 @@
 #include "../Graphics/Drawable.h"
 #include "../Graphics/OctreeQuery.h"
 
+#include <atomic>
+
 namespace Urho3D
 {
 
@@ -59,6 +61,7 @@ public:
     {
         drawable->SetOctant(this);
         drawables_.Push(drawable);
+        drawableBoundsDirty_ = true;
         IncDrawableCount();
     }
 
@@ -67,6 +70,7 @@ public:
     {
         if (drawables_.Remove(drawable))
         {
+            drawableBoundsDirty_ = true;
             if (resetOctant)
                 drawable->SetOctant(nullptr);
             DecDrawableCount();
@@ -95,6 +99,9 @@ public:
     /// Return true if there are no drawable objects in this octant and child octants.
     bool IsEmpty() { return numDrawables_ == 0; }
 
+    /// Mark the bounding box blocks of the drawables out of date, for example when a drawable has moved. Is thread-safe.
+    void MarkDrawableBoundsDirty() { drawableBoundsDirty_ = true; }
+
     /// Reset root pointer recursively. Called when the whole octree is being destroyed.
     void ResetRoot();
     /// Draw bounds to the debug graphics recursively.
@@ -110,6 +117,8 @@ protected:
     void GetDrawablesInternal(RayOctreeQuery& query) const;
     /// Return drawable objects only for a threaded ray query, called internally.
     void GetDrawablesOnlyInternal(RayOctreeQuery& query, PODVector<Drawable*>& drawables) const;
+    /// Rebuild out of date drawable bounding box blocks recursively.
+    void UpdateDrawableBounds();
 
     /// Increase drawable object count recursively.
     void IncDrawableCount()
@@ -141,6 +150,8 @@ protected:
     BoundingBox cullingBox_;
     /// Drawable objects.
     PODVector<Drawable*> drawables_;
+    /// Drawable world bounding boxes in blocks of four, in the same order as the drawables. Valid only when not dirty.
+    PODVector<DrawableBoundsBlock> drawableBounds_;
     /// Child octants.
     Octant* children_[NUM_OCTANTS]{};
     /// World bounding box center.
@@ -157,6 +168,8 @@ protected:
     Octree* root_;
     /// Octant index relative to its siblings or ROOT_INDEX for root octant.
     unsigned index_;
+    /// Drawable bounding box blocks out of date flag. Queries test the drawables one by one while set. Drawables may set it from worker threads while updating their batches.
+    std::atomic<bool> drawableBoundsDirty_{true};
 };
 
 /// %Octree component. Should be added only to the root scene node.
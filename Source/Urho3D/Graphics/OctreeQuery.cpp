@@ -117,6 +117,38 @@ void FrustumOctreeQuery::TestDrawables(Drawable** start, Drawable** end, bool in
     }
 }
 
+void FrustumOctreeQuery::TestDrawableBounds(Drawable** start, Drawable** end, const DrawableBoundsBlock* bounds, bool inside)
+{
+    if (inside)
+    {
+        TestDrawables(start, end, inside);
+        return;
+    }
+
+    const auto numDrawables = (unsigned)(end - start);
+    insideDrawables_.Clear();
+
+    FrustumBoundsTest test(frustum_);
+
+    for (unsigned i = 0; i < numDrawables; i += 4)
+    {
+        unsigned insideMask = test.Test(bounds[i >> 2u]);
+
+        // Mask out the unused lanes of the last block
+        if (numDrawables - i < 4)
+            insideMask &= (1u << (numDrawables - i)) - 1;
+
+        for (unsigned lane = 0; insideMask; ++lane, insideMask >>= 1u)
+        {
+            if (insideMask & 1u)
+                insideDrawables_.Push(start[i + lane]);
+        }
+    }
+
+    // Let TestDrawables() (possibly overridden) apply the flag, view mask and other checks, skipping the frustum test
+    if (insideDrawables_.Size())
+        TestDrawables(&insideDrawables_[0], &insideDrawables_[0] + insideDrawables_.Size(), true);
+}
 
 Intersection AllContentOctreeQuery::TestOctant(const BoundingBox& box, bool inside)
 {
@@ -30,12 +30,130 @@
 #include "../Math/Ray.h"
 #include "../Math/Sphere.h"
 
+#ifdef URHO3D_SSE
+#include <xmmintrin.h>
+#endif
+
 namespace Urho3D
 {
 
 class Drawable;
 class Node;
 
+/// World-space bounding boxes of four drawables as centers and half sizes in structure-of-arrays form, for testing them with SIMD instructions.
+struct DrawableBoundsBlock
+{
+    /// Bounding box center X coordinates.
+    float centerX_[4];
+    /// Bounding box center Y coordinates.
+    float centerY_[4];
+    /// Bounding box center Z coordinates.
+    float centerZ_[4];
+    /// Bounding box half size X components.
+    float halfSizeX_[4];
+    /// Bounding box half size Y components.
+    float halfSizeY_[4];
+    /// Bounding box half size Z components.
+    float halfSizeZ_[4];
+};
+
+/// Frustum planes prepared for testing the boxes of DrawableBoundsBlocks four at a time.
+class FrustumBoundsTest
+{
+public:
+    /// Construct from a frustum.
+    explicit FrustumBoundsTest(const Frustum& frustum)
+    {
+#ifdef URHO3D_SSE
+        for (unsigned i = 0; i < NUM_FRUSTUM_PLANES; ++i)
+        {
+            const Plane& plane = frustum.planes_[i];
+            normalX_[i] = _mm_set1_ps(plane.normal_.x_);
+            normalY_[i] = _mm_set1_ps(plane.normal_.y_);
+            normalZ_[i] = _mm_set1_ps(plane.normal_.z_);
+            absNormalX_[i] = _mm_set1_ps(plane.absNormal_.x_);
+            absNormalY_[i] = _mm_set1_ps(plane.absNormal_.y_);
+            absNormalZ_[i] = _mm_set1_ps(plane.absNormal_.z_);
+            planeD_[i] = _mm_set1_ps(plane.d_);
+        }
+#else
+        for (unsigned i = 0; i < NUM_FRUSTUM_PLANES; ++i)
+            planes_[i] = frustum.planes_[i];
+#endif
+    }
+
+    /// Return a mask with a bit set for each box of the block that is inside or intersects the frustum.
+    unsigned Test(const DrawableBoundsBlock& block) const
+    {
+        // Same test as Frustum::IsInsideFast(): outside if the center is further behind any plane than the box extends
+#ifdef URHO3D_SSE
+        __m128 centerX = _mm_loadu_ps(block.centerX_);
+        __m128 centerY = _mm_loadu_ps(block.centerY_);
+        __m128 centerZ = _mm_loadu_ps(block.centerZ_);
+        __m128 halfSizeX = _mm_loadu_ps(block.halfSizeX_);
+        __m128 halfSizeY = _mm_loadu_ps(block.halfSizeY_);
+        __m128 halfSizeZ = _mm_loadu_ps(block.halfSizeZ_);
+        const __m128 zero = _mm_setzero_ps();
+        __m128 outside = zero;
+
+        for (unsigned i = 0; i < NUM_FRUSTUM_PLANES; ++i)
+        {
+            __m128 dist = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(normalX_[i], centerX), _mm_mul_ps(normalY_[i], centerY)),
+                _mm_mul_ps(normalZ_[i], centerZ)), planeD_[i]);
+            __m128 absDist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(absNormalX_[i], halfSizeX), _mm_mul_ps(absNormalY_[i], halfSizeY)),
+                _mm_mul_ps(absNormalZ_[i], halfSizeZ));
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(dist, _mm_sub_ps(zero, absDist)));
+        }
+
+        return ~(unsigned)_mm_movemask_ps(outside) & 0xfu;
+#else
+        unsigned insideMask = 0;
+
+        for (unsigned lane = 0; lane < 4; ++lane)
+        {
+            bool laneInside = true;
+            for (const auto& plane : planes_)
+            {
+                float dist = plane.normal_.x_ * block.centerX_[lane] + plane.normal_.y_ * block.centerY_[lane] +
+                    plane.normal_.z_ * block.centerZ_[lane] + plane.d_;
+                float absDist = plane.absNormal_.x_ * block.halfSizeX_[lane] + plane.absNormal_.y_ * block.halfSizeY_[lane] +
+                    plane.absNormal_.z_ * block.halfSizeZ_[lane];
+                if (dist < -absDist)
+                {
+                    laneInside = false;
+                    break;
+                }
+            }
+            if (laneInside)
+                insideMask |= 1u << lane;
+        }
+
+        return insideMask;
+#endif
+    }
+
+private:
+#ifdef URHO3D_SSE
+    /// Plane normal X components.
+    __m128 normalX_[NUM_FRUSTUM_PLANES];
+    /// Plane normal Y components.
+    __m128 normalY_[NUM_FRUSTUM_PLANES];
+    /// Plane normal Z components.
+    __m128 normalZ_[NUM_FRUSTUM_PLANES];
+    /// Absolute plane normal X components.
+    __m128 absNormalX_[NUM_FRUSTUM_PLANES];
+    /// Absolute plane normal Y components.
+    __m128 absNormalY_[NUM_FRUSTUM_PLANES];
+    /// Absolute plane normal Z components.
+    __m128 absNormalZ_[NUM_FRUSTUM_PLANES];
+    /// Plane distances.
+    __m128 planeD_[NUM_FRUSTUM_PLANES];
+#else
+    /// Frustum planes.
+    Plane planes_[NUM_FRUSTUM_PLANES];
+#endif
+};
+
 /// Base class for octree queries.
 class URHO3D_API OctreeQuery
 {
@@ -60,6 +178,11 @@ public:
     virtual Intersection TestOctant(const BoundingBox& box, bool inside) = 0;
     /// Intersection test for drawables.
     virtual void TestDrawables(Drawable** start, Drawable** end, bool inside) = 0;
+    /// Intersection test for drawables whose world bounding boxes are also available in blocks of four. By default ignores the blocks.
+    virtual void TestDrawableBounds(Drawable** start, Drawable** end, const DrawableBoundsBlock* bounds, bool inside)
+    {
+        TestDrawables(start, end, inside);
+    }
 
     /// Result vector reference.
     PODVector<Drawable*>& result_;
@@ -152,9 +275,15 @@ public:
     Intersection TestOctant(const BoundingBox& box, bool inside) override;
     /// Intersection test for drawables.
     void TestDrawables(Drawable** start, Drawable** end, bool inside) override;
+    /// Intersection test for drawables with bounding box blocks. Tests four boxes at a time against the frustum, then passes the ones inside to TestDrawables() for the remaining checks.
+    void TestDrawableBounds(Drawable** start, Drawable** end, const DrawableBoundsBlock* bounds, bool inside) override;
 
     /// Frustum.
     Frustum frustum_;
+
+private:
+    /// Drawables that passed the frustum test of the current block range.
+    PODVector<Drawable*> insideDrawables_;
 };
 
 /// General octree query result. Used for Lua bindings only.
@@ -72,6 +72,7 @@ bool ConstantBuffer::SetSize(unsigned size)
     dirty_ = false;
     shadowData_ = new unsigned char[size_];
     memset(shadowData_.Get(), 0, size_);
+    dataSource_ = nullptr;
 
     if (graphics_)
     {
@@ -1022,6 +1022,12 @@ void Graphics::SetShaders(ShaderVariation* vs, ShaderVariation* ps)
     if (vs == vertexShader_ && ps == pixelShader_)
         return;
 
+    // Wait for asynchronous compiles to finish, as the shaders are needed now
+    if (vs && vs->IsCompiling())
+        vs->Create();
+    if (ps && ps->IsCompiling())
+        ps->Create();
+
     // Compile the shaders now if not yet compiled. If already attempted, do not retry
     if (vs && !vs->GetGPUObjectName())
     {
@@ -1472,6 +1478,27 @@ bool Graphics::HasShaderParameter(StringHash param)
     return impl_->shaderProgram_ && impl_->shaderProgram_->HasParameter(param);
 }
 
+bool Graphics::SetShaderParameterBlock(const ShaderParameterBlock& block, const void* source)
+{
+    bool copied = false;
+    const unsigned char* data = block.data_.Buffer();
+
+    for (PODVector<ConstantBuffer*>::ConstIterator i = block.buffers_.Begin(); i != block.buffers_.End(); ++i)
+    {
+        ConstantBuffer* buffer = *i;
+        if (!buffer->HasData(source, block.version_))
+        {
+            if (!buffer->IsDirty())
+                impl_->dirtyConstantBuffers_.Push(buffer);
+            buffer->SetData(data, source, block.version_);
+            copied = true;
+        }
+        data += buffer->GetSize();
+    }
+
+    return copied;
+}
+
 bool Graphics::HasTextureUnit(TextureUnit unit)
 {
     return impl_->shaderProgram_ && impl_->shaderProgram_->HasTextureUnit(unit);
@@ -2162,6 +2189,11 @@ ShaderProgram* Graphics::GetShaderProgram() const
     return impl_->shaderProgram_;
 }
 
+const ShaderParameter* Graphics::GetShaderParameterInfo(StringHash param) const
+{
+    return impl_->shaderProgram_ ? impl_->shaderProgram_->GetParameter(param) : nullptr;
+}
+
 TextureUnit Graphics::GetTextureUnit(const String& name)
 {
     HashMap<String, TextureUnit>::Iterator i = textureUnits_.Find(name);
@@ -55,6 +55,7 @@ void ShaderVariation::OnDeviceLost()
     GPUObject::OnDeviceLost();
 
     compilerOutput_.Clear();
+    compiling_ = false;
 }
 
 void ShaderVariation::Release()
@@ -85,9 +86,56 @@ void ShaderVariation::Release()
     }
 
     compilerOutput_.Clear();
+    compiling_ = false;
 }
 
 bool ShaderVariation::Create()
+{
+    // If an asynchronous compile is in progress, just wait for its result
+    if (compiling_)
+    {
+        compiling_ = false;
+        return EndCompile();
+    }
+
+    return BeginCompile() && EndCompile();
+}
+
+bool ShaderVariation::CreateAsync()
+{
+#ifndef GL_ES_VERSION_2_0
+    // Without parallel compile support glCompileShader may block, so there is nothing to gain from deferring the status check
+    if (!GLEW_ARB_parallel_shader_compile)
+        return Create();
+
+    if (!BeginCompile())
+        return false;
+
+    compiling_ = true;
+    return true;
+#else
+    return Create();
+#endif
+}
+
+bool ShaderVariation::PollCompile()
+{
+    if (!compiling_)
+        return false;
+
+#ifndef GL_ES_VERSION_2_0
+    int completed = 0;
+    glGetShaderiv(object_.name_, GL_COMPLETION_STATUS_ARB, &completed);
+    if (!completed)
+        return true;
+#endif
+
+    compiling_ = false;
+    EndCompile();
+    return false;
+}
+
+bool ShaderVariation::BeginCompile()
 {
     Release();
 
@@ -172,7 +220,11 @@ bool ShaderVariation::Create()
     const char* shaderCStr = shaderCode.CString();
     glShaderSource(object_.name_, 1, &shaderCStr, nullptr);
     glCompileShader(object_.name_);
+    return true;
+}
 
+bool ShaderVariation::EndCompile()
+{
     int compiled, length;
     glGetShaderiv(object_.name_, GL_COMPILE_STATUS, &compiled);
     if (!compiled)
@@ -197,7 +249,7 @@ void ShaderVariation::SetDefines(const String& defines)
 
 // These methods are no-ops for OpenGL
 bool ShaderVariation::LoadByteCode(const String& binaryShaderName) { return false; }
-bool ShaderVariation::Compile() { return false; }
+bool ShaderVariation::Compile(const String& sourceCode, const String& sourceName) { return false; }
 void ShaderVariation::ParseParameters(unsigned char* bufData, unsigned bufSize) {}
 void ShaderVariation::SaveByteCode(const String& binaryShaderName) {}
 void ShaderVariation::CalculateConstantBufferSizes() {}
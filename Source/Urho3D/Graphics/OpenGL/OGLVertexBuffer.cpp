@@ -150,7 +150,11 @@ bool VertexBuffer::SetDataRange(const void* data, unsigned start, unsigned count
             if (!discard || start != 0)
                 glBufferSubData(GL_ARRAY_BUFFER, start * (size_t)vertexSize_, count * vertexSize_, data);
             else
-                glBufferData(GL_ARRAY_BUFFER, count * (size_t)vertexSize_, data, dynamic_ ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW);
+            {
+                // Orphan the whole buffer before filling the range, so that the buffer keeps its size
+                glBufferData(GL_ARRAY_BUFFER, vertexCount_ * (size_t)vertexSize_, nullptr, dynamic_ ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW);
+                glBufferSubData(GL_ARRAY_BUFFER, 0, count * vertexSize_, data);
+            }
         }
         else
         {
@@ -204,6 +208,12 @@ void* VertexBuffer::Lock(unsigned start, unsigned count, bool discard)
         return nullptr;
 }
 
+void* VertexBuffer::LockNoOverwrite(unsigned start, unsigned count)
+{
+    // The locked range is uploaded with glBufferSubData, which does not require special handling to avoid a stall
+    return Lock(start, count, false);
+}
+
 void VertexBuffer::Unlock()
 {
     switch (lockState_)
@@ -265,7 +275,7 @@ bool VertexBuffer::UpdateToGPU()
         return false;
 }
 
-void* VertexBuffer::MapBuffer(unsigned start, unsigned count, bool discard)
+void* VertexBuffer::MapBuffer(unsigned start, unsigned count, bool discard, bool noOverwrite)
 {
     // Never called on OpenGL
     return nullptr;
@@ -24,6 +24,8 @@
 
 #include "../Core/CoreEvents.h"
 #include "../Core/Profiler.h"
+#include "../Core/Timer.h"
+#include "../Core/WorkQueue.h"
 #include "../Graphics/Camera.h"
 #include "../Graphics/DebugRenderer.h"
 #include "../Graphics/Geometry.h"
@@ -36,6 +38,8 @@
 #include "../Graphics/Octree.h"
 #include "../Graphics/Renderer.h"
 #include "../Graphics/RenderPath.h"
+#include "../Graphics/Shader.h"
+#include "../Graphics/ShaderPrecache.h"
 #include "../Graphics/ShaderVariation.h"
 #include "../Graphics/Technique.h"
 #include "../Graphics/Texture2D.h"
@@ -252,8 +256,116 @@ static const char* heightFogVariations[] =
 
 static const unsigned MAX_BUFFER_AGE = 1000;
 
+void PreCullViewWork(const WorkItem* item, unsigned threadIndex)
+{
+    auto** start = reinterpret_cast<View**>(item->start_);
+    auto** end = reinterpret_cast<View**>(item->end_);
+
+    while (start != end)
+        (*start++)->PreCull();
+}
+
 static const int MAX_EXTRA_INSTANCING_BUFFER_ELEMENTS = 4;
 
+/// Compile shader variations that have not been compiled yet, skipping those that can not be used. Return the number of variations that are compiled.
+static unsigned CompileShaderVariations(const Vector<SharedPtr<ShaderVariation> >& variations, bool instancing)
+{
+    unsigned numCompiled = 0;
+
+    for (Vector<SharedPtr<ShaderVariation> >::ConstIterator i = variations.Begin(); i != variations.End(); ++i)
+    {
+        ShaderVariation* variation = *i;
+        if (!variation)
+            continue;
+
+        const String& defines = variation->GetDefines();
+        if (!instancing && defines.Contains("INSTANCED"))
+            continue;
+#ifdef GL_ES_VERSION_2_0
+        if (defines.Contains("POINTLIGHT") && defines.Contains("SHADOW"))
+            continue;
+#endif
+
+        bool compiled = variation->IsCreated();
+        // If already attempted, do not retry
+        if (!compiled && variation->GetCompilerOutput().Empty())
+        {
+            compiled = variation->Create();
+            if (!compiled)
+                URHO3D_LOGERROR("Failed to compile shader " + variation->GetFullName() + ":\n" + variation->GetCompilerOutput());
+        }
+
+        if (compiled)
+            ++numCompiled;
+    }
+
+    return numCompiled;
+}
+
+static String RemoveClusteredDefines(const String& defines)
+{
+    Vector<String> definesVec = defines.Split(' ');
+    definesVec.Remove("CLUSTERED");
+    definesVec.Remove("CLUSTERSPECULAR");
+    return String::Joined(definesVec, " ");
+}
+
+static void StoreShaderCombinations(ShaderPrecache* precache, Pass* pass, const Vector<SharedPtr<ShaderVariation> >& vertexShaders,
+    const Vector<SharedPtr<ShaderVariation> >& pixelShaders)
+{
+    for (unsigned i = 0; i < vertexShaders.Size(); ++i)
+    {
+        ShaderVariation* vs = vertexShaders[i];
+        if (!vs || !vs->IsCreated())
+            continue;
+
+        for (unsigned j = 0; j < pixelShaders.Size(); ++j)
+        {
+            ShaderVariation* ps = pixelShaders[j];
+            if (!ps || !ps->IsCreated())
+                continue;
+
+            // Forward lit variations are only combined when the light type and shadowing match, the same way as
+            // SetBatchShaders() selects them. Normal offset pixel shader variations are not used for forward lights
+            if (pass->GetLightingMode() == LIGHTING_PERPIXEL)
+            {
+                unsigned vsLight = i % MAX_LIGHT_VS_VARIATIONS;
+                unsigned psLight = j % MAX_LIGHT_PS_VARIATIONS;
+                if (psLight >= LPS_SHADOW * 2)
+                    continue;
+                if ((vsLight >= LVS_SHADOW) != ((psLight & LPS_SHADOW) != 0))
+                    continue;
+
+                unsigned vsType = vsLight % LVS_SHADOW;
+                unsigned psType = psLight % LPS_SPEC;
+                if (psType == LPS_POINTMASK)
+                    psType = LPS_POINT;
+                if (vsType != psType)
+                    continue;
+            }
+
+            precache->StoreShaders(vs, ps);
+        }
+    }
+}
+
+static bool IsShaderReady(ShaderVariation* variation)
+{
+    // A variation that failed to compile is also ready, as it will not be retried. The compiler output must not be read while
+    // a worker thread may still be writing it
+    if (variation->IsCompiling())
+        return false;
+    return variation->IsCreated() || !variation->GetCompilerOutput().Empty();
+}
+
+static void LogShaderCompile(ShaderVariation* variation)
+{
+    if (variation->IsCreated())
+        URHO3D_LOGDEBUG("Compiled shader " + variation->GetFullName());
+    else if (!variation->GetCompilerOutput().Empty())
+        URHO3D_LOGERROR("Failed to compile shader " + variation->GetFullName() + ":\n" + variation->GetCompilerOutput());
+}
+
 inline PODVector<VertexElement> CreateInstancingBufferElements(unsigned numExtraElements)
 {
     static const unsigned NUM_INSTANCEMATRIX_ELEMENTS = 3;
@@ -483,6 +595,11 @@ void Renderer::SetMaxSortedInstances(int instances)
     maxSortedInstances_ = Max(instances, 0);
 }
 
+void Renderer::SetRetainedBatchQueues(bool enable)
+{
+    retainedBatchQueues_ = enable;
+}
+
 void Renderer::SetMaxOccluderTriangles(int triangles)
 {
     maxOccluderTriangles_ = Max(triangles, 0);
@@ -523,11 +640,78 @@ void Renderer::SetThreadedOcclusion(bool enable)
     }
 }
 
+void Renderer::SetTemporalOcclusion(bool enable)
+{
+    temporalOcclusion_ = enable;
+}
+
+void Renderer::SetThreadedViewCulling(bool enable)
+{
+    threadedViewCulling_ = enable;
+}
+
+void Renderer::SetAsyncShaderCompilation(bool enable)
+{
+    asyncShaderCompilation_ = enable;
+}
+
+void Renderer::SetFallbackTechnique(Technique* technique)
+{
+    fallbackTechnique_ = technique;
+}
+
+void Renderer::SetMaxShaderCompileMs(int ms)
+{
+    maxShaderCompileMs_ = Max(ms, 0);
+}
+
+void Renderer::SetClusteredLighting(bool enable)
+{
+    clusteredLighting_ = enable;
+}
+
 void Renderer::ReloadShaders()
 {
     shadersDirty_ = true;
 }
 
+unsigned Renderer::PrecompileShaders(Technique* technique, ShaderPrecache* precache)
+{
+    if (!technique || !initialized_)
+        return 0;
+
+    URHO3D_PROFILE(PrecompileShaders);
+
+    if (shadersDirty_)
+        LoadShaders();
+
+    BatchQueue queue;
+    unsigned numCompiled = 0;
+
+    PODVector<Pass*> passes = technique->GetPasses();
+    for (PODVector<Pass*>::ConstIterator i = passes.Begin(); i != passes.End(); ++i)
+    {
+        Pass* pass = *i;
+
+        // Load the same variations as SetBatchShaders() would
+        if (pass->GetShadersLoadedFrameNumber() != shadersChangedFrameNumber_)
+            pass->ReleaseShaders();
+
+        Vector<SharedPtr<ShaderVariation> >& vertexShaders = pass->GetVertexShaders();
+        Vector<SharedPtr<ShaderVariation> >& pixelShaders = pass->GetPixelShaders();
+        if (!vertexShaders.Size() || !pixelShaders.Size())
+            LoadPassShaders(pass, vertexShaders, pixelShaders, queue);
+
+        numCompiled += CompileShaderVariations(vertexShaders, GetDynamicInstancing());
+        numCompiled += CompileShaderVariations(pixelShaders, GetDynamicInstancing());
+
+        if (precache)
+            StoreShaderCombinations(precache, pass, vertexShaders, pixelShaders);
+    }
+
+    return numCompiled;
+}
+
 void Renderer::ApplyShadowMapFilter(View* view, Texture2D* shadowMap, float blurScale)
 {
     if (shadowMapFilterInstance_ && shadowMapFilter_)
@@ -668,6 +852,9 @@ void Renderer::Update(float timeStep)
     if (shadersDirty_)
         LoadShaders();
 
+    if (!pendingShaders_.Empty())
+        UpdateShaderCompiles();
+
     // Queue update of the main viewports. Use reverse order, as rendering order is also reverse
     // to render auxiliary views before dependent main views
     for (unsigned i = viewports_.Size() - 1; i < viewports_.Size(); --i)
@@ -675,15 +862,18 @@ void Renderer::Update(float timeStep)
 
     // Update main viewports. This may queue further views
     unsigned numMainViewports = queuedViewports_.Size();
-    for (unsigned i = 0; i < numMainViewports; ++i)
-        UpdateQueuedViewport(i);
+    UpdateQueuedViewports(0, numMainViewports);
 
     // Gather queued & autoupdated render surfaces
     SendEvent(E_RENDERSURFACEUPDATE);
 
-    // Update viewports that were added as result of the event above
-    for (unsigned i = numMainViewports; i < queuedViewports_.Size(); ++i)
-        UpdateQueuedViewport(i);
+    // Update viewports that were added as result of the event above. Their updates may again queue further views
+    for (unsigned start = numMainViewports; start < queuedViewports_.Size();)
+    {
+        unsigned end = queuedViewports_.Size();
+        UpdateQueuedViewports(start, end);
+        start = end;
+    }
 
     queuedViewports_.Clear();
     resetViews_ = false;
@@ -703,6 +893,9 @@ void Renderer::Render()
     graphics_->SetDefaultTextureFilterMode(textureFilterMode_);
     graphics_->SetDefaultTextureAnisotropy((unsigned)textureAnisotropy_);
 
+    numShaderParametersSet_ = 0;
+    numShaderParametersSkipped_ = 0;
+
     // If no views that render to the backbuffer, clear the screen so that e.g. the UI is not rendered on top of previous frame
     bool hasBackbufferViews = false;
     for (unsigned i = 0; i < views_.Size(); ++i)
@@ -1103,6 +1296,22 @@ RenderSurface* Renderer::GetDepthStencil(int width, int height, int multiSample,
 OcclusionBuffer* Renderer::GetOcclusionBuffer(Camera* camera)
 {
     assert(numOcclusionBuffers_ <= occlusionBuffers_.Size());
+
+    // With temporal occlusion, prefer the buffer last used with the same camera, as its contents can be reused
+    if (temporalOcclusion_)
+    {
+        for (unsigned i = numOcclusionBuffers_ + 1; i < occlusionBuffers_.Size(); ++i)
+        {
+            if (occlusionBuffers_[i]->GetCamera() == camera)
+            {
+                SharedPtr<OcclusionBuffer> temp = occlusionBuffers_[i];
+                occlusionBuffers_[i] = occlusionBuffers_[numOcclusionBuffers_];
+                occlusionBuffers_[numOcclusionBuffers_] = temp;
+                break;
+            }
+        }
+    }
+
     if (numOcclusionBuffers_ == occlusionBuffers_.Size())
     {
         SharedPtr<OcclusionBuffer> newBuffer(new OcclusionBuffer(context_));
@@ -1159,10 +1368,67 @@ View* Renderer::GetActualView(View* view)
         return view;
 }
 
-void Renderer::SetBatchShaders(Batch& batch, Technique* tech, bool allowShadows, const BatchQueue& queue)
+bool Renderer::CheckClusteredLightingSupport(Pass* pass)
+{
+    if (!pass->IsClusteredLightingSupportChecked())
+    {
+        ShaderVariation* pixelShader = graphics_->GetShader(PS, pass->GetPixelShader(), pass->GetEffectivePixelShaderDefines());
+        pass->MarkClusteredLightingSupport(pixelShader && pixelShader->GetOwner()->GetClusteredLightingSupport());
+    }
+
+    return pass->GetClusteredLightingSupport();
+}
+
+bool Renderer::SetBatchShaders(Batch& batch, Technique* tech, bool allowShadows, const BatchQueue& queue)
 {
     Pass* pass = batch.pass_;
+    if (!ChooseBatchShaders(batch, pass, allowShadows, queue))
+        return true;
+
+    bool ownShaders = true;
 
+    // If the shaders are not compiled yet, compile them over the next frames and use the same pass of the fallback technique
+    // meanwhile. The fallback pass must have the same lighting mode for its shaders to match the batch's light queue
+    if (asyncShaderCompilation_ && batch.vertexShader_ && batch.pixelShader_ &&
+        (!IsShaderReady(batch.vertexShader_) || !IsShaderReady(batch.pixelShader_)))
+    {
+        Technique* fallbackTech = fallbackTechnique_ ? fallbackTechnique_.Get() : GetDefaultTechnique();
+        Pass* fallbackPass = fallbackTech && fallbackTech != tech ? fallbackTech->GetSupportedPass(pass->GetIndex()) : nullptr;
+        if (fallbackPass && fallbackPass->GetLightingMode() == pass->GetLightingMode())
+        {
+            ShaderVariation* vs = batch.vertexShader_;
+            ShaderVariation* ps = batch.pixelShader_;
+            ChooseBatchShaders(batch, fallbackPass, allowShadows, queue);
+
+            if (batch.vertexShader_ && batch.pixelShader_)
+            {
+                QueueShaderCompile(vs);
+                QueueShaderCompile(ps);
+                ownShaders = false;
+            }
+            else
+            {
+                batch.vertexShader_ = vs;
+                batch.pixelShader_ = ps;
+            }
+        }
+    }
+
+    // Log error if shaders could not be assigned, but only once per technique
+    if (!batch.vertexShader_ || !batch.pixelShader_)
+    {
+        if (!shaderErrorDisplayed_.Contains(tech))
+        {
+            shaderErrorDisplayed_.Insert(tech);
+            URHO3D_LOGERROR("Technique " + tech->GetName() + " has missing shaders");
+        }
+    }
+
+    return ownShaders;
+}
+
+bool Renderer::ChooseBatchShaders(Batch& batch, Pass* pass, bool allowShadows, const BatchQueue& queue)
+{
     // Check if need to release/reload all shaders
     if (pass->GetShadersLoadedFrameNumber() != shadersChangedFrameNumber_)
         pass->ReleaseShaders();
@@ -1195,7 +1461,7 @@ void Renderer::SetBatchShaders(Batch& batch, Technique* tech, bool allowShadows,
                 // Do not log error, as it would result in a lot of spam
                 batch.vertexShader_ = nullptr;
                 batch.pixelShader_ = nullptr;
-                return;
+                return false;
             }
 
             Light* light = lightQueue->light_;
@@ -1263,15 +1529,59 @@ void Renderer::SetBatchShaders(Batch& batch, Technique* tech, bool allowShadows,
         }
     }
 
-    // Log error if shaders could not be assigned, but only once per technique
-    if (!batch.vertexShader_ || !batch.pixelShader_)
+    return true;
+}
+
+void Renderer::QueueShaderCompile(ShaderVariation* variation)
+{
+    bool exists;
+    pendingShaders_.Insert(variation, exists);
+    if (!exists)
+        queuedShaders_.Push(SharedPtr<ShaderVariation>(variation));
+}
+
+void Renderer::UpdateShaderCompiles()
+{
+    URHO3D_PROFILE(UpdateShaderCompiles);
+
+    // Finish the compiles that the driver has completed. A variation may also have been released due to a shader reload,
+    // or have been waited for because it was needed for rendering
+    for (unsigned i = compilingShaders_.Size() - 1; i < compilingShaders_.Size(); --i)
     {
-        if (!shaderErrorDisplayed_.Contains(tech))
+        ShaderVariation* variation = compilingShaders_[i];
+        if (!variation->PollCompile())
         {
-            shaderErrorDisplayed_.Insert(tech);
-            URHO3D_LOGERROR("Technique " + tech->GetName() + " has missing shaders");
+            LogShaderCompile(variation);
+            pendingShaders_.Erase(variation);
+            compilingShaders_.Erase(i);
         }
     }
+
+    // Start queued compiles until the time budget runs out. On APIs without asynchronous compiles this compiles to completion
+    HiresTimer compileTimer;
+    long long maxUSec = (long long)maxShaderCompileMs_ * 1000;
+    unsigned numStarted = 0;
+
+    while (numStarted < queuedShaders_.Size() && (!numStarted || compileTimer.GetUSec(false) < maxUSec))
+    {
+        ShaderVariation* variation = queuedShaders_[numStarted++];
+
+        if (!IsShaderReady(variation))
+        {
+            variation->CreateAsync();
+            if (variation->IsCompiling())
+            {
+                compilingShaders_.Push(SharedPtr<ShaderVariation>(variation));
+                continue;
+            }
+
+            LogShaderCompile(variation);
+        }
+
+        pendingShaders_.Erase(variation);
+    }
+
+    queuedShaders_.Erase(0, numStarted);
 }
 
 void Renderer::SetLightVolumeBatchShaders(Batch& batch, Camera* camera, const String& vsName, const String& psName, const String& vsDefines,
@@ -1343,30 +1653,18 @@ void Renderer::SetCullMode(CullMode mode, Camera* camera)
     graphics_->SetCullMode(mode);
 }
 
-bool Renderer::ResizeInstancingBuffer(unsigned numInstances)
+void* Renderer::LockInstancingBuffer(unsigned numInstances, unsigned& start)
 {
     if (!instancingBuffer_ || !dynamicInstancing_)
-        return false;
-
-    unsigned oldSize = instancingBuffer_->GetVertexCount();
-    if (numInstances <= oldSize)
-        return true;
-
-    unsigned newSize = INSTANCING_BUFFER_DEFAULT_SIZE;
-    while (newSize < numInstances)
-        newSize <<= 1;
+        return nullptr;
 
-    const PODVector<VertexElement> instancingBufferElements = CreateInstancingBufferElements(numExtraInstancingBufferElements_);
-    if (!instancingBuffer_->SetSize(newSize, instancingBufferElements, true))
-    {
-        URHO3D_LOGERROR("Failed to resize instancing buffer to " + String(newSize));
-        // If failed, try to restore the old size
-        instancingBuffer_->SetSize(oldSize, instancingBufferElements, true);
-        return false;
-    }
+    return instancingBuffer_->Lock(numInstances, start);
+}
 
-    URHO3D_LOGDEBUG("Resized instancing buffer to " + String(newSize));
-    return true;
+void Renderer::UnlockInstancingBuffer()
+{
+    if (instancingBuffer_)
+        instancingBuffer_->Unlock();
 }
 
 void Renderer::OptimizeLightByScissor(Light* light, Camera* camera)
@@ -1473,13 +1771,69 @@ const Rect& Renderer::GetLightScissor(Light* light, Camera* camera)
 }
 
 void Renderer::UpdateQueuedViewport(unsigned index)
+{
+    View* view = DefineQueuedViewport(index);
+    if (!view)
+        return;
+
+    // Update view. This may queue further views. View will send update begin/end events once its state is set
+    ResetShadowMapAllocations(); // Each view can reuse the same shadow maps
+    view->Update(frame_);
+}
+
+void Renderer::UpdateQueuedViewports(unsigned start, unsigned end)
+{
+    if (!threadedViewCulling_ || end - start < 2)
+    {
+        for (unsigned i = start; i < end; ++i)
+            UpdateQueuedViewport(i);
+        return;
+    }
+
+    // Define all views and update their octrees first, so that the octree queries of the views can run in parallel. Views
+    // sharing a culling camera are marked prepared already here, so that they are still prepared only once
+    definedViews_.Clear();
+    preCullViews_.Clear();
+    for (unsigned i = start; i < end; ++i)
+    {
+        View* view = DefineQueuedViewport(i);
+        definedViews_.Push(view);
+        if (view && view->BeginPreCull())
+        {
+            preCullViews_.Push(view);
+            StorePreparedView(view, view->GetCullCamera());
+        }
+    }
+
+    if (preCullViews_.Size() > 1)
+    {
+        URHO3D_PROFILE(PreCullViews);
+        GetSubsystem<WorkQueue>()->ParallelFor(PreCullViewWork, preCullViews_.Buffer(), preCullViews_.Buffer() +
+            preCullViews_.Size(), nullptr);
+    }
+    else if (preCullViews_.Size())
+        preCullViews_[0]->PreCull();
+
+    // Batch the views serially, as the views share the drawables and the shadow map allocations
+    for (unsigned i = 0; i < definedViews_.Size(); ++i)
+    {
+        View* view = definedViews_[i];
+        if (!view)
+            continue;
+
+        ResetShadowMapAllocations();
+        view->Update(frame_);
+    }
+}
+
+View* Renderer::DefineQueuedViewport(unsigned index)
 {
     WeakPtr<RenderSurface>& renderTarget = queuedViewports_[index].first_;
     WeakPtr<Viewport>& viewport = queuedViewports_[index].second_;
 
     // Null pointer means backbuffer view. Differentiate between that and an expired rendersurface
     if ((renderTarget.NotNull() && renderTarget.Expired()) || viewport.Expired())
-        return;
+        return nullptr;
 
     // (Re)allocate the view structure if necessary
     if (!viewport->GetView() || resetViews_)
@@ -1489,14 +1843,14 @@ void Renderer::UpdateQueuedViewport(unsigned index)
     assert(view);
     // Check if view can be defined successfully (has either valid scene, camera and octree, or no scene passes)
     if (!view->Define(renderTarget, viewport))
-        return;
+        return nullptr;
 
     views_.Push(WeakPtr<View>(view));
 
     const IntRect& viewRect = viewport->GetRect();
     Scene* scene = viewport->GetScene();
     if (!scene)
-        return;
+        return nullptr;
 
     auto* octree = scene->GetComponent<Octree>();
 
@@ -1518,9 +1872,7 @@ void Renderer::UpdateQueuedViewport(unsigned index)
             debug->SetView(viewport->GetCamera());
     }
 
-    // Update view. This may queue further views. View will send update begin/end events once its state is set
-    ResetShadowMapAllocations(); // Each view can reuse the same shadow maps
-    view->Update(frame_);
+    return view;
 }
 
 void Renderer::PrepareViewRender()
@@ -1653,15 +2005,23 @@ void Renderer::LoadPassShaders(Pass* pass, Vector<SharedPtr<ShaderVariation> >&
     if (psDefines.Length() && !psDefines.EndsWith(" "))
         psDefines += ' ';
 
-    // Append defines from batch queue (renderpath command) if needed
-    if (queue.vsExtraDefines_.Length())
+    // Append defines from batch queue (renderpath command) if needed. Leave out the clustered lighting defines if the
+    // shader does not support them, to not compile redundant variations
+    String vsExtraDefines = queue.vsExtraDefines_;
+    String psExtraDefines = queue.psExtraDefines_;
+    if (psExtraDefines.Contains("CLUSTERED") && !CheckClusteredLightingSupport(pass))
+    {
+        vsExtraDefines = RemoveClusteredDefines(vsExtraDefines);
+        psExtraDefines = RemoveClusteredDefines(psExtraDefines);
+    }
+    if (vsExtraDefines.Length())
     {
-        vsDefines += queue.vsExtraDefines_;
+        vsDefines += vsExtraDefines;
         vsDefines += ' ';
     }
-    if (queue.psExtraDefines_.Length())
+    if (psExtraDefines.Length())
     {
-        psDefines += queue.psExtraDefines_;
+        psDefines += psExtraDefines;
         psDefines += ' ';
     }
 
@@ -1886,9 +2246,9 @@ void Renderer::CreateInstancingBuffer()
         return;
     }
 
-    instancingBuffer_ = new VertexBuffer(context_);
+    instancingBuffer_ = new RingVertexBuffer(context_);
     const PODVector<VertexElement> instancingBufferElements = CreateInstancingBufferElements(numExtraInstancingBufferElements_);
-    if (!instancingBuffer_->SetSize(INSTANCING_BUFFER_DEFAULT_SIZE, instancingBufferElements, true))
+    if (!instancingBuffer_->SetSize(INSTANCING_BUFFER_DEFAULT_SIZE, instancingBufferElements))
     {
         instancingBuffer_.Reset();
         dynamicInstancing_ = false;
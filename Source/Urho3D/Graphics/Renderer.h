@@ -28,6 +28,7 @@
 #include "../Core/Mutex.h"
 #include "../Graphics/Batch.h"
 #include "../Graphics/Drawable.h"
+#include "../Graphics/RingVertexBuffer.h"
 #include "../Graphics/Viewport.h"
 #include "../Math/Color.h"
 
@@ -46,6 +47,7 @@ class RenderPath;
 class RenderSurface;
 class ResourceCache;
 class Scene;
+class ShaderPrecache;
 class Skeleton;
 class OcclusionBuffer;
 class Technique;
@@ -254,6 +256,9 @@ public:
     /// Set maximum number of sorted instances per batch group. If exceeded, instances are rendered unsorted.
     /// @property
     void SetMaxSortedInstances(int instances);
+    /// Set retained batch queues on/off. When on, the instanced batch groups of scene passes persist across frames along with their chosen shaders, which avoids most shader selection work. The batches themselves are still collected from the visible drawables each frame. Default off.
+    /// @property
+    void SetRetainedBatchQueues(bool enable);
     /// Set maximum number of occluder triangles.
     /// @property
     void SetMaxOccluderTriangles(int triangles);
@@ -266,6 +271,24 @@ public:
     /// Set whether to thread occluder rendering. Default false.
     /// @property
     void SetThreadedOcclusion(bool enable);
+    /// Set whether to reuse occlusion buffer contents from the previous frame, reprojected to the current camera, and draw only the occluders that changed. Default false.
+    /// @property
+    void SetTemporalOcclusion(bool enable);
+    /// Set whether to query the octree for several views in parallel worker threads before updating them. Default true.
+    /// @property
+    void SetThreadedViewCulling(bool enable);
+    /// Set whether to compile missing shader variations over the following frames instead of stalling, rendering with the fallback technique's shaders meanwhile. Default false.
+    /// @property
+    void SetAsyncShaderCompilation(bool enable);
+    /// Set technique to take shaders from while a batch's own shaders are compiling. Null (default) uses the default non-textured technique.
+    /// @property
+    void SetFallbackTechnique(Technique* technique);
+    /// Set time budget in milliseconds for starting shader compiles on each frame. At least one compile is started on each frame. Default 5.
+    /// @property
+    void SetMaxShaderCompileMs(int ms);
+    /// Set whether to assign unshadowed point and spot lights to a screen-space cluster grid and shade them in the base pass of forward rendering, instead of drawing an additional pass per light. Requires OpenGL 3 or Direct3D 11. Default false.
+    /// @property
+    void SetClusteredLighting(bool enable);
     /// Set shadow depth bias multiplier for mobile platforms to counteract possible worse shadow map precision. Default 1.0 (no effect).
     /// @property
     void SetMobileShadowBiasMul(float mul);
@@ -277,6 +300,8 @@ public:
     void SetMobileNormalOffsetMul(float mul);
     /// Force reload of shaders.
     void ReloadShaders();
+    /// Compile the shader variations the passes of a technique can use with the current rendering settings, so that they are written to the shader cache if supported and do not cause a hitch on first use. Render path commands with extra defines are not covered. Return the number of variations compiled or already compiled. Optionally store the vertex and pixel shader combinations the passes can use to a shader precache.
+    unsigned PrecompileShaders(Technique* technique, ShaderPrecache* precache = nullptr);
 
     /// Apply post processing filter to the shadow map. Called by View.
     void ApplyShadowMapFilter(View* view, Texture2D* shadowMap, float blurScale);
@@ -369,6 +394,13 @@ public:
     /// @property
     int GetMaxSortedInstances() const { return maxSortedInstances_; }
 
+    /// Return whether retained batch queues are in use.
+    /// @property
+    bool GetRetainedBatchQueues() const { return retainedBatchQueues_; }
+
+    /// Return frame number on which shaders last changed.
+    unsigned GetShadersChangedFrameNumber() const { return shadersChangedFrameNumber_; }
+
     /// Return maximum number of occluder triangles.
     /// @property
     int GetMaxOccluderTriangles() const { return maxOccluderTriangles_; }
@@ -385,6 +417,34 @@ public:
     /// @property
     bool GetThreadedOcclusion() const { return threadedOcclusion_; }
 
+    /// Return whether occlusion buffer contents are reused from the previous frame.
+    /// @property
+    bool GetTemporalOcclusion() const { return temporalOcclusion_; }
+
+    /// Return whether views are culled in parallel.
+    /// @property
+    bool GetThreadedViewCulling() const { return threadedViewCulling_; }
+
+    /// Return whether shaders are compiled over several frames.
+    /// @property
+    bool GetAsyncShaderCompilation() const { return asyncShaderCompilation_; }
+
+    /// Return technique used while shaders are compiling.
+    /// @property
+    Technique* GetFallbackTechnique() const { return fallbackTechnique_; }
+
+    /// Return time budget in milliseconds for starting shader compiles on each frame.
+    /// @property
+    int GetMaxShaderCompileMs() const { return maxShaderCompileMs_; }
+
+    /// Return number of shader variations waiting for or undergoing compilation.
+    /// @property
+    unsigned GetNumPendingShaders() const { return pendingShaders_.Size(); }
+
+    /// Return whether clustered forward lighting is enabled.
+    /// @property
+    bool GetClusteredLighting() const { return clusteredLighting_; }
+
     /// Return shadow depth bias multiplier for mobile platforms.
     /// @property
     float GetMobileShadowBiasMul() const { return mobileShadowBiasMul_; }
@@ -409,6 +469,14 @@ public:
     /// @property
     unsigned GetNumBatches() const { return numBatches_; }
 
+    /// Return number of material shader parameters set on the last frame, either individually or as part of constant buffer contents.
+    /// @property
+    unsigned GetNumShaderParametersSet() const { return numShaderParametersSet_; }
+
+    /// Return number of material shader parameters skipped on the last frame because the shaders already held them.
+    /// @property
+    unsigned GetNumShaderParametersSkipped() const { return numShaderParametersSkipped_; }
+
     /// Return number of geometries rendered.
     /// @property
     unsigned GetNumGeometries(bool allViews = false) const;
@@ -445,7 +513,7 @@ public:
     TextureCube* GetIndirectionCubeMap() const { return indirectionCubeMap_; }
 
     /// Return the instancing vertex buffer.
-    VertexBuffer* GetInstancingBuffer() const { return dynamicInstancing_ ? instancingBuffer_.Get() : nullptr; }
+    VertexBuffer* GetInstancingBuffer() const { return dynamicInstancing_ && instancingBuffer_ ? instancingBuffer_->GetVertexBuffer() : nullptr; }
 
     /// Return the frame update parameters.
     const FrameInfo& GetFrameInfo() const { return frame_; }
@@ -480,15 +548,25 @@ public:
     void StorePreparedView(View* view, Camera* camera);
     /// Return a prepared view if exists for the specified camera. Used to avoid duplicate view preparation CPU work.
     View* GetPreparedView(Camera* camera);
-    /// Choose shaders for a forward rendering batch. The related batch queue is provided in case it has extra shader compilation defines.
-    void SetBatchShaders(Batch& batch, Technique* tech, bool allowShadows, const BatchQueue& queue);
+    /// Choose shaders for a forward rendering batch. The related batch queue is provided in case it has extra shader compilation defines. Return false if fallback shaders were chosen while the batch's own shaders are compiling.
+    bool SetBatchShaders(Batch& batch, Technique* tech, bool allowShadows, const BatchQueue& queue);
+    /// Return whether the pixel shader of a pass supports clustered forward lighting. The result is cached in the pass until its shaders are released.
+    bool CheckClusteredLightingSupport(Pass* pass);
     /// Choose shaders for a deferred light volume batch.
     void SetLightVolumeBatchShaders
         (Batch& batch, Camera* camera, const String& vsName, const String& psName, const String& vsDefines, const String& psDefines);
     /// Set cull mode while taking possible projection flipping into account.
     void SetCullMode(CullMode mode, Camera* camera);
-    /// Ensure sufficient size of the instancing vertex buffer. Return true if successful.
-    bool ResizeInstancingBuffer(unsigned numInstances);
+    /// Allocate space for instances from the instancing vertex buffer and lock it for writing. Return data pointer and the first instance index if successful. The instances must be drawn before the next allocation.
+    void* LockInstancingBuffer(unsigned numInstances, unsigned& start);
+    /// Unlock the instancing vertex buffer after writing.
+    void UnlockInstancingBuffer();
+    /// Add to the number of material shader parameters set and skipped on this frame. Called by Batch.
+    void AddShaderParameterStats(unsigned numSet, unsigned numSkipped)
+    {
+        numShaderParametersSet_ += numSet;
+        numShaderParametersSkipped_ += numSkipped;
+    }
     /// Optimize a light by scissor rectangle.
     void OptimizeLightByScissor(Light* light, Camera* camera);
     /// Optimize a light by marking it to the stencil buffer and setting a stencil test.
@@ -504,6 +582,12 @@ private:
     void Initialize();
     /// Reload shaders.
     void LoadShaders();
+    /// Choose shaders from a pass for a forward rendering batch. Return false if the pass needs a light queue but the batch has none.
+    bool ChooseBatchShaders(Batch& batch, Pass* pass, bool allowShadows, const BatchQueue& queue);
+    /// Queue a shader variation for compilation over the following frames.
+    void QueueShaderCompile(ShaderVariation* variation);
+    /// Finish completed shader compiles and start queued ones within the time budget.
+    void UpdateShaderCompiles();
     /// Reload shaders for a material pass. The related batch queue is provided in case it has extra shader compilation defines.
     void LoadPassShaders(Pass* pass, Vector<SharedPtr<ShaderVariation> >& vertexShaders, Vector<SharedPtr<ShaderVariation> >& pixelShaders, const BatchQueue& queue);
     /// Release shaders used in materials.
@@ -518,6 +602,10 @@ private:
     void SetIndirectionTextureData();
     /// Update a queued viewport for rendering.
     void UpdateQueuedViewport(unsigned index);
+    /// Update a range of queued viewports for rendering, culling their views in parallel if enabled.
+    void UpdateQueuedViewports(unsigned start, unsigned end);
+    /// Define the view of a queued viewport and update its octree. Return the view if it needs to be updated.
+    View* DefineQueuedViewport(unsigned index);
     /// Prepare for rendering of a new view.
     void PrepareViewRender();
     /// Remove unused occlusion and screen buffers.
@@ -554,7 +642,7 @@ private:
     /// Point light volume geometry.
     SharedPtr<Geometry> pointLightGeometry_;
     /// Instance stream vertex buffer.
-    SharedPtr<VertexBuffer> instancingBuffer_;
+    SharedPtr<RingVertexBuffer> instancingBuffer_;
     /// Default material.
     SharedPtr<Material> defaultMaterial_;
     /// Default range attenuation texture.
@@ -591,12 +679,24 @@ private:
     Vector<Pair<WeakPtr<RenderSurface>, WeakPtr<Viewport> > > queuedViewports_;
     /// Views that have been processed this frame.
     Vector<WeakPtr<View> > views_;
+    /// Defined views waiting for update, in queued order. Null for viewports that need no update.
+    PODVector<View*> definedViews_;
+    /// Defined views being culled in parallel.
+    PODVector<View*> preCullViews_;
     /// Prepared views by culling camera.
     HashMap<Camera*, WeakPtr<View> > preparedViews_;
     /// Octrees that have been updated during the frame.
     HashSet<Octree*> updatedOctrees_;
     /// Techniques for which missing shader error has been displayed.
     HashSet<Technique*> shaderErrorDisplayed_;
+    /// Fallback technique for batches whose shaders are compiling.
+    SharedPtr<Technique> fallbackTechnique_;
+    /// Shader variations waiting for compilation.
+    Vector<SharedPtr<ShaderVariation> > queuedShaders_;
+    /// Shader variations compiling asynchronously.
+    Vector<SharedPtr<ShaderVariation> > compilingShaders_;
+    /// Shader variations that are queued or compiling.
+    HashSet<ShaderVariation*> pendingShaders_;
     /// Mutex for shadow camera allocation.
     Mutex rendererMutex_;
     /// Current variation names for deferred light volume shaders.
@@ -629,6 +729,8 @@ private:
     int maxSortedInstances_{1000};
     /// Maximum occluder triangles.
     int maxOccluderTriangles_{5000};
+    /// Time budget in milliseconds for starting shader compiles on each frame.
+    int maxShaderCompileMs_{5};
     /// Occlusion buffer width.
     int occlusionBufferSize_{256};
     /// Occluder screen size threshold.
@@ -647,6 +749,10 @@ private:
     unsigned numPrimitives_{};
     /// Number of batches (3D geometry only).
     unsigned numBatches_{};
+    /// Number of material shader parameters set.
+    unsigned numShaderParametersSet_{};
+    /// Number of material shader parameters skipped.
+    unsigned numShaderParametersSkipped_{};
     /// Frame number on which shaders last changed.
     unsigned shadersChangedFrameNumber_{M_MAX_UNSIGNED};
     /// Current stencil value for light optimization.
@@ -661,10 +767,20 @@ private:
     bool reuseShadowMaps_{true};
     /// Dynamic instancing flag.
     bool dynamicInstancing_{true};
+    /// Retained batch queues flag.
+    bool retainedBatchQueues_{};
     /// Number of extra instancing data elements.
     int numExtraInstancingBufferElements_{};
     /// Threaded occlusion rendering flag.
     bool threadedOcclusion_{};
+    /// Temporal occlusion flag.
+    bool temporalOcclusion_{};
+    /// Threaded view culling flag.
+    bool threadedViewCulling_{true};
+    /// Asynchronous shader compilation flag.
+    bool asyncShaderCompilation_{};
+    /// Clustered forward lighting flag.
+    bool clusteredLighting_{};
     /// Shaders need reloading flag.
     bool shadersDirty_{true};
     /// Initialized flag.
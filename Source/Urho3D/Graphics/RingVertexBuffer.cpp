@@ -0,0 +1,107 @@
+//
+// Copyright (c) 2008-2020 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Precompiled.h"
+
+#include "../Graphics/RingVertexBuffer.h"
+#include "../IO/Log.h"
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+RingVertexBuffer::RingVertexBuffer(Context* context) :
+    Object(context),
+    buffer_(new VertexBuffer(context))
+{
+}
+
+RingVertexBuffer::~RingVertexBuffer() = default;
+
+bool RingVertexBuffer::SetSize(unsigned vertexCount, const PODVector<VertexElement>& elements)
+{
+    position_ = 0;
+    discardNext_ = true;
+    return buffer_->SetSize(vertexCount, elements, true);
+}
+
+bool RingVertexBuffer::SetSize(unsigned vertexCount, unsigned elementMask)
+{
+    return SetSize(vertexCount, VertexBuffer::GetElements(elementMask));
+}
+
+void* RingVertexBuffer::Lock(unsigned count, unsigned& start)
+{
+    if (!count)
+        return nullptr;
+
+    unsigned vertexCount = buffer_->GetVertexCount();
+    if (count > vertexCount)
+    {
+        // Grow to the next power of two that fits the range, at least doubling the size
+        unsigned newSize = NextPowerOfTwo(Max(count, vertexCount * 2));
+        PODVector<VertexElement> elements = buffer_->GetElements();
+        if (!SetSize(newSize, elements))
+        {
+            URHO3D_LOGERROR("Failed to resize ring vertex buffer to " + String(newSize));
+            return nullptr;
+        }
+
+        URHO3D_LOGDEBUG("Resized ring vertex buffer to " + String(newSize));
+    }
+
+    // Wrap around to the start if the range does not fit in the remaining space
+    if (position_ + count > buffer_->GetVertexCount())
+    {
+        position_ = 0;
+        discardNext_ = true;
+    }
+
+    void* data = discardNext_ ? buffer_->Lock(position_, count, true) : buffer_->LockNoOverwrite(position_, count);
+    if (!data)
+        return nullptr;
+
+    start = position_;
+    position_ += count;
+    discardNext_ = false;
+    return data;
+}
+
+void RingVertexBuffer::Unlock()
+{
+    buffer_->Unlock();
+}
+
+unsigned RingVertexBuffer::SetData(const void* data, unsigned count)
+{
+    unsigned start;
+    void* dest = Lock(count, start);
+    if (!dest)
+        return M_MAX_UNSIGNED;
+
+    memcpy(dest, data, (size_t)count * buffer_->GetVertexSize());
+    Unlock();
+    return start;
+}
+
+}
@@ -0,0 +1,76 @@
+//
+// Copyright (c) 2008-2020 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+/// \file
+
+#pragma once
+
+#include "../Core/Object.h"
+#include "../Graphics/VertexBuffer.h"
+
+namespace Urho3D
+{
+
+/// Ring allocator for streaming dynamic vertex data into a shared vertex buffer. Ranges are appended without overwriting the data of draw calls already issued, and the buffer contents are discarded only when the allocation wraps around.
+class URHO3D_API RingVertexBuffer : public Object
+{
+    URHO3D_OBJECT(RingVertexBuffer, Object);
+
+public:
+    /// Construct.
+    explicit RingVertexBuffer(Context* context);
+    /// Destruct.
+    ~RingVertexBuffer() override;
+
+    /// Set size in vertices and vertex elements. Previous data will be lost. Return true if successful.
+    bool SetSize(unsigned vertexCount, const PODVector<VertexElement>& elements);
+    /// Set size in vertices and vertex elements using legacy element bitmask. Previous data will be lost. Return true if successful.
+    bool SetSize(unsigned vertexCount, unsigned elementMask);
+    /// Allocate a range of vertices and lock it for writing. Return data pointer and the first vertex of the range if successful. The buffer grows if the range does not fit. Draw calls using the range must be issued before the next allocation, as it may discard the buffer contents.
+    void* Lock(unsigned count, unsigned& start);
+    /// Unlock the range after writing.
+    void Unlock();
+    /// Allocate a range of vertices and copy data to it. Return the first vertex of the range, or M_MAX_UNSIGNED if failed.
+    unsigned SetData(const void* data, unsigned count);
+
+    /// Return the vertex buffer to draw from.
+    VertexBuffer* GetVertexBuffer() const { return buffer_; }
+
+    /// Return size in vertices.
+    unsigned GetVertexCount() const { return buffer_->GetVertexCount(); }
+
+    /// Return vertex size in bytes.
+    unsigned GetVertexSize() const { return buffer_->GetVertexSize(); }
+
+    /// Return the first free vertex.
+    unsigned GetPosition() const { return position_; }
+
+private:
+    /// Vertex buffer.
+    SharedPtr<VertexBuffer> buffer_;
+    /// First free vertex.
+    unsigned position_{};
+    /// Discard on next lock flag.
+    bool discardNext_{true};
+};
+
+}
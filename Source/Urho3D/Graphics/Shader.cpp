@@ -89,6 +89,7 @@ bool Shader::BeginLoad(Deserializer& source)
 
     // Load the shader source code and resolve any includes
     timeStamp_ = 0;
+    clusteredLightingSupport_ = false;
     String shaderCode;
     if (!ProcessSource(shaderCode, source))
         return false;
@@ -105,6 +106,9 @@ bool Shader::BeginLoad(Deserializer& source)
     psSourceCode_.Replace("void PS(", "void main(");
 #endif
 
+    vsSourceHash_ = StringHash(vsSourceCode_).Value();
+    psSourceHash_ = StringHash(psSourceCode_).Value();
+
     RefreshMemoryUse();
     return true;
 }
@@ -194,6 +198,11 @@ bool Shader::ProcessSource(String& code, Deserializer& source)
         }
         else
         {
+            // Lighting include files define the clustered lighting functions, but only a shader which calls them in its
+            // own code supports clustered lighting
+            if (source.GetName() == GetName() && line.Contains("CLUSTERED"))
+                clusteredLightingSupport_ = true;
+
             code += line;
             code += "\n";
         }
@@ -60,6 +60,12 @@ public:
     /// Return the latest timestamp of the shader code and its includes.
     unsigned GetTimeStamp() const { return timeStamp_; }
 
+    /// Return hash of either vertex or pixel shader source code, including the included files.
+    unsigned GetSourceHash(ShaderType type) const { return type == VS ? vsSourceHash_ : psSourceHash_; }
+
+    /// Return whether the shader's own code, not counting included files, handles the CLUSTERED define of clustered forward lighting.
+    bool GetClusteredLightingSupport() const { return clusteredLightingSupport_; }
+
 private:
     /// Process source code and include files. Return true if successful.
     bool ProcessSource(String& code, Deserializer& source);
@@ -76,10 +82,16 @@ private:
     HashMap<StringHash, SharedPtr<ShaderVariation> > vsVariations_;
     /// Pixel shader variations.
     HashMap<StringHash, SharedPtr<ShaderVariation> > psVariations_;
+    /// Vertex shader source code hash.
+    unsigned vsSourceHash_{};
+    /// Pixel shader source code hash.
+    unsigned psSourceHash_{};
     /// Source code timestamp.
     unsigned timeStamp_;
     /// Number of unique variations so far.
     unsigned numVariations_;
+    /// Clustered forward lighting support flag.
+    bool clusteredLightingSupport_{};
 };
 
 }
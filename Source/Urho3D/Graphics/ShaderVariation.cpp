@@ -22,9 +22,12 @@
 
 #include "../Precompiled.h"
 
+#include "../Core/IDPool.h"
+#include "../Core/WorkQueue.h"
 #include "../Graphics/Graphics.h"
 #include "../Graphics/Shader.h"
 #include "../Graphics/ShaderVariation.h"
+#include "../IO/FileSystem.h"
 
 #include "../DebugNew.h"
 
@@ -55,16 +58,25 @@ ShaderParameter::ShaderParameter(ShaderType type, const String& name, unsigned r
 {
 }
 
+/// Return the pool of shader variation sort IDs by shader type. Intentionally never destroyed, as shader variations may outlive static destruction.
+static IDPool& GetSortIDPool(ShaderType type)
+{
+    static auto* pools = new IDPool[2];
+    return pools[type == PS ? 1 : 0];
+}
+
 ShaderVariation::ShaderVariation(Shader* owner, ShaderType type) :
     GPUObject(owner->GetSubsystem<Graphics>()),
     owner_(owner),
-    type_(type)
+    type_(type),
+    sortID_(GetSortIDPool(type).Allocate())
 {
 }
 
 ShaderVariation::~ShaderVariation()
 {
     Release();
+    GetSortIDPool(type_).Free(sortID_);
 }
 
 void ShaderVariation::SetName(const String& name)
@@ -77,4 +89,22 @@ Shader* ShaderVariation::GetOwner() const
     return owner_;
 }
 
+bool ShaderVariation::IsCreated() const
+{
+#ifdef URHO3D_OPENGL
+    return object_.name_ && !compiling_;
+#else
+    return !compiling_ && object_.ptr_ != nullptr;
+#endif
+}
+
+String ShaderVariation::GetByteCodeFileName(const char* extension) const
+{
+    String path, name, sourceExtension;
+    SplitPath(owner_->GetName(), path, name, sourceExtension);
+
+    unsigned hash = StringHash::Calculate(defines_.CString(), owner_->GetSourceHash(type_));
+    return graphics_->GetShaderCacheDir() + name + "_" + StringHash(hash).ToString() + extension;
+}
+
 }
@@ -25,6 +25,7 @@
 #include "../Container/HashMap.h"
 #include "../Container/RefCounted.h"
 #include "../Container/ArrayPtr.h"
+#include "../Container/Ptr.h"
 #include "../Graphics/GPUObject.h"
 #include "../Graphics/GraphicsDefs.h"
 
@@ -33,6 +34,8 @@ namespace Urho3D
 
 class ConstantBuffer;
 class Shader;
+class ShaderProgram;
+struct WorkItem;
 
 /// %Shader parameter definition.
 struct ShaderParameter
@@ -77,6 +80,21 @@ struct ShaderParameter
     ConstantBuffer* bufferPtr_{};
 };
 
+/// Precomputed constant buffer contents for a group of shader parameters, laid out for a specific shader program.
+struct ShaderParameterBlock
+{
+    /// Shader program the contents are laid out for.
+    WeakPtr<ShaderProgram> program_;
+    /// Version of the parameter values the contents were built from.
+    unsigned version_{};
+    /// Whether the shader program keeps all the parameters in constant buffers.
+    bool valid_{};
+    /// Constant buffers to copy the contents to.
+    PODVector<ConstantBuffer*> buffers_;
+    /// Contents of the constant buffers, one after another.
+    PODVector<unsigned char> data_;
+};
+
 /// Vertex or pixel shader on the GPU.
 class URHO3D_API ShaderVariation : public RefCounted, public GPUObject
 {
@@ -91,8 +109,12 @@ public:
     /// Release the shader.
     void Release() override;
 
-    /// Compile the shader. Return true if successful.
+    /// Compile the shader. Return true if successful. If an asynchronous compile is in progress, wait for it to finish.
     bool Create();
+    /// Start compiling the shader without waiting for the result, if supported by the rendering API. Otherwise compile now. Return true if no error so far.
+    bool CreateAsync();
+    /// Check an asynchronous compile and finish creating the shader if the compile has completed. Return true while still in progress.
+    bool PollCompile();
     /// Set name.
     void SetName(const String& name);
     /// Set defines.
@@ -131,12 +153,21 @@ public:
     /// Return compile error/warning string.
     const String& GetCompilerOutput() const { return compilerOutput_; }
 
+    /// Return whether the shader has been created and is not compiling asynchronously.
+    bool IsCreated() const;
+
+    /// Return whether an asynchronous compile has been started and not yet finished. The other properties must not be read meanwhile.
+    bool IsCompiling() const { return compiling_; }
+
     /// Return constant buffer data sizes.
     const unsigned* GetConstantBufferSizes() const { return &constantBufferSizes_[0]; }
 
     /// Return defines with the CLIPPLANE define appended. Used internally on Direct3D11 only, will be empty on other APIs.
     const String& GetDefinesClipPlane() { return definesClipPlane_; }
 
+    /// Return small integer ID for batch state sorting. Unique among existing shader variations of the same type.
+    unsigned GetSortID() const { return sortID_; }
+
     /// D3D11 vertex semantic names. Used internally.
     static const char* elementSemanticNames[];
 
@@ -144,11 +175,25 @@ private:
     /// Load bytecode from a file. Return true if successful.
     bool LoadByteCode(const String& binaryShaderName);
     /// Compile from source. Return true if successful.
-    bool Compile();
+    bool Compile(const String& sourceCode, const String& sourceName);
+    /// Create the shader object and submit the source for compiling. Used on OpenGL only.
+    bool BeginCompile();
+    /// Check the compile result. Used on OpenGL only.
+    bool EndCompile();
+    /// Create the shader object from the bytecode. Used on Direct3D11 only.
+    bool CreateFromByteCode();
+    /// Wait for the asynchronous compile to complete and finish it. Used on Direct3D11 only.
+    void WaitForCompile();
+    /// Save the bytecode of a completed asynchronous compile and clear the compile state. Used on Direct3D11 only.
+    void FinishCompile();
+    /// Work function for compiling in a worker thread. Used on Direct3D11 only.
+    static void CompileWork(const WorkItem* item, unsigned threadIndex);
     /// Inspect the constant parameters and input layout (if applicable) from the shader bytecode.
     void ParseParameters(unsigned char* bufData, unsigned bufSize);
     /// Save bytecode to a file.
     void SaveByteCode(const String& binaryShaderName);
+    /// Return bytecode file name in the shader cache. Keyed by a hash of the source code and defines, so that a changed shader never loads stale bytecode.
+    String GetByteCodeFileName(const char* extension) const;
     /// Calculate constant buffer sizes from parameters.
     void CalculateConstantBufferSizes();
 
@@ -156,6 +201,8 @@ private:
     WeakPtr<Shader> owner_;
     /// Shader type.
     ShaderType type_;
+    /// Batch state sorting ID.
+    unsigned sortID_;
     /// Vertex element hash for vertex shaders. Zero for pixel shaders. Note that hashing is different than vertex buffers.
     unsigned long long elementHash_{};
     /// Shader parameters.
@@ -174,6 +221,14 @@ private:
     String definesClipPlane_;
     /// Shader compile error string.
     String compilerOutput_;
+    /// Source code copied for the asynchronous compile, so that a shader reload does not modify it meanwhile. Used on Direct3D11 only.
+    String compileSourceCode_;
+    /// Source name copied for the asynchronous compile. Used on Direct3D11 only.
+    String compileSourceName_;
+    /// Work item of the asynchronous compile. Used on Direct3D11 only.
+    SharedPtr<WorkItem> compileItem_;
+    /// Asynchronous compile in progress flag. Used on OpenGL and Direct3D11.
+    bool compiling_{};
 };
 
 }
@@ -31,6 +31,8 @@
 #include "../Graphics/OctreeQuery.h"
 #include "../Graphics/StaticModelGroup.h"
 #include "../Graphics/VertexBuffer.h"
+#include "../IO/MemoryBuffer.h"
+#include "../IO/VectorBuffer.h"
 #include "../Scene/Scene.h"
 
 #include "../DebugNew.h"
@@ -40,6 +42,9 @@ namespace Urho3D
 
 extern const char* GEOMETRY_CATEGORY;
 
+/// Number of instances in a chunk for coarse frustum and occlusion culling. Must be a multiple of four.
+static const unsigned INSTANCE_CHUNK_SIZE = 64;
+
 static const StringVector instanceNodesStructureElementNames =
 {
     "Instance Count",
@@ -63,6 +68,9 @@ void StaticModelGroup::RegisterObject(Context* context)
     URHO3D_ACCESSOR_ATTRIBUTE("Instance Nodes", GetNodeIDsAttr, SetNodeIDsAttr,
         VariantVector, Variant::emptyVariantVector, AM_DEFAULT | AM_NODEIDVECTOR)
         .SetMetadata(AttributeMetadata::P_VECTOR_STRUCT_ELEMENTS, instanceNodesStructureElementNames);
+    URHO3D_MIXED_ACCESSOR_ATTRIBUTE("Instance Transforms", GetInstanceTransformsAttr, SetInstanceTransformsAttr, PODVector<unsigned char>,
+        Variant::emptyBuffer, AM_FILE | AM_NOEDIT);
+    URHO3D_ATTRIBUTE("Instance Culling", bool, instanceCulling_, true, AM_DEFAULT);
 }
 
 void StaticModelGroup::ApplyAttributes()
@@ -96,8 +104,7 @@ void StaticModelGroup::ApplyAttributes()
         }
     }
 
-    worldTransforms_.Resize(instanceNodes_.Size());
-    numWorldTransforms_ = 0; // Correct amount will be found during world bounding box update
+    ResizeWorldTransforms();
     nodesDirty_ = false;
 
     OnMarkedDirty(GetNode());
@@ -168,24 +175,29 @@ void StaticModelGroup::ProcessRayQuery(const RayOctreeQuery& query, PODVector<Ra
 
 void StaticModelGroup::UpdateBatches(const FrameInfo& frame)
 {
+    // Shadow caster processing may update a group outside the view from several worker threads at once
+    MutexLock lock(batchMutex_);
+
     // Getting the world bounding box ensures the transforms are updated
     const BoundingBox& worldBoundingBox = GetWorldBoundingBox();
     const Matrix3x4& worldTransform = node_->GetWorldTransform();
     distance_ = frame.camera_->GetDistance(worldBoundingBox.Center());
 
+    const Matrix3x4* transforms = numWorldTransforms_ ? &worldTransforms_[0] : &Matrix3x4::IDENTITY;
+
     if (batches_.Size() > 1)
     {
         for (unsigned i = 0; i < batches_.Size(); ++i)
         {
             batches_[i].distance_ = frame.camera_->GetDistance(worldTransform * geometryData_[i].center_);
-            batches_[i].worldTransform_ = numWorldTransforms_ ? &worldTransforms_[0] : &Matrix3x4::IDENTITY;
+            batches_[i].worldTransform_ = transforms;
             batches_[i].numWorldTransforms_ = numWorldTransforms_;
         }
     }
     else if (batches_.Size() == 1)
     {
         batches_[0].distance_ = distance_;
-        batches_[0].worldTransform_ = numWorldTransforms_ ? &worldTransforms_[0] : &Matrix3x4::IDENTITY;
+        batches_[0].worldTransform_ = transforms;
         batches_[0].numWorldTransforms_ = numWorldTransforms_;
     }
 
@@ -197,6 +209,31 @@ void StaticModelGroup::UpdateBatches(const FrameInfo& frame)
         lodDistance_ = newLodDistance;
         CalculateLodLevels();
     }
+
+    if (instanceCulling_ && numWorldTransforms_ > 1)
+    {
+        // Shadow casters outside the view still cast shadows into it, so keep all instances for the shadow batches. Copy them
+        // only after the LOD levels have been chosen, as the copies include the geometries
+        if (castShadows_)
+            shadowBatches_ = batches_;
+        else
+            shadowBatches_.Clear();
+
+        const PODVector<Matrix3x4>& visibleTransforms = CullInstances(frame);
+        transforms = visibleTransforms.Size() ? &visibleTransforms[0] : &Matrix3x4::IDENTITY;
+        for (unsigned i = 0; i < batches_.Size(); ++i)
+        {
+            batches_[i].worldTransform_ = transforms;
+            batches_[i].numWorldTransforms_ = visibleTransforms.Size();
+        }
+    }
+    else
+        shadowBatches_.Clear();
+}
+
+const Vector<SourceBatch>& StaticModelGroup::GetShadowBatches() const
+{
+    return shadowBatches_.Empty() ? batches_ : shadowBatches_;
 }
 
 unsigned StaticModelGroup::GetNumOccluderTriangles()
@@ -313,6 +350,32 @@ void StaticModelGroup::RemoveAllInstanceNodes()
     UpdateNumTransforms();
 }
 
+void StaticModelGroup::AddInstanceTransform(const Matrix3x4& transform)
+{
+    instanceTransforms_.Push(transform);
+    ResizeWorldTransforms();
+    OnMarkedDirty(GetNode());
+}
+
+void StaticModelGroup::SetInstanceTransforms(const PODVector<Matrix3x4>& transforms)
+{
+    instanceTransforms_ = transforms;
+    ResizeWorldTransforms();
+    OnMarkedDirty(GetNode());
+}
+
+void StaticModelGroup::RemoveAllInstanceTransforms()
+{
+    instanceTransforms_.Clear();
+    ResizeWorldTransforms();
+    OnMarkedDirty(GetNode());
+}
+
+void StaticModelGroup::SetInstanceCulling(bool enable)
+{
+    instanceCulling_ = enable;
+}
+
 Node* StaticModelGroup::GetInstanceNode(unsigned index) const
 {
     return index < instanceNodes_.Size() ? instanceNodes_[index] : nullptr;
@@ -352,6 +415,19 @@ void StaticModelGroup::SetNodeIDsAttr(const VariantVector& value)
     nodeIDsDirty_ = false;
 }
 
+void StaticModelGroup::SetInstanceTransformsAttr(const PODVector<unsigned char>& value)
+{
+    MemoryBuffer buffer(value);
+    unsigned numTransforms = value.Size() ? buffer.ReadVLE() : 0;
+
+    instanceTransforms_.Resize(numTransforms);
+    for (unsigned i = 0; i < numTransforms; ++i)
+        instanceTransforms_[i] = buffer.ReadMatrix3x4();
+
+    ResizeWorldTransforms();
+    OnMarkedDirty(GetNode());
+}
+
 const VariantVector& StaticModelGroup::GetNodeIDsAttr() const
 {
     if (nodeIDsDirty_)
@@ -360,6 +436,17 @@ const VariantVector& StaticModelGroup::GetNodeIDsAttr() const
     return nodeIDsAttr_;
 }
 
+PODVector<unsigned char> StaticModelGroup::GetInstanceTransformsAttr() const
+{
+    VectorBuffer ret;
+
+    ret.WriteVLE(instanceTransforms_.Size());
+    for (unsigned i = 0; i < instanceTransforms_.Size(); ++i)
+        ret.WriteMatrix3x4(instanceTransforms_[i]);
+
+    return ret.GetBuffer();
+}
+
 void StaticModelGroup::OnNodeSetEnabled(Node* node)
 {
     Drawable::OnMarkedDirty(node);
@@ -367,7 +454,7 @@ void StaticModelGroup::OnNodeSetEnabled(Node* node)
 
 void StaticModelGroup::OnWorldBoundingBoxUpdate()
 {
-    // Update transforms and bounding box at the same time to have to go through the objects only once
+    // Update transforms and bounding boxes at the same time to have to go through the objects only once
     unsigned index = 0;
 
     BoundingBox worldBox;
@@ -378,9 +465,19 @@ void StaticModelGroup::OnWorldBoundingBoxUpdate()
         if (!node || !node->IsEnabled())
             continue;
 
-        const Matrix3x4& worldTransform = node->GetWorldTransform();
-        worldTransforms_[index++] = worldTransform;
-        worldBox.Merge(boundingBox_.Transformed(worldTransform));
+        worldTransforms_[index] = node->GetWorldTransform();
+        worldBox.Merge(UpdateInstanceBounds(index++));
+    }
+
+    if (instanceTransforms_.Size())
+    {
+        const Matrix3x4& groupTransform = node_->GetWorldTransform();
+
+        for (unsigned i = 0; i < instanceTransforms_.Size(); ++i)
+        {
+            worldTransforms_[index] = groupTransform * instanceTransforms_[i];
+            worldBox.Merge(UpdateInstanceBounds(index++));
+        }
     }
 
     worldBoundingBox_ = worldBox;
@@ -392,14 +489,23 @@ void StaticModelGroup::OnWorldBoundingBoxUpdate()
 
 void StaticModelGroup::UpdateNumTransforms()
 {
-    worldTransforms_.Resize(instanceNodes_.Size());
-    numWorldTransforms_ = 0; // Correct amount will be during world bounding box update
+    ResizeWorldTransforms();
     nodeIDsDirty_ = true;
 
     OnMarkedDirty(GetNode());
     MarkNetworkUpdate();
 }
 
+void StaticModelGroup::ResizeWorldTransforms()
+{
+    unsigned maxTransforms = instanceNodes_.Size() + instanceTransforms_.Size();
+
+    worldTransforms_.Resize(maxTransforms);
+    instanceBounds_.Resize((maxTransforms + 3) >> 2u);
+    chunkBoundingBoxes_.Resize((maxTransforms + INSTANCE_CHUNK_SIZE - 1) / INSTANCE_CHUNK_SIZE);
+    numWorldTransforms_ = 0; // Correct amount will be found during world bounding box update
+}
+
 void StaticModelGroup::UpdateNodeIDs() const
 {
     unsigned numInstances = instanceNodes_.Size();
@@ -416,4 +522,86 @@ void StaticModelGroup::UpdateNodeIDs() const
     nodeIDsDirty_ = false;
 }
 
+BoundingBox StaticModelGroup::UpdateInstanceBounds(unsigned index)
+{
+    BoundingBox box = boundingBox_.Transformed(worldTransforms_[index]);
+    Vector3 center = box.Center();
+    Vector3 halfSize = center - box.min_;
+    DrawableBoundsBlock& block = instanceBounds_[index >> 2u];
+    unsigned lane = index & 3u;
+
+    block.centerX_[lane] = center.x_;
+    block.centerY_[lane] = center.y_;
+    block.centerZ_[lane] = center.z_;
+    block.halfSizeX_[lane] = halfSize.x_;
+    block.halfSizeY_[lane] = halfSize.y_;
+    block.halfSizeZ_[lane] = halfSize.z_;
+
+    BoundingBox& chunkBox = chunkBoundingBoxes_[index / INSTANCE_CHUNK_SIZE];
+    if (index % INSTANCE_CHUNK_SIZE)
+        chunkBox.Merge(box);
+    else
+        chunkBox = box;
+
+    return box;
+}
+
+const PODVector<Matrix3x4>& StaticModelGroup::CullInstances(const FrameInfo& frame)
+{
+    // Each view of the frame gets its own list, as the batches of the views updated earlier still point to theirs
+    if (frame.frameNumber_ != cullFrameNumber_)
+    {
+        cullFrameNumber_ = frame.frameNumber_;
+        nextVisibleTransforms_ = visibleTransforms_.Begin();
+    }
+    if (nextVisibleTransforms_ == visibleTransforms_.End())
+    {
+        visibleTransforms_.Push(PODVector<Matrix3x4>());
+        nextVisibleTransforms_ = --visibleTransforms_.End();
+    }
+
+    PODVector<Matrix3x4>& visibleTransforms = *nextVisibleTransforms_++;
+    visibleTransforms.Clear();
+
+    const Frustum& frustum = frame.camera_->GetFrustum();
+    FrustumBoundsTest test(frustum);
+    OcclusionBuffer* buffer = occludee_ ? frame.occlusionBuffer_ : nullptr;
+    unsigned numChunks = (numWorldTransforms_ + INSTANCE_CHUNK_SIZE - 1) / INSTANCE_CHUNK_SIZE;
+
+    for (unsigned i = 0; i < numChunks; ++i)
+    {
+        // Test the chunks first, so that only the chunks intersecting the frustum need per-instance tests
+        const BoundingBox& chunkBox = chunkBoundingBoxes_[i];
+        Intersection chunkIntersection = frustum.IsInside(chunkBox);
+        if (chunkIntersection == OUTSIDE || (buffer && !buffer->IsVisible(chunkBox)))
+            continue;
+
+        unsigned start = i * INSTANCE_CHUNK_SIZE;
+        unsigned end = Min(start + INSTANCE_CHUNK_SIZE, numWorldTransforms_);
+
+        if (chunkIntersection == INSIDE)
+        {
+            visibleTransforms.Insert(visibleTransforms.End(), &worldTransforms_[start], &worldTransforms_[0] + end);
+            continue;
+        }
+
+        for (unsigned j = start; j < end; j += 4)
+        {
+            unsigned insideMask = test.Test(instanceBounds_[j >> 2u]);
+
+            // Mask out the unused lanes of the last block
+            if (end - j < 4)
+                insideMask &= (1u << (end - j)) - 1;
+
+            for (unsigned lane = 0; insideMask; ++lane, insideMask >>= 1u)
+            {
+                if (insideMask & 1u)
+                    visibleTransforms.Push(worldTransforms_[j + lane]);
+            }
+        }
+    }
+
+    return visibleTransforms;
+}
+
 }
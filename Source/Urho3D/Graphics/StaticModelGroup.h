@@ -22,6 +22,9 @@
 
 #pragma once
 
+#include "../Container/List.h"
+#include "../Core/Mutex.h"
+#include "../Graphics/OctreeQuery.h"
 #include "../Graphics/StaticModel.h"
 
 namespace Urho3D
@@ -51,6 +54,8 @@ public:
     unsigned GetNumOccluderTriangles() override;
     /// Draw to occlusion buffer. Return true if did not run out of triangles.
     bool DrawOcclusion(OcclusionBuffer* buffer) override;
+    /// Return draw call source data for shadow map rendering. Contains all instances also when the view batches are culled.
+    const Vector<SourceBatch>& GetShadowBatches() const override;
 
     /// Add an instance scene node. It does not need any drawable components of its own.
     void AddInstanceNode(Node* node);
@@ -58,6 +63,15 @@ public:
     void RemoveInstanceNode(Node* node);
     /// Remove all instance scene nodes.
     void RemoveAllInstanceNodes();
+    /// Add an instance without a scene node, with a transform relative to the group's scene node. Avoids the per-instance scene node overhead when there are very many instances.
+    void AddInstanceTransform(const Matrix3x4& transform);
+    /// Set all instances without a scene node, with transforms relative to the group's scene node.
+    void SetInstanceTransforms(const PODVector<Matrix3x4>& transforms);
+    /// Remove all instances without a scene node.
+    void RemoveAllInstanceTransforms();
+    /// Set whether to cull the instances individually for each view. Default true. Shadow maps always render all instances, as instances outside the view may still cast shadows into it.
+    /// @property
+    void SetInstanceCulling(bool enable);
 
     /// Return number of instance nodes.
     /// @property
@@ -67,11 +81,26 @@ public:
     /// @property{get_instanceNodes}
     Node* GetInstanceNode(unsigned index) const;
 
+    /// Return number of instances without a scene node.
+    /// @property
+    unsigned GetNumInstanceTransforms() const { return instanceTransforms_.Size(); }
+
+    /// Return transforms of the instances without a scene node.
+    const PODVector<Matrix3x4>& GetInstanceTransforms() const { return instanceTransforms_; }
+
+    /// Return whether the instances are culled individually.
+    /// @property
+    bool GetInstanceCulling() const { return instanceCulling_; }
+
     /// Set node IDs attribute.
     void SetNodeIDsAttr(const VariantVector& value);
+    /// Set instance transforms attribute.
+    void SetInstanceTransformsAttr(const PODVector<unsigned char>& value);
 
     /// Return node IDs attribute.
     const VariantVector& GetNodeIDsAttr() const;
+    /// Return instance transforms attribute.
+    PODVector<unsigned char> GetInstanceTransformsAttr() const;
 
 protected:
     /// Handle scene node enabled status changing.
@@ -82,13 +111,35 @@ protected:
 private:
     /// Ensure proper size of world transforms when nodes are added/removed. Also mark node IDs dirty.
     void UpdateNumTransforms();
+    /// Ensure proper size of world transforms and instance bounds for the instance nodes and transforms.
+    void ResizeWorldTransforms();
     /// Update node IDs attribute from the actual nodes.
     void UpdateNodeIDs() const;
+    /// Store the world bounding box of an instance for culling and return it.
+    BoundingBox UpdateInstanceBounds(unsigned index);
+    /// Cull the instances against the view frustum, and their chunks also against the occlusion buffer. Return the transforms of the visible instances.
+    const PODVector<Matrix3x4>& CullInstances(const FrameInfo& frame);
 
     /// Instance nodes.
     Vector<WeakPtr<Node> > instanceNodes_;
-    /// World transforms of valid (existing and visible) instances.
+    /// Transforms of instances without a scene node, relative to the group's scene node.
+    PODVector<Matrix3x4> instanceTransforms_;
+    /// World transforms of valid (existing and visible) instances. Instance nodes come first, followed by the instances without a scene node.
     PODVector<Matrix3x4> worldTransforms_;
+    /// World bounding boxes of valid instances in blocks of four.
+    PODVector<DrawableBoundsBlock> instanceBounds_;
+    /// World bounding boxes of consecutive chunks of valid instances.
+    Vector<BoundingBox> chunkBoundingBoxes_;
+    /// Visible instance transforms on the current frame, one list per view. Kept in a list so that the batches of the views updated earlier on the frame can still point to theirs.
+    List<PODVector<Matrix3x4> > visibleTransforms_;
+    /// Next visible transforms list to use on the current frame.
+    List<PODVector<Matrix3x4> >::Iterator nextVisibleTransforms_;
+    /// Source batches with all instances for shadow map rendering. Empty when the instances are not culled.
+    Vector<SourceBatch> shadowBatches_;
+    /// Batch update mutex. Shadow caster processing may update the batches from several worker threads at once.
+    Mutex batchMutex_;
+    /// Frame number of the last instance culling.
+    unsigned cullFrameNumber_{M_MAX_UNSIGNED};
     /// IDs of instance nodes for serialization.
     mutable VariantVector nodeIDsAttr_;
     /// Number of valid instance node transforms.
@@ -97,6 +148,8 @@ private:
     mutable bool nodesDirty_{};
     /// Whether nodes have been manipulated by the API and node ID attribute should be refreshed.
     mutable bool nodeIDsDirty_{};
+    /// Whether to cull the instances individually.
+    bool instanceCulling_{true};
 };
 
 }
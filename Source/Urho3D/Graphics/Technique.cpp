@@ -34,9 +34,14 @@
 
 #include "../DebugNew.h"
 
+#include <atomic>
+
 namespace Urho3D
 {
 
+/// Next pass shaders version. Passes may be created in background loading threads.
+static std::atomic<unsigned> nextShadersVersion(1);
+
 extern const char* cullModeNames[];
 
 const char* blendModeNames[] =
@@ -79,9 +84,12 @@ Pass::Pass(const String& name) :
     depthTestMode_(CMP_LESSEQUAL),
     lightingMode_(LIGHTING_UNLIT),
     shadersLoadedFrameNumber_(0),
+    shadersVersion_(nextShadersVersion++),
     alphaToCoverage_(false),
     depthWrite_(true),
-    isDesktop_(false)
+    isDesktop_(false),
+    clusteredLightingChecked_(false),
+    clusteredLightingSupport_(false)
 {
     name_ = name.ToLower();
     index_ = Technique::GetPassIndex(name_);
@@ -114,6 +122,7 @@ void Pass::SetDepthTestMode(CompareMode mode)
 void Pass::SetLightingMode(PassLightingMode mode)
 {
     lightingMode_ = mode;
+    ReleaseShaders();
 }
 
 void Pass::SetDepthWrite(bool enable)
@@ -174,6 +183,8 @@ void Pass::ReleaseShaders()
     pixelShaders_.Clear();
     extraVertexShaders_.Clear();
     extraPixelShaders_.Clear();
+    shadersVersion_ = nextShadersVersion++;
+    clusteredLightingChecked_ = false;
 }
 
 void Pass::MarkShadersLoaded(unsigned frameNumber)
@@ -181,6 +192,12 @@ void Pass::MarkShadersLoaded(unsigned frameNumber)
     shadersLoadedFrameNumber_ = frameNumber;
 }
 
+void Pass::MarkClusteredLightingSupport(bool support)
+{
+    clusteredLightingSupport_ = support;
+    clusteredLightingChecked_ = true;
+}
+
 String Pass::GetEffectiveVertexShaderDefines() const
 {
     // Prefer to return just the original defines if possible
@@ -92,6 +92,8 @@ public:
     void ReleaseShaders();
     /// Mark shaders loaded this frame.
     void MarkShadersLoaded(unsigned frameNumber);
+    /// Mark whether the pixel shader supports clustered forward lighting. Called internally by Renderer.
+    void MarkClusteredLightingSupport(bool support);
 
     /// Return pass name.
     const String& GetName() const { return name_; }
@@ -118,6 +120,15 @@ public:
     /// Return last shaders loaded frame number.
     unsigned GetShadersLoadedFrameNumber() const { return shadersLoadedFrameNumber_; }
 
+    /// Return shaders version. Changes whenever the shaders are released, and is unique among all passes.
+    unsigned GetShadersVersion() const { return shadersVersion_; }
+
+    /// Return whether clustered forward lighting support has been checked since the shaders were released.
+    bool IsClusteredLightingSupportChecked() const { return clusteredLightingChecked_; }
+
+    /// Return whether the pixel shader supports clustered forward lighting. Valid only after it has been checked.
+    bool GetClusteredLightingSupport() const { return clusteredLightingSupport_; }
+
     /// Return depth write mode.
     /// @property
     bool GetDepthWrite() const { return depthWrite_; }
@@ -182,12 +193,18 @@ private:
     PassLightingMode lightingMode_;
     /// Last shaders loaded frame number.
     unsigned shadersLoadedFrameNumber_;
+    /// Shaders version.
+    unsigned shadersVersion_;
     /// Depth write mode.
     bool depthWrite_;
     /// Alpha-to-coverage mode.
     bool alphaToCoverage_;
     /// Require desktop level hardware flag.
     bool isDesktop_;
+    /// Clustered forward lighting support checked flag.
+    bool clusteredLightingChecked_;
+    /// Clustered forward lighting support flag.
+    bool clusteredLightingSupport_;
     /// Vertex shader name.
     String vertexShaderName_;
     /// Pixel shader name.
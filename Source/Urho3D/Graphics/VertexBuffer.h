@@ -61,6 +61,8 @@ public:
     bool SetDataRange(const void* data, unsigned start, unsigned count, bool discard = false);
     /// Lock the buffer for write-only editing. Return data pointer if successful. Optionally discard data outside the range.
     void* Lock(unsigned start, unsigned count, bool discard = false);
+    /// Lock a range of a dynamic buffer for appending data. The range must not overlap data used by draw calls issued since the last discard, so that the GPU buffer does not need to be synchronized or renamed. Return data pointer if successful.
+    void* LockNoOverwrite(unsigned start, unsigned count);
     /// Unlock the buffer and apply changes to the GPU buffer.
     void Unlock();
 
@@ -147,7 +149,7 @@ private:
     /// Update the shadow data to the GPU buffer.
     bool UpdateToGPU();
     /// Map the GPU buffer into CPU memory. Not used on OpenGL.
-    void* MapBuffer(unsigned start, unsigned count, bool discard);
+    void* MapBuffer(unsigned start, unsigned count, bool discard, bool noOverwrite = false);
     /// Unmap the GPU buffer. Not used on OpenGL.
     void UnmapBuffer();
 
@@ -55,6 +55,31 @@
 namespace Urho3D
 {
 
+/// Minimum number of drawables per chunk when checking visibility in worker threads.
+static const unsigned VISIBILITY_CHUNK_SIZE = 16;
+/// Cluster grid width in screen tiles. The cluster grid and texture layout must match the shaders.
+static const int CLUSTER_GRID_X = 16;
+/// Cluster grid height in screen tiles.
+static const int CLUSTER_GRID_Y = 8;
+/// Cluster grid depth slices. Slices are distributed by the square root of linear depth.
+static const int CLUSTER_GRID_Z = 24;
+/// Texels per cluster. The first float is the light count, the rest are light indices.
+static const unsigned CLUSTER_TEXELS = 8;
+/// Maximum number of lights in one cluster.
+static const unsigned MAX_CLUSTER_LIGHTS = CLUSTER_TEXELS * 4 - 1;
+/// Maximum number of clustered lights in a view.
+static const unsigned MAX_CLUSTERED_LIGHTS = 256;
+/// Texels of light parameters per clustered light.
+static const unsigned CLUSTER_LIGHT_TEXELS = 4;
+/// Cluster texture width.
+static const unsigned CLUSTER_TEXTURE_WIDTH = 128;
+/// Cluster texture row where the light parameters begin.
+static const unsigned CLUSTER_LIGHT_ROW = CLUSTER_GRID_X * CLUSTER_GRID_Y * CLUSTER_GRID_Z * CLUSTER_TEXELS / CLUSTER_TEXTURE_WIDTH;
+/// Cluster texture height.
+static const unsigned CLUSTER_TEXTURE_HEIGHT = CLUSTER_LIGHT_ROW + MAX_CLUSTERED_LIGHTS * CLUSTER_LIGHT_TEXELS / CLUSTER_TEXTURE_WIDTH;
+/// Floats of cluster data per depth slice.
+static const unsigned CLUSTER_SLICE_FLOATS = CLUSTER_GRID_X * CLUSTER_GRID_Y * CLUSTER_TEXELS * 4;
+
 /// %Frustum octree query for shadowcasters.
 class ShadowCasterOctreeQuery : public FrustumOctreeQuery
 {
@@ -226,6 +251,47 @@ void CheckVisibilityWork(const WorkItem* item, unsigned threadIndex)
     }
 }
 
+void BuildClusterSlicesWork(const WorkItem* item, unsigned threadIndex)
+{
+    auto* view = reinterpret_cast<View*>(item->aux_);
+    auto* start = reinterpret_cast<float*>(item->start_);
+    auto* end = reinterpret_cast<float*>(item->end_);
+    const PODVector<ClusterLightRange>& ranges = view->clusterLightRanges_;
+    auto z = (int)((start - view->clusterData_.Buffer()) / CLUSTER_SLICE_FLOATS);
+
+    for (float* slice = start; slice < end; slice += CLUSTER_SLICE_FLOATS, ++z)
+    {
+        unsigned& numDropped = view->clusterSliceDroppedLights_[z];
+        numDropped = 0;
+        for (float* cluster = slice; cluster < slice + CLUSTER_SLICE_FLOATS; cluster += CLUSTER_TEXELS * 4)
+            cluster[0] = 0.0f;
+
+        for (unsigned i = 0; i < ranges.Size(); ++i)
+        {
+            const ClusterLightRange& range = ranges[i];
+            if (z < range.min_.z_ || z > range.max_.z_)
+                continue;
+
+            for (int y = range.min_.y_; y <= range.max_.y_; ++y)
+            {
+                for (int x = range.min_.x_; x <= range.max_.x_; ++x)
+                {
+                    float* cluster = slice + (y * CLUSTER_GRID_X + x) * CLUSTER_TEXELS * 4;
+                    auto numLights = (unsigned)cluster[0];
+                    // If the cluster is full, further lights are dropped
+                    if (numLights < MAX_CLUSTER_LIGHTS)
+                    {
+                        cluster[numLights + 1] = (float)i;
+                        cluster[0] = (float)(numLights + 1);
+                    }
+                    else
+                        ++numDropped;
+                }
+            }
+        }
+    }
+}
+
 void ProcessLightWork(const WorkItem* item, unsigned threadIndex)
 {
     auto* view = reinterpret_cast<View*>(item->aux_);
@@ -252,29 +318,35 @@ void UpdateDrawableGeometriesWork(const WorkItem* item, unsigned threadIndex)
 void SortBatchQueueFrontToBackWork(const WorkItem* item, unsigned threadIndex)
 {
     auto* queue = reinterpret_cast<BatchQueue*>(item->start_);
+    FrameAllocator& allocator = reinterpret_cast<WorkQueue*>(item->aux_)->GetFrameAllocator(threadIndex);
 
-    queue->SortFrontToBack();
+    queue->SortFrontToBack(&allocator);
 }
 
 void SortBatchQueueBackToFrontWork(const WorkItem* item, unsigned threadIndex)
 {
     auto* queue = reinterpret_cast<BatchQueue*>(item->start_);
+    FrameAllocator& allocator = reinterpret_cast<WorkQueue*>(item->aux_)->GetFrameAllocator(threadIndex);
 
-    queue->SortBackToFront();
+    queue->SortBackToFront(&allocator);
 }
 
 void SortLightQueueWork(const WorkItem* item, unsigned threadIndex)
 {
     auto* start = reinterpret_cast<LightBatchQueue*>(item->start_);
-    start->litBaseBatches_.SortFrontToBack();
-    start->litBatches_.SortFrontToBack();
+    FrameAllocator& allocator = reinterpret_cast<WorkQueue*>(item->aux_)->GetFrameAllocator(threadIndex);
+
+    start->litBaseBatches_.SortFrontToBack(&allocator);
+    start->litBatches_.SortFrontToBack(&allocator);
 }
 
 void SortShadowQueueWork(const WorkItem* item, unsigned threadIndex)
 {
     auto* start = reinterpret_cast<LightBatchQueue*>(item->start_);
+    FrameAllocator& allocator = reinterpret_cast<WorkQueue*>(item->aux_)->GetFrameAllocator(threadIndex);
+
     for (unsigned i = 0; i < start->shadowSplits_.Size(); ++i)
-        start->shadowSplits_[i].shadowBatches_.SortFrontToBack();
+        start->shadowSplits_[i].shadowBatches_.SortFrontToBack(&allocator);
 }
 
 StringHash ParseTextureTypeXml(ResourceCache* cache, const String& filename);
@@ -293,6 +365,8 @@ View::View(Context* context) :
 bool View::Define(RenderSurface* renderTarget, Viewport* viewport)
 {
     sourceView_ = nullptr;
+    hasPreCulledZonesOccluders_ = false;
+    hasPreCulledDrawables_ = false;
     renderPath_ = viewport->GetRenderPath();
     if (!renderPath_)
         return false;
@@ -344,6 +418,7 @@ bool View::Define(RenderSurface* renderTarget, Viewport* viewport)
             useLitBase_ = sourceView_->useLitBase_;
             hasScenePasses_ = sourceView_->hasScenePasses_;
             noStencil_ = sourceView_->noStencil_;
+            clusteredLighting_ = sourceView_->clusteredLighting_;
             lightVolumeCommand_ = sourceView_->lightVolumeCommand_;
             forwardLightsCommand_ = sourceView_->forwardLightsCommand_;
             octree_ = sourceView_->octree_;
@@ -397,6 +472,22 @@ bool View::Define(RenderSurface* renderTarget, Viewport* viewport)
 #endif
 #endif
 
+    // Clustered lighting reads the light lists with integer texel fetches, which need OpenGL 3 or Direct3D 11.
+    // It is not used if the renderpath draws light volumes, as those already shade any number of lights per pixel
+#if defined(URHO3D_D3D11)
+    clusteredLighting_ = renderer_->GetClusteredLighting();
+#elif defined(URHO3D_OPENGL) && !defined(GL_ES_VERSION_2_0)
+    clusteredLighting_ = renderer_->GetClusteredLighting() && Graphics::GetGL3Support();
+#else
+    clusteredLighting_ = false;
+#endif
+    for (unsigned i = 0; i < renderPath_->commands_.Size() && clusteredLighting_; ++i)
+    {
+        const RenderPathCommand& command = renderPath_->commands_[i];
+        if (command.enabled_ && command.type_ == CMD_LIGHTVOLUMES)
+            clusteredLighting_ = false;
+    }
+
     // Make sure that all necessary batch queues exist
     for (unsigned i = 0; i < renderPath_->commands_.Size(); ++i)
     {
@@ -435,7 +526,8 @@ bool View::Define(RenderSurface* renderTarget, Viewport* viewport)
             if (j == batchQueues_.End())
                 j = batchQueues_.Insert(Pair<unsigned, BatchQueue>(info.passIndex_, BatchQueue()));
             info.batchQueue_ = &j->second_;
-            SetQueueShaderDefines(*info.batchQueue_, command);
+            SetQueueShaderDefines(*info.batchQueue_, &command, clusteredLighting_ &&
+                (info.passIndex_ == basePassIndex_ || info.passIndex_ == alphaPassIndex_));
 
             scenePasses_.Push(info);
         }
@@ -540,8 +632,12 @@ void View::Update(const FrameInfo& frame)
     occluders_.Clear();
     activeOccluders_ = 0;
     vertexLightQueues_.Clear();
+    bool retainBatchGroups = renderer_->GetRetainedBatchQueues();
     for (HashMap<unsigned, BatchQueue>::Iterator i = batchQueues_.Begin(); i != batchQueues_.End(); ++i)
+    {
+        i->second_.retainBatchGroups_ = retainBatchGroups;
         i->second_.Clear(maxSortedInstances);
+    }
 
     if (hasScenePasses_ && (!cullCamera_ || !octree_))
     {
@@ -560,6 +656,42 @@ void View::Update(const FrameInfo& frame)
     SendViewEvent(E_ENDVIEWUPDATE);
 }
 
+bool View::BeginPreCull()
+{
+    hasPreCulledZonesOccluders_ = false;
+    hasPreCulledDrawables_ = false;
+
+    if (sourceView_ || !octree_ || !cullCamera_)
+        return false;
+
+    // Apply the automatic aspect ratio now like Update() does, so that the frustum stays the same
+    if (cullCamera_->GetAutoAspectRatio())
+        cullCamera_->SetAspectRatioInternal((float)viewSize_.x_ / (float)viewSize_.y_);
+
+    // Copy the frustum here, as the camera calculates it on demand
+    preCullFrustum_ = cullCamera_->GetFrustum();
+    preCullViewMask_ = cullCamera_->GetViewMask();
+    return true;
+}
+
+void View::PreCull()
+{
+    {
+        ZoneOccluderOctreeQuery
+            query(preCulledZonesOccluders_, preCullFrustum_, DRAWABLE_GEOMETRY | DRAWABLE_ZONE, preCullViewMask_);
+        octree_->GetDrawables(query);
+        hasPreCulledZonesOccluders_ = true;
+    }
+
+    // With occlusion, the geometry query has to wait for the occluders to be rendered during update
+    if (maxOccluderTriangles_ <= 0)
+    {
+        FrustumOctreeQuery query(preCulledDrawables_, preCullFrustum_, DRAWABLE_GEOMETRY | DRAWABLE_LIGHT, preCullViewMask_);
+        octree_->GetDrawables(query);
+        hasPreCulledDrawables_ = true;
+    }
+}
+
 void View::Render()
 {
     SendViewEvent(E_BEGINVIEWRENDER);
@@ -610,6 +742,10 @@ void View::Render()
     }
 #endif
 
+    // Assign the clustered lights now that the render camera's projection is final
+    if (clusteredLighting_ && camera_)
+        BuildClusters();
+
     // Render
     ExecuteRenderPathCommands();
 
@@ -799,7 +935,27 @@ void View::GetDrawables()
     auto* queue = GetSubsystem<WorkQueue>();
     PODVector<Drawable*>& tempDrawables = tempDrawables_[0];
 
+    // Use the results queried ahead of update, unless the camera was changed since
+    bool usePreCulled = false;
+    if (hasPreCulledZonesOccluders_ && cullCamera_->GetViewMask() == preCullViewMask_)
+    {
+        const Frustum& frustum = cullCamera_->GetFrustum();
+        usePreCulled = true;
+        for (unsigned i = 0; i < NUM_FRUSTUM_VERTICES; ++i)
+        {
+            if (frustum.vertices_[i] != preCullFrustum_.vertices_[i])
+            {
+                usePreCulled = false;
+                break;
+            }
+        }
+    }
+    hasPreCulledZonesOccluders_ = false;
+
     // Get zones and occluders first
+    if (usePreCulled)
+        tempDrawables.Swap(preCulledZonesOccluders_);
+    else
     {
         ZoneOccluderOctreeQuery
             query(tempDrawables, cullCamera_->GetFrustum(), DRAWABLE_GEOMETRY | DRAWABLE_ZONE, cullCamera_->GetViewMask());
@@ -855,6 +1011,7 @@ void View::GetDrawables()
 
     // If occlusion in use, get & render the occluders
     occlusionBuffer_ = nullptr;
+    frame_.occlusionBuffer_ = nullptr;
     if (maxOccluderTriangles_ > 0)
     {
         UpdateOccluders(occluders_, cullCamera_);
@@ -868,6 +1025,7 @@ void View::GetDrawables()
     }
     else
         occluders_.Clear();
+    frame_.occlusionBuffer_ = occlusionBuffer_;
 
     // Get lights and geometries. Coarse occlusion for octants is used at this point
     if (occlusionBuffer_)
@@ -876,11 +1034,14 @@ void View::GetDrawables()
             (tempDrawables, cullCamera_->GetFrustum(), occlusionBuffer_, DRAWABLE_GEOMETRY | DRAWABLE_LIGHT, cullCamera_->GetViewMask());
         octree_->GetDrawables(query);
     }
+    else if (usePreCulled && hasPreCulledDrawables_)
+        tempDrawables.Swap(preCulledDrawables_);
     else
     {
         FrustumOctreeQuery query(tempDrawables, cullCamera_->GetFrustum(), DRAWABLE_GEOMETRY | DRAWABLE_LIGHT, cullCamera_->GetViewMask());
         octree_->GetDrawables(query);
     }
+    hasPreCulledDrawables_ = false;
 
     // Check drawable occlusion, find zones for moved drawables and collect geometries & lights in worker threads
     {
@@ -894,30 +1055,8 @@ void View::GetDrawables()
             result.maxZ_ = 0.0f;
         }
 
-        int numWorkItems = queue->GetNumThreads() + 1; // Worker threads + main thread
-        int drawablesPerItem = tempDrawables.Size() / numWorkItems;
-
-        PODVector<Drawable*>::Iterator start = tempDrawables.Begin();
-        // Create a work item for each thread
-        for (int i = 0; i < numWorkItems; ++i)
-        {
-            SharedPtr<WorkItem> item = queue->GetFreeItem();
-            item->priority_ = M_MAX_UNSIGNED;
-            item->workFunction_ = CheckVisibilityWork;
-            item->aux_ = this;
-
-            PODVector<Drawable*>::Iterator end = tempDrawables.End();
-            if (i < numWorkItems - 1 && end - start > drawablesPerItem)
-                end = start + drawablesPerItem;
-
-            item->start_ = &(*start);
-            item->end_ = &(*end);
-            queue->AddWorkItem(item);
-
-            start = end;
-        }
-
-        queue->Complete(M_MAX_UNSIGNED);
+        queue->ParallelFor(CheckVisibilityWork, tempDrawables.Buffer(), tempDrawables.Buffer() + tempDrawables.Size(), this,
+            VISIBILITY_CHUNK_SIZE);
     }
 
     // Combine lights, geometries & scene Z range from the threads
@@ -981,10 +1120,11 @@ void View::ProcessLights()
 
     auto* queue = GetSubsystem<WorkQueue>();
     lightQueryResults_.Resize(lights_.Size());
+    workItems_.Clear();
 
     for (unsigned i = 0; i < lightQueryResults_.Size(); ++i)
     {
-        SharedPtr<WorkItem> item = queue->GetFreeItem();
+        WorkItem* item = queue->AllocateItem();
         item->priority_ = M_MAX_UNSIGNED;
         item->workFunction_ = ProcessLightWork;
         item->aux_ = this;
@@ -994,10 +1134,11 @@ void View::ProcessLights()
 
         item->start_ = &query;
         queue->AddWorkItem(item);
+        workItems_.Push(item);
     }
 
     // Ensure all lights have been processed before proceeding
-    queue->Complete(M_MAX_UNSIGNED);
+    queue->Complete(workItems_);
 }
 
 void View::GetLightBatches()
@@ -1008,6 +1149,53 @@ void View::GetLightBatches()
     {
         URHO3D_PROFILE(GetLightBatches);
 
+        // Move unshadowed point and spot lights to the cluster grid. Lights using custom ramp or shape textures still get
+        // their own light queue, as the clustered shading approximates the default textures
+        clusteredLights_.Clear();
+        if (clusteredLighting_)
+        {
+            // The cluster grid cannot apply light masks, so a light is clustered only if no visible geometry excludes it
+            // through its own or its zone's light mask
+            unsigned excludedLightMask = 0;
+            nonClusteredGeometries_.Clear();
+            for (PODVector<Drawable*>::ConstIterator i = geometries_.Begin(); i != geometries_.End(); ++i)
+            {
+                excludedLightMask |= ~GetLightMask(*i);
+                if (!CheckClusteredLightingSupport(*i))
+                    nonClusteredGeometries_.Insert(*i);
+            }
+
+            for (Vector<LightQueryResult>::Iterator i = lightQueryResults_.Begin(); i != lightQueryResults_.End(); ++i)
+            {
+                Light* light = i->light_;
+                if (clusteredLights_.Size() >= MAX_CLUSTERED_LIGHTS)
+                    break;
+                if (i->litGeometries_.Empty() || light->GetPerVertex() || light->GetLightType() == LIGHT_DIRECTIONAL ||
+                    light->IsNegative() || i->numSplits_ || light->GetRampTexture() || light->GetShapeTexture() ||
+                    (light->GetLightMask() & excludedLightMask))
+                    continue;
+
+                // Keep the light queue if any lit geometry would not shade the light in its base or alpha pass
+                bool supported = true;
+                if (!nonClusteredGeometries_.Empty())
+                {
+                    for (PODVector<Drawable*>::ConstIterator j = i->litGeometries_.Begin(); j != i->litGeometries_.End(); ++j)
+                    {
+                        if (nonClusteredGeometries_.Contains(*j))
+                        {
+                            supported = false;
+                            break;
+                        }
+                    }
+                }
+                if (!supported)
+                    continue;
+
+                clusteredLights_.Push(light);
+                i->litGeometries_.Clear();
+            }
+        }
+
         // Preallocate light queues: per-pixel lights which have lit geometries
         unsigned numLightQueues = 0;
         unsigned usedLightQueues = 0;
@@ -1039,21 +1227,15 @@ void View::GetLightBatches()
                 // Initialize light queue and store it to the light so that it can be found later
                 LightBatchQueue& lightQueue = lightQueues_[usedLightQueues++];
                 light->SetLightQueue(&lightQueue);
+                lightQueue.sortID_ = usedLightQueues;
                 lightQueue.light_ = light;
                 lightQueue.negative_ = light->IsNegative();
                 lightQueue.shadowMap_ = nullptr;
                 lightQueue.litBaseBatches_.Clear(maxSortedInstances);
                 lightQueue.litBatches_.Clear(maxSortedInstances);
-                if (forwardLightsCommand_)
-                {
-                    SetQueueShaderDefines(lightQueue.litBaseBatches_, *forwardLightsCommand_);
-                    SetQueueShaderDefines(lightQueue.litBatches_, *forwardLightsCommand_);
-                }
-                else
-                {
-                    lightQueue.litBaseBatches_.hasExtraDefines_ = false;
-                    lightQueue.litBatches_.hasExtraDefines_ = false;
-                }
+                // The litbase pass replaces the base pass, so it also shades the clustered lights
+                SetQueueShaderDefines(lightQueue.litBaseBatches_, forwardLightsCommand_, clusteredLighting_);
+                SetQueueShaderDefines(lightQueue.litBatches_, forwardLightsCommand_);
                 lightQueue.volumeBatches_.Clear();
 
                 // Allocate shadow map now
@@ -1096,7 +1278,7 @@ void View::GetLightBatches()
                                 threadedGeometries_.Push(drawable);
                         }
 
-                        const Vector<SourceBatch>& batches = drawable->GetBatches();
+                        const Vector<SourceBatch>& batches = drawable->GetShadowBatches();
 
                         for (unsigned l = 0; l < batches.Size(); ++l)
                         {
@@ -1256,6 +1438,7 @@ void View::GetBaseBatches()
                         if (i == vertexLightQueues_.End())
                         {
                             i = vertexLightQueues_.Insert(MakePair(hash, LightBatchQueue()));
+                            i->second_.sortID_ = lightQueues_.Size() + vertexLightQueues_.Size();
                             i->second_.light_ = nullptr;
                             i->second_.shadowMap_ = nullptr;
                             i->second_.vertexLights_ = drawableVertexLights;
@@ -1289,6 +1472,7 @@ void View::UpdateGeometries()
     URHO3D_PROFILE(SortAndUpdateGeometry);
 
     auto* queue = GetSubsystem<WorkQueue>();
+    workItems_.Clear();
 
     // Sort batches
     {
@@ -1300,30 +1484,36 @@ void View::UpdateGeometries()
 
             if (command.type_ == CMD_SCENEPASS)
             {
-                SharedPtr<WorkItem> item = queue->GetFreeItem();
+                WorkItem* item = queue->AllocateItem();
                 item->priority_ = M_MAX_UNSIGNED;
                 item->workFunction_ =
                     command.sortMode_ == SORT_FRONTTOBACK ? SortBatchQueueFrontToBackWork : SortBatchQueueBackToFrontWork;
                 item->start_ = &batchQueues_[command.passIndex_];
+                item->aux_ = queue;
                 queue->AddWorkItem(item);
+                workItems_.Push(item);
             }
         }
 
         for (Vector<LightBatchQueue>::Iterator i = lightQueues_.Begin(); i != lightQueues_.End(); ++i)
         {
-            SharedPtr<WorkItem> lightItem = queue->GetFreeItem();
+            WorkItem* lightItem = queue->AllocateItem();
             lightItem->priority_ = M_MAX_UNSIGNED;
             lightItem->workFunction_ = SortLightQueueWork;
             lightItem->start_ = &(*i);
+            lightItem->aux_ = queue;
             queue->AddWorkItem(lightItem);
+            workItems_.Push(lightItem);
 
             if (i->shadowSplits_.Size())
             {
-                SharedPtr<WorkItem> shadowItem = queue->GetFreeItem();
+                WorkItem* shadowItem = queue->AllocateItem();
                 shadowItem->priority_ = M_MAX_UNSIGNED;
                 shadowItem->workFunction_ = SortShadowQueueWork;
                 shadowItem->start_ = &(*i);
+                shadowItem->aux_ = queue;
                 queue->AddWorkItem(shadowItem);
+                workItems_.Push(shadowItem);
             }
         }
     }
@@ -1344,26 +1534,8 @@ void View::UpdateGeometries()
                 }
             }
 
-            int numWorkItems = queue->GetNumThreads() + 1; // Worker threads + main thread
-            int drawablesPerItem = threadedGeometries_.Size() / numWorkItems;
-
-            PODVector<Drawable*>::Iterator start = threadedGeometries_.Begin();
-            for (int i = 0; i < numWorkItems; ++i)
-            {
-                PODVector<Drawable*>::Iterator end = threadedGeometries_.End();
-                if (i < numWorkItems - 1 && end - start > drawablesPerItem)
-                    end = start + drawablesPerItem;
-
-                SharedPtr<WorkItem> item = queue->GetFreeItem();
-                item->priority_ = M_MAX_UNSIGNED;
-                item->workFunction_ = UpdateDrawableGeometriesWork;
-                item->aux_ = const_cast<FrameInfo*>(&frame_);
-                item->start_ = &(*start);
-                item->end_ = &(*end);
-                queue->AddWorkItem(item);
-
-                start = end;
-            }
+            queue->AddParallelWorkItems(UpdateDrawableGeometriesWork, threadedGeometries_.Buffer(),
+                threadedGeometries_.Buffer() + threadedGeometries_.Size(), const_cast<FrameInfo*>(&frame_), M_MAX_UNSIGNED, &workItems_);
         }
 
         // While the work queue is processed, update non-threaded geometries
@@ -1372,7 +1544,7 @@ void View::UpdateGeometries()
     }
 
     // Finally ensure all threaded work has completed
-    queue->Complete(M_MAX_UNSIGNED);
+    queue->Complete(workItems_);
     geometriesUpdated_ = true;
 }
 
@@ -2231,7 +2403,13 @@ void View::UpdateOccluders(PODVector<Drawable*>& occluders, Camera* camera)
 void View::DrawOccluders(OcclusionBuffer* buffer, const PODVector<Drawable*>& occluders)
 {
     buffer->SetMaxTriangles((unsigned)maxOccluderTriangles_);
-    buffer->Clear();
+
+    // With temporal occlusion, keep the occluders drawn on previous frames and draw only the new ones
+    bool temporal = renderer_->GetTemporalOcclusion();
+    if (temporal)
+        buffer->Reuse();
+    else
+        buffer->Clear();
 
     if (!buffer->IsThreaded())
     {
@@ -2239,6 +2417,11 @@ void View::DrawOccluders(OcclusionBuffer* buffer, const PODVector<Drawable*>& oc
         for (unsigned i = 0; i < occluders.Size(); ++i)
         {
             Drawable* occluder = occluders[i];
+            if (temporal && buffer->HasDrawnOccluder(occluder))
+            {
+                ++activeOccluders_;
+                continue;
+            }
             if (i > 0)
             {
                 // For subsequent occluders, do a test against the pixel-level occlusion buffer to see if rendering is necessary
@@ -2253,6 +2436,9 @@ void View::DrawOccluders(OcclusionBuffer* buffer, const PODVector<Drawable*>& oc
             buffer->DrawTriangles();
             if (!success)
                 break;
+            // Remember only occluders that were drawn completely, so that a partially drawn one is retried next frame
+            if (temporal)
+                buffer->AddDrawnOccluder(occluder);
         }
     }
     else
@@ -2260,10 +2446,17 @@ void View::DrawOccluders(OcclusionBuffer* buffer, const PODVector<Drawable*>& oc
         // In threaded mode submit all triangles first, then render (cannot test in this case)
         for (unsigned i = 0; i < occluders.Size(); ++i)
         {
-            // Check for running out of triangles
+            Drawable* occluder = occluders[i];
             ++activeOccluders_;
-            if (!occluders[i]->DrawOcclusion(buffer))
+            if (temporal && buffer->HasDrawnOccluder(occluder))
+                continue;
+
+            // Check for running out of triangles
+            bool success = occluder->DrawOcclusion(buffer);
+            if (!success)
                 break;
+            if (temporal)
+                buffer->AddDrawnOccluder(occluder);
         }
 
         buffer->DrawTriangles();
@@ -2878,10 +3071,63 @@ void View::CheckMaterialForAuxView(Material* material)
     material->MarkForAuxView(frame_.frameNumber_);
 }
 
-void View::SetQueueShaderDefines(BatchQueue& queue, const RenderPathCommand& command)
+bool View::CheckClusteredLightingSupport(Drawable* drawable)
 {
-    String vsDefines = command.vertexShaderDefines_.Trimmed();
-    String psDefines = command.pixelShaderDefines_.Trimmed();
+    const Vector<SourceBatch>& batches = drawable->GetBatches();
+
+    for (unsigned i = 0; i < batches.Size(); ++i)
+    {
+        const SourceBatch& srcBatch = batches[i];
+
+        Technique* tech = GetTechnique(drawable, srcBatch.material_);
+        if (!srcBatch.geometry_ || !srcBatch.numWorldTransforms_ || !tech)
+            continue;
+        if (gBufferPassIndex_ != M_MAX_UNSIGNED && tech->HasPass(gBufferPassIndex_))
+            continue;
+
+        // Clustered lights are shaded in the base or litbase pass of opaque materials, and in the alpha pass of transparent
+        // materials, instead of the per-pixel light passes. Materials that do not receive per-pixel light are not affected
+        if (tech->GetSupportedPass(lightPassIndex_) || tech->GetSupportedPass(litBasePassIndex_))
+        {
+            Pass* basePass = tech->GetSupportedPass(basePassIndex_);
+            Pass* litBasePass = tech->GetSupportedPass(litBasePassIndex_);
+            if (!basePass || !renderer_->CheckClusteredLightingSupport(basePass) ||
+                (litBasePass && !renderer_->CheckClusteredLightingSupport(litBasePass)))
+                return false;
+        }
+        else if (tech->GetSupportedPass(litAlphaPassIndex_))
+        {
+            Pass* alphaPass = tech->GetSupportedPass(alphaPassIndex_);
+            if (!alphaPass || !renderer_->CheckClusteredLightingSupport(alphaPass))
+                return false;
+        }
+    }
+
+    return true;
+}
+
+void View::SetQueueShaderDefines(BatchQueue& queue, const RenderPathCommand* command, bool clustered)
+{
+    String vsDefines = command ? command->vertexShaderDefines_.Trimmed() : String::EMPTY;
+    String psDefines = command ? command->pixelShaderDefines_.Trimmed() : String::EMPTY;
+    if (clustered)
+    {
+        vsDefines = (vsDefines + " CLUSTERED").Trimmed();
+        psDefines = (psDefines + " CLUSTERED").Trimmed();
+        // SPECULAR is only defined for per-pixel light passes, so the clustered lights have their own specular define
+        if (renderer_->GetSpecularLighting())
+            psDefines += " CLUSTERSPECULAR";
+    }
+
+    // Retained batch groups have their shaders chosen with the old defines
+    if (queue.hasExtraDefines_ != (vsDefines.Length() || psDefines.Length()) ||
+        (queue.hasExtraDefines_ && (queue.vsExtraDefines_ != vsDefines || queue.psExtraDefines_ != psDefines)))
+    {
+        queue.batchGroups_.Clear();
+        queue.sortedBatchGroups_.Clear();
+        queue.numUsedBatchGroups_ = 0;
+    }
+
     if (vsDefines.Length() || psDefines.Length())
     {
         queue.hasExtraDefines_ = true;
@@ -2914,9 +3160,21 @@ void View::AddBatchToQueue(BatchQueue& queue, Batch& batch, Technique* tech, boo
             // In case the group remains below the instancing limit, do not enable instancing shaders yet
             BatchGroup newGroup(batch);
             newGroup.geometryType_ = GEOM_STATIC;
-            renderer_->SetBatchShaders(newGroup, tech, allowShadows, queue);
+            SetBatchGroupShaders(newGroup, tech, allowShadows, queue);
             newGroup.CalculateSortKey();
             i = queue.batchGroups_.Insert(MakePair(key, newGroup));
+            ++queue.numUsedBatchGroups_;
+        }
+        else if (i->second_.instances_.Empty())
+        {
+            // Reuse a group retained from an earlier frame, refreshing its state from the batch
+            BatchGroup& group = i->second_;
+            static_cast<Batch&>(group) = batch;
+            group.geometryType_ = GEOM_STATIC;
+            group.startIndex_ = M_MAX_UNSIGNED;
+            SetBatchGroupShaders(group, tech, allowShadows, queue);
+            group.CalculateSortKey();
+            ++queue.numUsedBatchGroups_;
         }
 
         int oldSize = i->second_.instances_.Size();
@@ -2925,7 +3183,7 @@ void View::AddBatchToQueue(BatchQueue& queue, Batch& batch, Technique* tech, boo
         if (oldSize < minInstances_ && (int)i->second_.instances_.Size() >= minInstances_)
         {
             i->second_.geometryType_ = GEOM_INSTANCED;
-            renderer_->SetBatchShaders(i->second_, tech, allowShadows, queue);
+            SetBatchGroupShaders(i->second_, tech, allowShadows, queue);
             i->second_.CalculateSortKey();
         }
     }
@@ -2951,6 +3209,50 @@ void View::AddBatchToQueue(BatchQueue& queue, Batch& batch, Technique* tech, boo
     }
 }
 
+void View::SetBatchGroupShaders(BatchGroup& group, Technique* tech, bool allowShadows, const BatchQueue& queue)
+{
+    // Groups with a light queue can not retain shaders, as the light queues are rebuilt each frame
+    if (!queue.retainBatchGroups_ || group.lightQueue_)
+    {
+        renderer_->SetBatchShaders(group, tech, allowShadows, queue);
+        return;
+    }
+
+    // Without a light queue, the shaders only depend on the pass, the geometry type and the zone's height fog
+    Pass* pass = group.pass_;
+    GeometryType geometryType = group.geometryType_;
+    bool heightFog = group.zone_ && group.zone_->GetHeightFog();
+    unsigned index = geometryType == GEOM_INSTANCED ? 1 : 0;
+
+    if (group.retainedVertexShaders_[index] && group.retainedShadersVersion_ == pass->GetShadersVersion() &&
+        group.retainedHeightFog_ == heightFog && pass->GetShadersLoadedFrameNumber() == renderer_->GetShadersChangedFrameNumber() &&
+        (geometryType != GEOM_INSTANCED || renderer_->GetDynamicInstancing()))
+    {
+        group.vertexShader_ = group.retainedVertexShaders_[index];
+        group.pixelShader_ = group.retainedPixelShaders_[index];
+        return;
+    }
+
+    // Note that choosing the shaders may release and reload the pass shaders, changing their version
+    bool ownShaders = renderer_->SetBatchShaders(group, tech, allowShadows, queue);
+
+    if (group.retainedShadersVersion_ != pass->GetShadersVersion() || group.retainedHeightFog_ != heightFog)
+    {
+        group.retainedVertexShaders_[0] = group.retainedVertexShaders_[1] = nullptr;
+        group.retainedPixelShaders_[0] = group.retainedPixelShaders_[1] = nullptr;
+        group.retainedShadersVersion_ = pass->GetShadersVersion();
+        group.retainedHeightFog_ = heightFog;
+    }
+
+    // Do not retain if the geometry type had to be changed, for example due to instancing being unavailable, or if fallback
+    // shaders are in use while the group's own shaders are compiling
+    if (ownShaders && group.geometryType_ == geometryType && group.vertexShader_ && group.pixelShader_)
+    {
+        group.retainedVertexShaders_[index] = group.vertexShader_;
+        group.retainedPixelShaders_[index] = group.pixelShader_;
+    }
+}
+
 void View::PrepareInstancingBuffer()
 {
     // Prepare instancing buffer from the source view
@@ -2976,28 +3278,141 @@ void View::PrepareInstancingBuffer()
         totalInstances += i->litBatches_.GetNumInstances();
     }
 
-    if (!totalInstances || !renderer_->ResizeInstancingBuffer(totalInstances))
+    if (!totalInstances)
         return;
 
-    VertexBuffer* instancingBuffer = renderer_->GetInstancingBuffer();
-    unsigned freeIndex = 0;
-    void* dest = instancingBuffer->Lock(0, totalInstances, true);
+    // Allocate from the shared instancing buffer after the data of previously rendered views, so that the buffer does
+    // not need to be discarded for each view
+    unsigned lockStart;
+    void* dest = renderer_->LockInstancingBuffer(totalInstances, lockStart);
     if (!dest)
         return;
 
-    const unsigned stride = instancingBuffer->GetVertexSize();
+    unsigned freeIndex = lockStart;
+    const unsigned stride = renderer_->GetInstancingBuffer()->GetVertexSize();
     for (HashMap<unsigned, BatchQueue>::Iterator i = batchQueues_.Begin(); i != batchQueues_.End(); ++i)
-        i->second_.SetInstancingData(dest, stride, freeIndex);
+        i->second_.SetInstancingData(dest, lockStart, stride, freeIndex);
 
     for (Vector<LightBatchQueue>::Iterator i = lightQueues_.Begin(); i != lightQueues_.End(); ++i)
     {
         for (unsigned j = 0; j < i->shadowSplits_.Size(); ++j)
-            i->shadowSplits_[j].shadowBatches_.SetInstancingData(dest, stride, freeIndex);
-        i->litBaseBatches_.SetInstancingData(dest, stride, freeIndex);
-        i->litBatches_.SetInstancingData(dest, stride, freeIndex);
+            i->shadowSplits_[j].shadowBatches_.SetInstancingData(dest, lockStart, stride, freeIndex);
+        i->litBaseBatches_.SetInstancingData(dest, lockStart, stride, freeIndex);
+        i->litBatches_.SetInstancingData(dest, lockStart, stride, freeIndex);
+    }
+
+    renderer_->UnlockInstancingBuffer();
+}
+
+void View::BuildClusters()
+{
+    URHO3D_PROFILE(BuildClusters);
+
+    View* actualView = sourceView_ ? sourceView_ : this;
+    const PODVector<Light*>& lights = actualView->clusteredLights_;
+
+    if (!clusterTexture_)
+    {
+        clusterTexture_ = new Texture2D(context_);
+        clusterTexture_->SetNumLevels(1);
+        clusterTexture_->SetFilterMode(FILTER_NEAREST);
+        clusterTexture_->SetSize(CLUSTER_TEXTURE_WIDTH, CLUSTER_TEXTURE_HEIGHT, Graphics::GetRGBAFloat32Format());
+        clusterData_.Resize(CLUSTER_TEXTURE_WIDTH * CLUSTER_TEXTURE_HEIGHT * 4);
+        clusterSliceDroppedLights_.Resize(CLUSTER_GRID_Z);
+    }
+
+    const Matrix3x4& view = camera_->GetView();
+    Matrix4 projection = camera_->GetProjection();
+    float nearClip = camera_->GetNearClip();
+    float farClip = camera_->GetFarClip();
+    float* lightData = &clusterData_[CLUSTER_LIGHT_ROW * CLUSTER_TEXTURE_WIDTH * 4];
+    clusterLightRanges_.Resize(lights.Size());
+
+    for (unsigned i = 0; i < lights.Size(); ++i)
+    {
+        Light* light = lights[i];
+        Node* lightNode = light->GetNode();
+        bool isSpot = light->GetLightType() == LIGHT_SPOT;
+
+        // Fade the light like Batch does for per-pixel lights
+        float fade = 1.0f;
+        float fadeEnd = light->GetDrawDistance();
+        float fadeStart = light->GetFadeDistance();
+        if (fadeEnd > 0.0f && fadeStart > 0.0f && fadeStart < fadeEnd)
+            fade = Min(1.0f - (light->GetDistance() - fadeStart) / (fadeEnd - fadeStart), 1.0f);
+
+        Vector3 position = lightNode->GetWorldPosition();
+        Vector3 direction = lightNode->GetWorldDirection();
+        Color color = light->GetEffectiveColor() * fade;
+
+        float* data = lightData + i * CLUSTER_LIGHT_TEXELS * 4;
+        data[0] = position.x_;
+        data[1] = position.y_;
+        data[2] = position.z_;
+        data[3] = 1.0f / Max(light->GetRange(), M_EPSILON);
+        data[4] = color.r_;
+        data[5] = color.g_;
+        data[6] = color.b_;
+        data[7] = light->GetEffectiveSpecularIntensity() * fade;
+        data[8] = direction.x_;
+        data[9] = direction.y_;
+        data[10] = direction.z_;
+        // Spot cutoff cosine, or below -1 for point lights
+        data[11] = isSpot ? Cos(light->GetFov() * 0.5f) : -2.0f;
+
+        // Find the cells covered by the light's view space bounding box
+        BoundingBox viewBox = isSpot ? BoundingBox(light->GetViewSpaceFrustum(view)) :
+            BoundingBox(Sphere(view * position, light->GetRange()));
+        ClusterLightRange& range = clusterLightRanges_[i];
+        if (viewBox.max_.z_ < nearClip || viewBox.min_.z_ > farClip)
+        {
+            range.min_ = IntVector3::ZERO;
+            range.max_ = IntVector3(-1, -1, -1);
+            continue;
+        }
+
+        // If the box crosses the near plane in a perspective projection, its projection is unbounded
+        Rect screenRect(-1.0f, -1.0f, 1.0f, 1.0f);
+        if (camera_->IsOrthographic() || viewBox.min_.z_ >= nearClip)
+        {
+            screenRect.Clear();
+            for (unsigned j = 0; j < 8; ++j)
+            {
+                Vector3 corner((j & 1u) ? viewBox.max_.x_ : viewBox.min_.x_, (j & 2u) ? viewBox.max_.y_ : viewBox.min_.y_,
+                    (j & 4u) ? viewBox.max_.z_ : viewBox.min_.z_);
+                Vector4 clipPos = projection * Vector4(corner, 1.0f);
+                screenRect.Merge(Vector2(clipPos.x_ / clipPos.w_, clipPos.y_ / clipPos.w_));
+            }
+        }
+
+        range.min_.x_ = Clamp((int)((screenRect.min_.x_ * 0.5f + 0.5f) * CLUSTER_GRID_X), 0, CLUSTER_GRID_X - 1);
+        range.max_.x_ = Clamp((int)((screenRect.max_.x_ * 0.5f + 0.5f) * CLUSTER_GRID_X), 0, CLUSTER_GRID_X - 1);
+        range.min_.y_ = Clamp((int)((screenRect.min_.y_ * 0.5f + 0.5f) * CLUSTER_GRID_Y), 0, CLUSTER_GRID_Y - 1);
+        range.max_.y_ = Clamp((int)((screenRect.max_.y_ * 0.5f + 0.5f) * CLUSTER_GRID_Y), 0, CLUSTER_GRID_Y - 1);
+        // The shaders compare against the linear depth divided by far clip, which is also correct for orthographic
+        // cameras as their near clip is zero
+        range.min_.z_ = Clamp((int)(sqrtf(Max(viewBox.min_.z_ / farClip, 0.0f)) * CLUSTER_GRID_Z), 0, CLUSTER_GRID_Z - 1);
+        range.max_.z_ = Clamp((int)(sqrtf(Max(viewBox.max_.z_ / farClip, 0.0f)) * CLUSTER_GRID_Z), 0, CLUSTER_GRID_Z - 1);
+    }
+
+    // Fill the light lists one depth slice per work item
+    GetSubsystem<WorkQueue>()->ParallelFor(BuildClusterSlicesWork, clusterData_.Buffer(), (unsigned)CLUSTER_GRID_Z,
+        CLUSTER_SLICE_FLOATS * sizeof(float), this);
+
+    numDroppedClusterLights_ = 0;
+    for (unsigned i = 0; i < clusterSliceDroppedLights_.Size(); ++i)
+        numDroppedClusterLights_ += clusterSliceDroppedLights_[i];
+    if (numDroppedClusterLights_ && !clusterOverflowLogged_)
+    {
+        URHO3D_LOGWARNING("Dropped " + String(numDroppedClusterLights_) + " light assignments from clusters with over " +
+            String(MAX_CLUSTER_LIGHTS) + " lights");
+        clusterOverflowLogged_ = true;
     }
 
-    instancingBuffer->Unlock();
+    // Upload only the light parameter rows in use
+    unsigned numRows = CLUSTER_LIGHT_ROW + (lights.Size() * CLUSTER_LIGHT_TEXELS + CLUSTER_TEXTURE_WIDTH - 1) /
+        CLUSTER_TEXTURE_WIDTH;
+    clusterTexture_->SetData(0, 0, 0, CLUSTER_TEXTURE_WIDTH, numRows, clusterData_.Buffer());
 }
 
 void View::SetupLightVolumeBatch(Batch& batch)
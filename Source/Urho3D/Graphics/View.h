@@ -76,6 +76,15 @@ struct LightQueryResult
     unsigned numSplits_;
 };
 
+/// Range of cluster grid cells covered by a clustered light.
+struct ClusterLightRange
+{
+    /// Minimum cell coordinates.
+    IntVector3 min_;
+    /// Maximum cell coordinates, inclusive.
+    IntVector3 max_;
+};
+
 /// Scene render pass info.
 struct ScenePassInfo
 {
@@ -111,6 +120,7 @@ class URHO3D_API View : public Object
 {
     friend void CheckVisibilityWork(const WorkItem* item, unsigned threadIndex);
     friend void ProcessLightWork(const WorkItem* item, unsigned threadIndex);
+    friend void BuildClusterSlicesWork(const WorkItem* item, unsigned threadIndex);
 
     URHO3D_OBJECT(View, Object);
 
@@ -124,6 +134,10 @@ public:
     bool Define(RenderSurface* renderTarget, Viewport* viewport);
     /// Update and cull objects and construct rendering batches.
     void Update(const FrameInfo& frame);
+    /// Prepare for querying the octree ahead of update. Return true if the view does its own culling. Called from the main thread after Define().
+    bool BeginPreCull();
+    /// Query the octree ahead of update. The results are used by Update() if the culling frustum has not changed. Safe to call from a worker thread.
+    void PreCull();
     /// Render batches.
     void Render();
 
@@ -174,6 +188,17 @@ public:
     /// Return the last used software occlusion buffer.
     OcclusionBuffer* GetOcclusionBuffer() const { return occlusionBuffer_; }
 
+    /// Return whether lights are assigned to a cluster grid and shaded in the base pass.
+    bool GetClusteredLighting() const { return clusteredLighting_; }
+
+    /// Return lights shaded through the cluster grid.
+    const PODVector<Light*>& GetClusteredLights() const { return clusteredLights_; }
+
+    /// Return the texture holding the cluster grid light lists and light parameters, or null if clustered lighting is not in use.
+    Texture2D* GetClusterTexture() const { return clusteredLighting_ ? clusterTexture_.Get() : nullptr; }
+    /// Return the number of light assignments dropped from clusters that were already full on the last frame. Such lights are missing from parts of the view.
+    unsigned GetNumDroppedClusterLights() const { return numDroppedClusterLights_; }
+
     /// Return number of occluders that were actually rendered. Occluders may be rejected if running out of triangles or if behind other occluders.
     unsigned GetNumActiveOccluders() const { return activeOccluders_; }
 
@@ -260,11 +285,17 @@ private:
     /// Check if material should render an auxiliary view (if it has a camera attached).
     void CheckMaterialForAuxView(Material* material);
     /// Set shader defines for a batch queue if used.
-    void SetQueueShaderDefines(BatchQueue& queue, const RenderPathCommand& command);
+    void SetQueueShaderDefines(BatchQueue& queue, const RenderPathCommand* command, bool clustered = false);
     /// Choose shaders for a batch and add it to queue.
     void AddBatchToQueue(BatchQueue& queue, Batch& batch, Technique* tech, bool allowInstancing = true, bool allowShadows = true);
+    /// Choose shaders for a batch group. Reuses the shaders of a retained group when still valid.
+    void SetBatchGroupShaders(BatchGroup& group, Technique* tech, bool allowShadows, const BatchQueue& queue);
     /// Prepare instancing buffer by filling it with all instance transforms.
     void PrepareInstancingBuffer();
+    /// Return whether the passes a drawable is lit in support clustered lighting.
+    bool CheckClusteredLightingSupport(Drawable* drawable);
+    /// Assign the clustered lights to the cluster grid of the render camera and upload the cluster texture.
+    void BuildClusters();
     /// Set up a light volume rendering batch.
     void SetupLightVolumeBatch(Batch& batch);
     /// Check whether a light queue needs shadow rendering.
@@ -364,6 +395,8 @@ private:
     int minInstances_{};
     /// Highest zone priority currently visible.
     int highestZonePriority_{};
+    /// Light assignments dropped from full clusters on the last frame.
+    unsigned numDroppedClusterLights_{};
     /// Geometries updated flag.
     bool geometriesUpdated_{};
     /// Camera zone's override flag.
@@ -380,14 +413,32 @@ private:
     bool hasScenePasses_{};
     /// Whether is using a custom readable depth texture without a stencil channel.
     bool noStencil_{};
+    /// Clustered forward lighting flag. If in use, unshadowed point and spot lights are shaded in the base and alpha passes.
+    bool clusteredLighting_{};
+    /// Whether dropped cluster light assignments have been logged already.
+    bool clusterOverflowLogged_{};
     /// Draw debug geometry flag. Copied from the viewport.
     bool drawDebug_{};
     /// Renderpath.
     RenderPath* renderPath_{};
     /// Per-thread octree query results.
     Vector<PODVector<Drawable*> > tempDrawables_;
+    /// Zones and occluders queried ahead of update.
+    PODVector<Drawable*> preCulledZonesOccluders_;
+    /// Geometries and lights queried ahead of update.
+    PODVector<Drawable*> preCulledDrawables_;
+    /// Culling frustum of the results queried ahead of update.
+    Frustum preCullFrustum_;
+    /// Culling view mask of the results queried ahead of update.
+    unsigned preCullViewMask_{};
+    /// Zones and occluders queried ahead of update flag.
+    bool hasPreCulledZonesOccluders_{};
+    /// Geometries and lights queried ahead of update flag.
+    bool hasPreCulledDrawables_{};
     /// Per-thread geometries, lights and Z range collection results.
     Vector<PerThreadSceneResult> sceneResults_;
+    /// Work items queued by the current update stage. Completed without waiting for other queued work.
+    PODVector<WorkItem*> workItems_;
     /// Visible zones.
     PODVector<Zone*> zones_;
     /// Visible geometry objects.
@@ -415,6 +466,18 @@ private:
     Vector<LightBatchQueue> lightQueues_;
     /// Per-vertex light queues.
     HashMap<unsigned long long, LightBatchQueue> vertexLightQueues_;
+    /// Lights shaded through the cluster grid instead of light queues.
+    PODVector<Light*> clusteredLights_;
+    /// Visible geometries with lit passes that do not support clustered lighting.
+    HashSet<Drawable*> nonClusteredGeometries_;
+    /// Cluster grid ranges of the clustered lights.
+    PODVector<ClusterLightRange> clusterLightRanges_;
+    /// Cluster texture contents.
+    PODVector<float> clusterData_;
+    /// Light assignments dropped from full clusters, per depth slice.
+    PODVector<unsigned> clusterSliceDroppedLights_;
+    /// Cluster grid light lists and light parameters.
+    SharedPtr<Texture2D> clusterTexture_;
     /// Batch queues by pass index.
     HashMap<unsigned, BatchQueue> batchQueues_;
     /// Index of the GBuffer pass.
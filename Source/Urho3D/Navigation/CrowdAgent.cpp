@@ -621,6 +621,14 @@ void CrowdAgent::OnSceneSet(Scene* scene)
 
 void CrowdAgent::OnMarkedDirty(Node* node)
 {
+    // Due to the world position query and the Detour agent modification, is not safe from worker threads
+    Scene* scene = GetScene();
+    if (scene && scene->IsThreadedUpdate())
+    {
+        scene->DelayedMarkedDirty(this);
+        return;
+    }
+
     if (!ignoreTransformChanges_ && IsEnabledEffective())
     {
         auto* agent = const_cast<dtCrowdAgent*>(GetDetourCrowdAgent());
@@ -450,6 +450,14 @@ void Constraint::OnSceneSet(Scene* scene)
 
 void Constraint::OnMarkedDirty(Node* node)
 {
+    // Due to the world scale query and the Bullet constraint modification, is not safe from worker threads
+    Scene* scene = GetScene();
+    if (scene && scene->IsThreadedUpdate())
+    {
+        scene->DelayedMarkedDirty(this);
+        return;
+    }
+
     /// \todo This does not catch the connected body node's scale changing
     if (HasWorldScaleChanged(cachedWorldScale_, node->GetWorldScale()))
         ApplyFrames();
@@ -22,6 +22,8 @@
 
 #include "../Precompiled.h"
 
+#include "../Core/Context.h"
+#include "../Core/EventChannel.h"
 #include "../IO/Log.h"
 #if defined(URHO3D_PHYSICS) || defined(URHO3D_URHO2D)
 #include "../Physics/PhysicsEvents.h"
@@ -37,6 +39,8 @@ LogicComponent::LogicComponent(Context* context) :
     Component(context),
     updateEventMask_(USE_UPDATE | USE_POSTUPDATE | USE_FIXEDUPDATE | USE_FIXEDPOSTUPDATE),
     currentEventMask_(0),
+    threadedEventMask_(0),
+    threadedUpdate_(false),
     delayedStartCalled_(false)
 {
 }
@@ -73,6 +77,15 @@ void LogicComponent::SetUpdateEventMask(UpdateEventFlags mask)
     }
 }
 
+void LogicComponent::SetThreadedUpdate(bool enable)
+{
+    if (threadedUpdate_ != enable)
+    {
+        threadedUpdate_ = enable;
+        UpdateEventSubscription();
+    }
+}
+
 void LogicComponent::OnNodeSet(Node* node)
 {
     if (node)
@@ -93,13 +106,13 @@ void LogicComponent::OnSceneSet(Scene* scene)
         UpdateEventSubscription();
     else
     {
-        UnsubscribeFromEvent(E_SCENEUPDATE);
-        UnsubscribeFromEvent(E_SCENEPOSTUPDATE);
 #if defined(URHO3D_PHYSICS) || defined(URHO3D_URHO2D)
         UnsubscribeFromEvent(E_PHYSICSPRESTEP);
         UnsubscribeFromEvent(E_PHYSICSPOSTSTEP);
 #endif
+        // The scene has already unsubscribed this component from its update channels and removed it from its threaded updates
         currentEventMask_ = USE_NO_EVENT;
+        threadedEventMask_ = USE_NO_EVENT;
     }
 }
 
@@ -110,31 +123,59 @@ void LogicComponent::UpdateEventSubscription()
         return;
 
     bool enabled = IsEnabledEffective();
+    // Thread-safe updates are dispatched by the scene once DelayedStart() has been called on the main thread
+    bool threaded = threadedUpdate_ && delayedStartCalled_;
 
     bool needUpdate = enabled && ((updateEventMask_ & USE_UPDATE) || !delayedStartCalled_);
+    bool needThreadedUpdate = needUpdate && threaded;
+    needUpdate = needUpdate && !threaded;
     if (needUpdate && !(currentEventMask_ & USE_UPDATE))
     {
-        SubscribeToEvent(scene, E_SCENEUPDATE, URHO3D_HANDLER(LogicComponent, HandleSceneUpdate));
+        scene->GetUpdateChannel()->Subscribe(this, &LogicComponent::HandleSceneUpdate);
         currentEventMask_ |= USE_UPDATE;
     }
     else if (!needUpdate && (currentEventMask_ & USE_UPDATE))
     {
-        UnsubscribeFromEvent(scene, E_SCENEUPDATE);
+        scene->GetUpdateChannel()->Unsubscribe(this);
         currentEventMask_ &= ~USE_UPDATE;
     }
 
+    if (needThreadedUpdate && !(threadedEventMask_ & USE_UPDATE))
+    {
+        scene->AddThreadedLogicComponent(this, false);
+        threadedEventMask_ |= USE_UPDATE;
+    }
+    else if (!needThreadedUpdate && (threadedEventMask_ & USE_UPDATE))
+    {
+        scene->RemoveThreadedLogicComponent(this, false);
+        threadedEventMask_ &= ~USE_UPDATE;
+    }
+
     bool needPostUpdate = enabled && (updateEventMask_ & USE_POSTUPDATE);
+    bool needThreadedPostUpdate = needPostUpdate && threaded;
+    needPostUpdate = needPostUpdate && !threaded;
     if (needPostUpdate && !(currentEventMask_ & USE_POSTUPDATE))
     {
-        SubscribeToEvent(scene, E_SCENEPOSTUPDATE, URHO3D_HANDLER(LogicComponent, HandleScenePostUpdate));
+        scene->GetPostUpdateChannel()->Subscribe(this, &LogicComponent::HandleScenePostUpdate);
         currentEventMask_ |= USE_POSTUPDATE;
     }
     else if (!needPostUpdate && (currentEventMask_ & USE_POSTUPDATE))
     {
-        UnsubscribeFromEvent(scene, E_SCENEPOSTUPDATE);
+        scene->GetPostUpdateChannel()->Unsubscribe(this);
         currentEventMask_ &= ~USE_POSTUPDATE;
     }
 
+    if (needThreadedPostUpdate && !(threadedEventMask_ & USE_POSTUPDATE))
+    {
+        scene->AddThreadedLogicComponent(this, true);
+        threadedEventMask_ |= USE_POSTUPDATE;
+    }
+    else if (!needThreadedPostUpdate && (threadedEventMask_ & USE_POSTUPDATE))
+    {
+        scene->RemoveThreadedLogicComponent(this, true);
+        threadedEventMask_ &= ~USE_POSTUPDATE;
+    }
+
 #if defined(URHO3D_PHYSICS) || defined(URHO3D_URHO2D)
     Component* world = GetFixedUpdateSource();
     if (!world)
@@ -166,10 +207,8 @@ void LogicComponent::UpdateEventSubscription()
 #endif
 }
 
-void LogicComponent::HandleSceneUpdate(StringHash eventType, VariantMap& eventData)
+void LogicComponent::HandleSceneUpdate(const SceneUpdateEvent& event)
 {
-    using namespace SceneUpdate;
-
     // Execute user-defined delayed start function before first update
     if (!delayedStartCalled_)
     {
@@ -179,22 +218,27 @@ void LogicComponent::HandleSceneUpdate(StringHash eventType, VariantMap& eventDa
         // If did not need actual update events, unsubscribe now
         if (!(updateEventMask_ & USE_UPDATE))
         {
-            UnsubscribeFromEvent(GetScene(), E_SCENEUPDATE);
+            event.scene_->GetUpdateChannel()->Unsubscribe(this);
             currentEventMask_ &= ~USE_UPDATE;
             return;
         }
+
+        // If thread-safe, hand over to the scene, which updates the component in worker threads after this event
+        if (threadedUpdate_)
+        {
+            UpdateEventSubscription();
+            return;
+        }
     }
 
     // Then execute user-defined update function
-    Update(eventData[P_TIMESTEP].GetFloat());
+    Update(event.timeStep_);
 }
 
-void LogicComponent::HandleScenePostUpdate(StringHash eventType, VariantMap& eventData)
+void LogicComponent::HandleScenePostUpdate(const ScenePostUpdateEvent& event)
 {
-    using namespace ScenePostUpdate;
-
     // Execute user-defined post-update function
-    PostUpdate(eventData[P_TIMESTEP].GetFloat());
+    PostUpdate(event.timeStep_);
 }
 
 #if defined(URHO3D_PHYSICS) || defined(URHO3D_URHO2D)
@@ -208,6 +252,10 @@ void LogicComponent::HandlePhysicsPreStep(StringHash eventType, VariantMap& even
     {
         DelayedStart();
         delayedStartCalled_ = true;
+
+        // Hand over variable timestep updates to the scene if thread-safe
+        if (threadedUpdate_)
+            UpdateEventSubscription();
     }
 
     // Execute user-defined fixed update function
@@ -30,6 +30,9 @@
 namespace Urho3D
 {
 
+struct ScenePostUpdateEvent;
+struct SceneUpdateEvent;
+
 enum UpdateEvent : unsigned
 {
     /// Bitmask for not using any events.
@@ -78,10 +81,22 @@ class URHO3D_API LogicComponent : public Component
 
     /// Set what update events should be subscribed to. Use this for optimization: by default all are in use. Note that this is not an attribute and is not saved or network-serialized, therefore it should always be called eg. in the subclass constructor.
     void SetUpdateEventMask(UpdateEventFlags mask);
+    /// Set whether Update() and PostUpdate() are thread-safe, in which case the scene calls them from worker threads.
+    /// Threaded updates run after all scene update or post-update event handlers, rather than in subscription order.
+    /// A thread-safe update may only modify its own node and components, and must not create or remove nodes or components.
+    /// No other threaded component may share its node.
+    /// It may read the world transforms of its node and the node's parents, but not those of other nodes.
+    /// Components whose node has an ancestor with a threaded component are updated serially afterward on the main thread.
+    /// DelayedStart() and the fixed updates are still called on the main thread.
+    /// Not an attribute, like the update event mask. Must not be called from worker threads.
+    void SetThreadedUpdate(bool enable);
 
     /// Return what update events are subscribed to.
     UpdateEventFlags GetUpdateEventMask() const { return updateEventMask_; }
 
+    /// Return whether Update() and PostUpdate() are called from worker threads.
+    bool GetThreadedUpdate() const { return threadedUpdate_; }
+
     /// Return whether the DelayedStart() function has been called.
     bool IsDelayedStartCalled() const { return delayedStartCalled_; }
 
@@ -94,10 +109,10 @@ protected:
 private:
     /// Subscribe/unsubscribe to update events based on current enabled state and update event mask.
     void UpdateEventSubscription();
-    /// Handle scene update event.
-    void HandleSceneUpdate(StringHash eventType, VariantMap& eventData);
-    /// Handle scene post-update event.
-    void HandleScenePostUpdate(StringHash eventType, VariantMap& eventData);
+    /// Handle scene update from the typed event channel.
+    void HandleSceneUpdate(const SceneUpdateEvent& event);
+    /// Handle scene post-update from the typed event channel.
+    void HandleScenePostUpdate(const ScenePostUpdateEvent& event);
 #if defined(URHO3D_PHYSICS) || defined(URHO3D_URHO2D)
     /// Handle physics pre-step event.
     void HandlePhysicsPreStep(StringHash eventType, VariantMap& eventData);
@@ -108,6 +123,10 @@ private:
     UpdateEventFlags updateEventMask_;
     /// Current event subscription mask.
     UpdateEventFlags currentEventMask_;
+    /// Update events currently dispatched by the scene in worker threads.
+    UpdateEventFlags threadedEventMask_;
+    /// Thread-safe update flag.
+    bool threadedUpdate_;
     /// Flag for delayed start.
     bool delayedStartCalled_;
 };
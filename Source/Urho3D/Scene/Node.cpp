@@ -49,6 +49,7 @@ Node::Node(Context* context) :
     Animatable(context),
     worldTransform_(Matrix3x4::IDENTITY),
     dirty_(false),
+    transformIndex_(M_MAX_UNSIGNED),
     enabled_(true),
     enabledPrev_(true),
     networkUpdate_(false),
@@ -742,6 +743,10 @@ void Node::SetOwner(Connection* owner)
 
 void Node::MarkDirty()
 {
+    // With the scene's batched transform update, the scene walks the subtree in hierarchy order instead
+    if (scene_ && scene_->MarkTransformDirty(this))
+        return;
+
     Node *cur = this;
     for (;;)
     {
@@ -757,21 +762,7 @@ void Node::MarkDirty()
         cur->dirty_ = true;
 
         // Notify listener components first, then mark child nodes
-        for (Vector<WeakPtr<Component> >::Iterator i = cur->listeners_.Begin(); i != cur->listeners_.End();)
-        {
-            Component *c = *i;
-            if (c)
-            {
-                c->OnMarkedDirty(cur);
-                ++i;
-            }
-            // If listener has expired, erase from list (swap with the last element to avoid O(n^2) behavior)
-            else
-            {
-                *i = cur->listeners_.Back();
-                cur->listeners_.Pop();
-            }
-        }
+        cur->NotifyMarkedDirty();
 
         // Tail call optimization: Don't recurse to mark the first child dirty, but
         // instead process it in the context of the current function. If there are more
@@ -789,6 +780,25 @@ void Node::MarkDirty()
     }
 }
 
+void Node::NotifyMarkedDirty()
+{
+    for (Vector<WeakPtr<Component> >::Iterator i = listeners_.Begin(); i != listeners_.End();)
+    {
+        Component *c = *i;
+        if (c)
+        {
+            c->OnMarkedDirty(this);
+            ++i;
+        }
+        // If listener has expired, erase from list (swap with the last element to avoid O(n^2) behavior)
+        else
+        {
+            *i = listeners_.Back();
+            listeners_.Pop();
+        }
+    }
+}
+
 Node* Node::CreateChild(const String& name, CreateMode mode, unsigned id, bool temporary)
 {
     Node* newNode = CreateChild(id, mode, temporary);
@@ -843,6 +853,11 @@ void Node::AddChild(Node* node, unsigned index)
         scene_->NodeAdded(node);
 
     node->parent_ = this;
+    if (scene_)
+    {
+        scene_->MarkTransformNodeAdded(node);
+        scene_->MarkNestingDirty();
+    }
     node->MarkDirty();
     node->MarkNetworkUpdate();
     // If the child node has components, also mark network update on them to ensure they have a valid NetworkState
@@ -1896,6 +1911,14 @@ void Node::SetTransformSilent(const Vector3& position, const Quaternion& rotatio
     position_ = position;
     rotation_ = rotation;
     scale_ = scale;
+    if (transformIndex_ != M_MAX_UNSIGNED)
+        MarkLocalTransformChanged();
+}
+
+void Node::MarkLocalTransformChanged()
+{
+    if (scene_)
+        scene_->MarkLocalTransformDirty(transformIndex_);
 }
 
 void Node::OnAttributeAnimationAdded()
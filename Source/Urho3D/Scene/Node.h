@@ -77,6 +77,7 @@ class URHO3D_API Node : public Animatable
     URHO3D_OBJECT(Node, Animatable);
 
     friend class Connection;
+    friend class TransformHierarchy;
 
 public:
     /// Construct.
@@ -674,13 +675,28 @@ public:
     unsigned GetNumPersistentComponents() const;
 
     /// Set position in parent space silently without marking the node & child nodes dirty. Used by animation code.
-    void SetPositionSilent(const Vector3& position) { position_ = position; }
+    void SetPositionSilent(const Vector3& position)
+    {
+        position_ = position;
+        if (transformIndex_ != M_MAX_UNSIGNED)
+            MarkLocalTransformChanged();
+    }
 
     /// Set position in parent space silently without marking the node & child nodes dirty. Used by animation code.
-    void SetRotationSilent(const Quaternion& rotation) { rotation_ = rotation; }
+    void SetRotationSilent(const Quaternion& rotation)
+    {
+        rotation_ = rotation;
+        if (transformIndex_ != M_MAX_UNSIGNED)
+            MarkLocalTransformChanged();
+    }
 
     /// Set scale in parent space silently without marking the node & child nodes dirty. Used by animation code.
-    void SetScaleSilent(const Vector3& scale) { scale_ = scale; }
+    void SetScaleSilent(const Vector3& scale)
+    {
+        scale_ = scale;
+        if (transformIndex_ != M_MAX_UNSIGNED)
+            MarkLocalTransformChanged();
+    }
 
     /// Set local transform silently without marking the node & child nodes dirty. Used by animation code.
     void SetTransformSilent(const Vector3& position, const Quaternion& rotation, const Vector3& scale);
@@ -700,6 +716,10 @@ private:
     Component* SafeCreateComponent(const String& typeName, StringHash type, CreateMode mode, unsigned id);
     /// Recalculate the world transform.
     void UpdateWorldTransform() const;
+    /// Notify listener components of the node being marked dirty. Erase expired listeners.
+    void NotifyMarkedDirty();
+    /// Tell the scene's batched transform update that the local transform changed without marking the node dirty. Only called when the node has a transform index.
+    void MarkLocalTransformChanged();
     /// Remove child node by iterator.
     void RemoveChild(Vector<SharedPtr<Node> >::Iterator i);
     /// Return child nodes recursively.
@@ -721,6 +741,8 @@ private:
     mutable Matrix3x4 worldTransform_;
     /// World transform needs update flag.
     mutable bool dirty_;
+    /// Index in the scene's batched transform update arrays.
+    unsigned transformIndex_;
     /// Enabled flag.
     bool enabled_;
     /// Last SetEnabled flag before any SetDeepEnabled.
@@ -34,6 +34,7 @@
 #include "../Resource/XMLFile.h"
 #include "../Resource/JSONFile.h"
 #include "../Scene/Component.h"
+#include "../Scene/LogicComponent.h"
 #include "../Scene/ObjectAnimation.h"
 #include "../Scene/ReplicationState.h"
 #include "../Scene/Scene.h"
@@ -55,8 +56,104 @@ const char* SUBSYSTEM_CATEGORY = "Subsystem";
 static const float DEFAULT_SMOOTHING_CONSTANT = 50.0f;
 static const float DEFAULT_SNAP_THRESHOLD = 5.0f;
 
+/// Minimum number of smoothed transforms per chunk when updating in worker threads.
+static const unsigned SMOOTHING_CHUNK_SIZE = 64;
+
+/// Smoothing parameters passed to worker threads.
+struct SmoothingUpdateParams
+{
+    /// Smoothing constant for this frame.
+    float constant_;
+    /// Squared snap threshold.
+    float squaredSnapThreshold_;
+};
+
+void UpdateSmoothingWork(const WorkItem* item, unsigned threadIndex)
+{
+    auto* params = reinterpret_cast<SmoothingUpdateParams*>(item->aux_);
+    auto* start = reinterpret_cast<SmoothedTransform**>(item->start_);
+    auto* end = reinterpret_cast<SmoothedTransform**>(item->end_);
+
+    while (start != end)
+        (*start++)->Update(params->constant_, params->squaredSnapThreshold_);
+}
+
+/// Return whether a node has an ancestor with a smoothed transform.
+static bool HasSmoothedAncestor(Node* node)
+{
+    for (Node* parent = node->GetParent(); parent; parent = parent->GetParent())
+    {
+        if (parent->GetComponent<SmoothedTransform>())
+            return true;
+    }
+
+    return false;
+}
+
+/// Return whether a node has an ancestor with a thread-safe logic component.
+static bool HasThreadedLogicAncestor(Node* node)
+{
+    for (Node* parent = node->GetParent(); parent; parent = parent->GetParent())
+    {
+        const Vector<SharedPtr<Component> >& components = parent->GetComponents();
+        for (Vector<SharedPtr<Component> >::ConstIterator i = components.Begin(); i != components.End(); ++i)
+        {
+            if ((*i)->IsInstanceOf<LogicComponent>() && static_cast<LogicComponent*>(i->Get())->GetThreadedUpdate())
+                return true;
+        }
+    }
+
+    return false;
+}
+
+/// Move the thread-safe logic components whose node has a threaded ancestor to the end of the list, preserving their order. Return the number of the other components.
+static unsigned PartitionNestedLogicComponents(PODVector<LogicComponent*>& components)
+{
+    PODVector<LogicComponent*> nested;
+    unsigned numTopmost = 0;
+    for (unsigned i = 0; i < components.Size(); ++i)
+    {
+        LogicComponent* component = components[i];
+        if (HasThreadedLogicAncestor(component->GetNode()))
+            nested.Push(component);
+        else
+            components[numTopmost++] = component;
+    }
+    for (unsigned i = 0; i < nested.Size(); ++i)
+        components[numTopmost + i] = nested[i];
+
+    return numTopmost;
+}
+
+void LogicUpdateWork(const WorkItem* item, unsigned threadIndex)
+{
+    float timeStep = *reinterpret_cast<float*>(item->aux_);
+    auto* start = reinterpret_cast<LogicComponent**>(item->start_);
+    auto* end = reinterpret_cast<LogicComponent**>(item->end_);
+
+    while (start != end)
+        (*start++)->Update(timeStep);
+}
+
+void LogicPostUpdateWork(const WorkItem* item, unsigned threadIndex)
+{
+    float timeStep = *reinterpret_cast<float*>(item->aux_);
+    auto* start = reinterpret_cast<LogicComponent**>(item->start_);
+    auto* end = reinterpret_cast<LogicComponent**>(item->end_);
+
+    while (start != end)
+        (*start++)->PostUpdate(timeStep);
+}
+
 Scene::Scene(Context* context) :
     Node(context),
+    numTopmostThreadedLogicUpdates_(0),
+    numTopmostThreadedLogicPostUpdates_(0),
+    threadedLogicNestingDirty_(false),
+    smoothedNestingDirty_(false),
+    sceneUpdateChannel_(nullptr),
+    sceneSubsystemUpdateChannel_(nullptr),
+    scenePostUpdateChannel_(nullptr),
     replicatedNodeID_(FIRST_REPLICATED_ID),
     replicatedComponentID_(FIRST_REPLICATED_ID),
     localNodeID_(FIRST_LOCAL_ID),
@@ -81,6 +178,11 @@ Scene::Scene(Context* context) :
 
 Scene::~Scene()
 {
+    // The components are going away, so avoid removing them from the threaded logic and smoothing updates one by one
+    threadedLogicUpdates_.Clear();
+    threadedLogicPostUpdates_.Clear();
+    smoothedTransforms_.Clear();
+
     // Remove root-level components first, so that scene subsystems such as the octree destroy themselves. This will speed up
     // the removal of child nodes' components
     RemoveAllComponents();
@@ -669,6 +771,17 @@ void Scene::SetAsyncLoadingMs(int ms)
     asyncLoadingMs_ = Max(ms, 1);
 }
 
+void Scene::SetBatchedTransformUpdate(bool enable)
+{
+    if (enable == transformHierarchy_.NotNull())
+        return;
+
+    if (enable)
+        transformHierarchy_ = new TransformHierarchy(this);
+    else
+        transformHierarchy_.Reset();
+}
+
 void Scene::SetElapsedTime(float time)
 {
     elapsedTime_ = time;
@@ -777,14 +890,21 @@ void Scene::Update(float timeStep)
     eventData[P_SCENE] = this;
     eventData[P_TIMESTEP] = timeStep;
 
+    // Scenes may be constructed outside the main thread, so bind the typed channels here
+    if (!sceneUpdateChannel_)
+        BindEventChannels();
+
     // Update variable timestep logic
     SendEvent(E_SCENEUPDATE, eventData);
+    sceneUpdateChannel_->Send(SceneUpdateEvent{this, timeStep});
+    UpdateThreadedLogic(false, timeStep);
 
     // Update scene attribute animation.
     SendEvent(E_ATTRIBUTEANIMATIONUPDATE, eventData);
 
     // Update scene subsystems. If a physics world is present, it will be updated, triggering fixed timestep logic updates
     SendEvent(E_SCENESUBSYSTEMUPDATE, eventData);
+    sceneSubsystemUpdateChannel_->Send(SceneSubsystemUpdateEvent{this, timeStep});
 
     // Update transform smoothing
     {
@@ -793,6 +913,9 @@ void Scene::Update(float timeStep)
         float constant = 1.0f - Clamp(powf(2.0f, -timeStep * smoothingConstant_), 0.0f, 1.0f);
         float squaredSnapThreshold = snapThreshold_ * snapThreshold_;
 
+        UpdateSmoothedTransforms(constant, squaredSnapThreshold);
+
+        // Send the smoothing event for custom smoothing implementations
         using namespace UpdateSmoothing;
 
         smoothingData_[P_CONSTANT] = constant;
@@ -802,6 +925,8 @@ void Scene::Update(float timeStep)
 
     // Post-update variable timestep logic
     SendEvent(E_SCENEPOSTUPDATE, eventData);
+    scenePostUpdateChannel_->Send(ScenePostUpdateEvent{this, timeStep});
+    UpdateThreadedLogic(true, timeStep);
 
     // Note: using a float for elapsed time accumulation is inherently inaccurate. The purpose of this value is
     // primarily to update material animation effects, as it is available to shaders. It can be reset by calling
@@ -809,6 +934,15 @@ void Scene::Update(float timeStep)
     elapsedTime_ += timeStep;
 }
 
+void Scene::UpdateTransforms()
+{
+    if (transformHierarchy_)
+    {
+        URHO3D_PROFILE(UpdateTransforms);
+        transformHierarchy_->Update();
+    }
+}
+
 void Scene::BeginThreadedUpdate()
 {
     // Check the work queue subsystem whether it actually has created worker threads. If not, do not enter threaded mode.
@@ -839,6 +973,30 @@ void Scene::DelayedMarkedDirty(Component* component)
     delayedDirtyComponents_.Push(component);
 }
 
+void Scene::AddThreadedLogicComponent(LogicComponent* component, bool postUpdate)
+{
+    if (postUpdate)
+        threadedLogicPostUpdates_.Push(component);
+    else
+        threadedLogicUpdates_.Push(component);
+    threadedLogicNestingDirty_ = true;
+}
+
+void Scene::RemoveThreadedLogicComponent(LogicComponent* component, bool postUpdate)
+{
+    if (postUpdate)
+        threadedLogicPostUpdates_.RemoveSwap(component);
+    else
+        threadedLogicUpdates_.RemoveSwap(component);
+    threadedLogicNestingDirty_ = true;
+}
+
+void Scene::AddSmoothedTransform(SmoothedTransform* transform)
+{
+    transform->nested_ = HasSmoothedAncestor(transform->GetNode());
+    smoothedTransforms_.Push(transform);
+}
+
 unsigned Scene::GetFreeNodeID(CreateMode mode)
 {
     if (mode == REPLICATED)
@@ -990,6 +1148,8 @@ void Scene::NodeRemoved(Node* node)
     else
         localNodes_.Erase(id);
 
+    if (transformHierarchy_)
+        transformHierarchy_->NodeRemoved(node);
     node->ResetScene();
 
     // Remove node from tag cache
@@ -1046,6 +1206,10 @@ void Scene::ComponentAdded(Component* component)
         localComponents_[id] = component;
     }
 
+    // A new smoothed transform may be the ancestor of smoothed transforms already in the scene
+    if (component->IsInstanceOf<SmoothedTransform>())
+        smoothedNestingDirty_ = true;
+
     component->OnSceneSet(this);
 }
 
@@ -1061,6 +1225,29 @@ void Scene::ComponentRemoved(Component* component)
         localComponents_.Erase(id);
 
     component->SetID(0);
+
+    // The component can no longer reach the scene when notified, so remove it from the update channels, and the threaded
+    // logic and smoothing updates here
+    if (component->IsInstanceOf<LogicComponent>())
+    {
+        if (sceneUpdateChannel_)
+        {
+            sceneUpdateChannel_->Unsubscribe(component);
+            scenePostUpdateChannel_->Unsubscribe(component);
+        }
+        if (static_cast<LogicComponent*>(component)->GetThreadedUpdate())
+        {
+            RemoveThreadedLogicComponent(static_cast<LogicComponent*>(component), false);
+            RemoveThreadedLogicComponent(static_cast<LogicComponent*>(component), true);
+        }
+    }
+    if (component->IsInstanceOf<SmoothedTransform>())
+    {
+        if (static_cast<SmoothedTransform*>(component)->addedToScene_)
+            smoothedTransforms_.RemoveSwap(static_cast<SmoothedTransform*>(component));
+        smoothedNestingDirty_ = true;
+    }
+
     component->OnSceneSet(nullptr);
 }
 
@@ -1527,6 +1714,108 @@ void Scene::PreloadResourcesJSON(const JSONValue& value)
 #endif
 }
 
+void Scene::BindEventChannels()
+{
+    // The channels are specific to this scene, so that a receiver is only invoked for the scene it belongs to
+    sceneUpdateChannel_ = context_->GetEventChannel<SceneUpdateEvent>(this);
+    sceneSubsystemUpdateChannel_ = context_->GetEventChannel<SceneSubsystemUpdateEvent>(this);
+    scenePostUpdateChannel_ = context_->GetEventChannel<ScenePostUpdateEvent>(this);
+}
+
+void Scene::UpdateThreadedLogic(bool postUpdate, float timeStep)
+{
+    PODVector<LogicComponent*>& components = postUpdate ? threadedLogicPostUpdates_ : threadedLogicUpdates_;
+    if (components.Empty())
+        return;
+
+    URHO3D_PROFILE(UpdateThreadedLogic);
+
+    // A component below another threaded component could modify the same node hierarchy from two threads at once, so keep
+    // the nested components at the end of the lists. Recalculate only after the components or the hierarchy have changed
+    if (threadedLogicNestingDirty_)
+    {
+        numTopmostThreadedLogicUpdates_ = PartitionNestedLogicComponents(threadedLogicUpdates_);
+        numTopmostThreadedLogicPostUpdates_ = PartitionNestedLogicComponents(threadedLogicPostUpdates_);
+        threadedLogicNestingDirty_ = false;
+    }
+    unsigned numTopmost = postUpdate ? numTopmostThreadedLogicPostUpdates_ : numTopmostThreadedLogicUpdates_;
+
+    // Querying a dirty world transform recalculates it and its dirty parents, which would race between components
+    // sharing a parent. Clean the transforms of the components' nodes and their parents first
+    if (transformHierarchy_)
+        transformHierarchy_->Update();
+    else
+    {
+        for (PODVector<LogicComponent*>::ConstIterator i = components.Begin(); i != components.End(); ++i)
+            (*i)->GetNode()->GetWorldTransform();
+    }
+
+    // Dirty notifications from the updated nodes are delayed until all topmost components have been updated
+    BeginThreadedUpdate();
+    GetSubsystem<WorkQueue>()->ParallelFor(postUpdate ? LogicPostUpdateWork : LogicUpdateWork, components.Buffer(),
+        components.Buffer() + numTopmost, &timeStep);
+    EndThreadedUpdate();
+
+    for (unsigned i = numTopmost; i < components.Size(); ++i)
+    {
+        if (postUpdate)
+            components[i]->PostUpdate(timeStep);
+        else
+            components[i]->Update(timeStep);
+    }
+}
+
+void Scene::UpdateSmoothedTransforms(float constant, float squaredSnapThreshold)
+{
+    if (smoothedTransforms_.Empty())
+        return;
+
+    // The nesting is cached when a transform starts smoothing, and recalculated only after the hierarchy has changed
+    if (smoothedNestingDirty_)
+    {
+        for (unsigned i = 0; i < smoothedTransforms_.Size(); ++i)
+            smoothedTransforms_[i]->nested_ = HasSmoothedAncestor(smoothedTransforms_[i]->GetNode());
+        smoothedNestingDirty_ = false;
+    }
+
+    // A smoothed node below another smoothed node would be marked dirty from two threads at once, so move the nested
+    // transforms to the end of the list and update only the topmost ones in parallel
+    nestedSmoothedTransforms_.Clear();
+    unsigned numTopmost = 0;
+    for (unsigned i = 0; i < smoothedTransforms_.Size(); ++i)
+    {
+        SmoothedTransform* transform = smoothedTransforms_[i];
+        if (transform->nested_)
+            nestedSmoothedTransforms_.Push(transform);
+        else
+            smoothedTransforms_[numTopmost++] = transform;
+    }
+    for (unsigned i = 0; i < nestedSmoothedTransforms_.Size(); ++i)
+        smoothedTransforms_[numTopmost + i] = nestedSmoothedTransforms_[i];
+
+    // Dirty notifications from the smoothed nodes are delayed until all topmost transforms have been updated
+    SmoothingUpdateParams params{constant, squaredSnapThreshold};
+    BeginThreadedUpdate();
+    GetSubsystem<WorkQueue>()->ParallelFor(UpdateSmoothingWork, smoothedTransforms_.Buffer(),
+        smoothedTransforms_.Buffer() + numTopmost, &params, SMOOTHING_CHUNK_SIZE);
+    EndThreadedUpdate();
+
+    for (unsigned i = numTopmost; i < smoothedTransforms_.Size(); ++i)
+        smoothedTransforms_[i]->Update(constant, squaredSnapThreshold);
+
+    // Remove the transforms that have completed smoothing, preserving the order of the rest
+    unsigned numActive = 0;
+    for (unsigned i = 0; i < smoothedTransforms_.Size(); ++i)
+    {
+        SmoothedTransform* transform = smoothedTransforms_[i];
+        if (transform->IsInProgress())
+            smoothedTransforms_[numActive++] = transform;
+        else
+            transform->addedToScene_ = false;
+    }
+    smoothedTransforms_.Resize(numActive);
+}
+
 void RegisterSceneLibrary(Context* context)
 {
     ValueAnimation::RegisterObject(context);
@@ -30,12 +30,19 @@
 #include "../Resource/JSONFile.h"
 #include "../Scene/Node.h"
 #include "../Scene/SceneResolver.h"
+#include "../Scene/TransformHierarchy.h"
 
 namespace Urho3D
 {
 
 class File;
+class LogicComponent;
 class PackageFile;
+class SmoothedTransform;
+template <class E> class EventChannel;
+struct SceneUpdateEvent;
+struct SceneSubsystemUpdateEvent;
+struct ScenePostUpdateEvent;
 
 static const unsigned FIRST_REPLICATED_ID = 0x1;
 static const unsigned LAST_REPLICATED_ID = 0xffffff;
@@ -166,6 +173,9 @@ public:
     /// Set maximum milliseconds per frame to spend on async scene loading.
     /// @property
     void SetAsyncLoadingMs(int ms);
+    /// Set whether to recalculate dirty world transforms of all nodes in one batched pass before the octree update, instead of lazily when read. Default false.
+    /// @property
+    void SetBatchedTransformUpdate(bool enable);
     /// Add a required package file for networking. To be called on the server.
     void AddRequiredPackageFile(PackageFile* package);
     /// Clear required package files.
@@ -228,6 +238,10 @@ public:
     /// @property
     int GetAsyncLoadingMs() const { return asyncLoadingMs_; }
 
+    /// Return whether dirty world transforms are recalculated in one batched pass.
+    /// @property
+    bool GetBatchedTransformUpdate() const { return transformHierarchy_.NotNull(); }
+
     /// Return required package files.
     /// @property
     const Vector<SharedPtr<PackageFile> >& GetRequiredPackageFiles() const { return requiredPackageFiles_; }
@@ -243,10 +257,61 @@ public:
     void EndThreadedUpdate();
     /// Add a component to the delayed dirty notify queue. Is thread-safe.
     void DelayedMarkedDirty(Component* component);
+    /// Add a thread-safe logic component to be updated in worker threads after the update or post-update event. Called by LogicComponent.
+    void AddThreadedLogicComponent(LogicComponent* component, bool postUpdate);
+    /// Remove a logic component from the worker thread updates. Called by LogicComponent.
+    void RemoveThreadedLogicComponent(LogicComponent* component, bool postUpdate);
+    /// Add a smoothed transform with smoothing in progress to the smoothing update. It is removed automatically once smoothing completes. Called by SmoothedTransform.
+    void AddSmoothedTransform(SmoothedTransform* transform);
 
     /// Return threaded update flag.
     bool IsThreadedUpdate() const { return threadedUpdate_; }
 
+    /// Return the typed scene update event channel of this scene. Must be called from the main thread.
+    EventChannel<SceneUpdateEvent>* GetUpdateChannel()
+    {
+        if (!sceneUpdateChannel_)
+            BindEventChannels();
+        return sceneUpdateChannel_;
+    }
+    /// Return the typed scene subsystem update event channel of this scene. Must be called from the main thread.
+    EventChannel<SceneSubsystemUpdateEvent>* GetSubsystemUpdateChannel()
+    {
+        if (!sceneUpdateChannel_)
+            BindEventChannels();
+        return sceneSubsystemUpdateChannel_;
+    }
+    /// Return the typed scene post-update event channel of this scene. Must be called from the main thread.
+    EventChannel<ScenePostUpdateEvent>* GetPostUpdateChannel()
+    {
+        if (!sceneUpdateChannel_)
+            BindEventChannels();
+        return scenePostUpdateChannel_;
+    }
+
+    /// Recalculate dirty world transforms in one batched pass if enabled. Called by Octree before updating drawables.
+    void UpdateTransforms();
+    /// Mark a node and its subtree dirty through the batched transform update. Return false if not enabled or the node has to walk its subtree itself. Called by Node. Is thread-safe.
+    bool MarkTransformDirty(Node* node) { return transformHierarchy_ && transformHierarchy_->MarkDirty(node); }
+    /// Record a node whose local transform changed silently for the batched transform update. Called by Node. Is thread-safe.
+    void MarkLocalTransformDirty(unsigned transformIndex)
+    {
+        if (transformHierarchy_)
+            transformHierarchy_->MarkLocalDirty(transformIndex);
+    }
+    /// Record a node added or reparented for the batched transform update. Called by Node.
+    void MarkTransformNodeAdded(Node* node)
+    {
+        if (transformHierarchy_)
+            transformHierarchy_->NodeAdded(node);
+    }
+    /// Mark the cached nesting of smoothed transforms and thread-safe logic components dirty after a node's parent changed. Called by Node.
+    void MarkNestingDirty()
+    {
+        smoothedNestingDirty_ = true;
+        threadedLogicNestingDirty_ = true;
+    }
+
     /// Get free node ID, either non-local or local.
     unsigned GetFreeNodeID(CreateMode mode);
     /// Get free component ID, either non-local or local.
@@ -302,6 +367,12 @@ private:
     void PreloadResourcesXML(const XMLElement& element);
     /// Preload resources from a JSON scene or object prefab file.
     void PreloadResourcesJSON(const JSONValue& value);
+    /// Look up the typed update event channels of this scene from the context.
+    void BindEventChannels();
+    /// Update thread-safe logic components in worker threads, except those with a threaded ancestor, which are updated serially afterward.
+    void UpdateThreadedLogic(bool postUpdate, float timeStep);
+    /// Update the smoothed transforms in progress in worker threads and remove those that have completed.
+    void UpdateSmoothedTransforms(float constant, float squaredSnapThreshold);
 
     /// Replicated scene nodes by ID.
     HashMap<unsigned, Node*> replicatedNodes_;
@@ -331,8 +402,32 @@ private:
     PODVector<Component*> delayedDirtyComponents_;
     /// Mutex for the delayed dirty notification queue.
     Mutex sceneMutex_;
+    /// Thread-safe logic components to update in worker threads after the update event.
+    PODVector<LogicComponent*> threadedLogicUpdates_;
+    /// Thread-safe logic components to update in worker threads after the post-update event.
+    PODVector<LogicComponent*> threadedLogicPostUpdates_;
+    /// Number of thread-safe logic components at the start of the update list whose node has no threaded ancestor.
+    unsigned numTopmostThreadedLogicUpdates_;
+    /// Number of thread-safe logic components at the start of the post-update list whose node has no threaded ancestor.
+    unsigned numTopmostThreadedLogicPostUpdates_;
+    /// Thread-safe logic component nesting needs to be recalculated flag. Set when components are added or removed, or a node's parent changes.
+    bool threadedLogicNestingDirty_;
+    /// Smoothed transforms with smoothing in progress.
+    PODVector<SmoothedTransform*> smoothedTransforms_;
+    /// Smoothed transforms whose node has a smoothed ancestor, collected during the smoothing update.
+    PODVector<SmoothedTransform*> nestedSmoothedTransforms_;
+    /// Smoothed transform nesting needs to be recalculated flag. Set when smoothed transforms are added or removed, or a node's parent changes.
+    bool smoothedNestingDirty_;
+    /// Hierarchy-ordered transform arrays for the batched transform update. Null when not enabled.
+    UniquePtr<TransformHierarchy> transformHierarchy_;
     /// Preallocated event data map for smoothing update events.
     VariantMap smoothingData_;
+    /// Typed scene update event channel of this scene. Bound on first use.
+    EventChannel<SceneUpdateEvent>* sceneUpdateChannel_;
+    /// Typed scene subsystem update event channel of this scene. Bound on first use.
+    EventChannel<SceneSubsystemUpdateEvent>* sceneSubsystemUpdateChannel_;
+    /// Typed scene post-update event channel of this scene. Bound on first use.
+    EventChannel<ScenePostUpdateEvent>* scenePostUpdateChannel_;
     /// Next free non-local node ID.
     unsigned replicatedNodeID_;
     /// Next free non-local component ID.
@@ -27,6 +27,8 @@
 namespace Urho3D
 {
 
+class Scene;
+
 /// Variable timestep scene update.
 URHO3D_EVENT(E_SCENEUPDATE, SceneUpdate)
 {
@@ -34,6 +36,16 @@ URHO3D_EVENT(E_SCENEUPDATE, SceneUpdate)
     URHO3D_PARAM(P_TIMESTEP, TimeStep);            // float
 }
 
+/// Typed counterpart of E_SCENEUPDATE, sent through the scene's channel returned by Scene::GetUpdateChannel() right after it.
+struct SceneUpdateEvent
+{
+    URHO3D_TYPED_EVENT(SceneUpdateEvent)
+    /// Scene being updated.
+    Scene* scene_;
+    /// Scaled time step.
+    float timeStep_;
+};
+
 /// Scene subsystem update.
 URHO3D_EVENT(E_SCENESUBSYSTEMUPDATE, SceneSubsystemUpdate)
 {
@@ -41,6 +53,16 @@ URHO3D_EVENT(E_SCENESUBSYSTEMUPDATE, SceneSubsystemUpdate)
     URHO3D_PARAM(P_TIMESTEP, TimeStep);            // float
 }
 
+/// Typed counterpart of E_SCENESUBSYSTEMUPDATE, sent through the scene's channel returned by Scene::GetSubsystemUpdateChannel() right after it.
+struct SceneSubsystemUpdateEvent
+{
+    URHO3D_TYPED_EVENT(SceneSubsystemUpdateEvent)
+    /// Scene being updated.
+    Scene* scene_;
+    /// Scaled time step.
+    float timeStep_;
+};
+
 /// Scene transform smoothing update.
 URHO3D_EVENT(E_UPDATESMOOTHING, UpdateSmoothing)
 {
@@ -93,6 +115,16 @@ URHO3D_EVENT(E_SCENEPOSTUPDATE, ScenePostUpdate)
     URHO3D_PARAM(P_TIMESTEP, TimeStep);            // float
 }
 
+/// Typed counterpart of E_SCENEPOSTUPDATE, sent through the scene's channel returned by Scene::GetPostUpdateChannel() right after it.
+struct ScenePostUpdateEvent
+{
+    URHO3D_TYPED_EVENT(ScenePostUpdateEvent)
+    /// Scene being updated.
+    Scene* scene_;
+    /// Scaled time step.
+    float timeStep_;
+};
+
 /// Asynchronous scene loading progress.
 URHO3D_EVENT(E_ASYNCLOADPROGRESS, AsyncLoadProgress)
 {
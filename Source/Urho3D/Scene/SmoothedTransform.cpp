@@ -37,7 +37,8 @@ SmoothedTransform::SmoothedTransform(Context* context) :
     targetPosition_(Vector3::ZERO),
     targetRotation_(Quaternion::IDENTITY),
     smoothingMask_(SMOOTH_NONE),
-    subscribed_(false)
+    addedToScene_(false),
+    nested_(false)
 {
 }
 
@@ -87,26 +88,13 @@ void SmoothedTransform::Update(float constant, float squaredSnapThreshold)
             node_->SetRotation(rotation);
         }
     }
-
-    // If smoothing has completed, unsubscribe from the update event
-    if (!smoothingMask_)
-    {
-        UnsubscribeFromEvent(GetScene(), E_UPDATESMOOTHING);
-        subscribed_ = false;
-    }
 }
 
 void SmoothedTransform::SetTargetPosition(const Vector3& position)
 {
     targetPosition_ = position;
     smoothingMask_ |= SMOOTH_POSITION;
-
-    // Subscribe to smoothing update if not yet subscribed
-    if (!subscribed_)
-    {
-        SubscribeToEvent(GetScene(), E_UPDATESMOOTHING, URHO3D_HANDLER(SmoothedTransform, HandleUpdateSmoothing));
-        subscribed_ = true;
-    }
+    AddToScene();
 
     SendEvent(E_TARGETPOSITION);
 }
@@ -115,12 +103,7 @@ void SmoothedTransform::SetTargetRotation(const Quaternion& rotation)
 {
     targetRotation_ = rotation;
     smoothingMask_ |= SMOOTH_ROTATION;
-
-    if (!subscribed_)
-    {
-        SubscribeToEvent(GetScene(), E_UPDATESMOOTHING, URHO3D_HANDLER(SmoothedTransform, HandleUpdateSmoothing));
-        subscribed_ = true;
-    }
+    AddToScene();
 
     SendEvent(E_TARGETROTATION);
 }
@@ -167,13 +150,29 @@ void SmoothedTransform::OnNodeSet(Node* node)
     }
 }
 
-void SmoothedTransform::HandleUpdateSmoothing(StringHash eventType, VariantMap& eventData)
+void SmoothedTransform::OnSceneSet(Scene* scene)
 {
-    using namespace UpdateSmoothing;
+    if (scene)
+    {
+        // Resume smoothing that was started outside the scene
+        if (smoothingMask_)
+            AddToScene();
+    }
+    else
+    {
+        // The scene has already removed this component from its smoothing update
+        addedToScene_ = false;
+    }
+}
 
-    float constant = eventData[P_CONSTANT].GetFloat();
-    float squaredSnapThreshold = eventData[P_SQUAREDSNAPTHRESHOLD].GetFloat();
-    Update(constant, squaredSnapThreshold);
+void SmoothedTransform::AddToScene()
+{
+    Scene* scene = GetScene();
+    if (scene && !addedToScene_)
+    {
+        scene->AddSmoothedTransform(this);
+        addedToScene_ = true;
+    }
 }
 
 }
@@ -45,6 +45,8 @@ class URHO3D_API SmoothedTransform : public Component
 {
     URHO3D_OBJECT(SmoothedTransform, Component);
 
+    friend class Scene;
+
 public:
     /// Construct.
     explicit SmoothedTransform(Context* context);
@@ -54,7 +56,7 @@ public:
     /// @nobind
     static void RegisterObject(Context* context);
 
-    /// Update smoothing.
+    /// Update smoothing. Called by the scene for all smoothed transforms in progress, from worker threads if available unless the node has a smoothed ancestor.
     void Update(float constant, float squaredSnapThreshold);
     /// Set target position in parent space.
     /// @property
@@ -91,10 +93,12 @@ public:
 protected:
     /// Handle scene node being assigned at creation.
     void OnNodeSet(Node* node) override;
+    /// Handle scene being assigned.
+    void OnSceneSet(Scene* scene) override;
 
 private:
-    /// Handle smoothing update event.
-    void HandleUpdateSmoothing(StringHash eventType, VariantMap& eventData);
+    /// Add to the scene's smoothing update if not yet added.
+    void AddToScene();
 
     /// Target position.
     Vector3 targetPosition_;
@@ -102,8 +106,10 @@ private:
     Quaternion targetRotation_;
     /// Active smoothing operations bitmask.
     SmoothingTypeFlags smoothingMask_;
-    /// Subscribed to smoothing update event flag.
-    bool subscribed_;
+    /// Added to the scene's smoothing update flag.
+    bool addedToScene_;
+    /// Node has an ancestor with a smoothed transform flag. Cached by the scene.
+    bool nested_;
 };
 
 }
@@ -287,14 +287,35 @@ void SplinePath::OnMarkedDirty(Node* point)
     if (!point)
         return;
 
-    WeakPtr<Node> controlPoint(point);
+    // Due to the world position query, is not safe from worker threads
+    Scene* scene = GetScene();
+    if (scene && scene->IsThreadedUpdate())
+    {
+        scene->DelayedMarkedDirty(this);
+        return;
+    }
 
-    for (unsigned i = 0; i < controlPoints_.Size(); ++i)
+    // A delayed notification is received for the path's own node and does not tell which control point moved, so refresh
+    // all knots then
+    if (point == node_)
     {
-        if (controlPoints_[i] == controlPoint)
+        for (unsigned i = 0; i < controlPoints_.Size(); ++i)
         {
-            spline_.SetKnot(point->GetWorldPosition(), i);
-            break;
+            if (controlPoints_[i])
+                spline_.SetKnot(controlPoints_[i]->GetWorldPosition(), i);
+        }
+    }
+    else
+    {
+        WeakPtr<Node> controlPoint(point);
+
+        for (unsigned i = 0; i < controlPoints_.Size(); ++i)
+        {
+            if (controlPoints_[i] == controlPoint)
+            {
+                spline_.SetKnot(point->GetWorldPosition(), i);
+                break;
+            }
         }
     }
 
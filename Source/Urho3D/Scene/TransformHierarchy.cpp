@@ -0,0 +1,373 @@
+//
+// Copyright (c) 2008-2020 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Precompiled.h"
+
+#include "../Container/Sort.h"
+#include "../Core/WorkQueue.h"
+#include "../Scene/Scene.h"
+#include "../Scene/TransformHierarchy.h"
+
+#include <cstring>
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+/// Subtrees larger than this are split into their children, so that deep hierarchies under a single root still update in parallel.
+static const unsigned MAX_TRANSFORM_RANGE_SIZE = 1024;
+/// Minimum number of subtrees per chunk when updating in worker threads.
+static const unsigned TRANSFORM_RANGE_CHUNK_SIZE = 16;
+
+void UpdateTransformRangesWork(const WorkItem* item, unsigned threadIndex)
+{
+    auto* hierarchy = reinterpret_cast<TransformHierarchy*>(item->aux_);
+    auto* start = reinterpret_cast<TransformRange*>(item->start_);
+    auto* end = reinterpret_cast<TransformRange*>(item->end_);
+
+    while (start != end)
+        hierarchy->UpdateRange(*start++);
+}
+
+static inline bool CompareInsertions(const TransformInsertion& lhs, const TransformInsertion& rhs)
+{
+    if (lhs.position_ != rhs.position_)
+        return lhs.position_ < rhs.position_;
+    // Subtrees ending at the same position are nested. Insert into the innermost first, so that each inserted subtree
+    // directly follows its parent's subtree
+    if (lhs.parentIndex_ == M_MAX_UNSIGNED || rhs.parentIndex_ == M_MAX_UNSIGNED)
+        return rhs.parentIndex_ == M_MAX_UNSIGNED && lhs.parentIndex_ != M_MAX_UNSIGNED;
+    return lhs.parentIndex_ > rhs.parentIndex_;
+}
+
+TransformHierarchy::TransformHierarchy(Scene* scene) :
+    scene_(scene),
+    firstRemovedIndex_(M_MAX_UNSIGNED),
+    structureDirty_(false)
+{
+    const Vector<SharedPtr<Node> >& children = scene_->GetChildren();
+    for (Vector<SharedPtr<Node> >::ConstIterator i = children.Begin(); i != children.End(); ++i)
+        NodeAdded(*i);
+}
+
+TransformHierarchy::~TransformHierarchy()
+{
+    // Forget the indices so that a later hierarchy does not mistake the nodes for being already added
+    for (PODVector<Node*>::Iterator i = nodes_.Begin(); i != nodes_.End(); ++i)
+    {
+        if (*i)
+            (*i)->transformIndex_ = M_MAX_UNSIGNED;
+    }
+}
+
+void TransformHierarchy::NodeAdded(Node* node)
+{
+    // When reparenting, the subtree is removed from its old position first
+    NodeRemoved(node);
+    node->transformIndex_ = M_MAX_UNSIGNED;
+    addedNodes_.Push(WeakPtr<Node>(node));
+    structureDirty_ = true;
+}
+
+void TransformHierarchy::NodeRemoved(Node* node)
+{
+    unsigned index = node->transformIndex_;
+    if (index >= nodes_.Size() || nodes_[index] != node)
+        return;
+
+    // Leave the subtree in place and null its nodes. The subtree end indices stay valid for skipping it
+    unsigned end = subtreeEnds_[index];
+    for (unsigned i = index; i < end; ++i)
+    {
+        if (nodes_[i])
+            nodes_[i]->transformIndex_ = M_MAX_UNSIGNED;
+        nodes_[i] = nullptr;
+        dirtyRoots_[i] = 0;
+        localDirty_[i] = 0;
+    }
+
+    firstRemovedIndex_ = Min(firstRemovedIndex_, index);
+}
+
+bool TransformHierarchy::MarkDirty(Node* node)
+{
+    unsigned index = node->transformIndex_;
+    if (index >= nodes_.Size() || nodes_[index] != node)
+        return false;
+
+    localDirty_[index] = 1;
+    // If the node was already dirty, so is its subtree
+    if (node->dirty_)
+        return true;
+    dirtyRoots_[index] = 1;
+    // Nodes waiting to be added may be missing from the subtree, so let the caller walk the child nodes
+    if (structureDirty_)
+        return false;
+
+    unsigned end = subtreeEnds_[index];
+    unsigned i = index;
+    while (i < end)
+    {
+        Node* cur = nodes_[i];
+        // Skip removed subtrees, and subtrees already dirty
+        if (!cur || cur->dirty_)
+        {
+            i = subtreeEnds_[i];
+            continue;
+        }
+
+        cur->dirty_ = true;
+        cur->NotifyMarkedDirty();
+        ++i;
+    }
+
+    return true;
+}
+
+void TransformHierarchy::Update()
+{
+    if (structureDirty_ || firstRemovedIndex_ < nodes_.Size())
+        ApplyStructureChanges();
+
+    // Find the dirty subtrees. Scan the flags eight at a time, as usually most nodes are clean
+    dirtyRanges_.Clear();
+    unsigned numNodes = nodes_.Size();
+    unsigned i = 0;
+    while (i < numNodes)
+    {
+        if (!(i & 7u) && i + 8 <= numNodes)
+        {
+            unsigned long long flags;
+            memcpy(&flags, &dirtyRoots_[i], sizeof flags);
+            if (!flags)
+            {
+                i += 8;
+                continue;
+            }
+        }
+
+        if (dirtyRoots_[i])
+        {
+            // Nodes marked dirty inside this subtree are covered by it
+            QueueRange(i);
+            i = subtreeEnds_[i];
+        }
+        else
+            ++i;
+    }
+
+    if (numNodes)
+        memset(&dirtyRoots_[0], 0, numNodes);
+
+    if (!dirtyRanges_.Empty())
+    {
+        scene_->GetSubsystem<WorkQueue>()->ParallelFor(UpdateTransformRangesWork, dirtyRanges_.Buffer(),
+            dirtyRanges_.Buffer() + dirtyRanges_.Size(), this, TRANSFORM_RANGE_CHUNK_SIZE);
+    }
+}
+
+void TransformHierarchy::UpdateRange(const TransformRange& range)
+{
+    for (unsigned i = range.start_; i < range.end_; ++i)
+    {
+        Node* node = nodes_[i];
+
+        // Copy local transforms that changed since the last pass, the rest are read from the arrays
+        if (localDirty_[i])
+        {
+            localTransforms_[i] = node->GetTransform();
+            localRotations_[i] = node->GetRotation();
+            localDirty_[i] = 0;
+        }
+
+        unsigned parentIndex = parents_[i];
+        if (parentIndex == M_MAX_UNSIGNED)
+        {
+            // Assume the root node (scene) has identity transform
+            worldTransforms_[i] = localTransforms_[i];
+            worldRotations_[i] = localRotations_[i];
+        }
+        else if (i == range.start_)
+        {
+            // The parent of the subtree root is outside the range and already clean
+            Node* parent = nodes_[parentIndex];
+            worldTransforms_[i] = parent->GetWorldTransform() * localTransforms_[i];
+            worldRotations_[i] = parent->GetWorldRotation() * localRotations_[i];
+        }
+        else
+        {
+            worldTransforms_[i] = worldTransforms_[parentIndex] * localTransforms_[i];
+            worldRotations_[i] = worldRotations_[parentIndex] * localRotations_[i];
+        }
+
+        // Write the results back for the node's world transform getters
+        node->worldTransform_ = worldTransforms_[i];
+        node->worldRotation_ = worldRotations_[i];
+        node->dirty_ = false;
+    }
+}
+
+void TransformHierarchy::ApplyStructureChanges()
+{
+    unsigned oldSize = nodes_.Size();
+
+    // Find where the added subtrees go: after the last existing child of their parent. Nodes whose parent is not in the
+    // arrays yet are inserted along with their parent
+    insertions_.Clear();
+    for (Vector<WeakPtr<Node> >::ConstIterator i = addedNodes_.Begin(); i != addedNodes_.End(); ++i)
+    {
+        Node* node = *i;
+        if (!node || node->GetScene() != scene_)
+            continue;
+
+        Node* parent = node->GetParent();
+        if (parent == scene_)
+            insertions_.Push(TransformInsertion{oldSize, M_MAX_UNSIGNED, node});
+        else if (parent && parent->transformIndex_ < oldSize && nodes_[parent->transformIndex_] == parent)
+        {
+            unsigned parentIndex = parent->transformIndex_;
+            insertions_.Push(TransformInsertion{subtreeEnds_[parentIndex], parentIndex, node});
+        }
+    }
+    addedNodes_.Clear();
+    Sort(insertions_.Begin(), insertions_.End(), CompareInsertions);
+
+    // The arrays before the first change stay as they are
+    unsigned offset = Min(firstRemovedIndex_, oldSize);
+    if (!insertions_.Empty())
+        offset = Min(offset, insertions_.Front().position_);
+    // Remember the subtrees that contain the first change, their ends are recalculated below
+    unsigned changedAncestor = offset < oldSize ? parents_[offset] : M_MAX_UNSIGNED;
+
+    // Rewrite the rest into the temporary arrays, leaving out removed nodes and inserting the added subtrees
+    tempNodes_.Clear();
+    tempParents_.Clear();
+    tempDirtyRoots_.Clear();
+    tempLocalDirty_.Clear();
+    tempLocalTransforms_.Clear();
+    tempLocalRotations_.Clear();
+    unsigned nextInsertion = 0;
+    for (unsigned i = offset; i <= oldSize; ++i)
+    {
+        for (; nextInsertion < insertions_.Size() && insertions_[nextInsertion].position_ == i; ++nextInsertion)
+        {
+            Node* node = insertions_[nextInsertion].node_;
+            // The same node may have been added more than once
+            if (node->transformIndex_ != M_MAX_UNSIGNED)
+                continue;
+
+            // The parent is either before the offset, or already has its new index
+            Node* parent = node->GetParent();
+            unsigned index = tempNodes_.Size();
+            InsertNode(node, parent == scene_ ? M_MAX_UNSIGNED : parent->transformIndex_, offset);
+            tempDirtyRoots_[index] = 1;
+        }
+
+        if (i == oldSize)
+            break;
+
+        Node* node = nodes_[i];
+        if (!node)
+            continue;
+
+        unsigned parentIndex = parents_[i];
+        node->transformIndex_ = offset + tempNodes_.Size();
+        tempNodes_.Push(node);
+        tempParents_.Push(parentIndex != M_MAX_UNSIGNED && parentIndex >= offset ? nodes_[parentIndex]->transformIndex_ :
+            parentIndex);
+        tempDirtyRoots_.Push(dirtyRoots_[i]);
+        tempLocalDirty_.Push(localDirty_[i]);
+        tempLocalTransforms_.Push(localTransforms_[i]);
+        tempLocalRotations_.Push(localRotations_[i]);
+    }
+
+    unsigned numNodes = offset + tempNodes_.Size();
+    nodes_.Resize(numNodes);
+    parents_.Resize(numNodes);
+    subtreeEnds_.Resize(numNodes);
+    dirtyRoots_.Resize(numNodes);
+    localDirty_.Resize(numNodes);
+    localTransforms_.Resize(numNodes);
+    localRotations_.Resize(numNodes);
+    worldTransforms_.Resize(numNodes);
+    worldRotations_.Resize(numNodes);
+
+    for (unsigned i = offset; i < numNodes; ++i)
+    {
+        unsigned j = i - offset;
+        nodes_[i] = tempNodes_[j];
+        parents_[i] = tempParents_[j];
+        subtreeEnds_[i] = i + 1;
+        dirtyRoots_[i] = tempDirtyRoots_[j];
+        localDirty_[i] = tempLocalDirty_[j];
+        localTransforms_[i] = tempLocalTransforms_[j];
+        localRotations_[i] = tempLocalRotations_[j];
+    }
+
+    // Shrink the subtrees that contained the first change to the unchanged part, then grow all subtrees back to their last
+    // descendant. Going backwards, each parent usually reaches its final end from its last descendant
+    for (unsigned i = changedAncestor; i != M_MAX_UNSIGNED; i = parents_[i])
+        subtreeEnds_[i] = offset;
+    for (unsigned i = numNodes; i-- > offset;)
+    {
+        unsigned end = subtreeEnds_[i];
+        for (unsigned j = parents_[i]; j != M_MAX_UNSIGNED && subtreeEnds_[j] < end; j = parents_[j])
+            subtreeEnds_[j] = end;
+    }
+
+    firstRemovedIndex_ = M_MAX_UNSIGNED;
+    structureDirty_ = false;
+}
+
+void TransformHierarchy::InsertNode(Node* node, unsigned parentIndex, unsigned offset)
+{
+    unsigned index = offset + tempNodes_.Size();
+    node->transformIndex_ = index;
+    tempNodes_.Push(node);
+    tempParents_.Push(parentIndex);
+    tempDirtyRoots_.Push(0);
+    tempLocalDirty_.Push(0);
+    tempLocalTransforms_.Push(node->GetTransform());
+    tempLocalRotations_.Push(node->GetRotation());
+
+    const Vector<SharedPtr<Node> >& children = node->GetChildren();
+    for (Vector<SharedPtr<Node> >::ConstIterator i = children.Begin(); i != children.End(); ++i)
+        InsertNode(*i, index, offset);
+}
+
+void TransformHierarchy::QueueRange(unsigned index)
+{
+    unsigned end = subtreeEnds_[index];
+    if (end - index <= MAX_TRANSFORM_RANGE_SIZE)
+    {
+        dirtyRanges_.Push(TransformRange{index, end});
+        return;
+    }
+
+    // Update the root now, then its child subtrees can be updated independently
+    UpdateRange(TransformRange{index, index + 1});
+    for (unsigned i = index + 1; i < end; i = subtreeEnds_[i])
+        QueueRange(i);
+}
+
+}
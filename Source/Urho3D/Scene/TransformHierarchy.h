@@ -0,0 +1,141 @@
+//
+// Copyright (c) 2008-2020 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+/// \file
+
+#pragma once
+
+#include "../Container/Ptr.h"
+#include "../Container/Vector.h"
+#include "../Math/Matrix3x4.h"
+#include "../Math/Quaternion.h"
+
+#include <atomic>
+
+namespace Urho3D
+{
+
+class Node;
+class Scene;
+
+/// Range of nodes forming one subtree in hierarchy order.
+struct TransformRange
+{
+    /// First node index.
+    unsigned start_;
+    /// One past the last node index.
+    unsigned end_;
+};
+
+/// Subtree waiting to be inserted into the hierarchy arrays.
+struct TransformInsertion
+{
+    /// Index in the arrays before which the subtree is inserted.
+    unsigned position_;
+    /// Parent index before the insertion. M_MAX_UNSIGNED for children of the scene.
+    unsigned parentIndex_;
+    /// Subtree root node.
+    Node* node_;
+};
+
+/// %Scene nodes in hierarchy order with their local and world transforms in contiguous arrays. Recalculates dirty world transforms in one batched pass, processing independent subtrees in worker threads.
+class URHO3D_API TransformHierarchy
+{
+public:
+    /// Construct. The scene's nodes are added on the first update.
+    explicit TransformHierarchy(Scene* scene);
+    /// Destruct.
+    ~TransformHierarchy();
+
+    /// Handle a node added to the scene or reparented. Its subtree is inserted into the arrays on the next update. Must be called from the main thread.
+    void NodeAdded(Node* node);
+    /// Handle a node removed from the scene. Its subtree is removed from the arrays on the next update. Must be called from the main thread.
+    void NodeRemoved(Node* node);
+    /// Mark a node's local transform changed and its subtree dirty. Walks the subtree in hierarchy order to mark it dirty and notify listeners. Return false if the node is not in the arrays yet or other nodes are waiting to be added, in which case the caller has to walk the subtree. Safe to call from worker threads.
+    bool MarkDirty(Node* node);
+    /// Mark a node's local transform changed without marking its subtree dirty. Safe to call from worker threads.
+    void MarkLocalDirty(unsigned index)
+    {
+        if (index < localDirty_.Size())
+            localDirty_[index] = 1;
+    }
+    /// Recalculate all dirty world transforms. Must be called from the main thread.
+    void Update();
+    /// Recalculate the world transforms of one subtree. Called by worker threads.
+    void UpdateRange(const TransformRange& range);
+
+    /// Return number of nodes in the hierarchy arrays, including removed nodes not yet cleaned up.
+    unsigned GetNumNodes() const { return nodes_.Size(); }
+
+private:
+    /// Remove the subtrees of removed nodes from the arrays and insert the subtrees of added nodes. Only the arrays from the first change onward are rewritten.
+    void ApplyStructureChanges();
+    /// Add a node and its children to the end of the temporary arrays.
+    void InsertNode(Node* node, unsigned parentIndex, unsigned offset);
+    /// Queue a dirty subtree for update. Subtrees too large for one work item have their root updated now and their children queued separately.
+    void QueueRange(unsigned index);
+
+    /// Scene.
+    Scene* scene_;
+    /// Nodes in depth-first order. Null for removed nodes until the next update.
+    PODVector<Node*> nodes_;
+    /// Parent indices. M_MAX_UNSIGNED for children of the scene.
+    PODVector<unsigned> parents_;
+    /// Subtree end indices.
+    PODVector<unsigned> subtreeEnds_;
+    /// Nonzero for nodes whose subtree was marked dirty since the last update.
+    PODVector<unsigned char> dirtyRoots_;
+    /// Nonzero for nodes whose local transform changed since it was last copied to the arrays.
+    PODVector<unsigned char> localDirty_;
+    /// Local transforms.
+    PODVector<Matrix3x4> localTransforms_;
+    /// Local rotations.
+    Vector<Quaternion> localRotations_;
+    /// World transforms, valid for the nodes updated in the last pass.
+    PODVector<Matrix3x4> worldTransforms_;
+    /// World rotations, valid for the nodes updated in the last pass.
+    Vector<Quaternion> worldRotations_;
+    /// Dirty subtrees of the current update.
+    PODVector<TransformRange> dirtyRanges_;
+    /// Nodes added or reparented since the last update.
+    Vector<WeakPtr<Node> > addedNodes_;
+    /// Subtrees to insert in the current structure update.
+    PODVector<TransformInsertion> insertions_;
+    /// Rewritten part of the node array in the current structure update.
+    PODVector<Node*> tempNodes_;
+    /// Rewritten part of the parent index array in the current structure update.
+    PODVector<unsigned> tempParents_;
+    /// Rewritten part of the dirty root flags in the current structure update.
+    PODVector<unsigned char> tempDirtyRoots_;
+    /// Rewritten part of the local dirty flags in the current structure update.
+    PODVector<unsigned char> tempLocalDirty_;
+    /// Rewritten part of the local transforms in the current structure update.
+    PODVector<Matrix3x4> tempLocalTransforms_;
+    /// Rewritten part of the local rotations in the current structure update.
+    Vector<Quaternion> tempLocalRotations_;
+    /// Lowest index of a removed node since the last update. M_MAX_UNSIGNED if none.
+    unsigned firstRemovedIndex_;
+    /// Nodes waiting to be added flag. Read by worker threads marking nodes dirty.
+    std::atomic<bool> structureDirty_;
+};
+
+}
@@ -86,6 +86,7 @@ const float DEFAULT_DRAGBEGIN_INTERVAL = 0.5f;
 const float DEFAULT_TOOLTIP_DELAY = 0.5f;
 const int DEFAULT_DRAGBEGIN_DISTANCE = 5;
 const int DEFAULT_FONT_TEXTURE_MAX_SIZE = 2048;
+const unsigned UI_VERTEX_BUFFER_DEFAULT_SIZE = 16384;
 
 const char* UI_CATEGORY = "UI";
 
@@ -494,17 +495,17 @@ void UI::Render(bool renderUICommand)
     // Perform the default backbuffer render only if not rendered yet, or additional renders through RenderUI command
     if (renderUICommand || !uiRendered_)
     {
-        SetVertexData(vertexBuffer_, vertexData_);
-        SetVertexData(debugVertexBuffer_, debugVertexData_);
+        unsigned vertexStart, debugVertexStart;
+        SetVertexData(vertexData_, debugVertexData_, vertexStart, debugVertexStart);
 
         if (!renderUICommand)
             graphics_->ResetRenderTargets();
         // Render non-modal batches
-        Render(vertexBuffer_, batches_, 0, nonModalBatchSize_);
+        Render(vertexStart, batches_, 0, nonModalBatchSize_);
         // Render debug draw
-        Render(debugVertexBuffer_, debugDrawBatches_, 0, debugDrawBatches_.Size());
+        Render(debugVertexStart, debugDrawBatches_, 0, debugDrawBatches_.Size());
         // Render modal batches
-        Render(vertexBuffer_, batches_, nonModalBatchSize_, batches_.Size());
+        Render(vertexStart, batches_, nonModalBatchSize_, batches_.Size());
     }
 
     // Render to UIComponent textures. This is skipped when called from the RENDERUI command
@@ -515,8 +516,8 @@ void UI::Render(bool renderUICommand)
             RenderToTextureData& data = item.second_;
             if (data.rootElement_->IsEnabled())
             {
-                SetVertexData(data.vertexBuffer_, data.vertexData_);
-                SetVertexData(data.debugVertexBuffer_, data.debugVertexData_);
+                unsigned vertexStart, debugVertexStart;
+                SetVertexData(data.vertexData_, data.debugVertexData_, vertexStart, debugVertexStart);
 
                 RenderSurface* surface = data.texture_->GetRenderSurface();
                 graphics_->SetDepthStencil(surface->GetLinkedDepthStencil());
@@ -524,8 +525,8 @@ void UI::Render(bool renderUICommand)
                 graphics_->SetViewport(IntRect(0, 0, surface->GetWidth(), surface->GetHeight()));
                 graphics_->Clear(Urho3D::CLEAR_COLOR);
 
-                Render(data.vertexBuffer_, data.batches_, 0, data.batches_.Size());
-                Render(data.debugVertexBuffer_, data.debugDrawBatches_, 0, data.debugDrawBatches_.Size());
+                Render(vertexStart, data.batches_, 0, data.batches_.Size());
+                Render(debugVertexStart, data.debugDrawBatches_, 0, data.debugDrawBatches_.Size());
                 data.debugDrawBatches_.Clear();
                 data.debugVertexData_.Clear();
             }
@@ -949,8 +950,8 @@ void UI::Initialize()
     // Set initial root element size
     ResizeRootElement();
 
-    vertexBuffer_ = new VertexBuffer(context_);
-    debugVertexBuffer_ = new VertexBuffer(context_);
+    vertexBuffer_ = new RingVertexBuffer(context_);
+    vertexBuffer_->SetSize(UI_VERTEX_BUFFER_DEFAULT_SIZE, MASK_POSITION | MASK_COLOR | MASK_TEXCOORD1);
 
     initialized_ = true;
 
@@ -976,26 +977,38 @@ void UI::Update(float timeStep, UIElement* element)
         Update(timeStep, children[i]);
 }
 
-void UI::SetVertexData(VertexBuffer* dest, const PODVector<float>& vertexData)
+void UI::SetVertexData(const PODVector<float>& vertexData, const PODVector<float>& debugVertexData, unsigned& vertexStart,
+    unsigned& debugVertexStart)
 {
-    if (vertexData.Empty())
-        return;
+    vertexStart = debugVertexStart = M_MAX_UNSIGNED;
 
-    // Update quad geometry into the vertex buffer
-    // Resize the vertex buffer first if too small or much too large
+    // Upload both into one range of the shared vertex buffer, as the UI geometry is drawn again after the debug geometry
     unsigned numVertices = vertexData.Size() / UI_VERTEX_SIZE;
-    if (dest->GetVertexCount() < numVertices || dest->GetVertexCount() > numVertices * 2)
-        dest->SetSize(numVertices, MASK_POSITION | MASK_COLOR | MASK_TEXCOORD1, true);
+    unsigned numDebugVertices = debugVertexData.Size() / UI_VERTEX_SIZE;
+    if (!numVertices && !numDebugVertices)
+        return;
+
+    unsigned start;
+    auto* dest = static_cast<float*>(vertexBuffer_->Lock(numVertices + numDebugVertices, start));
+    if (!dest)
+        return;
+
+    if (numVertices)
+        memcpy(dest, &vertexData[0], vertexData.Size() * sizeof(float));
+    if (numDebugVertices)
+        memcpy(dest + vertexData.Size(), &debugVertexData[0], debugVertexData.Size() * sizeof(float));
+    vertexBuffer_->Unlock();
 
-    dest->SetData(&vertexData[0]);
+    vertexStart = start;
+    debugVertexStart = start + numVertices;
 }
 
-void UI::Render(VertexBuffer* buffer, const PODVector<UIBatch>& batches, unsigned batchStart, unsigned batchEnd)
+void UI::Render(unsigned vertexStart, const PODVector<UIBatch>& batches, unsigned batchStart, unsigned batchEnd)
 {
     // Engine does not render when window is closed or device is lost
     assert(graphics_ && graphics_->IsInitialized() && !graphics_->IsDeviceLost());
 
-    if (batches.Empty())
+    if (batches.Empty() || vertexStart == M_MAX_UNSIGNED)
         return;
 
     unsigned alphaFormat = Graphics::GetAlphaFormat();
@@ -1037,7 +1050,7 @@ void UI::Render(VertexBuffer* buffer, const PODVector<UIBatch>& batches, unsigne
     graphics_->SetDepthWrite(false);
     graphics_->SetFillMode(FILL_SOLID);
     graphics_->SetStencilTest(false);
-    graphics_->SetVertexBuffer(buffer);
+    graphics_->SetVertexBuffer(vertexBuffer_->GetVertexBuffer());
 
     ShaderVariation* noTextureVS = graphics_->GetShader(VS, "Basic", "VERTEXCOLOR");
     ShaderVariation* diffTextureVS = graphics_->GetShader(VS, "Basic", "DIFFMAP VERTEXCOLOR");
@@ -1149,7 +1162,7 @@ void UI::Render(VertexBuffer* buffer, const PODVector<UIBatch>& batches, unsigne
             }
         }
 
-        graphics_->Draw(TRIANGLE_LIST, batch.vertexStart_ / UI_VERTEX_SIZE,
+        graphics_->Draw(TRIANGLE_LIST, vertexStart + batch.vertexStart_ / UI_VERTEX_SIZE,
             (batch.vertexEnd_ - batch.vertexStart_) / UI_VERTEX_SIZE);
 
         if (batch.customMaterial_)
@@ -2195,8 +2208,6 @@ void UI::SetElementRenderTexture(UIElement* element, Texture2D* texture)
         RenderToTextureData data;
         data.texture_ = texture;
         data.rootElement_ = element;
-        data.vertexBuffer_ = new VertexBuffer(context_);
-        data.debugVertexBuffer_ = new VertexBuffer(context_);
         renderToTexture_[element] = data;
     }
     else if (it != renderToTexture_.End())
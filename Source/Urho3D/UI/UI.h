@@ -25,7 +25,7 @@
 #pragma once
 
 #include "../Core/Object.h"
-#include "../Graphics/VertexBuffer.h"
+#include "../Graphics/RingVertexBuffer.h"
 #include "../UI/Cursor.h"
 #include "../UI/UIBatch.h"
 
@@ -296,24 +296,21 @@ private:
         PODVector<UIBatch> batches_;
         /// UI rendering vertex data.
         PODVector<float> vertexData_;
-        /// UI vertex buffer.
-        SharedPtr<VertexBuffer> vertexBuffer_;
         /// UI rendering batches for debug draw.
         PODVector<UIBatch> debugDrawBatches_;
         /// UI rendering vertex data for debug draw.
         PODVector<float> debugVertexData_;
-        /// UI debug geometry vertex buffer.
-        SharedPtr<VertexBuffer> debugVertexBuffer_;
     };
 
     /// Initialize when screen mode initially set.
     void Initialize();
     /// Update UI element logic recursively.
     void Update(float timeStep, UIElement* element);
-    /// Upload UI geometry into a vertex buffer.
-    void SetVertexData(VertexBuffer* dest, const PODVector<float>& vertexData);
-    /// Render UI batches to the current rendertarget. Geometry must have been uploaded first.
-    void Render(VertexBuffer* buffer, const PODVector<UIBatch>& batches, unsigned batchStart, unsigned batchEnd);
+    /// Upload UI geometry and debug geometry into the vertex buffer. Return the first vertex of each.
+    void SetVertexData(const PODVector<float>& vertexData, const PODVector<float>& debugVertexData, unsigned& vertexStart,
+        unsigned& debugVertexStart);
+    /// Render UI batches to the current rendertarget. Geometry must have been uploaded first, starting at vertexStart.
+    void Render(unsigned vertexStart, const PODVector<UIBatch>& batches, unsigned batchStart, unsigned batchEnd);
     /// Generate batches from an UI element recursively. Skip the cursor element.
     void GetBatches(PODVector<UIBatch>& batches, PODVector<float>& vertexData, UIElement* element, IntRect currentScissor);
     /// Return UI element at global screen coordinates. Return position converted to element's screen coordinates.
@@ -406,10 +403,8 @@ private:
     PODVector<UIBatch> debugDrawBatches_;
     /// UI rendering vertex data for debug draw.
     PODVector<float> debugVertexData_;
-    /// UI vertex buffer.
-    SharedPtr<VertexBuffer> vertexBuffer_;
-    /// UI debug geometry vertex buffer.
-    SharedPtr<VertexBuffer> debugVertexBuffer_;
+    /// UI vertex buffer shared by all UI and debug geometry, including render to texture.
+    SharedPtr<RingVertexBuffer> vertexBuffer_;
     /// UI element query vector.
     PODVector<UIElement*> tempElements_;
     /// Clipboard text.
@@ -174,6 +174,53 @@ float GetIntensity(vec3 color)
     return dot(color, vec3(0.299, 0.587, 0.114));
 }
 
+#if defined(CLUSTERED) && !defined(GL_ES)
+// Cluster grid and light data layout, must match View.cpp
+const vec3 cClusterGridSize = vec3(16.0, 8.0, 24.0);
+const int CLUSTER_TEXELS = 8;
+const int CLUSTER_LIGHT_ROW = 192;
+
+vec3 GetClusteredLight(vec3 clusterPos, vec4 worldPos, vec3 normal, vec3 diffColor, vec3 specColor)
+{
+    // Find the cluster from the screen position and the square root of the linear depth
+    vec2 screenPos = clamp(clusterPos.xy / clusterPos.z * 0.5 + 0.5, 0.0, 0.999);
+    float slice = min(sqrt(max(worldPos.w, 0.0)) * cClusterGridSize.z, cClusterGridSize.z - 1.0);
+    ivec3 cluster = ivec3(vec3(screenPos * cClusterGridSize.xy, slice));
+    int texel = ((cluster.z * 8 + cluster.y) * 16 + cluster.x) * CLUSTER_TEXELS;
+    ivec2 clusterCoord = ivec2(texel & 127, texel >> 7);
+
+    int numLights = int(texelFetch(sLightBuffer, clusterCoord, 0).x);
+    vec3 eyeVec = cCameraPosPS - worldPos.xyz;
+    vec3 result = vec3(0.0, 0.0, 0.0);
+
+    for (int i = 1; i <= numLights; ++i)
+    {
+        int lightIndex = int(texelFetch(sLightBuffer, clusterCoord + ivec2(i >> 2, 0), 0)[i & 3]);
+        ivec2 lightCoord = ivec2((lightIndex & 31) * 4, CLUSTER_LIGHT_ROW + (lightIndex >> 5));
+        vec4 lightPos = texelFetch(sLightBuffer, lightCoord, 0);
+        vec4 lightColor = texelFetch(sLightBuffer, lightCoord + ivec2(1, 0), 0);
+        vec4 lightDirCutoff = texelFetch(sLightBuffer, lightCoord + ivec2(2, 0), 0);
+
+        // Approximate the default light ramp and spot textures analytically
+        vec3 lightVec = (lightPos.xyz - worldPos.xyz) * lightPos.w;
+        float atten = clamp(1.0 - dot(lightVec, lightVec), 0.0, 1.0);
+        vec3 lightDir = normalize(lightVec);
+        if (lightDirCutoff.w > -1.0)
+            atten *= clamp((dot(-lightDir, lightDirCutoff.xyz) - lightDirCutoff.w) / (1.0 - lightDirCutoff.w), 0.0, 1.0);
+
+        float diff = max(dot(normal, lightDir), 0.0) * atten;
+        #ifdef CLUSTERSPECULAR
+            float spec = GetSpecular(normal, eyeVec, lightDir, cMatSpecColor.a);
+            result += diff * lightColor.rgb * (diffColor + spec * specColor * lightColor.a);
+        #else
+            result += diff * lightColor.rgb * diffColor;
+        #endif
+    }
+
+    return result;
+}
+#endif
+
 #ifdef SHADOW
 
 #if defined(DIRLIGHT) && (!defined(GL_ES) || defined(WEBGL))
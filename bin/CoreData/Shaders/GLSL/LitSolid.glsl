@@ -40,6 +40,9 @@ varying vec4 vWorldPos;
         varying vec2 vTexCoord2;
     #endif
 #endif
+#ifdef CLUSTERED
+    varying vec3 vClusterPos;
+#endif
 
 void VS()
 {
@@ -102,6 +105,10 @@ void VS()
             vReflectionVec = worldPos - cCameraPos;
         #endif
     #endif
+
+    #ifdef CLUSTERED
+        vClusterPos = gl_Position.xyw;
+    #endif
 }
 
 void PS()
@@ -174,6 +181,9 @@ void PS()
         #ifdef AMBIENT
             finalColor += cAmbientColor.rgb * diffColor.rgb;
             finalColor += cMatEmissiveColor;
+            #ifdef CLUSTERED
+                finalColor += GetClusteredLight(vClusterPos, vWorldPos, normal, diffColor.rgb, specColor);
+            #endif
             gl_FragColor = vec4(GetFog(finalColor, fogFactor), diffColor.a);
         #else
             gl_FragColor = vec4(GetLitFog(finalColor, fogFactor), diffColor.a);
@@ -218,6 +228,11 @@ void PS()
             // If using AO, the vertex light ambient is black, calculate occluded ambient here
             finalColor += texture2D(sEmissiveMap, vTexCoord2).rgb * cAmbientColor.rgb * diffColor.rgb;
         #endif
+
+        #ifdef CLUSTERED
+            // Add lights assigned to the pixel's cluster
+            finalColor += GetClusteredLight(vClusterPos, vWorldPos, normal, diffColor.rgb, specColor);
+        #endif
         
         #ifdef MATERIAL
             // Add light pre-pass accumulation result
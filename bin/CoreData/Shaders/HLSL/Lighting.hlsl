@@ -187,6 +187,53 @@ float GetIntensity(float3 color)
     return dot(color, float3(0.299, 0.587, 0.114));
 }
 
+#if defined(CLUSTERED) && defined(D3D11)
+// Cluster grid and light data layout, must match View.cpp
+static const float3 cClusterGridSize = float3(16.0, 8.0, 24.0);
+static const int CLUSTER_TEXELS = 8;
+static const int CLUSTER_LIGHT_ROW = 192;
+
+float3 GetClusteredLight(float3 clusterPos, float4 worldPos, float3 normal, float3 diffColor, float3 specColor)
+{
+    // Find the cluster from the screen position and the square root of the linear depth
+    float2 screenPos = clamp(clusterPos.xy / clusterPos.z * 0.5 + 0.5, 0.0, 0.999);
+    float slice = min(sqrt(max(worldPos.w, 0.0)) * cClusterGridSize.z, cClusterGridSize.z - 1.0);
+    int3 cluster = int3(float3(screenPos * cClusterGridSize.xy, slice));
+    int texel = ((cluster.z * 8 + cluster.y) * 16 + cluster.x) * CLUSTER_TEXELS;
+    int2 clusterCoord = int2(texel & 127, texel >> 7);
+
+    int numLights = (int)tLightBuffer.Load(int3(clusterCoord, 0)).x;
+    float3 eyeVec = cCameraPosPS - worldPos.xyz;
+    float3 result = 0.0;
+
+    for (int i = 1; i <= numLights; ++i)
+    {
+        int lightIndex = (int)tLightBuffer.Load(int3(clusterCoord + int2(i >> 2, 0), 0))[i & 3];
+        int2 lightCoord = int2((lightIndex & 31) * 4, CLUSTER_LIGHT_ROW + (lightIndex >> 5));
+        float4 lightPos = tLightBuffer.Load(int3(lightCoord, 0));
+        float4 lightColor = tLightBuffer.Load(int3(lightCoord + int2(1, 0), 0));
+        float4 lightDirCutoff = tLightBuffer.Load(int3(lightCoord + int2(2, 0), 0));
+
+        // Approximate the default light ramp and spot textures analytically
+        float3 lightVec = (lightPos.xyz - worldPos.xyz) * lightPos.w;
+        float atten = saturate(1.0 - dot(lightVec, lightVec));
+        float3 lightDir = normalize(lightVec);
+        if (lightDirCutoff.w > -1.0)
+            atten *= saturate((dot(-lightDir, lightDirCutoff.xyz) - lightDirCutoff.w) / (1.0 - lightDirCutoff.w));
+
+        float diff = saturate(dot(normal, lightDir)) * atten;
+        #ifdef CLUSTERSPECULAR
+            float spec = GetSpecular(normal, eyeVec, lightDir, cMatSpecColor.a);
+            result += diff * lightColor.rgb * (diffColor + spec * specColor * lightColor.a);
+        #else
+            result += diff * lightColor.rgb * diffColor;
+        #endif
+    }
+
+    return result;
+}
+#endif
+
 #ifdef SHADOW
 
 #ifdef DIRLIGHT
@@ -59,6 +59,9 @@ void VS(float4 iPos : POSITION,
             out float2 oTexCoord2 : TEXCOORD7,
         #endif
     #endif
+    #ifdef CLUSTERED
+        out float3 oClusterPos : TEXCOORD8,
+    #endif
     #ifdef VERTEXCOLOR
         out float4 oColor : COLOR0,
     #endif
@@ -134,6 +137,10 @@ void VS(float4 iPos : POSITION,
             oReflectionVec = worldPos - cCameraPos;
         #endif
     #endif
+
+    #ifdef CLUSTERED
+        oClusterPos = oPos.xyw;
+    #endif
 }
 
 void PS(
@@ -165,6 +172,9 @@ void PS(
             float2 iTexCoord2 : TEXCOORD7,
         #endif
     #endif
+    #ifdef CLUSTERED
+        float3 iClusterPos : TEXCOORD8,
+    #endif
     #ifdef VERTEXCOLOR
         float4 iColor : COLOR0,
     #endif
@@ -249,6 +259,9 @@ void PS(
         #ifdef AMBIENT
             finalColor += cAmbientColor.rgb * diffColor.rgb;
             finalColor += cMatEmissiveColor;
+            #ifdef CLUSTERED
+                finalColor += GetClusteredLight(iClusterPos, iWorldPos, normal, diffColor.rgb, specColor);
+            #endif
             oColor = float4(GetFog(finalColor, fogFactor), diffColor.a);
         #else
             oColor = float4(GetLitFog(finalColor, fogFactor), diffColor.a);
@@ -293,6 +306,11 @@ void PS(
             finalColor += Sample2D(EmissiveMap, iTexCoord2).rgb * cAmbientColor.rgb * diffColor.rgb;
         #endif
 
+        #ifdef CLUSTERED
+            // Add lights assigned to the pixel's cluster
+            finalColor += GetClusteredLight(iClusterPos, iWorldPos, normal, diffColor.rgb, specColor);
+        #endif
+
         #ifdef MATERIAL
             // Add light pre-pass accumulation result
             // Lights are accumulated at half intensity. Bring back to full intensity now